@@ -4,6 +4,7 @@ N_BENCH_SAMPLES=1
 METRIC="splinf"
 TEST_BIN_NAME="${METRIC}_bench"
 OUT_FILE_PATH="bench_results.out"
+CSV_OUT_FILE_PATH="bench_results.csv"
 
 BENCH_PARAMS=(
     "256 2 10 40"
@@ -47,23 +48,16 @@ test_name() {
 }
 
 extract_metrics() {
-    BENCH_OUTPUT=$1
-
-    LAST_BENCH_NAME_LINDEX=$(echo "$BENCH_OUTPUT" | sed -n "/benchmark name/=" | tail -n 1)
-    RUNTIME_LINE=$(echo "$BENCH_OUTPUT" | tail -n +"$LAST_BENCH_NAME_LINDEX" | head -n 6 | tail -n 2 | head -n 1)
-
-    RUNTIME=$(echo "$RUNTIME_LINE" | awk '{print $1, $2}')
-
-    #echo "RUNTIME: $RUNTIME"
-    MBs_EXCHANGED_LINE=$(echo "$BENCH_OUTPUT" | grep "Number of MBs exchanged")
-    MBs_EXCHANGED=$(echo "$MBs_EXCHANGED_LINE" | grep -oP '\d+\.\d+' | tail -n 1)
-
-    echo "$RUNTIME;$MBs_EXCHANGED"
+    RESULTS_CSV=$1
 
+    # One benchmark per run. The names at the start of a sparse-csv line may contain commas, so the
+    # columns are taken from the end: mean_ns, stddev_ns, samples_ns, bytes, rounds, peak_rss_kb
+    tail -n 1 "$RESULTS_CSV" | awk -F ',' '{ printf "%.3f ms;%.6f\n", $(NF-5) / 1000000, $(NF-2) / 1024 / 1024 }'
 }
 
 RUNTIME_OUT_STR=""
 MBs_EXCHANGED_OUT_STR=""
+rm -f "$CSV_OUT_FILE_PATH"
 
 for PARAMS in "${BENCH_PARAMS[@]}"; do
     set -- $PARAMS
@@ -72,10 +66,11 @@ for PARAMS in "${BENCH_PARAMS[@]}"; do
     
     echo "Running test: $TEST_NAME"
     
-    BENCH_OUTPUT=$("$TEST_BIN_PATH" --benchmark-samples $N_BENCH_SAMPLES --success "$TEST_NAME")
+    RESULTS_CSV="${LOG_PATH}/${TEST_NAME}.csv"
+    BENCH_OUTPUT=$("$TEST_BIN_PATH" --benchmark-samples $N_BENCH_SAMPLES --success --reporter console --reporter "sparse-csv::out=${RESULTS_CSV}" "$TEST_NAME")
     #echo $BENCH_OUTPUT
     echo $BENCH_OUTPUT > "${LOG_PATH}/${TEST_NAME}.out"
-    METRICS=$(extract_metrics "$BENCH_OUTPUT")
+    METRICS=$(extract_metrics "$RESULTS_CSV")
     
     MBs_EXCHANGED=$(echo "$METRICS" | cut -d ';' -f 2)
     RUNTIME=$(echo "$METRICS" | cut -d ';' -f 1)
@@ -87,6 +82,11 @@ for PARAMS in "${BENCH_PARAMS[@]}"; do
 
     RUNTIME_OUT_STR="${RUNTIME_OUT_STR}${RUNTIME}\t"
     MBs_EXCHANGED_OUT_STR="${MBs_EXCHANGED_OUT_STR}${MBs_EXCHANGED}\t"
+
+    if [ ! -f "$CSV_OUT_FILE_PATH" ]; then
+        head -n 1 "$RESULTS_CSV" > "$CSV_OUT_FILE_PATH"
+    fi
+    tail -n +2 "$RESULTS_CSV" >> "$CSV_OUT_FILE_PATH"
 done
 
 printf "$RUNTIME_OUT_STR\n" > "$OUT_FILE_PATH"
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+
+"""Compares two benchmark result files written by the sparse-json or sparse-csv reporters.
+
+    compare.py baseline.json candidate.json [--sigmas 3] [--min-rel 0.05] [--rss-rel 0.10]
+
+A benchmark regresses when its mean runtime grows by more than the noise threshold, i.e. the larger of
+--min-rel times the baseline mean and --sigmas standard errors of the difference of the means, estimated
+from the samples of both files. Bytes and rounds are deterministic and regress on any increase; the peak
+RSS regresses when it grows by more than --rss-rel. Exits with status 1 if anything regressed.
+"""
+
+import argparse
+import csv
+import json
+import math
+import sys
+
+
+def load(path):
+    if path.endswith(".json"):
+        with open(path) as f:
+            records = json.load(f)["benchmarks"]
+    else:
+        with open(path, newline="") as f:
+            records = list(csv.DictReader(f))
+
+        for record in records:
+            record["samples_ns"] = [float(s) for s in record["samples_ns"].split(";") if s]
+
+            for key in ("mean_ns", "stddev_ns"):
+                record[key] = float(record[key])
+
+            for key in ("bytes", "rounds", "peak_rss_kb"):
+                record[key] = int(record[key]) if record[key] else None
+
+    return {(r["test"], r["benchmark"], r["party_mode"]): r for r in records}
+
+
+def spread(record):
+    samples = record["samples_ns"]
+
+    if len(samples) < 2:
+        return record["stddev_ns"], max(len(samples), 1)
+
+    mean = sum(samples) / len(samples)
+    return math.sqrt(sum((s - mean) ** 2 for s in samples) / (len(samples) - 1)), len(samples)
+
+
+def compare(base, cand, args):
+    findings = []
+
+    base_sd, base_n = spread(base)
+    cand_sd, cand_n = spread(cand)
+
+    noise = math.sqrt(base_sd ** 2 / base_n + cand_sd ** 2 / cand_n)
+    threshold = max(args.min_rel * base["mean_ns"], args.sigmas * noise)
+    diff = cand["mean_ns"] - base["mean_ns"]
+
+    if diff > threshold:
+        findings.append(("REGRESSION", "runtime %.3f ms -> %.3f ms (+%.1f%%, threshold %.3f ms)"
+                         % (base["mean_ns"] / 1e6, cand["mean_ns"] / 1e6, 100.0 * diff / base["mean_ns"], threshold / 1e6)))
+    elif -diff > threshold:
+        findings.append(("improvement", "runtime %.3f ms -> %.3f ms (%.1f%%)"
+                         % (base["mean_ns"] / 1e6, cand["mean_ns"] / 1e6, 100.0 * diff / base["mean_ns"])))
+
+    for key in ("bytes", "rounds"):
+        if base.get(key) is None or cand.get(key) is None:
+            continue
+
+        if cand[key] > base[key]:
+            findings.append(("REGRESSION", "%s %d -> %d" % (key, base[key], cand[key])))
+        elif cand[key] < base[key]:
+            findings.append(("improvement", "%s %d -> %d" % (key, base[key], cand[key])))
+
+    if base.get("peak_rss_kb") and cand.get("peak_rss_kb") is not None:
+        if cand["peak_rss_kb"] > base["peak_rss_kb"] * (1.0 + args.rss_rel):
+            findings.append(("REGRESSION", "peak rss %.1f MBs -> %.1f MBs" % (base["peak_rss_kb"] / 1024.0, cand["peak_rss_kb"] / 1024.0)))
+
+    return findings
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flags benchmark regressions between two result files")
+    parser.add_argument("baseline")
+    parser.add_argument("candidate")
+    parser.add_argument("--sigmas", type=float, default=3.0, help="standard errors a runtime change must exceed")
+    parser.add_argument("--min-rel", type=float, default=0.05, help="smallest relative runtime change reported")
+    parser.add_argument("--rss-rel", type=float, default=0.10, help="largest relative peak RSS growth tolerated")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    candidate = load(args.candidate)
+    regressions = 0
+
+    for key in sorted(baseline.keys() | candidate.keys()):
+        label = "%s / %s [%s]" % key
+
+        if key not in candidate:
+            print("missing     %s" % label)
+            continue
+        if key not in baseline:
+            print("new         %s" % label)
+            continue
+
+        for kind, message in compare(baseline[key], candidate[key], args):
+            print("%-11s %s: %s" % (kind, label, message))
+            regressions += kind == "REGRESSION"
+
+    print("%d regression(s)" % regressions)
+
+    return 1 if regressions > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -14,5 +14,6 @@ rm -rf "$SCRIPT_DIR/log"
 mkdir -p "$SCRIPT_DIR/log"
 
 rm -rf "$SCRIPT_DIR/bench_results.out"
+rm -rf "$SCRIPT_DIR/bench_results.csv"
 
 echo -e "\e[1;32mAll logs and bench-results.out have been deleted.\e[0m"
\ No newline at end of file
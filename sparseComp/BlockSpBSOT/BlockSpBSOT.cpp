@@ -6,6 +6,8 @@
 #include "../Common/Common.h"
 #include "cryptoTools/Crypto/AES.h"
 #include "../Common/BaxosUtils.h"
+#include "../Common/CommStats.h"
+#include "../Common/Trace.h"
 #include <vector>
 #include <array>
 #include <iostream>
@@ -172,24 +174,27 @@ static vector<block>* tmp_encode_okvs(const AES& aes,const vector<block>& pointH
     paxos.init(t*k*n, sparse_comp::baxosBinSize(t*k*n), 3, SSP, PaxosParam::GF128, oc::ZeroBlock);
     vector<block>* paxos_structure = new vector<block>(paxos.size());
 
-    // std::cout << okvs_idxs.size() << ";" << okvs_values.size() << std::endl;
-
     paxos.solve<block>(okvs_idxs, okvs_values, *paxos_structure, nullptr, NUM_THREADS);
 
-    // std::cout << "TEST" << std::endl;
-
     return paxos_structure;
 }
 
 
 
-Proto sendOkvsStructure(Socket& sock, vector<block>& paxos_structure) {
+inline Proto sendOkvsStructure(Socket& sock, vector<block>& paxos_structure) {
     MC_BEGIN(Proto, &sock, &paxos_structure,
-             t = coproto::task<void>());
+             t = coproto::task<void>(),
+             scope = (sparse_comp::comm::CommScope*) nullptr);
+
+        scope = new sparse_comp::comm::CommScope(sock, "block_spbsot.okvs");
+        SPARSE_COMP_TRACE_BEGIN(sock, "block_spbsot.okvs");
 
         t = sparse_comp::send<block,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, paxos_structure);
 
         MC_AWAIT(t);
+
+        SPARSE_COMP_TRACE_END(sock, "block_spbsot.okvs");
+        delete scope;
     
     MC_END();
 }
@@ -207,44 +212,43 @@ void sample_output_shares(PRNG& prng, array<array<block,k>,t>& output_shares) {
 }
 
 template<size_t tr, size_t t, size_t k, size_t n>
-Proto sparse_comp::block_sp_bsot::Sender<tr,t,k,n>::send(coproto::Socket& sock, vector<block>& ordIndexSet, array<array<array<block,n>,k>,t>& msg_vecs, array<array<ZN<n>,k>,t>& choice_vec_shares, array<array<block,k>,t>& output_shares) {
-    MC_BEGIN(Proto, this, &sock, &ordIndexSet, &msg_vecs, &choice_vec_shares, &output_shares,
+Proto sparse_comp::block_sp_bsot::Sender<tr,t,k,n>::send(coproto::Socket& sock, vector<block>& ordIndexSet, array<array<array<block,n>,k>,t>& msg_vecs, array<array<ZN<n>,k>,t>& choice_vec_shares, array<array<block,k>,t>& output_shares, bool output_shares_presampled) {
+    MC_BEGIN(Proto, this, &sock, &ordIndexSet, &msg_vecs, &choice_vec_shares, &output_shares, output_shares_presampled,
     oprfSendProto = Proto(),
     oprfRecvProto = Proto(),
     block_matrix = (array<VecMatrix<block>*,t>*) nullptr,
     okvs_structure = (vector<block>*) nullptr,
     h_vec = vector<block>(t*k)
     );
-        // std::cout << "(SENDER) SENDING OPRF" << std::endl;
 
         oprfSendProto = this->oprfSender->send(sock,k*tr);
         oprfRecvProto = sender_query_oprf<t,k>(sock,*(this->oprfReceiver), ordIndexSet, h_vec);
 
-        sample_output_shares(*(this->prng), output_shares);
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "block_spbsot.mask_r");
 
-        block_matrix = mask_msg_vectors_with_r_values<t,k,n>(output_shares, msg_vecs);
+            if (!output_shares_presampled) sample_output_shares(*(this->prng), output_shares);
 
-        // std::cout << (output_shares[0][0].to_uint64_t()) << std::endl;
-        // std::cout << (msg_vecs[0][0][50]).to_uint64_t() << std::endl;
-        // std::cout << ((*msg_vecs_masked_with_r)[0]->row(0)[50]).to_uint64_t() << std::endl;
+            block_matrix = mask_msg_vectors_with_r_values<t,k,n>(output_shares, msg_vecs);
 
-        cshift_masked_matrices<n,k,t>(*block_matrix,choice_vec_shares);
-
-        // std::cout << ((*msg_vecs_masked_with_r)[0]->row(0)[50]).to_uint64_t() << std::endl;
+            cshift_masked_matrices<n,k,t>(*block_matrix,choice_vec_shares);
+        }
 
+        SPARSE_COMP_TRACE_BEGIN(sock, "block_spbsot.oprf");
         MC_AWAIT(oprfSendProto);
         MC_AWAIT(oprfRecvProto);
+        SPARSE_COMP_TRACE_END(sock, "block_spbsot.oprf");
 
-        // std::cout << "(SENDER) OPRF SENT" << std::endl;
-
-        mask_block_mtx_using_oprf<t,k,n>(*(this->oprfSender), ordIndexSet, *block_matrix);
-        mask_block_mtx_using_h_vec<t,k,n>(*block_matrix, h_vec);
-
-        // std::cout << "(SENDER) ENCODING OKVS AS PART OF SP SOT" << std::endl;
-
-        okvs_structure = tmp_encode_okvs<t,k,n>(this->aes, ordIndexSet, *block_matrix);
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "block_spbsot.mask");
+            mask_block_mtx_using_oprf<t,k,n>(*(this->oprfSender), ordIndexSet, *block_matrix);
+            mask_block_mtx_using_h_vec<t,k,n>(*block_matrix, h_vec);
+        }
 
-        //std::cout << okvs_structure->size() << std::endl;
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "block_spbsot.okvs_encode");
+            okvs_structure = tmp_encode_okvs<t,k,n>(this->aes, ordIndexSet, *block_matrix);
+        }
 
         MC_AWAIT(sendOkvsStructure(sock,*okvs_structure));
 
@@ -275,17 +279,10 @@ static vector<block>* tmp_decode_okvs(const AES& aes, const vector<block>& ordIn
 
     }
 
-    //std::cout << "before block paxos decoding" << std::endl;
-    //std::cout << paxos_structure.size() << std::endl;
-
     Baxos paxos;
     paxos.init(ts*k*n, sparse_comp::baxosBinSize(ts*k*n), 3, SSP, PaxosParam::GF128, oc::ZeroBlock);
     paxos.decode<block>(okvs_idxs, *okvs_values, paxos_structure);
 
-    //std::cout << "receiver paxos decoded values:" << std::endl;
-
-    //std::cout << "after block paxos decoding" << std::endl;
-
     return okvs_values;
 }
 
@@ -311,23 +308,21 @@ void extract_shares_from_okvs_values(CustomOPRFSender& oprfSender, vector<block>
 
 }
 
-template<size_t ts, size_t tr, size_t k, size_t n>
-static void internalReceive(AES& aes,  CustomOPRFSender& oprfSender,vector<block>& oprf_vals, vector<block>& paxos_structure, vector<block>& ordIndexSet, array<array<ZN<n>,k>,tr>& choice_vec_shares, array<array<block,k>,tr>& output_shares) {
-    auto okvs_vals = tmp_decode_okvs<ts,tr,k,n>(aes, ordIndexSet,choice_vec_shares, paxos_structure);
-
-    extract_shares_from_okvs_values<tr,k,n>(oprfSender , ordIndexSet,*okvs_vals, oprf_vals, output_shares);
-
-    delete okvs_vals;
-}
-
 
-Proto receiveOkvsStructure(coproto::Socket& sock, vector<block>& paxos_structure) {
+inline Proto receiveOkvsStructure(coproto::Socket& sock, vector<block>& paxos_structure) {
     MC_BEGIN(Proto, &sock, &paxos_structure,
-             t = coproto::task<void>());
+             t = coproto::task<void>(),
+             scope = (sparse_comp::comm::CommScope*) nullptr);
+
+        scope = new sparse_comp::comm::CommScope(sock, "block_spbsot.okvs");
+        SPARSE_COMP_TRACE_BEGIN(sock, "block_spbsot.okvs");
 
         t = sparse_comp::receive<block,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, paxos_structure.size(), paxos_structure);
         MC_AWAIT(t);
 
+        SPARSE_COMP_TRACE_END(sock, "block_spbsot.okvs");
+        delete scope;
+
     MC_END();
 }
 
@@ -338,20 +333,19 @@ Proto sparse_comp::block_sp_bsot::Receiver<ts, tr,k,n>::receive(coproto::Socket&
     oprf_values = vector<block>(tr*k),
     paxos = Baxos{},
     paxos_structure = (vector<block>*) nullptr,
+    okvs_values = (vector<block>*) nullptr,
     proto = Proto(),
     oprfSendProto = Proto()
     );
         
-        // std::cout << "(RECEIVER) BEFORE SP SOT OPRF QUERY" << std::endl;
-
         proto = receiver_query_oprf<tr,k,n>(sock,*(this->oprfReceiver), ordIndexSet, choice_vec_shares, oprf_values);
 
         oprfSendProto = this->oprfSender->send(sock, k*ts);
 
+        SPARSE_COMP_TRACE_BEGIN(sock, "block_spbsot.oprf");
         MC_AWAIT(proto);
         MC_AWAIT(oprfSendProto);
-
-        // std::cout << "(RECEIVER) AFTER SP SOT OPRF QUERY" << std::endl;
+        SPARSE_COMP_TRACE_END(sock, "block_spbsot.oprf");
 
         paxos = Baxos();
         paxos.init(ts*k*n, sparse_comp::baxosBinSize(ts*k*n), 3, SSP, PaxosParam::GF128, oc::ZeroBlock);
@@ -362,10 +356,17 @@ Proto sparse_comp::block_sp_bsot::Receiver<ts, tr,k,n>::receive(coproto::Socket&
             receiveOkvsStructure(sock, *paxos_structure)
         );
 
-        //std::cout << "block receive before internal" << std::endl;
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "block_spbsot.okvs_decode");
+            okvs_values = tmp_decode_okvs<ts,tr,k,n>(this->aes, ordIndexSet, choice_vec_shares, *paxos_structure);
+        }
 
-        internalReceive<ts,tr,k,n>(this->aes, *(this->oprfSender), oprf_values, *paxos_structure, ordIndexSet, choice_vec_shares, output_shares);
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "block_spbsot.extract");
+            extract_shares_from_okvs_values<tr,k,n>(*(this->oprfSender), ordIndexSet, *okvs_values, oprf_values, output_shares);
+        }
 
+        delete okvs_values;
         delete paxos_structure;
 
      MC_END();
@@ -49,7 +49,8 @@ namespace sparse_comp::block_sp_bsot {
                 delete oprfReceiver;
             }
 
-            Proto send(coproto::Socket& sock, vec<block>& ordIndexSet, array<array<array<block,n>,k>,t>& msg_vecs, array<array<ZN<n>,k>,t>& choice_vec_shares, array<array<block,k>,t>& output_shares);
+            // If output_shares_presampled is set, output_shares already holds the (random) sender output shares.
+            Proto send(coproto::Socket& sock, vec<block>& ordIndexSet, array<array<array<block,n>,k>,t>& msg_vecs, array<array<ZN<n>,k>,t>& choice_vec_shares, array<array<block,k>,t>& output_shares, bool output_shares_presampled = false);
     };
 
     template<size_t ts, size_t t, size_t k, size_t n>
@@ -1,6 +1,8 @@
 #include "./BlockUtils.h"
 #include <cstdint>
 #include <vector>
+#include <cassert>
+#include <algorithm>
 
 using namespace std;
 
@@ -11,4 +13,80 @@ void sparse_comp::block_vec_xor(vec<block>& va, vec<block>& vb, vec<block>& vc)
     for(uint32_t i=0;i < vc.size();i++) {
         vc[i] = va[i] ^ vb[i];
     }
-}
\ No newline at end of file
+}
+
+static inline uint64_t low_bits_mask(size_t nbits) {
+    return nbits >= 64 ? uint64_t(-1) : ((uint64_t(1) << nbits) - 1);
+}
+
+// Writes the nbits (nbits <= 64) least significant bits of data starting at bit position bit_pos of words.
+static inline void write_bits(vec<uint64_t>& words, size_t bit_pos, uint64_t data, size_t nbits) {
+    size_t word_idx = bit_pos / 64;
+    size_t bit_offset = bit_pos % 64;
+
+    words[word_idx] ^= data << bit_offset;
+
+    if (bit_offset + nbits > 64) {
+        words[word_idx + 1] ^= data >> (64 - bit_offset);
+    }
+}
+
+// Reads nbits (nbits <= 64) bits starting at bit position bit_pos of words.
+static inline uint64_t read_bits(const vec<uint64_t>& words, size_t bit_pos, size_t nbits) {
+    size_t word_idx = bit_pos / 64;
+    size_t bit_offset = bit_pos % 64;
+
+    uint64_t data = words[word_idx] >> bit_offset;
+
+    if (bit_offset + nbits > 64) {
+        data ^= words[word_idx + 1] << (64 - bit_offset);
+    }
+
+    return data & low_bits_mask(nbits);
+}
+
+size_t sparse_comp::packed_blocks_word_count(size_t block_count, size_t nbits) {
+    return (block_count*nbits + 63) / 64;
+}
+
+void sparse_comp::pack_blocks(const vec<block>& blocks, size_t nbits, vec<uint64_t>& packed) {
+    assert(nbits > 0 && nbits <= 128);
+
+    const size_t low_nbits = std::min(nbits, size_t(64));
+    const size_t high_nbits = nbits - low_nbits;
+
+    packed.assign(packed_blocks_word_count(blocks.size(), nbits), 0);
+
+    size_t bit_pos = 0;
+    for (size_t i=0;i < blocks.size();i++) {
+        write_bits(packed, bit_pos, blocks[i].get<uint64_t>(0) & low_bits_mask(low_nbits), low_nbits);
+        bit_pos += low_nbits;
+
+        if (high_nbits > 0) {
+            write_bits(packed, bit_pos, blocks[i].get<uint64_t>(1) & low_bits_mask(high_nbits), high_nbits);
+            bit_pos += high_nbits;
+        }
+    }
+}
+
+void sparse_comp::unpack_blocks(const vec<uint64_t>& packed, size_t nbits, vec<block>& blocks) {
+    assert(nbits > 0 && nbits <= 128);
+    assert(packed.size() >= packed_blocks_word_count(blocks.size(), nbits));
+
+    const size_t low_nbits = std::min(nbits, size_t(64));
+    const size_t high_nbits = nbits - low_nbits;
+
+    size_t bit_pos = 0;
+    for (size_t i=0;i < blocks.size();i++) {
+        uint64_t low = read_bits(packed, bit_pos, low_nbits);
+        uint64_t high = 0;
+        bit_pos += low_nbits;
+
+        if (high_nbits > 0) {
+            high = read_bits(packed, bit_pos, high_nbits);
+            bit_pos += high_nbits;
+        }
+
+        blocks[i] = block(high, low);
+    }
+}
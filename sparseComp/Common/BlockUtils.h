@@ -1,6 +1,7 @@
 #pragma once
 
 #include "cryptoTools/Common/block.h"
+#include <cstdint>
 #include <vector>
 
 using block = osuCrypto::block;
@@ -13,4 +14,13 @@ namespace sparse_comp {
     // Let va and vb be two vectors of blocks. This function returns a vector of blocks vc, where vc[i] = va[i] xor vb[i]
     void block_vec_xor(std::vector<block>& va, std::vector<block>& vb, std::vector<block>& vc);
 
-};
\ No newline at end of file
+    // Returns the number of uint64_t words required to store block_count values of nbits bits each.
+    size_t packed_blocks_word_count(size_t block_count, size_t nbits);
+
+    // Packs the nbits (nbits <= 128) least significant bits of every block of blocks into a contiguous bit string.
+    void pack_blocks(const std::vector<block>& blocks, size_t nbits, std::vector<uint64_t>& packed);
+
+    // Inverse of pack_blocks. blocks must already have the number of packed blocks as its size.
+    void unpack_blocks(const std::vector<uint64_t>& packed, size_t nbits, std::vector<block>& blocks);
+
+};
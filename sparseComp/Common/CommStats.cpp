@@ -0,0 +1,120 @@
+#include "./CommStats.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+    struct socket_ledger {
+        sparse_comp::comm::PhaseReport phases;
+        std::vector<sparse_comp::comm::CommScope*> open_scopes;
+    };
+
+    std::mutex ledgers_mtx;
+    std::map<const coproto::Socket*, socket_ledger> ledgers;
+
+};
+
+sparse_comp::comm::PhaseStats& sparse_comp::comm::PhaseStats::operator+=(const PhaseStats& other) {
+    this->bytes_sent += other.bytes_sent;
+    this->bytes_received += other.bytes_received;
+    this->flights += other.flights;
+    this->runs += other.runs;
+
+    return *this;
+}
+
+sparse_comp::comm::PhaseReport sparse_comp::comm::report(const coproto::Socket& sock) {
+    std::lock_guard<std::mutex> lock(ledgers_mtx);
+
+    auto it = ledgers.find(&sock);
+
+    return it == ledgers.end() ? PhaseReport() : it->second.phases;
+}
+
+void sparse_comp::comm::reset(const coproto::Socket& sock) {
+    std::lock_guard<std::mutex> lock(ledgers_mtx);
+
+    auto it = ledgers.find(&sock);
+
+    if (it == ledgers.end()) return;
+
+    if (it->second.open_scopes.empty()) ledgers.erase(it);
+    else it->second.phases.clear();
+}
+
+void sparse_comp::comm::note(const coproto::Socket& sock, int dir) {
+    std::lock_guard<std::mutex> lock(ledgers_mtx);
+
+    auto it = ledgers.find(&sock);
+
+    if (it == ledgers.end()) return;
+
+    for (auto scope : it->second.open_scopes) {
+        if (scope->last_dir != dir) {
+            scope->flights++;
+            scope->last_dir = dir;
+        }
+    }
+}
+
+void sparse_comp::comm::note_send(const coproto::Socket& sock) {
+    note(sock, 1);
+}
+
+void sparse_comp::comm::note_recv(const coproto::Socket& sock) {
+    note(sock, -1);
+}
+
+sparse_comp::comm::CommScope::CommScope(coproto::Socket& sock, const std::string& name) {
+    this->start(sock, name);
+}
+
+sparse_comp::comm::CommScope::~CommScope() {
+    if (this->active()) this->stop();
+}
+
+void sparse_comp::comm::CommScope::start(coproto::Socket& sock, const std::string& name) {
+    if (this->active()) this->stop();
+
+    this->sock = &sock;
+    this->name = name;
+    this->sent_at_start = sock.bytesSent();
+    this->received_at_start = sock.bytesReceived();
+    this->flights = 0;
+    this->last_dir = 0;
+
+    std::lock_guard<std::mutex> lock(ledgers_mtx);
+    ledgers[&sock].open_scopes.push_back(this);
+}
+
+void sparse_comp::comm::CommScope::stop() {
+    if (!this->active()) return;
+
+    PhaseStats stats;
+    stats.bytes_sent = this->sock->bytesSent() - this->sent_at_start;
+    stats.bytes_received = this->sock->bytesReceived() - this->received_at_start;
+    stats.flights = this->flights;
+    stats.runs = 1;
+
+    {
+        std::lock_guard<std::mutex> lock(ledgers_mtx);
+
+        socket_ledger& ledger = ledgers[this->sock];
+        ledger.phases[this->name] += stats;
+        ledger.open_scopes.erase(std::remove(ledger.open_scopes.begin(), ledger.open_scopes.end(), this), ledger.open_scopes.end());
+    }
+
+    this->sock = nullptr;
+}
+
+void sparse_comp::comm::print_report(const std::string& label, const PhaseReport& report) {
+    for (auto& [name, stats] : report) {
+        std::printf("%s %-24s sent: %10.3f MBs received: %10.3f MBs flights: %6lu runs: %lu\n",
+                    label.c_str(), name.c_str(),
+                    ((double) stats.bytes_sent)/1024.0/1024.0,
+                    ((double) stats.bytes_received)/1024.0/1024.0,
+                    (unsigned long) stats.flights, (unsigned long) stats.runs);
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "coproto/Socket/Socket.h"
+#include <cstdint>
+#include <map>
+#include <string>
+
+// Per phase communication accounting. A phase is a named span of a protocol run on a given socket
+// (e.g. "spbsot.okvs"); while it is open, the bytes moved by the socket in each direction are charged to it,
+// together with the number of message flights, i.e. maximal runs of messages in the same direction.
+// Nested phases each account the whole traffic of their span. Phases are recorded per socket, so both parties
+// of a local run can be accounted in the same process.
+
+namespace sparse_comp::comm {
+
+    struct PhaseStats {
+        uint64_t bytes_sent = 0;
+        uint64_t bytes_received = 0;
+        uint64_t flights = 0;
+        uint64_t runs = 0;
+
+        PhaseStats& operator+=(const PhaseStats& other);
+    };
+
+    using PhaseReport = std::map<std::string, PhaseStats>;
+
+    // Phases recorded so far on sock, keyed by phase name.
+    PhaseReport report(const coproto::Socket& sock);
+
+    // Drops everything recorded on sock. Call it before reusing a socket (or its address) for a new measurement.
+    void reset(const coproto::Socket& sock);
+
+    // Called by the send/receive helpers of SockUtils.h before each message, so that the open phases of sock
+    // can count direction changes. Messages exchanged inside libOTe (base OTs, OT extension) do not go through
+    // the helpers: their bytes are accounted, their flights are not.
+    void note_send(const coproto::Socket& sock);
+    void note_recv(const coproto::Socket& sock);
+
+    // Scope of a phase. Outside of coroutines it is used as a plain RAII object:
+    //
+    //     CommScope scope(sock, "oprf.setup");
+    //
+    // Inside an MC_BEGIN coroutine the stack does not survive MC_AWAIT, so keep it in a frame variable
+    // (scope = (sparse_comp::comm::CommScope*) nullptr), allocate it before the awaited steps and delete it after them.
+    class CommScope {
+        private:
+            coproto::Socket* sock = nullptr;
+            std::string name;
+            uint64_t sent_at_start = 0;
+            uint64_t received_at_start = 0;
+            uint64_t flights = 0;
+            int last_dir = 0;
+
+            friend void note(const coproto::Socket& sock, int dir);
+
+        public:
+            CommScope() = default;
+            CommScope(coproto::Socket& sock, const std::string& name);
+            ~CommScope();
+
+            CommScope(const CommScope&) = delete;
+            CommScope& operator=(const CommScope&) = delete;
+
+            void start(coproto::Socket& sock, const std::string& name);
+            void stop();
+
+            bool active() const { return this->sock != nullptr; }
+    };
+
+    void note(const coproto::Socket& sock, int dir);
+
+    // Prints one line per phase of report, prefixed by label.
+    void print_report(const std::string& label, const PhaseReport& report);
+
+};
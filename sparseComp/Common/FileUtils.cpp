@@ -0,0 +1,69 @@
+#include "./FileUtils.h"
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void sparse_comp::write_file_atomically(const std::string& path, const std::vector<std::pair<const void*, size_t>>& chunks) {
+    const std::string tmp_path = path + ".tmp";
+
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) throw std::runtime_error("could not create " + tmp_path);
+
+    for (auto& chunk : chunks) {
+        const uint8_t* data = (const uint8_t*) chunk.first;
+        size_t togo = chunk.second;
+
+        while (togo > 0) {
+            ssize_t written = ::write(fd, data, togo);
+
+            if (written < 0) {
+                ::close(fd);
+                throw std::runtime_error("could not write " + tmp_path);
+            }
+
+            data += written;
+            togo -= (size_t) written;
+        }
+    }
+
+    if (::fsync(fd) != 0 || ::close(fd) != 0) throw std::runtime_error("could not sync " + tmp_path);
+
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) throw std::runtime_error("could not rename " + tmp_path + " to " + path);
+}
+
+sparse_comp::MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("could not open " + path);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("could not stat " + path);
+    }
+
+    // An empty file cannot be mapped; it is left unmapped with size 0
+    if (st.st_size > 0) {
+        void* map = ::mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (map == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("could not map " + path);
+        }
+
+        this->map = map;
+        this->map_size = (size_t) st.st_size;
+    }
+
+    ::close(fd);
+}
+
+sparse_comp::MappedFile::~MappedFile() {
+    if (this->map != nullptr) ::munmap(this->map, this->map_size);
+}
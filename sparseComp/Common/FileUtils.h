@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sparse_comp {
+
+    // Writes the given chunks to path + ".tmp", syncs it and renames it over path, so that readers
+    // either see the previous content or the new one. Throws std::runtime_error on failure.
+    void write_file_atomically(const std::string& path, const std::vector<std::pair<const void*, size_t>>& chunks);
+
+    // Read only private mapping of a whole file, unmapped on destruction.
+    class MappedFile {
+        private:
+            void* map = nullptr;
+            size_t map_size = 0;
+
+        public:
+            // Throws std::runtime_error if the file cannot be opened or mapped.
+            explicit MappedFile(const std::string& path);
+            ~MappedFile();
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            const void* data() const { return this->map; }
+            size_t size() const { return this->map_size; }
+    };
+
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "./Common.h"
+#include "./BaxosUtils.h"
+#include "./BlockUtils.h"
+#include "volePSI/Paxos.h"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "cryptoTools/Common/block.h"
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Shared finalization step of the Fuzzy PSI protocols (L1, L2 and L_inf). After the SpX protocol
+// the sender encodes, for each of its points, the point index under the key given by its spatial hash.
+// The receiver decodes the OKVS on its cells and, whenever the decoded value unmasks to a valid index,
+// decrypts the corresponding sender point.
+
+namespace sparse_comp::fuzzy {
+
+    // Number of bits used to encode a sender point index.
+    template<size_t ts>
+    constexpr size_t idx_nbits() {
+        return (size_t) std::bit_width(ts - 1);
+    }
+
+    // Number of bits kept from each cell of the index OKVS: ssp bits of redundancy plus the point index.
+    template<size_t ts, size_t ssp>
+    constexpr size_t idx_okvs_nbits() {
+        static_assert(ssp + idx_nbits<ts>() <= 128, "ssp + log2(ts) must be less or equal to 128");
+        return ssp + idx_nbits<ts>();
+    }
+
+    template<size_t ts, size_t ssp>
+    inline size_t idx_okvs_word_count() {
+        return sparse_comp::packed_blocks_word_count(sparse_comp::baxosBlockCount(ts, ssp), idx_okvs_nbits<ts,ssp>());
+    }
+
+    template<size_t ts, size_t d>
+    constexpr size_t point_ctxs_count() {
+        return ts*d;
+    }
+
+    template<size_t ts, size_t d, uint8_t ssp>
+    void compute_final_encryped_points(osuCrypto::AES& hash,
+                                       std::array<point,ts>& sndr_points,
+                                       std::vector<block>& sndr_points_spthashs,
+                                       std::array<std::array<block,1>,ts>& z_vec_shares,
+                                       std::vector<uint64_t>& idx_okvs,
+                                       std::vector<uint32_t>& point_ctxs) {
+        static_assert(ts > 0 && d > 0);
+        static_assert(ssp <= 64,"ssp must be less or equal to 64");
+        static_assert(d <= point::MAX_DIM);
+
+        std::vector<block> okvs_vals(ts);
+        std::vector<block> okvs(sparse_comp::baxosBlockCount(ts, ssp));
+
+        point_ctxs.resize(point_ctxs_count<ts,d>());
+
+        for (size_t i=0;i < ts;i++) {
+            osuCrypto::PRNG prng(z_vec_shares[i][0]);
+            block k0 = prng.get<block>();
+
+            okvs_vals[i] = k0 ^ block((uint64_t) 0,(uint64_t) i);
+
+            for (size_t j=0;j < d; j++) {
+                point_ctxs[i*d+j] = sndr_points[i].coords[j] ^ prng.get<uint32_t>();
+            }
+        }
+
+        volePSI::Baxos paxos;
+        paxos.init(ts, sparse_comp::baxosBinSize(ts), 3, ssp, volePSI::PaxosParam::GF128, oc::ZeroBlock);
+
+        paxos.solve<block>(sndr_points_spthashs, okvs_vals, okvs, nullptr, 1);
+
+        // Only the index and ssp bits of redundancy are needed by the receiver, the rest of each cell is dropped.
+        sparse_comp::pack_blocks(okvs, idx_okvs_nbits<ts,ssp>(), idx_okvs);
+
+    }
+
+    // Appends to intersec the sender points found in the cells of the receiver points. If matched is given, it
+    // gets the index of the receiver point of each appended point.
+    template<size_t ts, size_t tr, size_t d, size_t cell_count, uint32_t ssp>
+    void receiver_intersection(osuCrypto::AES& hash,
+                               std::array<point,tr>& rcver_points,
+                               std::vector<block>& rcvr_cells,
+                               std::array<std::array<block,1>,cell_count>& rcvr_z_shares,
+                               std::vector<uint64_t>& sndr_idx_okvs,
+                               std::vector<uint32_t>& sndr_point_ctxs,
+                               std::vector<point>& intersec,
+                               std::vector<uint32_t>* matched = nullptr) {
+        constexpr const size_t twotod = (size_t) std::pow(2, d);
+        constexpr const size_t nbits = idx_okvs_nbits<ts,ssp>();
+        constexpr const size_t idx_bits = idx_nbits<ts>();
+
+        static_assert(cell_count == twotod * tr);
+        static_assert(ts > 0 && tr > 0);
+        static_assert(ssp <= 64,"ssp must be less or equal to 64");
+
+        const uint64_t low_msk = nbits >= 64 ? uint64_t(-1) : ((uint64_t(1) << nbits) - 1);
+        const uint64_t high_msk = nbits <= 64 ? 0 : (nbits == 128 ? uint64_t(-1) : ((uint64_t(1) << (nbits - 64)) - 1));
+        const uint64_t idx_msk = idx_bits == 0 ? 0 : (uint64_t(-1) >> (64 - idx_bits));
+
+        std::vector<block> okvs(sparse_comp::baxosBlockCount(ts, ssp));
+        std::vector<block> decoded_vals(cell_count);
+
+        sparse_comp::unpack_blocks(sndr_idx_okvs, nbits, okvs);
+
+        volePSI::Baxos paxos;
+        paxos.init(ts, sparse_comp::baxosBinSize(ts), 3, ssp, volePSI::PaxosParam::GF128, oc::ZeroBlock);
+
+        paxos.decode<block>(rcvr_cells, decoded_vals, okvs);
+
+        for (size_t i=0;i < cell_count;i++) {
+            osuCrypto::PRNG prng(rcvr_z_shares[i][0]);
+            block k0 = prng.get<block>();
+
+            block dec_okvs_val = decoded_vals[i] ^ k0;
+
+            uint64_t low = dec_okvs_val.get<uint64_t>(0) & low_msk;
+            uint64_t high = dec_okvs_val.get<uint64_t>(1) & high_msk;
+
+            // Every kept bit above the index must be zero
+            if (high != 0 || (low & ~idx_msk) != 0) continue;
+
+            size_t idx = (size_t) (low & idx_msk);
+
+            if (idx >= ts) continue;
+
+            point pt;
+            pt.coord_dim = d;
+
+            for (size_t j=0;j < d;j++) {
+                pt.coords[j] = sndr_point_ctxs[idx*d+j] ^ prng.get<uint32_t>();
+            }
+
+            intersec.push_back(pt);
+            if (matched != nullptr) matched->push_back((uint32_t) (i / twotod));
+        }
+
+    }
+
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "./ZN.h"
+#include "../CustomOPRF/CustomizedOPRF.h"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace sparse_comp {
+
+    // Input independent part of a SpX send: the OPRF instances of both directions, the sender output shares of the
+    // SpBSOT (h) and BlockSpBSOT (z) runs and the random masks of the z message vectors. A bundle is filled by
+    // preprocess and consumed by a single online call; it is large for big sets, so allocate it on the heap.
+    template<size_t t, size_t k, uint64_t M>
+    struct SenderOfflineBundle {
+        std::vector<sparse_comp::custom_oprf::Sender*> oprfSenders;
+        std::vector<sparse_comp::custom_oprf::Receiver*> oprfReceivers;
+        std::array<std::array<ZN<M>,k>,t> h_shares;
+        std::array<std::array<block,1>,t> z_shares;
+        std::array<block,t> z_masks;
+        bool ready = false;
+
+        void sample(PRNG& prng) {
+            ZN<M>::template sample<t,k>(prng, this->h_shares);
+
+            for (size_t i=0;i < t;i++) {
+                this->z_shares[i][0] = prng.get<block>();
+                this->z_masks[i] = prng.get<block>();
+            }
+        }
+
+        // OPRF instances handed to an online run are owned by its SpBSOT sender/receiver, the rest are released here.
+        ~SenderOfflineBundle() {
+            for (auto oprfSender : this->oprfSenders) delete oprfSender;
+            for (auto oprfReceiver : this->oprfReceivers) delete oprfReceiver;
+        }
+    };
+
+    // Input independent part of a SpX receive: the OPRF instances of both directions.
+    struct ReceiverOfflineBundle {
+        std::vector<sparse_comp::custom_oprf::Sender*> oprfSenders;
+        std::vector<sparse_comp::custom_oprf::Receiver*> oprfReceivers;
+        bool ready = false;
+
+        ~ReceiverOfflineBundle() {
+            for (auto oprfSender : this->oprfSenders) delete oprfSender;
+            for (auto oprfReceiver : this->oprfReceivers) delete oprfReceiver;
+        }
+    };
+
+};
@@ -0,0 +1,193 @@
+#include "./PointFile.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+    constexpr char POINTS_MAGIC[8] = {'S','P','C','P','N','T','S','\0'};
+    constexpr char RESULTS_MAGIC[8] = {'S','P','C','R','S','L','T','\0'};
+
+    constexpr size_t RESULT_BUFFER_BYTES = size_t(1) << 20;
+
+    // Header of both kinds of files; count is the number of points or of records
+    struct file_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t d;
+        uint64_t count;
+        uint64_t reserved;
+    };
+
+    static_assert(sizeof(file_header) == 32, "the header must keep the coordinates aligned");
+
+    file_header make_header(const char (&magic)[8], uint32_t version, size_t d, uint64_t count) {
+        file_header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, magic, sizeof(header.magic));
+        header.version = version;
+        header.d = (uint32_t) d;
+        header.count = count;
+
+        return header;
+    }
+
+    // Checks the header of a mapped file and returns it
+    const file_header& check_header(const sparse_comp::MappedFile& mapping, const char (&magic)[8], uint32_t version, const std::string& path) {
+        if (mapping.size() < sizeof(file_header)) throw std::runtime_error("malformed file " + path);
+
+        const file_header& header = *(const file_header*) mapping.data();
+
+        if (std::memcmp(header.magic, magic, sizeof(header.magic)) != 0 || header.version != version ||
+            header.d == 0 || header.d > sparse_comp::point::MAX_DIM) {
+            throw std::runtime_error("malformed file " + path);
+        }
+
+        return header;
+    }
+
+    void check_dimension(size_t d) {
+        if (d == 0 || d > sparse_comp::point::MAX_DIM) throw std::invalid_argument("d must be between 1 and " + std::to_string(sparse_comp::point::MAX_DIM));
+    }
+
+}
+
+sparse_comp::PointFile::PointFile(const std::string& path) {
+    this->mapping = std::make_unique<MappedFile>(path);
+
+    const file_header& header = check_header(*(this->mapping), POINTS_MAGIC, VERSION, path);
+
+    const size_t point_size = header.d * sizeof(uint32_t);
+
+    if ((this->mapping->size() - sizeof(file_header)) / point_size != header.count ||
+        (this->mapping->size() - sizeof(file_header)) % point_size != 0) {
+        throw std::runtime_error("malformed file " + path);
+    }
+
+    const uint32_t* coords = (const uint32_t*) ((const uint8_t*) this->mapping->data() + sizeof(file_header));
+
+    this->columns = PointColumns(coords, header.d, header.count);
+}
+
+void sparse_comp::write_point_file(const std::string& path, std::span<const point> points, size_t d) {
+    check_dimension(d);
+
+    const file_header header = make_header(POINTS_MAGIC, PointFile::VERSION, d, points.size());
+    std::vector<uint32_t> coords(points.size() * d);
+
+    for (size_t j = 0; j < d; j++) {
+        for (size_t i = 0; i < points.size(); i++) coords[j * points.size() + i] = points[i][j];
+    }
+
+    sparse_comp::write_file_atomically(path, {{&header, sizeof(header)}, {coords.data(), coords.size() * sizeof(uint32_t)}});
+}
+
+sparse_comp::ResultWriter::ResultWriter(const std::string& path, size_t d) : path(path), dim(d) {
+    check_dimension(d);
+
+    this->fd = ::open((path + ".tmp").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (this->fd < 0) throw std::runtime_error("could not create " + path + ".tmp");
+
+    this->buffer.resize(RESULT_BUFFER_BYTES);
+
+    // The header is written on close, once the number of records is known
+    this->used = sizeof(file_header);
+}
+
+sparse_comp::ResultWriter::~ResultWriter() {
+    if (this->fd >= 0) {
+        ::close(this->fd);
+        std::remove((this->path + ".tmp").c_str());
+    }
+}
+
+void sparse_comp::ResultWriter::flush() {
+    const uint8_t* data = this->buffer.data();
+    size_t togo = this->used;
+
+    while (togo > 0) {
+        ssize_t written = ::write(this->fd, data, togo);
+
+        if (written < 0) throw std::runtime_error("could not write " + this->path + ".tmp");
+
+        data += written;
+        togo -= (size_t) written;
+    }
+
+    this->used = 0;
+}
+
+void sparse_comp::ResultWriter::write(uint64_t index, const point& pt) {
+    const size_t record_size = sizeof(uint64_t) + this->dim * sizeof(uint32_t);
+
+    if (this->fd < 0) throw std::runtime_error("the result file " + this->path + " is already closed");
+    if (this->used + record_size > this->buffer.size()) this->flush();
+
+    std::memcpy(this->buffer.data() + this->used, &index, sizeof(uint64_t));
+    std::memcpy(this->buffer.data() + this->used + sizeof(uint64_t), pt.coords, this->dim * sizeof(uint32_t));
+
+    this->used += record_size;
+    this->count++;
+}
+
+void sparse_comp::ResultWriter::close() {
+    if (this->fd < 0) throw std::runtime_error("the result file " + this->path + " is already closed");
+
+    this->flush();
+
+    const file_header header = make_header(RESULTS_MAGIC, VERSION, this->dim, this->count);
+
+    if (::pwrite(this->fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header) || ::fsync(this->fd) != 0) {
+        throw std::runtime_error("could not write " + this->path + ".tmp");
+    }
+
+    const int fd = this->fd;
+    this->fd = -1;
+
+    if (::close(fd) != 0) throw std::runtime_error("could not sync " + this->path + ".tmp");
+
+    if (std::rename((this->path + ".tmp").c_str(), this->path.c_str()) != 0) {
+        throw std::runtime_error("could not rename " + this->path + ".tmp to " + this->path);
+    }
+}
+
+sparse_comp::ResultFile::ResultFile(const std::string& path) {
+    this->mapping = std::make_unique<MappedFile>(path);
+
+    const file_header& header = check_header(*(this->mapping), RESULTS_MAGIC, ResultWriter::VERSION, path);
+    const size_t record_size = sizeof(uint64_t) + header.d * sizeof(uint32_t);
+
+    if ((this->mapping->size() - sizeof(file_header)) / record_size != header.count ||
+        (this->mapping->size() - sizeof(file_header)) % record_size != 0) {
+        throw std::runtime_error("malformed file " + path);
+    }
+
+    this->dim = header.d;
+    this->count = header.count;
+}
+
+const uint8_t* sparse_comp::ResultFile::record(size_t i) const {
+    return (const uint8_t*) this->mapping->data() + sizeof(file_header) + i * (sizeof(uint64_t) + this->dim * sizeof(uint32_t));
+}
+
+uint64_t sparse_comp::ResultFile::index(size_t i) const {
+    uint64_t index;
+    std::memcpy(&index, this->record(i), sizeof(uint64_t));
+
+    return index;
+}
+
+sparse_comp::point sparse_comp::ResultFile::operator[](size_t i) const {
+    point pt;
+    pt.coord_dim = (uint8_t) this->dim;
+
+    // Records are not 8 bytes aligned for odd d
+    std::memcpy(pt.coords, this->record(i) + sizeof(uint64_t), this->dim * sizeof(uint32_t));
+
+    return pt;
+}
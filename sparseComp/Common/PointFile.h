@@ -0,0 +1,131 @@
+#pragma once
+
+#include "./Common.h"
+#include "./FileUtils.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+// Binary files of point sets and of intersections, for sets too large to go through intermediate formats.
+//
+// A point file holds a 32 byte header (the magic "SPCPNTS", the version, d and the number of points n), then
+// the coordinates column by column: the n first coordinates, then the n second ones, and so on, as 4 byte
+// integers in the byte order of the host. It is mapped rather than read, and its points are accessed in place
+// through a PointColumns view, which the batched mode takes instead of a span (see FuzzyBatch.h).
+//
+// A result file holds a 32 byte header (the magic "SPCRSLT", the version, d and the number of records), then
+// one record per match: the index of the matching receiver point as an 8 byte integer, then the d coordinates
+// of the sender point. ResultWriter appends the records as the matches are found and only keeps a bounded
+// buffer in memory.
+
+namespace sparse_comp {
+
+    // Non owning view of the coordinates of n points of dimension d, stored column by column.
+    class PointColumns {
+        private:
+            const uint32_t* coords = nullptr;
+            size_t dim = 0;
+            size_t count = 0;
+
+        public:
+            PointColumns() = default;
+            PointColumns(const uint32_t* coords, size_t d, size_t n) : coords(coords), dim(d), count(n) {}
+
+            size_t dimension() const { return this->dim; }
+            size_t size() const { return this->count; }
+
+            // The j-th coordinates of all the points
+            const uint32_t* column(size_t j) const { return this->coords + j * this->count; }
+
+            point operator[](size_t i) const {
+                point pt;
+                pt.coord_dim = (uint8_t) this->dim;
+
+                for (size_t j = 0; j < this->dim; j++) pt.coords[j] = this->coords[j * this->count + i];
+
+                return pt;
+            }
+    };
+
+    class PointFile {
+        private:
+            std::unique_ptr<MappedFile> mapping;
+            PointColumns columns;
+
+        public:
+            static constexpr uint32_t VERSION = 1;
+
+            // Maps the file at path. Throws std::runtime_error if it is missing or malformed, of another version
+            // or of dimension 0 or above point::MAX_DIM.
+            explicit PointFile(const std::string& path);
+
+            size_t dimension() const { return this->columns.dimension(); }
+            size_t size() const { return this->columns.size(); }
+
+            // Valid as long as the file object lives
+            const PointColumns& points() const { return this->columns; }
+    };
+
+    // Writes the first d coordinates of points to a point file at path, atomically. It holds a copy of the
+    // coordinates while writing. Throws std::invalid_argument if d is 0 or above point::MAX_DIM, and
+    // std::runtime_error if the file cannot be written.
+    void write_point_file(const std::string& path, std::span<const point> points, size_t d);
+
+    // Streams the records of a result file. The records go to path + ".tmp", which close renames over path
+    // once they are complete; a writer destroyed before close removes it.
+    class ResultWriter {
+        private:
+            std::string path;
+            int fd = -1;
+            size_t dim;
+            uint64_t count = 0;
+            std::vector<uint8_t> buffer;
+            size_t used = 0;
+
+            void flush();
+
+        public:
+            static constexpr uint32_t VERSION = 1;
+
+            // Throws std::invalid_argument if d is 0 or above point::MAX_DIM, and std::runtime_error if the file
+            // cannot be created.
+            ResultWriter(const std::string& path, size_t d);
+            ~ResultWriter();
+
+            ResultWriter(const ResultWriter&) = delete;
+            ResultWriter& operator=(const ResultWriter&) = delete;
+
+            // Appends a record for the sender point pt, found within delta of the receiver point of index index.
+            // Throws std::runtime_error on a write failure.
+            void write(uint64_t index, const point& pt);
+
+            uint64_t records() const { return this->count; }
+
+            // Writes the header and the remaining records, syncs the file and renames it over path.
+            void close();
+    };
+
+    // Mapped result file, e.g. for checking the output of ResultWriter.
+    class ResultFile {
+        private:
+            std::unique_ptr<MappedFile> mapping;
+            size_t dim = 0;
+            size_t count = 0;
+
+            const uint8_t* record(size_t i) const;
+
+        public:
+            // Throws std::runtime_error if the file is missing or malformed, or of another version.
+            explicit ResultFile(const std::string& path);
+
+            size_t dimension() const { return this->dim; }
+            size_t size() const { return this->count; }
+
+            uint64_t index(size_t i) const;
+            point operator[](size_t i) const;
+    };
+
+};
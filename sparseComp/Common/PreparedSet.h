@@ -0,0 +1,220 @@
+#pragma once
+
+#include "./Common.h"
+#include "./FileUtils.h"
+#include "./HashUtils.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "cryptoTools/Common/block.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Input only preprocessing of the Fuzzy PSI protocols (L1, L2 and L_inf), for sets used in many sessions.
+//
+// A sender set is prepared into the spatial hashes of its points (the SpX indices and the keys of the index
+// OKVS) and their coordinates as SpX inputs; a receiver set into the spatial hashes of the 2^d cells around
+// each point and the coordinates of the point repeated for each of its cells. They only depend on the points,
+// delta and the public AES key. The protocols only read a prepared set, so concurrent sessions may share it.
+//
+// A prepared set can be saved to a file and mapped back: a 64 byte header (the magic "SPCPREP", the version,
+// the role, the number of points, d, delta, the size of a point and a fingerprint of the AES key), then the
+// hashes (16 bytes each), the points and the SpX inputs (d 4 bytes coordinates per hash), in the byte order of
+// the host. The points and the SpX inputs are used in place from the mapping; only the hashes are copied.
+
+namespace sparse_comp::fuzzy {
+
+    enum class PreparedRole : uint32_t { Sender = 1, Receiver = 2 };
+
+    namespace detail {
+
+        inline constexpr char PREPARED_MAGIC[8] = {'S','P','C','P','R','E','P','\0'};
+
+        struct prepared_header {
+            char magic[8];
+            uint32_t version;
+            uint32_t role;
+            uint64_t point_count;
+            uint32_t d;
+            uint32_t delta;
+            uint32_t point_size;
+            uint32_t reserved0;
+            uint64_t aes_check[2];
+            uint8_t reserved[8];
+        };
+
+        static_assert(sizeof(prepared_header) == 64, "the prepared set header must keep the hashes 16 bytes aligned");
+
+        // Hashes computed under another key would silently match nothing, so the files record which key they used
+        inline block aes_fingerprint(const osuCrypto::AES& aes) {
+            return aes.hashBlock(block(0, 0));
+        }
+
+    }
+
+    template<PreparedRole role, size_t t, size_t d>
+    class PreparedSet {
+        public:
+            static constexpr uint32_t VERSION = 1;
+
+            // Number of hashes and SpX inputs: one per point for the sender, one per cell for the receiver
+            static constexpr size_t rows = role == PreparedRole::Sender ? t : int_pow(2, d) * t;
+
+            using Points = std::array<point,t>;
+            using InValues = std::array<std::array<uint32_t,d>,rows>;
+
+        private:
+            uint8_t set_delta = 0;
+            block aes_check;
+            std::vector<block> hash_values;
+            Points* point_values = nullptr;
+            InValues* input_values = nullptr;
+
+            // Either the buffers of a set prepared in memory, or the mapping of a saved one
+            std::unique_ptr<Points> owned_points;
+            std::unique_ptr<InValues> owned_in_values;
+            std::unique_ptr<sparse_comp::MappedFile> mapping;
+
+            PreparedSet() = default;
+
+        public:
+            // Prepares points; it is large for big sets, so allocate it on the heap.
+            PreparedSet(const osuCrypto::AES& aes, const Points& points, uint8_t delta);
+
+            PreparedSet(const PreparedSet&) = delete;
+            PreparedSet& operator=(const PreparedSet&) = delete;
+
+            // Maps the set saved at path. Throws std::runtime_error if the file is missing, malformed, of another
+            // version, or was prepared for another role, size, d, delta or AES key.
+            static std::unique_ptr<PreparedSet> open(const std::string& path, const osuCrypto::AES& aes, uint8_t delta);
+
+            // Writes the set to path, atomically. Throws std::runtime_error on failure.
+            void save(const std::string& path) const;
+
+            uint8_t delta() const { return this->set_delta; }
+
+            // The accessors return mutable references for the protocols, which only read them
+            Points& points() { return *(this->point_values); }
+            std::vector<block>& hashes() { return this->hash_values; }
+            InValues& in_values() { return *(this->input_values); }
+    };
+
+    template<size_t ts, size_t d>
+    using PreparedSenderSet = PreparedSet<PreparedRole::Sender, ts, d>;
+
+    template<size_t tr, size_t d>
+    using PreparedReceiverSet = PreparedSet<PreparedRole::Receiver, tr, d>;
+
+    inline void check_prepared_delta(uint8_t prepared_delta, uint8_t delta) {
+        if (prepared_delta != delta) throw std::invalid_argument("the set was prepared for another delta");
+    }
+
+    template<PreparedRole role, size_t t, size_t d>
+    PreparedSet<role,t,d>::PreparedSet(const osuCrypto::AES& aes, const Points& points, uint8_t delta) {
+        static_assert(d <= point::MAX_DIM);
+
+        this->set_delta = delta;
+        this->aes_check = detail::aes_fingerprint(aes);
+
+        this->owned_points = std::make_unique<Points>(points);
+        this->owned_in_values = std::make_unique<InValues>();
+        this->point_values = this->owned_points.get();
+        this->input_values = this->owned_in_values.get();
+
+        if constexpr (role == PreparedRole::Sender) {
+            // Maps points to cells using spatial hashing
+            sparse_comp::spatial_hash<t>(aes, *(this->point_values), this->hash_values, d, delta);
+
+            for (size_t i = 0; i < t; i++) {
+                for (size_t j = 0; j < d; j++) {
+                    (*(this->input_values))[i][j] = points[i].coords[j];
+                }
+            }
+        } else {
+            constexpr size_t twotod = int_pow(2, d);
+
+            // Maps points to adjacent cells using spatial hashing
+            this->hash_values.resize(rows);
+            sparse_comp::spatial_cell_hash<t,d,rows>(aes, *(this->point_values), this->hash_values, delta);
+
+            for (size_t i = 0; i < t; i++) {
+                for (size_t j = 0; j < twotod; j++) {
+                    for (size_t k = 0; k < d; k++) {
+                        (*(this->input_values))[twotod*i+j][k] = points[i].coords[k];
+                    }
+                }
+            }
+        }
+    }
+
+    template<PreparedRole role, size_t t, size_t d>
+    std::unique_ptr<PreparedSet<role,t,d>> PreparedSet<role,t,d>::open(const std::string& path, const osuCrypto::AES& aes, uint8_t delta) {
+        constexpr size_t hashes_size = rows * sizeof(block);
+        constexpr size_t points_size = sizeof(Points);
+        constexpr size_t in_values_size = sizeof(InValues);
+
+        static_assert(alignof(Points) <= 16 && alignof(InValues) <= 16 && (hashes_size + points_size) % alignof(InValues) == 0);
+
+        std::unique_ptr<PreparedSet> prepared(new PreparedSet());
+        prepared->mapping = std::make_unique<sparse_comp::MappedFile>(path);
+
+        const sparse_comp::MappedFile& mapping = *(prepared->mapping);
+
+        if (mapping.size() != sizeof(detail::prepared_header) + hashes_size + points_size + in_values_size) {
+            throw std::runtime_error("malformed or mismatching prepared set " + path);
+        }
+
+        const detail::prepared_header* header = (const detail::prepared_header*) mapping.data();
+        const block aes_check = detail::aes_fingerprint(aes);
+
+        if (std::memcmp(header->magic, detail::PREPARED_MAGIC, sizeof(detail::PREPARED_MAGIC)) != 0 || header->version != VERSION ||
+            header->role != (uint32_t) role || header->point_count != t || header->d != d || header->point_size != sizeof(point)) {
+            throw std::runtime_error("malformed or mismatching prepared set " + path);
+        }
+
+        if (header->delta != delta) throw std::runtime_error("the prepared set " + path + " was prepared for another delta");
+
+        if (header->aes_check[0] != aes_check.get<uint64_t>(0) || header->aes_check[1] != aes_check.get<uint64_t>(1)) {
+            throw std::runtime_error("the prepared set " + path + " was prepared under another AES key");
+        }
+
+        const uint8_t* sections = (const uint8_t*) mapping.data() + sizeof(detail::prepared_header);
+
+        prepared->set_delta = delta;
+        prepared->aes_check = aes_check;
+
+        // The SpX and OKVS code takes the hashes as a vector
+        prepared->hash_values.resize(rows);
+        std::memcpy(prepared->hash_values.data(), sections, hashes_size);
+
+        // The mapping is read only; the protocols never write to these
+        prepared->point_values = (Points*) (sections + hashes_size);
+        prepared->input_values = (InValues*) (sections + hashes_size + points_size);
+
+        return prepared;
+    }
+
+    template<PreparedRole role, size_t t, size_t d>
+    void PreparedSet<role,t,d>::save(const std::string& path) const {
+        detail::prepared_header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, detail::PREPARED_MAGIC, sizeof(detail::PREPARED_MAGIC));
+        header.version = VERSION;
+        header.role = (uint32_t) role;
+        header.point_count = t;
+        header.d = d;
+        header.delta = this->set_delta;
+        header.point_size = sizeof(point);
+        header.aes_check[0] = this->aes_check.get<uint64_t>(0);
+        header.aes_check[1] = this->aes_check.get<uint64_t>(1);
+
+        sparse_comp::write_file_atomically(path, {{&header, sizeof(header)},
+                                                  {this->hash_values.data(), rows * sizeof(block)},
+                                                  {this->point_values, sizeof(Points)},
+                                                  {this->input_values, sizeof(InValues)}});
+    }
+
+};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "coproto/Socket/Socket.h"
+#include "./CommStats.h"
+#include "./Trace.h"
 #include <vector>
 #include <cmath>
 #include <span>
@@ -29,15 +31,14 @@ namespace sparse_comp {
             n_items_togo = v.size();
             n_items_sent = 0;
 
-            /*std::cout << "(s) max_item_per_round: " << max_item_per_round << std::endl;
-            std::cout << "(s) n_items_togo: " << n_items_togo << std::endl;
-            std::cout << "(s) sizeof(T): " << sizeof(T) << std::endl;*/
-
             while (n_items_togo > 0) {
                 send_size = std::min(max_item_per_round, n_items_togo);
                 send_span = v_span.subspan(n_items_sent, send_size);
 
+                sparse_comp::comm::note_send(sock);
+                SPARSE_COMP_TRACE_BEGIN(sock, "net.send");
                 MC_AWAIT(sock.send(send_span));
+                SPARSE_COMP_TRACE_END(sock, "net.send");
 
                 n_items_togo -= send_size;
                 n_items_sent += send_size;
@@ -67,20 +68,14 @@ namespace sparse_comp {
         n_items_togo = v.size();
         n_items_sent = 0;
 
-        /*std::cout << "(r) recv_vec_size: " << recv_vec_size << std::endl;
-        std::cout << "(r) max_items_per_round: " << max_items_per_round << std::endl;
-        std::cout << "(r) n_items_togo: " << n_items_togo << std::endl;
-        std::cout << "(r) sizeof(T): " << sizeof(T) << std::endl;
-        std::cout << "(r) num_rounds: " << num_rounds << std::endl;*/
-
         for (i = 0; i < num_rounds; i++) {
             n_items_recv = std::min(max_items_per_round, n_items_togo);
             recv_span = v_span.subspan(n_items_sent, n_items_recv);
 
-            //std::cout << "before recv" << std::endl;
+            sparse_comp::comm::note_recv(sock);
+            SPARSE_COMP_TRACE_BEGIN(sock, "net.recv");
             MC_AWAIT(sock.recv(recv_span));
-            //std::cout << "after recv" << std::endl;
-            
+            SPARSE_COMP_TRACE_END(sock, "net.recv");
 
             n_items_togo -= n_items_recv;
             n_items_sent += n_items_recv;
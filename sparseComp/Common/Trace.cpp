@@ -0,0 +1,242 @@
+#include "./Trace.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    constexpr size_t RING_CAPACITY = size_t(1) << 16;
+
+    struct trace_event {
+        const void* track;
+        const char* name;
+        uint64_t start_ns;
+        uint64_t end_ns;
+    };
+
+    // One per recording thread. The owning thread is the only writer; the mutex is only ever contended
+    // while a trace is being exported or cleared.
+    struct trace_ring {
+        std::mutex mtx;
+        std::vector<trace_event> events;
+        size_t next = 0;
+        uint32_t tid = 0;
+    };
+
+    std::mutex rings_mtx;
+    std::vector<std::shared_ptr<trace_ring>> rings; // Kept after their thread exits, so their spans can still be exported
+
+    std::mutex open_spans_mtx;
+    std::map<std::pair<const void*, std::string>, std::vector<uint64_t>> open_spans;
+
+    thread_local const void* innermost_track = nullptr;
+
+    std::array<std::atomic<sparse_comp::trace::SpanObserver*>, sparse_comp::trace::MAX_SPAN_OBSERVERS> span_observers{};
+
+    const uint64_t epoch_ns = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    trace_ring& local_ring() {
+        thread_local std::shared_ptr<trace_ring> ring;
+
+        if (!ring) {
+            ring = std::make_shared<trace_ring>();
+            ring->events.reserve(RING_CAPACITY);
+
+            std::lock_guard<std::mutex> lock(rings_mtx);
+            ring->tid = (uint32_t) rings.size() + 1;
+            rings.push_back(ring);
+        }
+
+        return *ring;
+    }
+
+    void write_json_string(FILE* f, const char* str) {
+        std::fputc('"', f);
+
+        for (const char* c = str; *c != '\0'; c++) {
+            if (*c == '"' || *c == '\\') std::fputc('\\', f);
+            std::fputc(*c, f);
+        }
+
+        std::fputc('"', f);
+    }
+
+};
+
+uint64_t sparse_comp::trace::now_ns() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() - epoch_ns;
+}
+
+const void* sparse_comp::trace::current_track() {
+    return innermost_track;
+}
+
+sparse_comp::trace::Span::Span(const void* track, const char* name) : track(track), parent_track(innermost_track), name(name), start_ns(now_ns()) {
+    innermost_track = track;
+
+    if (track != nullptr) {
+        for (auto& slot : span_observers) {
+            SpanObserver* observer = slot.load(std::memory_order_acquire);
+            if (observer != nullptr) observer->span_begin(track, name);
+        }
+    }
+}
+
+sparse_comp::trace::Span::~Span() {
+    const uint64_t end_ns = now_ns();
+
+    if (this->track != nullptr) {
+        for (size_t i = span_observers.size(); i-- > 0;) {
+            SpanObserver* observer = span_observers[i].load(std::memory_order_acquire);
+            if (observer != nullptr) observer->span_end(this->track, this->name);
+        }
+    }
+
+    record(this->track, this->name, this->start_ns, end_ns);
+    innermost_track = this->parent_track;
+}
+
+void sparse_comp::trace::add_span_observer(SpanObserver* observer) {
+    for (auto& slot : span_observers) {
+        SpanObserver* expected = nullptr;
+        if (slot.compare_exchange_strong(expected, observer, std::memory_order_acq_rel)) return;
+    }
+
+    throw std::logic_error("too many span observers");
+}
+
+void sparse_comp::trace::remove_span_observer(SpanObserver* observer) {
+    for (auto& slot : span_observers) {
+        SpanObserver* expected = observer;
+        slot.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+    }
+}
+
+void sparse_comp::trace::record(const void* track, const char* name, uint64_t start_ns, uint64_t end_ns) {
+    if (track == nullptr) return;
+
+    trace_ring& ring = local_ring();
+    std::lock_guard<std::mutex> lock(ring.mtx);
+
+    if (ring.events.size() < RING_CAPACITY) {
+        ring.events.push_back(trace_event{track, name, start_ns, end_ns});
+    } else {
+        ring.events[ring.next] = trace_event{track, name, start_ns, end_ns};
+    }
+
+    ring.next = (ring.next + 1) % RING_CAPACITY;
+}
+
+void sparse_comp::trace::begin(const void* track, const char* name) {
+    const uint64_t start_ns = now_ns();
+
+    std::lock_guard<std::mutex> lock(open_spans_mtx);
+    open_spans[{track, name}].push_back(start_ns);
+}
+
+void sparse_comp::trace::end(const void* track, const char* name) {
+    const uint64_t end_ns = now_ns();
+    uint64_t start_ns = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(open_spans_mtx);
+
+        auto it = open_spans.find({track, name});
+        if (it == open_spans.end() || it->second.empty()) throw std::logic_error(std::string("trace span ") + name + " ended without being started");
+
+        start_ns = it->second.back();
+        it->second.pop_back();
+
+        if (it->second.empty()) open_spans.erase(it);
+    }
+
+    record(track, name, start_ns, end_ns);
+}
+
+size_t sparse_comp::trace::write_chrome_json(const void* track, const std::string& path, const std::string& process_name) {
+    std::vector<std::pair<uint32_t, trace_event>> events;
+
+    {
+        std::lock_guard<std::mutex> lock(rings_mtx);
+
+        for (auto& ring : rings) {
+            std::lock_guard<std::mutex> ring_lock(ring->mtx);
+
+            for (auto& event : ring->events) {
+                if (event.track == track) events.emplace_back(ring->tid, event);
+            }
+        }
+    }
+
+    // Perfetto nests complete events by containment, which requires parents before their children
+    std::sort(events.begin(), events.end(), [](const auto& a, const auto& b) {
+        return a.second.start_ns != b.second.start_ns ? a.second.start_ns < b.second.start_ns : a.second.end_ns > b.second.end_ns;
+    });
+
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (f == nullptr) throw std::runtime_error("could not create trace file " + path);
+
+    std::fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    std::fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":");
+    write_json_string(f, process_name.c_str());
+    std::fprintf(f, "}}");
+
+    for (auto& [tid, event] : events) {
+        std::fprintf(f, ",\n{\"name\":");
+        write_json_string(f, event.name);
+        std::fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                     tid, event.start_ns / 1000.0, (event.end_ns - event.start_ns) / 1000.0);
+    }
+
+    std::fprintf(f, "\n]}\n");
+
+    if (std::fclose(f) != 0) throw std::runtime_error("could not write trace file " + path);
+
+    return events.size();
+}
+
+std::map<std::string, sparse_comp::trace::SpanTotal> sparse_comp::trace::totals(const void* track) {
+    std::map<std::string, SpanTotal> totals;
+
+    std::lock_guard<std::mutex> lock(rings_mtx);
+
+    for (auto& ring : rings) {
+        std::lock_guard<std::mutex> ring_lock(ring->mtx);
+
+        for (auto& event : ring->events) {
+            if (event.track != track) continue;
+
+            SpanTotal& total = totals[event.name];
+            total.ns += event.end_ns - event.start_ns;
+            total.count++;
+        }
+    }
+
+    return totals;
+}
+
+void sparse_comp::trace::clear(const void* track) {
+    std::lock_guard<std::mutex> lock(rings_mtx);
+
+    for (auto& ring : rings) {
+        std::lock_guard<std::mutex> ring_lock(ring->mtx);
+
+        std::vector<trace_event> kept;
+        kept.reserve(RING_CAPACITY);
+
+        for (auto& event : ring->events) {
+            if (event.track != track) kept.push_back(event);
+        }
+
+        ring->events = std::move(kept);
+        ring->next = ring->events.size() % RING_CAPACITY;
+    }
+}
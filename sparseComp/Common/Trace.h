@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+// Phase tracing. Trace points are spans recorded in thread local ring buffers with nanosecond timestamps and
+// exported as Chrome trace-event JSON (viewable in Perfetto or chrome://tracing). Every span belongs to a track,
+// which is the socket of the party running it, so each party of a run gets its own trace file even when both
+// run in the same thread. Trace points are compiled only with SPARSE_COMP_ENABLE_TRACING (cmake
+// -DSPARSE_COMP_TRACING=ON); otherwise the macros below expand to nothing.
+//
+// SPARSE_COMP_TRACE_SCOPE(sock, "name") times the enclosing block; it must not span an MC_AWAIT. Spans that
+// cover awaited steps use SPARSE_COMP_TRACE_BEGIN(sock, "name") and SPARSE_COMP_TRACE_END(sock, "name") instead.
+// Code without a socket at hand uses SPARSE_COMP_TRACE_NESTED("name"), which records on the track of the
+// innermost scope open on the calling thread, and nothing when there is none.
+
+namespace sparse_comp::trace {
+
+    uint64_t now_ns();
+
+    // Track of the innermost Span alive on the calling thread, nullptr if there is none.
+    const void* current_track();
+
+    // Records a completed span of track; spans without a track are dropped.
+    void record(const void* track, const char* name, uint64_t start_ns, uint64_t end_ns);
+
+    // Opens / closes a span of track by name; spans of the same name and track nest.
+    void begin(const void* track, const char* name);
+    void end(const void* track, const char* name);
+
+    // Writes the spans recorded on track as a trace-event JSON file named after process_name.
+    // Returns the number of spans written; spans overwritten in a full ring buffer are lost.
+    size_t write_chrome_json(const void* track, const std::string& path, const std::string& process_name);
+
+    // Drops the spans recorded on track.
+    void clear(const void* track);
+
+    struct SpanTotal {
+        uint64_t ns = 0;
+        uint64_t count = 0;
+
+        SpanTotal& operator+=(const SpanTotal& other) {
+            this->ns += other.ns;
+            this->count += other.count;
+            return *this;
+        }
+    };
+
+    // Total duration and number of the spans recorded on track, by span name. Nested spans of the same name
+    // are each counted.
+    std::map<std::string, SpanTotal> totals(const void* track);
+
+    // Notified on the running thread whenever a Span with a track opens and closes. Spans opened with begin/end
+    // are not reported, as they may be interleaved with other work of the same thread. The benchmarks use it to
+    // attach hardware counters and memory accounting to phases.
+    struct SpanObserver {
+        virtual ~SpanObserver() = default;
+        virtual void span_begin(const void* track, const char* name) = 0;
+        virtual void span_end(const void* track, const char* name) = 0;
+    };
+
+    // Installs / removes an observer. Up to MAX_SPAN_OBSERVERS can be installed at the same time; they see
+    // span_begin in installation order and span_end in reverse order.
+    constexpr size_t MAX_SPAN_OBSERVERS = 4;
+    void add_span_observer(SpanObserver* observer);
+    void remove_span_observer(SpanObserver* observer);
+
+    constexpr bool enabled() {
+#ifdef SPARSE_COMP_ENABLE_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    class Span {
+        private:
+            const void* track;
+            const void* parent_track;
+            const char* name;
+            uint64_t start_ns;
+
+        public:
+            Span(const void* track, const char* name);
+            ~Span();
+
+            Span(const Span&) = delete;
+            Span& operator=(const Span&) = delete;
+    };
+
+};
+
+#define SPARSE_COMP_TRACE_CONCAT_(a, b) a##b
+#define SPARSE_COMP_TRACE_CONCAT(a, b) SPARSE_COMP_TRACE_CONCAT_(a, b)
+
+#ifdef SPARSE_COMP_ENABLE_TRACING
+#define SPARSE_COMP_TRACE_SCOPE(sock, name) sparse_comp::trace::Span SPARSE_COMP_TRACE_CONCAT(trace_span_, __LINE__)(&(sock), name)
+#define SPARSE_COMP_TRACE_BEGIN(sock, name) sparse_comp::trace::begin(&(sock), name)
+#define SPARSE_COMP_TRACE_END(sock, name) sparse_comp::trace::end(&(sock), name)
+#define SPARSE_COMP_TRACE_NESTED(name) sparse_comp::trace::Span SPARSE_COMP_TRACE_CONCAT(trace_span_, __LINE__)(sparse_comp::trace::current_track(), name)
+#else
+#define SPARSE_COMP_TRACE_SCOPE(sock, name) ((void) 0)
+#define SPARSE_COMP_TRACE_BEGIN(sock, name) ((void) 0)
+#define SPARSE_COMP_TRACE_END(sock, name) ((void) 0)
+#define SPARSE_COMP_TRACE_NESTED(name) ((void) 0)
+#endif
@@ -4,6 +4,8 @@
 #include "cryptoTools/Common/block.h"
 #include "../Common/HashUtils.h"
 #include "../Common/Common.h"
+#include "../Common/CommStats.h"
+#include "../Common/Trace.h"
 #include <vector>
 #include <iostream>
 
@@ -12,43 +14,115 @@ using PRNG = osuCrypto::PRNG;
 using oprf_point = sparse_comp::custom_oprf::oprf_point;
 using MultiOprfRecvr = sparse_comp::multi_oprf::Receiver;
 using MultiOprfSender = sparse_comp::multi_oprf::Sender;
+using OprfBackend = sparse_comp::custom_oprf::OprfBackend;
+using RsOprfSender = volePSI::RsOprfSender;
+using RsOprfReceiver = volePSI::RsOprfReceiver;
 
 
 template<typename T>
 using vector = std::vector<T>;
 
-Proto sparse_comp::custom_oprf::Sender::setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Sender*>& senders) {
-    MC_BEGIN(Proto, &sock, &prng, num_instances, &senders,
+Proto sparse_comp::custom_oprf::Sender::setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Sender*>& senders, sparse_comp::multi_oprf::OtExtConfig otExt, OprfBackend backend) {
+    MC_BEGIN(Proto, &sock, &prng, num_instances, &senders, otExt, backend,
              oprfSenders = (std::vector<MultiOprfSender*>*) nullptr,
              i = (size_t) 0);
     
-        oprfSenders = new std::vector<MultiOprfSender*>(num_instances);
+        if (backend == OprfBackend::RsOprf) { // The VOLE is generated at query time, nothing to exchange here
+            for(i=0;i < num_instances;i++) {
+                senders[i] = new Sender(new RsOprfSender(), prng.get<block>());
+            }
+        } else {
+            oprfSenders = new std::vector<MultiOprfSender*>(num_instances);
 
-        MC_AWAIT(MultiOprfSender::setup(sock, prng, num_instances, *oprfSenders));
+            MC_AWAIT(MultiOprfSender::setup(sock, prng, num_instances, *oprfSenders, otExt));
 
-        for(i=0;i < num_instances;i++) {
-            senders[i] = new Sender(oprfSenders->at(i));
-        } 
+            for(i=0;i < num_instances;i++) {
+                senders[i] = new Sender(oprfSenders->at(i));
+            } 
 
-        delete oprfSenders;
+            delete oprfSenders;
+        }
 
     MC_END();
 }
 
-Proto sparse_comp::custom_oprf::Receiver::setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Receiver*>& receivers) {
-    MC_BEGIN(Proto, &sock, &prng, num_instances, &receivers,
+Proto sparse_comp::custom_oprf::Receiver::setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Receiver*>& receivers, sparse_comp::multi_oprf::OtExtConfig otExt, OprfBackend backend) {
+    MC_BEGIN(Proto, &sock, &prng, num_instances, &receivers, otExt, backend,
              oprfReceivers = (std::vector<MultiOprfRecvr*>*) nullptr,
              i = (size_t) 0);
     
+        if (backend == OprfBackend::RsOprf) {
+            for(i=0;i < num_instances;i++) {
+                receivers[i] = new Receiver(new RsOprfReceiver(), prng.get<block>());
+            }
+        } else {
+            oprfReceivers = new std::vector<MultiOprfRecvr*>(num_instances);
+            // std::vector<MultiOprfRecvr*> oprfReceivers(num_instances);
+
+            MC_AWAIT(MultiOprfRecvr::setup(sock, prng, num_instances, *oprfReceivers, otExt));
+
+            for(i=0;i < num_instances;i++) {
+                receivers[i] = new Receiver(oprfReceivers->at(i));
+            } 
+
+            delete oprfReceivers;
+        }
+
+    MC_END();
+}
+
+Proto sparse_comp::custom_oprf::setup_session(coproto::Socket& sock, PRNG& prng, bool is_leader, size_t num_instances, std::vector<Sender*>& senders, std::vector<Receiver*>& receivers, sparse_comp::multi_oprf::OtExtConfig otExt, OprfBackend backend) {
+    MC_BEGIN(Proto, &sock, &prng, is_leader, num_instances, &senders, &receivers, otExt, backend,
+             oprfSenders = (std::vector<MultiOprfSender*>*) nullptr,
+             oprfReceivers = (std::vector<MultiOprfRecvr*>*) nullptr,
+             i = (size_t) 0);
+
+        senders.resize(num_instances);
+        receivers.resize(num_instances);
+
+        if (backend == OprfBackend::RsOprf) {
+            for(i=0;i < num_instances;i++) {
+                senders[i] = new Sender(new RsOprfSender(), prng.get<block>());
+                receivers[i] = new Receiver(new RsOprfReceiver(), prng.get<block>());
+            }
+        } else {
+            oprfSenders = new std::vector<MultiOprfSender*>(num_instances);
+            oprfReceivers = new std::vector<MultiOprfRecvr*>(num_instances);
+
+            MC_AWAIT(sparse_comp::multi_oprf::setup_session(sock, prng, is_leader, num_instances, *oprfSenders, *oprfReceivers, otExt));
+
+            for(i=0;i < num_instances;i++) {
+                senders[i] = new Sender(oprfSenders->at(i));
+                receivers[i] = new Receiver(oprfReceivers->at(i));
+            }
+
+            delete oprfSenders;
+            delete oprfReceivers;
+        }
+
+    MC_END();
+}
+
+Proto sparse_comp::custom_oprf::setup_session(coproto::Socket& sock, sparse_comp::multi_oprf::OtPool& pool, size_t num_instances, std::vector<Sender*>& senders, std::vector<Receiver*>& receivers) {
+    MC_BEGIN(Proto, &sock, &pool, num_instances, &senders, &receivers,
+             oprfSenders = (std::vector<MultiOprfSender*>*) nullptr,
+             oprfReceivers = (std::vector<MultiOprfRecvr*>*) nullptr,
+             i = (size_t) 0);
+
+        oprfSenders = new std::vector<MultiOprfSender*>(num_instances);
         oprfReceivers = new std::vector<MultiOprfRecvr*>(num_instances);
-        // std::vector<MultiOprfRecvr*> oprfReceivers(num_instances);
 
-        MC_AWAIT(MultiOprfRecvr::setup(sock, prng, num_instances, *oprfReceivers));
+        MC_AWAIT(sparse_comp::multi_oprf::setup_session(sock, pool, num_instances, *oprfSenders, *oprfReceivers));
+
+        senders.resize(num_instances);
+        receivers.resize(num_instances);
 
         for(i=0;i < num_instances;i++) {
+            senders[i] = new Sender(oprfSenders->at(i));
             receivers[i] = new Receiver(oprfReceivers->at(i));
-        } 
+        }
 
+        delete oprfSenders;
         delete oprfReceivers;
 
     MC_END();
@@ -70,18 +144,43 @@ sparse_comp::custom_oprf::Sender::Sender(MultiOprfSender* oprfSender) {
     this->oprfSender = oprfSender;
 }
 
+sparse_comp::custom_oprf::Sender::Sender(RsOprfSender* rsOprfSender, block seed) {
+    this->rsOprfSender = rsOprfSender;
+    this->prng.SetSeed(seed);
+}
+
 sparse_comp::custom_oprf::Sender::~Sender() {
     delete (this->oprfSender);
+    delete (this->rsOprfSender);
 }
 
 Proto sparse_comp::custom_oprf::Sender::send(coproto::Socket& sock, uint_fast32_t n) {
-    MC_BEGIN(Proto, this, &sock, n);
-
-    MC_AWAIT(this->oprfSender->send(sock, n));
+    MC_BEGIN(Proto, this, &sock, n,
+             scope = (sparse_comp::comm::CommScope*) nullptr);
+
+    if (this->rsOprfSender != nullptr) {
+        scope = new sparse_comp::comm::CommScope(sock, "rs_oprf");
+        SPARSE_COMP_TRACE_BEGIN(sock, "rs_oprf");
+        MC_AWAIT(this->rsOprfSender->send(n, this->prng, sock));
+        SPARSE_COMP_TRACE_END(sock, "rs_oprf");
+        delete scope;
+    } else {
+        MC_AWAIT(this->oprfSender->send(sock, n));
+    }
 
     MC_END();
 }
 
+void sparse_comp::custom_oprf::Sender::eval_digests(vector<block>& point_digests, vector<block>& out) {
+    SPARSE_COMP_TRACE_NESTED("oprf.eval");
+
+    if (this->rsOprfSender != nullptr) {
+        this->rsOprfSender->eval(point_digests, out);
+    } else {
+        this->oprfSender->eval(point_digests, out);
+    }
+}
+
 void sparse_comp::custom_oprf::Sender::eval(block& pointHash, size_t k, size_t n, VecMatrix<block>& out) {
     vector<block> point_digests(k*n);
     vector<block> rsOprfOut(k*n);
@@ -97,7 +196,7 @@ void sparse_comp::custom_oprf::Sender::eval(block& pointHash, size_t k, size_t n
 
     }
 
-    this->oprfSender->eval(point_digests, rsOprfOut);
+    this->eval_digests(point_digests, rsOprfOut);
 
     g = 0;
     for (size_t i=0;i < k;i++) {
@@ -120,7 +219,7 @@ void sparse_comp::custom_oprf::Sender::eval(block& pointHash, size_t k, vector<b
         point_digests[i] = encode_point_as_block(Sender::aes, pointHash, i, 0);
     }
 
-    this->oprfSender->eval(point_digests, out);
+    this->eval_digests(point_digests, out);
 
 }
 
@@ -136,11 +235,7 @@ void sparse_comp::custom_oprf::Sender::eval(vector<block>& pointHashes, size_t k
 
     }
 
-    //auto start = std::chrono::high_resolution_clock::now();
-    this->oprfSender->eval(point_digests, out);
-    //auto end = std::chrono::high_resolution_clock::now();
-    //std::chrono::duration<double> elapsed = end - start;
-    //std::cout << "Time taken to execute oprfSender.eval: " << elapsed.count() << " seconds" << std::endl;
+    this->eval_digests(point_digests, out);
 }
 
 
@@ -148,14 +243,21 @@ sparse_comp::custom_oprf::Receiver::Receiver(MultiOprfRecvr* oprfRecvr) {
     this->oprfRecvr = oprfRecvr;
 }
 
+sparse_comp::custom_oprf::Receiver::Receiver(RsOprfReceiver* rsOprfRecvr, block seed) {
+    this->rsOprfRecvr = rsOprfRecvr;
+    this->prng.SetSeed(seed);
+}
+
 sparse_comp::custom_oprf::Receiver::~Receiver() {
     delete (this->oprfRecvr);
+    delete (this->rsOprfRecvr);
 }
 
 Proto sparse_comp::custom_oprf::Receiver::receive(coproto::Socket& sock, uint32_t n, vector<oprf_point>& points, vector<block>& outs) {
     MC_BEGIN(Proto, this, &sock, n, &points, &outs,    
     i = (size_t) 0,
-    point_digests = vector<block>(n)
+    point_digests = vector<block>(n),
+    scope = (sparse_comp::comm::CommScope*) nullptr
     );
 
         i = 0;
@@ -164,7 +266,15 @@ Proto sparse_comp::custom_oprf::Receiver::receive(coproto::Socket& sock, uint32_
             i++;
         }
 
-        MC_AWAIT(this->oprfRecvr->receive(sock, point_digests, outs));
+        if (this->rsOprfRecvr != nullptr) {
+            scope = new sparse_comp::comm::CommScope(sock, "rs_oprf");
+            SPARSE_COMP_TRACE_BEGIN(sock, "rs_oprf");
+            MC_AWAIT(this->rsOprfRecvr->receive(point_digests, outs, this->prng, sock));
+            SPARSE_COMP_TRACE_END(sock, "rs_oprf");
+            delete scope;
+        } else {
+            MC_AWAIT(this->oprfRecvr->receive(sock, point_digests, outs));
+        }
      
     MC_END();
 }
@@ -4,6 +4,8 @@
 #include "../Common/VecMatrix.h"
 #include "../Common/ZN.h"
 #include "../MultiOPRF/MultiOPRF.h"
+#include "../MultiOPRF/OtPool.h"
+#include "volePSI/RsOprf.h"
 #include "coproto/Socket/Socket.h"
 #include "cryptoTools/Crypto/AES.h"
 #include "cryptoTools/Crypto/PRNG.h"
@@ -36,16 +38,41 @@ namespace sparse_comp::custom_oprf {
         }
     };
 
+    // OPRF construction behind Sender/Receiver. MultiOprf is the OT based multi_oprf construction, whose
+    // queries cost a 128 bit Baxos OKVS per point and 128 AES calls per evaluated item. RsOprf is volePSI's
+    // silent VOLE OPRF: setup is local and each query run generates its own VOLE correlation, which trades
+    // the OT extension traffic of the setup and the OKVS width for VOLE communication.
+    enum class OprfBackend {
+        MultiOprf,
+        RsOprf
+    };
+
+    class Sender;
+    class Receiver;
+
+    // Sets up both directions of a session over a single base OT phase, see multi_oprf::setup_session.
+    // With the RsOprf backend no setup messages are exchanged and otExt is ignored.
+    Proto setup_session(coproto::Socket& sock, PRNG& prng, bool is_leader, size_t num_instances, std::vector<Sender*>& senders, std::vector<Receiver*>& receivers, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), OprfBackend backend = OprfBackend::MultiOprf);
+    // Pool backed setup, only available with the MultiOprf backend.
+    Proto setup_session(coproto::Socket& sock, sparse_comp::multi_oprf::OtPool& pool, size_t num_instances, std::vector<Sender*>& senders, std::vector<Receiver*>& receivers);
+
     class Sender {
 
         private:
             inline static AES aes = AES(block(7,7));
-            MultiOprfSender* oprfSender;
+            MultiOprfSender* oprfSender = nullptr;
+            volePSI::RsOprfSender* rsOprfSender = nullptr;
+            PRNG prng;
 
             Sender(MultiOprfSender* oprfSender);
+            Sender(volePSI::RsOprfSender* rsOprfSender, block seed);
+
+            void eval_digests(std::vector<block>& point_digests, std::vector<block>& out);
             
         public:
-            static Proto setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Sender*>& senders);
+            static Proto setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Sender*>& senders, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), OprfBackend backend = OprfBackend::MultiOprf);
+            friend Proto setup_session(coproto::Socket& sock, PRNG& prng, bool is_leader, size_t num_instances, std::vector<Sender*>& senders, std::vector<Receiver*>& receivers, sparse_comp::multi_oprf::OtExtConfig otExt, OprfBackend backend);
+            friend Proto setup_session(coproto::Socket& sock, sparse_comp::multi_oprf::OtPool& pool, size_t num_instances, std::vector<Sender*>& senders, std::vector<Receiver*>& receivers);
             ~Sender();
 
             Proto send(coproto::Socket& sock, uint_fast32_t n);
@@ -59,12 +86,17 @@ namespace sparse_comp::custom_oprf {
 
         private:
             inline static AES aes = AES(block(7,7));
-            MultiOprfRecvr* oprfRecvr;
+            MultiOprfRecvr* oprfRecvr = nullptr;
+            volePSI::RsOprfReceiver* rsOprfRecvr = nullptr;
+            PRNG prng;
 
             Receiver(MultiOprfRecvr* oprfRecvr);
+            Receiver(volePSI::RsOprfReceiver* rsOprfRecvr, block seed);
 
         public:
-            static Proto setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Receiver*>& receivers);
+            static Proto setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Receiver*>& receivers, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), OprfBackend backend = OprfBackend::MultiOprf);
+            friend Proto setup_session(coproto::Socket& sock, PRNG& prng, bool is_leader, size_t num_instances, std::vector<Sender*>& senders, std::vector<Receiver*>& receivers, sparse_comp::multi_oprf::OtExtConfig otExt, OprfBackend backend);
+            friend Proto setup_session(coproto::Socket& sock, sparse_comp::multi_oprf::OtPool& pool, size_t num_instances, std::vector<Sender*>& senders, std::vector<Receiver*>& receivers);
             ~Receiver();
 
             Proto receive(coproto::Socket& sock, uint32_t n, std::vector<oprf_point>& points, std::vector<block>& outs);
@@ -0,0 +1,423 @@
+#include "./FuzzyBatch.h"
+#include "../Common/Common.h"
+#include "../Common/PointFile.h"
+#include "../Common/SockUtils.h"
+#include "../Common/CommStats.h"
+#include "../Common/Trace.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using Proto = coproto::task<void>;
+
+namespace sparse_comp::fuzzy_batch::detail {
+
+    constexpr uint64_t COORD_RANGE = (uint64_t) 1 << 32;
+
+    inline size_t slab_of(uint64_t x, size_t slabs) {
+        return (size_t) ((x * slabs) >> 32);
+    }
+
+    // Smallest first coordinate of slab s; slab_lo(slabs, slabs) is the end of the coordinate range.
+    inline uint64_t slab_lo(size_t s, size_t slabs) {
+        return (((uint64_t) s << 32) + slabs - 1) / slabs;
+    }
+
+    inline uint32_t first_coordinate(std::span<const point> points, size_t i) {
+        return points[i][0];
+    }
+
+    // Only reads the first column, rather than gathering every point
+    inline uint32_t first_coordinate(const sparse_comp::PointColumns& points, size_t i) {
+        return points.column(0)[i];
+    }
+
+    template<size_t d>
+    void check_dimension(std::span<const point>) {}
+
+    template<size_t d>
+    void check_dimension(const sparse_comp::PointColumns& points) {
+        if (points.dimension() != d) {
+            throw std::invalid_argument("points of dimension " + std::to_string(points.dimension()) + " given for d = " + std::to_string(d));
+        }
+    }
+
+    // Indices of the points of each slab. A point also goes to the slabs that the window of the given radius
+    // around its first coordinate reaches.
+    template<typename Points>
+    void partition(const Points& points, size_t slabs, uint64_t radius, std::vector<std::vector<uint32_t>>& members) {
+        members.assign(slabs, std::vector<uint32_t>());
+
+        for (size_t i = 0; i < points.size(); i++) {
+            const uint64_t x = first_coordinate(points, i);
+            const size_t first = slab_of(x >= radius ? x - radius : 0, slabs);
+            const size_t last = slab_of(std::min(x + radius, COORD_RANGE - 1), slabs);
+
+            for (size_t s = first; s <= last; s++) members[s].push_back((uint32_t) i);
+        }
+    }
+
+    inline void chunk_counts(const std::vector<std::vector<uint32_t>>& members, size_t capacity, std::vector<uint32_t>& chunks) {
+        chunks.resize(members.size());
+
+        for (size_t s = 0; s < members.size(); s++) chunks[s] = (uint32_t) ((members[s].size() + capacity - 1) / capacity);
+    }
+
+    // Length of the first coordinate range holding the dummy points of a batch. Dummy receiver and sender
+    // points alternate along it, 4*delta+1 apart.
+    template<size_t max_capacity, uint8_t delta>
+    constexpr uint64_t dummy_span() {
+        return 2 * (4 * (uint64_t) delta + 1) * max_capacity;
+    }
+
+    // First coordinate of the first dummy point of slab s. The dummy range is placed above the slab if there
+    // is room for it, below otherwise, more than 4*delta away from the receiver points of the slab (which
+    // reach delta beyond it) and at least 2*delta away from the ends of the coordinate range.
+    template<size_t max_capacity, uint8_t delta>
+    uint64_t dummy_base(size_t s, size_t slabs) {
+        // One side of any slab has at least 2^31 - slab width / 2 >= 2^30 coordinates of room.
+        static_assert(dummy_span<max_capacity, delta>() + 7 * (uint64_t) delta + 3 <= ((uint64_t) 1 << 30),
+                      "batch capacities too large to place the dummy points");
+
+        const uint64_t above = slab_lo(s + 1, slabs) + 5 * (uint64_t) delta + 1;
+
+        if (above + dummy_span<max_capacity, delta>() + 2 * (uint64_t) delta < COORD_RANGE) return above;
+
+        return slab_lo(s, slabs) - 5 * (uint64_t) delta - 1 - dummy_span<max_capacity, delta>();
+    }
+
+    // Fills batch with the given chunk of the points of slab s, then with dummy points. Returns the number
+    // of points of the chunk.
+    template<size_t capacity, size_t max_capacity, size_t d, uint8_t delta, typename Points>
+    size_t fill_batch(const Points& points,
+                      const std::vector<uint32_t>& members,
+                      size_t chunk,
+                      size_t s,
+                      size_t slabs,
+                      bool is_receiver,
+                      std::array<point, capacity>& batch) {
+        const size_t begin = chunk * capacity;
+        const size_t count = std::min(capacity, members.size() - begin);
+
+        for (size_t k = 0; k < count; k++) {
+            batch[k] = points[members[begin + k]];
+        }
+
+        if (count == capacity) return count;
+
+        const uint64_t base = dummy_base<max_capacity, delta>(s, slabs);
+
+        for (size_t k = count; k < capacity; k++) {
+            batch[k] = point();
+            batch[k].coord_dim = (uint8_t) d;
+            batch[k][0] = (uint32_t) (base + (2 * k + (is_receiver ? 0 : 1)) * (4 * (uint64_t) delta + 1));
+
+            for (size_t j = 1; j < d; j++) batch[k][j] = (uint32_t) 1 << 31;
+        }
+
+        return count;
+    }
+
+    // Sorts intersec[begin, end) and drops repeated points: a sender point is found in every batch of a
+    // receiver chunk holding one of its matches.
+    template<size_t d>
+    void drop_repeated(std::vector<point>& intersec, size_t begin) {
+        auto less = [](const point& a, const point& b) {
+            return std::lexicographical_compare(a.coords, a.coords + d, b.coords, b.coords + d);
+        };
+        auto equal = [](const point& a, const point& b) {
+            return std::equal(a.coords, a.coords + d, b.coords);
+        };
+
+        std::sort(intersec.begin() + begin, intersec.end(), less);
+        intersec.erase(std::unique(intersec.begin() + begin, intersec.end(), equal), intersec.end());
+    }
+
+    // Number of batches the plan of own and peer chunks per slab runs
+    inline size_t batch_count(const std::vector<uint32_t>& own_chunks, const std::vector<uint32_t>& peer_chunks) {
+        size_t batches = 0;
+
+        for (size_t s = 0; s < own_chunks.size(); s++) batches += (size_t) own_chunks[s] * peer_chunks[s];
+
+        return batches;
+    }
+
+    // Whether the parties set up a pool of their own for the batches of a session: with the MultiOprf backend,
+    // no pool given and more than one batch to run.
+    inline bool needs_session_pool(const sparse_comp::multi_oprf::OtPool* otPool, sparse_comp::custom_oprf::OprfBackend oprfBackend, size_t batches) {
+        return otPool == nullptr && oprfBackend == sparse_comp::custom_oprf::OprfBackend::MultiOprf && batches > 1;
+    }
+
+    inline void check_budget(size_t btr, size_t bts, size_t d, size_t memory_budget) {
+        if (batch_memory_bytes(btr, bts, d) > memory_budget) {
+            throw std::invalid_argument("batches of " + std::to_string(btr) + " receiver and " + std::to_string(bts) +
+                                        " sender points need about " + std::to_string(batch_memory_bytes(btr, bts, d)) +
+                                        " bytes, over the memory budget of " + std::to_string(memory_budget));
+        }
+    }
+
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t btr, size_t bts, size_t d, uint8_t delta, uint8_t ssp>
+sparse_comp::fuzzy_batch::Sender<FuzzySender,btr,bts,d,delta,ssp>::Sender(
+                                                     osuCrypto::PRNG& prng,
+                                                     osuCrypto::AES& aes,
+                                                     size_t memory_budget,
+                                                     sparse_comp::multi_oprf::OtPool* otPool,
+                                                     sparse_comp::multi_oprf::OtExtConfig otExt,
+                                                     sparse_comp::custom_oprf::OprfBackend oprfBackend) {
+    sparse_comp::fuzzy_batch::detail::check_budget(btr, bts, d, memory_budget);
+
+    this->prng = &prng;
+    this->aes = &aes;
+    this->otPool = otPool;
+    this->otExt = otExt;
+    this->oprfBackend = oprfBackend;
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t btr, size_t bts, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::fuzzy_batch::Sender<FuzzySender,btr,bts,d,delta,ssp>::send(
+                                                     coproto::Socket& sock,
+                                                     std::span<const point> points) {
+    return this->run(sock, points);
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t btr, size_t bts, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::fuzzy_batch::Sender<FuzzySender,btr,bts,d,delta,ssp>::send(
+                                                     coproto::Socket& sock,
+                                                     sparse_comp::PointColumns points) {
+    return this->run(sock, points);
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t btr, size_t bts, size_t d, uint8_t delta, uint8_t ssp>
+template<typename Points>
+Proto sparse_comp::fuzzy_batch::Sender<FuzzySender,btr,bts,d,delta,ssp>::run(
+                                                     coproto::Socket& sock,
+                                                     Points points) {
+    MC_BEGIN(Proto, this, &sock, points,
+             sizes = std::vector<uint64_t>(1),
+             slabs = size_t(0),
+             members = std::vector<std::vector<uint32_t>>(),
+             own_chunks = std::vector<uint32_t>(),
+             peer_chunks = std::vector<uint32_t>(),
+             batch = (std::array<point,bts>*) nullptr,
+             fuzzySender = (FuzzySender<btr,bts,d,delta,ssp>*) nullptr,
+             sessionPool = (sparse_comp::multi_oprf::OtPool*) nullptr,
+             batches = size_t(0),
+             s = size_t(0),
+             rc = size_t(0),
+             sc = size_t(0),
+             prt = Proto(),
+             scope = (sparse_comp::comm::CommScope*) nullptr);
+
+        sparse_comp::fuzzy_batch::detail::check_dimension<d>(points);
+
+        scope = new sparse_comp::comm::CommScope(sock, "fuzzy_batch.plan");
+        SPARSE_COMP_TRACE_BEGIN(sock, "fuzzy_batch.plan");
+
+        sizes[0] = points.size();
+        prt = sparse_comp::send<uint64_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, sizes);
+        MC_AWAIT(prt);
+        prt = sparse_comp::receive<uint64_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, 1, sizes);
+        MC_AWAIT(prt);
+
+        slabs = sparse_comp::fuzzy_batch::slab_count(sizes[0], points.size(), btr, bts);
+
+        // Sender points only belong to the slab of their first coordinate
+        sparse_comp::fuzzy_batch::detail::partition(points, slabs, 0, members);
+        sparse_comp::fuzzy_batch::detail::chunk_counts(members, bts, own_chunks);
+
+        prt = sparse_comp::send<uint32_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, own_chunks);
+        MC_AWAIT(prt);
+        prt = sparse_comp::receive<uint32_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, slabs, peer_chunks);
+        MC_AWAIT(prt);
+
+        SPARSE_COMP_TRACE_END(sock, "fuzzy_batch.plan");
+        delete scope;
+
+        // One OT extension for all the batches rather than one per batch
+        batches = sparse_comp::fuzzy_batch::detail::batch_count(own_chunks, peer_chunks);
+
+        if (sparse_comp::fuzzy_batch::detail::needs_session_pool(this->otPool, this->oprfBackend, batches)) {
+            scope = new sparse_comp::comm::CommScope(sock, "fuzzy_batch.pool");
+            SPARSE_COMP_TRACE_BEGIN(sock, "fuzzy_batch.pool");
+
+            prt = sparse_comp::multi_oprf::OtPool::create_in_memory(sock, *(this->prng), true, batches * sparse_comp::multi_oprf::RUN_POOL_OTS, sessionPool, this->otExt);
+            MC_AWAIT(prt);
+
+            SPARSE_COMP_TRACE_END(sock, "fuzzy_batch.pool");
+            delete scope;
+        }
+
+        batch = new std::array<point,bts>();
+        fuzzySender = new FuzzySender<btr,bts,d,delta,ssp>(*(this->prng), *(this->aes), sessionPool != nullptr ? sessionPool : this->otPool, this->otExt, this->oprfBackend);
+
+        for (s = 0; s < slabs; s++) {
+            for (rc = 0; rc < peer_chunks[s]; rc++) {
+                for (sc = 0; sc < own_chunks[s]; sc++) {
+                    sparse_comp::fuzzy_batch::detail::fill_batch<bts,std::max(btr,bts),d,delta>(points, members[s], sc, s, slabs, false, *batch);
+
+                    SPARSE_COMP_TRACE_BEGIN(sock, "fuzzy_batch.batch");
+                    prt = fuzzySender->send(sock, *batch);
+                    MC_AWAIT(prt);
+                    SPARSE_COMP_TRACE_END(sock, "fuzzy_batch.batch");
+                }
+            }
+        }
+
+        delete fuzzySender;
+        delete sessionPool;
+        delete batch;
+
+    MC_END();
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+         size_t bts, size_t btr, size_t d, uint8_t delta, uint8_t ssp>
+sparse_comp::fuzzy_batch::Receiver<FuzzyReceiver,bts,btr,d,delta,ssp>::Receiver(
+                                                     osuCrypto::PRNG& prng,
+                                                     osuCrypto::AES& aes,
+                                                     size_t memory_budget,
+                                                     sparse_comp::multi_oprf::OtPool* otPool,
+                                                     sparse_comp::multi_oprf::OtExtConfig otExt,
+                                                     sparse_comp::custom_oprf::OprfBackend oprfBackend) {
+    sparse_comp::fuzzy_batch::detail::check_budget(btr, bts, d, memory_budget);
+
+    this->prng = &prng;
+    this->aes = &aes;
+    this->otPool = otPool;
+    this->otExt = otExt;
+    this->oprfBackend = oprfBackend;
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+         size_t bts, size_t btr, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::fuzzy_batch::Receiver<FuzzyReceiver,bts,btr,d,delta,ssp>::receive(
+                                                     coproto::Socket& sock,
+                                                     std::span<const point> points,
+                                                     std::vector<point>& intersec) {
+    MC_BEGIN(Proto, this, &sock, points, &intersec,
+             intersec_begin = intersec.size(),
+             prt = Proto());
+
+        prt = this->run(sock, points, [&intersec](uint64_t, const point& pt) { intersec.push_back(pt); });
+        MC_AWAIT(prt);
+
+        sparse_comp::fuzzy_batch::detail::drop_repeated<d>(intersec, intersec_begin);
+
+    MC_END();
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+         size_t bts, size_t btr, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::fuzzy_batch::Receiver<FuzzyReceiver,bts,btr,d,delta,ssp>::receive(
+                                                     coproto::Socket& sock,
+                                                     sparse_comp::PointColumns points,
+                                                     sparse_comp::ResultWriter& results) {
+    return this->run(sock, points, [&results](uint64_t index, const point& pt) { results.write(index, pt); });
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+         size_t bts, size_t btr, size_t d, uint8_t delta, uint8_t ssp>
+template<typename Points, typename Emit>
+Proto sparse_comp::fuzzy_batch::Receiver<FuzzyReceiver,bts,btr,d,delta,ssp>::run(
+                                                     coproto::Socket& sock,
+                                                     Points points,
+                                                     Emit emit) {
+    MC_BEGIN(Proto, this, &sock, points, emit,
+             sizes = std::vector<uint64_t>(1),
+             slabs = size_t(0),
+             members = std::vector<std::vector<uint32_t>>(),
+             own_chunks = std::vector<uint32_t>(),
+             peer_chunks = std::vector<uint32_t>(),
+             batch = (std::array<point,btr>*) nullptr,
+             fuzzyReceiver = (FuzzyReceiver<bts,btr,d,delta,ssp>*) nullptr,
+             sessionPool = (sparse_comp::multi_oprf::OtPool*) nullptr,
+             batches = size_t(0),
+             found = std::vector<point>(),
+             matched = std::vector<uint32_t>(),
+             count = size_t(0),
+             s = size_t(0),
+             rc = size_t(0),
+             sc = size_t(0),
+             prt = Proto(),
+             scope = (sparse_comp::comm::CommScope*) nullptr);
+
+        sparse_comp::fuzzy_batch::detail::check_dimension<d>(points);
+
+        scope = new sparse_comp::comm::CommScope(sock, "fuzzy_batch.plan");
+        SPARSE_COMP_TRACE_BEGIN(sock, "fuzzy_batch.plan");
+
+        prt = sparse_comp::receive<uint64_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, 1, sizes);
+        MC_AWAIT(prt);
+
+        slabs = sparse_comp::fuzzy_batch::slab_count(points.size(), sizes[0], btr, bts);
+
+        sizes[0] = points.size();
+        prt = sparse_comp::send<uint64_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, sizes);
+        MC_AWAIT(prt);
+
+        // Receiver points also go to the slabs their delta ball reaches, so that every match lies within a slab
+        sparse_comp::fuzzy_batch::detail::partition(points, slabs, delta, members);
+        sparse_comp::fuzzy_batch::detail::chunk_counts(members, btr, own_chunks);
+
+        prt = sparse_comp::receive<uint32_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, slabs, peer_chunks);
+        MC_AWAIT(prt);
+        prt = sparse_comp::send<uint32_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, own_chunks);
+        MC_AWAIT(prt);
+
+        SPARSE_COMP_TRACE_END(sock, "fuzzy_batch.plan");
+        delete scope;
+
+        // One OT extension for all the batches rather than one per batch
+        batches = sparse_comp::fuzzy_batch::detail::batch_count(own_chunks, peer_chunks);
+
+        if (sparse_comp::fuzzy_batch::detail::needs_session_pool(this->otPool, this->oprfBackend, batches)) {
+            scope = new sparse_comp::comm::CommScope(sock, "fuzzy_batch.pool");
+            SPARSE_COMP_TRACE_BEGIN(sock, "fuzzy_batch.pool");
+
+            prt = sparse_comp::multi_oprf::OtPool::create_in_memory(sock, *(this->prng), false, batches * sparse_comp::multi_oprf::RUN_POOL_OTS, sessionPool, this->otExt);
+            MC_AWAIT(prt);
+
+            SPARSE_COMP_TRACE_END(sock, "fuzzy_batch.pool");
+            delete scope;
+        }
+
+        batch = new std::array<point,btr>();
+        fuzzyReceiver = new FuzzyReceiver<bts,btr,d,delta,ssp>(*(this->prng), *(this->aes), sessionPool != nullptr ? sessionPool : this->otPool, this->otExt, this->oprfBackend);
+
+        for (s = 0; s < slabs; s++) {
+            for (rc = 0; rc < own_chunks[s]; rc++) {
+                for (sc = 0; sc < peer_chunks[s]; sc++) {
+                    count = sparse_comp::fuzzy_batch::detail::fill_batch<btr,std::max(btr,bts),d,delta>(points, members[s], rc, s, slabs, true, *batch);
+
+                    found.clear();
+                    matched.clear();
+
+                    SPARSE_COMP_TRACE_BEGIN(sock, "fuzzy_batch.batch");
+                    prt = fuzzyReceiver->receive(sock, *batch, found, &matched);
+                    MC_AWAIT(prt);
+                    SPARSE_COMP_TRACE_END(sock, "fuzzy_batch.batch");
+
+                    // Dummy receiver points match nothing; the others map back to their index in points
+                    for (size_t k = 0; k < found.size(); k++) {
+                        if (matched[k] < count) emit(members[s][rc * btr + matched[k]], found[k]);
+                    }
+                }
+            }
+        }
+
+        delete fuzzyReceiver;
+        delete sessionPool;
+        delete batch;
+
+    MC_END();
+}
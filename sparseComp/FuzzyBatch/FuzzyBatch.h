@@ -0,0 +1,130 @@
+#pragma once
+
+#include "coproto/Socket/Socket.h"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "../MultiOPRF/OtPool.h"
+#include "../CustomOPRF/CustomizedOPRF.h"
+#include "../Common/Common.h"
+#include "../Common/PointFile.h"
+#include "cryptoTools/Crypto/AES.h"
+#include <algorithm>
+#include <cstdint>
+#include <stddef.h>
+#include <span>
+#include <vector>
+#include <array>
+
+// Memory bounded mode of the Fuzzy PSI protocols (L1, L2 and L_inf), for sets too large for a single run.
+//
+// The protocols allocate their buffers for a fixed number of points: ts*d*256 ring elements and SpBSOT
+// matrix entries on the sender side, and 2^d*tr cells with their inputs, shares and OKVS on the receiver side.
+// Here the parties run the protocol given as FuzzySender/FuzzyReceiver repeatedly, over the same socket, on
+// batches of at most bts sender and btr receiver points, so that memory depends on the batch capacities
+// rather than on the set sizes.
+//
+// Batches are formed from a public partition of the first coordinate into slabs, whose number follows from
+// the set sizes, which the parties exchange. Each sender point belongs to the slab of its first coordinate;
+// a receiver point also goes to the neighbouring slabs that its delta ball reaches, so that every match lies
+// within one slab. The parties then exchange how many batches of their points each slab needs, and run one
+// batch for every pair of receiver and sender batches of the same slab. Batches are padded with dummy points
+// placed away from the slab, which match nothing. Besides the set sizes, this reveals to each party the
+// number of batches of the other party per slab, i.e. a coarse histogram of its first coordinates.
+//
+// All batches draw their OTs from a pool (see OtPool.h), so the base OTs and the OT extension are run once
+// rather than per batch: the OtPool given to the parties, or else one they set up in memory for the batches of
+// the session once the plan is known.
+//
+// The parties may also run on point files mapped in memory (see PointFile.h), whose coordinates the batches
+// are filled from in place, and the receiver may then write its matches to a result file as every batch
+// completes instead of collecting them.
+
+namespace sparse_comp::fuzzy_batch {
+
+    // Rough peak memory of one party running one batch of btr receiver and bts sender points, from the
+    // buffers that scale with them: 256 ring elements and SpBSOT matrix entries per sender point and
+    // dimension, and the inputs, shares and OKVS entries of the 2^d cells per receiver point. It is meant for
+    // choosing the batch capacities; the benchmarks report the actual peak RSS.
+    constexpr size_t batch_memory_bytes(size_t btr, size_t bts, size_t d) {
+        return bts * d * 256 * 32 + ((size_t) 1 << d) * btr * (d * 96 + 128);
+    }
+
+    // Largest power of two n such that batches of n receiver and n sender points fit in memory_budget
+    // according to batch_memory_bytes; 0 if none does.
+    constexpr size_t max_batch_capacity(size_t memory_budget, size_t d) {
+        size_t n = 0;
+
+        for (size_t c = 1; c <= ((size_t) 1 << 30) && batch_memory_bytes(c, c, d) <= memory_budget; c *= 2) n = c;
+
+        return n;
+    }
+
+    // Number of slabs for sets of tr receiver and ts sender points. The slabs are 1/4 larger than needed
+    // for uniform inputs, so that most of them fit in a single batch on both sides.
+    inline size_t slab_count(size_t tr, size_t ts, size_t btr, size_t bts) {
+        const size_t batches = std::max((tr + btr - 1) / btr, (ts + bts - 1) / bts);
+
+        return std::max<size_t>(2, (5 * batches + 3) / 4);
+    }
+
+    template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+             size_t btr, size_t bts, size_t d, uint8_t delta, uint8_t ssp>
+    class Sender {
+
+        osuCrypto::PRNG* prng;
+        osuCrypto::AES* aes;
+        sparse_comp::multi_oprf::OtPool* otPool;
+        sparse_comp::multi_oprf::OtExtConfig otExt;
+        sparse_comp::custom_oprf::OprfBackend oprfBackend;
+
+        template<typename Points>
+        coproto::task<void> run(coproto::Socket& sock, Points points);
+
+        public:
+            // Throws std::invalid_argument if batches of btr receiver and bts sender points do not fit in
+            // memory_budget bytes, as estimated by batch_memory_bytes. The other arguments are handed to
+            // FuzzySender for every batch; both parties must pass the same batch capacities.
+            Sender(osuCrypto::PRNG& prng, osuCrypto::AES& aes, size_t memory_budget, sparse_comp::multi_oprf::OtPool* otPool = nullptr, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf);
+
+            coproto::task<void> send(coproto::Socket& sock, std::span<const point> points);
+
+            // Same as send, on the points of a point file, which must stay mapped until the task completes.
+            // Throws std::invalid_argument if they are not of dimension d.
+            coproto::task<void> send(coproto::Socket& sock, sparse_comp::PointColumns points);
+    };
+
+    template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+             size_t bts, size_t btr, size_t d, uint8_t delta, uint8_t ssp>
+    class Receiver {
+
+        osuCrypto::PRNG* prng;
+        osuCrypto::AES* aes;
+        sparse_comp::multi_oprf::OtPool* otPool;
+        sparse_comp::multi_oprf::OtExtConfig otExt;
+        sparse_comp::custom_oprf::OprfBackend oprfBackend;
+
+        // Runs the batches and calls emit(index, pt) for every sender point pt found within delta of the
+        // receiver point of the given index in points
+        template<typename Points, typename Emit>
+        coproto::task<void> run(coproto::Socket& sock, Points points, Emit emit);
+
+        public:
+            // Throws std::invalid_argument if batches of btr receiver and bts sender points do not fit in
+            // memory_budget bytes, as estimated by batch_memory_bytes. The other arguments are handed to
+            // FuzzyReceiver for every batch; both parties must pass the same batch capacities.
+            Receiver(osuCrypto::PRNG& prng, osuCrypto::AES& aes, size_t memory_budget, sparse_comp::multi_oprf::OtPool* otPool = nullptr, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf);
+
+            // Appends to intersec the sender points within delta of some point of points, each once.
+            coproto::task<void> receive(coproto::Socket& sock, std::span<const point> points, std::vector<point>& intersec);
+
+            // Same as receive, on the points of a point file, which must stay mapped until the task completes.
+            // Every batch writes its matches to results as it completes: one record per receiver point (its index
+            // in points) and sender point within delta of it, so unlike above a sender point appears once for
+            // every receiver point it matches. Throws std::invalid_argument if the points are not of dimension
+            // d; results is not closed.
+            coproto::task<void> receive(coproto::Socket& sock, sparse_comp::PointColumns points, sparse_comp::ResultWriter& results);
+    };
+
+}
+
+#include "./FuzzyBatch.cpp"
@@ -2,6 +2,10 @@
 #include "../SpL1/SpL1.h"
 #include "../Common/HashUtils.h"
 #include "../Common/Common.h"
+#include "../Common/FuzzyUtils.h"
+#include "../Common/PreparedSet.h"
+#include "../Common/CommStats.h"
+#include "../Common/Trace.h"
 #include <array>
 #include <cstdint>
 #include <iostream>
@@ -13,211 +17,146 @@ using SpL1Sender = sparse_comp::sp_l1::Sender<tr,t,d,delta,ssp>;
 template<size_t ts, size_t t, size_t d, uint8_t delta, uint8_t ssp>
 using SpL1Receiver = sparse_comp::sp_l1::Receiver<ts,t,d,delta,ssp>;
 
-template<size_t ts, size_t d>
-static void sndr_points_to_in_values(std::array<point,ts>& points, std::array<std::array<uint32_t,d>,ts>& in_values) {
-
-    for (size_t i = 0; i < ts; i++) {
-        for (size_t j = 0; j < d; j++) {
-            in_values[i][j] = points[i].coords[j];
-        }
-    }
-
-}
-
-template<size_t ts, size_t d, uint8_t ssp>
-void compute_final_encryped_points(AES& hash, 
-                                   array<point,ts>& sndr_points,
-                                   vector<block>& sndr_points_spthashs,
-                                   array<array<block,1>,ts>& z_vec_shares,
-                                   vector<block>& idx_okvs,
-                                   vector<block>& point_ctxs) {
-    static_assert(ts > 0 && d > 0);
-    static_assert(ssp <= 64,"ssp must be less or equal to 64");
-
-    vector<block> okvs_vals(ts);
-
-    sparse_comp::points_to_blocks<ts,d>(sndr_points, point_ctxs);
-    size_t pt_blk_cnt = sparse_comp::point_encoding_block_count(d);
-
-    for (size_t i=0;i < ts;i++) {
-        PRNG prng(z_vec_shares[i][0]);
-        block k0 = prng.get<block>();
-    
-        okvs_vals[i] = k0 ^ block((uint64_t) 0,(uint64_t) i);
-        
-        for (size_t j=0;j < pt_blk_cnt; j++) {
-            point_ctxs[i*pt_blk_cnt+j] = point_ctxs[i*pt_blk_cnt+j] ^ prng.get<block>();
-        }
-    }
-
-    Baxos paxos;
-    paxos.init(ts, sparse_comp::baxosBinSize(ts), 3, ssp, PaxosParam::GF128, oc::ZeroBlock);
-    
-    idx_okvs.resize(paxos.size());
-
-    paxos.solve<block>(sndr_points_spthashs, okvs_vals, idx_okvs, nullptr, 1);
-
-}
-
-template<size_t ts, size_t tr, size_t d, size_t cell_count, uint32_t ssp>
-void receiver_intersection(AES& hash, 
-                           array<point,tr>& rcver_points, 
-                           vector<block>& rcvr_cells,
-                           array<array<block,1>,cell_count>& rcvr_z_shares, 
-                           vector<block>& sndr_idx_okvs, 
-                           vector<block>& sndr_point_ctxs,
-                           vector<point>& intersec) {
-    constexpr const size_t twotod = (size_t) pow(2, d);
-    static_assert(cell_count == twotod * tr);
-    static_assert(ts > 0 && tr > 0);
-    static_assert(ssp <= 64,"ssp must be less or equal to 64");
-
-    size_t pt_blk_cnt = sparse_comp::point_encoding_block_count(d);
-    //vector<block> decoded_keys(cell_count);
-    vector<block> decoded_vals(cell_count);
-    
-    //for (size_t i=0;i < cell_count;i++) {
-    //    decoded_keys[i] = sparse_comp::hash_point(hash, rcvr_cells[i]);
-    //}
-
-    Baxos paxos;
-    paxos.init(ts, sparse_comp::baxosBinSize(ts), 3, ssp, PaxosParam::GF128, oc::ZeroBlock);
-    
-    paxos.decode<block>(rcvr_cells, decoded_vals, sndr_idx_okvs);
-
-    const block high_u64_msk = block(0xFFFFFFFFFFFFFFFFULL,0);
-
-    std::vector<block> dec_blocks(pt_blk_cnt);
-
-    for (size_t i=0;i < cell_count;i++) {
-        PRNG prng(rcvr_z_shares[i][0]);
-        block k0 = prng.get<block>();
-
-        block dec_okvs_val = decoded_vals[i] ^ k0;
-
-        if ((dec_okvs_val & high_u64_msk) != block(0,0)) continue;
-
-        size_t idx = (size_t) (reinterpret_cast<uint64_t*>(dec_okvs_val.data())[0]); 
+template<size_t tr, size_t t, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::fuzzy_l1::Sender<tr,t,d,delta,ssp>::send(
+                                                     Socket& sock, 
+                                                     array<point,t>& points) {
+    MC_BEGIN(Proto, this, &sock, &points, 
+             prepared = (sparse_comp::fuzzy::PreparedSenderSet<t,d>*) nullptr,
+             prt = Proto());
 
-        for (size_t j=0;j < pt_blk_cnt;j++) {
-            dec_blocks[j] = sndr_point_ctxs[idx*pt_blk_cnt+j] ^ prng.get<block>();
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "fuzzy.spatial_hash");
+            prepared = new sparse_comp::fuzzy::PreparedSenderSet<t,d>(*(this->aes), points, delta);
         }
 
-        point pt = sparse_comp::blocks_to_point<d>(dec_blocks);
+        prt = this->send(sock, *prepared);
+        MC_AWAIT(prt);
 
-        intersec.push_back(pt);
-    }
+        delete prepared;
 
+    MC_END();
 }
 
 template<size_t tr, size_t t, size_t d, uint8_t delta, uint8_t ssp>
 Proto sparse_comp::fuzzy_l1::Sender<tr,t,d,delta,ssp>::send(
                                                      Socket& sock, 
-                                                     array<point,t>& points) {
+                                                     sparse_comp::fuzzy::PreparedSenderSet<t,d>& prepared) {
     constexpr const size_t twotod = (size_t) pow(2, d);
     constexpr const size_t rcvr_cell_count = twotod * tr;
     
-    MC_BEGIN(Proto, this, &sock, &points, 
+    MC_BEGIN(Proto, this, &sock, &prepared, 
              spL1Sender = (SpL1Sender<rcvr_cell_count,t,d,delta,ssp>*) nullptr,
-             point_hashs = vector<block>(),
-             in_values = (array<array<uint32_t,d>,t>*) nullptr,
              out_vec_shares = (array<array<block,1>,t>*) nullptr,
-             idx_okvs = vector<block>(),
-             point_ctxs = vector<block>(),
-             prt = Proto());
-
-        spL1Sender = new SpL1Sender<rcvr_cell_count, t, d, delta, ssp>(*(this->prng), *(this->aes));
-        in_values = new array<array<uint32_t,d>,t>();
-        out_vec_shares = new array<array<block,1>,t>();
+             idx_okvs = vector<uint64_t>(),
+             point_ctxs = vector<uint32_t>(),
+             prt = Proto(),
+             scope = (sparse_comp::comm::CommScope*) nullptr);
 
-        // Maps points to cells using spatial hashing
-        sparse_comp::spatial_hash<t>(*(this->aes), points, point_hashs, d, delta);
+        sparse_comp::fuzzy::check_prepared_delta(prepared.delta(), delta);
 
-        // Maps points to in_values
-        sndr_points_to_in_values<t,d>(points, *in_values);
+        spL1Sender = new SpL1Sender<rcvr_cell_count, t, d, delta, ssp>(*(this->prng), *(this->aes), this->otPool, this->otExt, this->oprfBackend);
+        out_vec_shares = new array<array<block,1>,t>();
 
-        prt = spL1Sender->send(sock, point_hashs, *in_values, *out_vec_shares);
+        SPARSE_COMP_TRACE_BEGIN(sock, "fuzzy.spx");
+        prt = spL1Sender->send(sock, prepared.hashes(), prepared.in_values(), *out_vec_shares);
 
         MC_AWAIT(prt);
+        SPARSE_COMP_TRACE_END(sock, "fuzzy.spx");
+
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "fuzzy.encrypt_points");
+            sparse_comp::fuzzy::compute_final_encryped_points<t,d,ssp>(*(this->aes), prepared.points(), prepared.hashes(), *out_vec_shares, idx_okvs, point_ctxs);
+        }
 
-        compute_final_encryped_points<t,d,ssp>(*(this->aes), points, point_hashs, *out_vec_shares, idx_okvs, point_ctxs);
+        scope = new sparse_comp::comm::CommScope(sock, "fuzzy.finalize");
+        SPARSE_COMP_TRACE_BEGIN(sock, "fuzzy.finalize");
 
-        prt = sparse_comp::send<block,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, idx_okvs);
+        prt = sparse_comp::send<uint64_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, idx_okvs);
         MC_AWAIT(prt);
-        prt = sparse_comp::send<block,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, point_ctxs);
+        prt = sparse_comp::send<uint32_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, point_ctxs);
         MC_AWAIT(prt);
 
+        SPARSE_COMP_TRACE_END(sock, "fuzzy.finalize");
+        delete scope;
+
         delete spL1Sender;
-        delete in_values;
         delete out_vec_shares;
     
     MC_END();
 }
 
-template<size_t t, size_t d, size_t cell_count>
-static void rcvr_points_to_in_values(std::array<point, t>& point_center, std::array<std::array<uint32_t,d>, cell_count>& in_values) {
-        constexpr const size_t twotod = (size_t) pow(2, d);
-
-        static_assert(cell_count == twotod*t);
-        static_assert(d <= point::MAX_DIM);
+template<size_t ts, size_t t, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::fuzzy_l1::Receiver<ts,t,d,delta,ssp>::receive(
+                                                     Socket& sock, 
+                                                     array<point,t>& points,
+                                                     vector<point>& intersec,
+                                                     vector<uint32_t>* matched) {
+    MC_BEGIN(Proto, this, &sock, &points, &intersec, matched,
+             prepared = (sparse_comp::fuzzy::PreparedReceiverSet<t,d>*) nullptr,
+             prt = Proto());
 
-        for (size_t i = 0; i < t; i++) {
-            for (size_t j = 0; j < twotod; j++) {
-                for (size_t k = 0; k < d; k++) {
-                    in_values[twotod*i+j][k] = point_center[i].coords[k];
-                }
-            }
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "fuzzy.spatial_hash");
+            prepared = new sparse_comp::fuzzy::PreparedReceiverSet<t,d>(*(this->aes), points, delta);
         }
 
+        prt = this->receive(sock, *prepared, intersec, matched);
+        MC_AWAIT(prt);
+
+        delete prepared;
+
+    MC_END();
 }
 
 template<size_t ts, size_t t, size_t d, uint8_t delta, uint8_t ssp>
 Proto sparse_comp::fuzzy_l1::Receiver<ts,t,d,delta,ssp>::receive(
                                                      Socket& sock, 
-                                                     array<point,t>& points,
-                                                     vector<point>& intersec) {
+                                                     sparse_comp::fuzzy::PreparedReceiverSet<t,d>& prepared,
+                                                     vector<point>& intersec,
+                                                     vector<uint32_t>* matched) {
     constexpr const size_t twotod = (size_t) pow(2, d);
     constexpr const size_t cell_count = twotod * t;
+
+    static_assert(sparse_comp::fuzzy::PreparedReceiverSet<t,d>::rows == cell_count);
     
-    MC_BEGIN(Proto, this, &sock, &points, &intersec,
+    MC_BEGIN(Proto, this, &sock, &prepared, &intersec, matched,
              spL1Receiver = (SpL1Receiver<ts,cell_count,d,delta,ssp>*) nullptr,
-             cells = vector<block>(cell_count),
-             in_values = (array<array<uint32_t,d>,cell_count>*) nullptr,
              out_vec_shares = (array<array<block,1>,cell_count>*) nullptr,
-             idx_okvs = vector<block>(),
-             point_ctxs = vector<block>(),
-             paxos = Baxos(),
-             prt = Proto());
-
-        spL1Receiver = new SpL1Receiver<ts,cell_count,d,delta,ssp>(*(this->prng), *(this->aes));
-        in_values = new array<array<uint32_t,d>,cell_count>();
-        out_vec_shares = new array<array<block,1>,cell_count>();
+             idx_okvs = vector<uint64_t>(),
+             point_ctxs = vector<uint32_t>(),
+             prt = Proto(),
+             scope = (sparse_comp::comm::CommScope*) nullptr);
 
-        // Maps points to adjcent cells using spatial hashing
-        sparse_comp::spatial_cell_hash<t,d,cell_count>(*(this->aes), points, cells, delta);
+        sparse_comp::fuzzy::check_prepared_delta(prepared.delta(), delta);
 
-        // Maps points to in_values
-        rcvr_points_to_in_values<t,d,cell_count>(points, *in_values);
+        spL1Receiver = new SpL1Receiver<ts,cell_count,d,delta,ssp>(*(this->prng), *(this->aes), this->otPool, this->otExt, this->oprfBackend);
+        out_vec_shares = new array<array<block,1>,cell_count>();
 
-        prt = spL1Receiver->receive(sock, cells, *in_values, *out_vec_shares);
+        SPARSE_COMP_TRACE_BEGIN(sock, "fuzzy.spx");
+        prt = spL1Receiver->receive(sock, prepared.hashes(), prepared.in_values(), *out_vec_shares);
         MC_AWAIT(prt);
+        SPARSE_COMP_TRACE_END(sock, "fuzzy.spx");
 
-        paxos.init(ts, sparse_comp::baxosBinSize(ts), 3, ssp, PaxosParam::GF128, oc::ZeroBlock);
-        idx_okvs.resize(paxos.size());
+        scope = new sparse_comp::comm::CommScope(sock, "fuzzy.finalize");
+        SPARSE_COMP_TRACE_BEGIN(sock, "fuzzy.finalize");
 
-        point_ctxs.resize(ts*sparse_comp::point_encoding_block_count(d));
-
-        prt = sparse_comp::receive<block,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, idx_okvs.size(), idx_okvs);
+        prt = sparse_comp::receive<uint64_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, sparse_comp::fuzzy::idx_okvs_word_count<ts,ssp>(), idx_okvs);
         MC_AWAIT(prt);
 
-        prt = sparse_comp::receive<block,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, point_ctxs.size(), point_ctxs);
+        prt = sparse_comp::receive<uint32_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, sparse_comp::fuzzy::point_ctxs_count<ts,d>(), point_ctxs);
         MC_AWAIT(prt);
 
-        receiver_intersection<ts,t,d,cell_count,ssp>(*(this->aes), points, cells, *out_vec_shares, idx_okvs, point_ctxs, intersec);
+        SPARSE_COMP_TRACE_END(sock, "fuzzy.finalize");
+        delete scope;
+
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "fuzzy.intersection");
+            sparse_comp::fuzzy::receiver_intersection<ts,t,d,cell_count,ssp>(*(this->aes), prepared.points(), prepared.hashes(), *out_vec_shares, idx_okvs, point_ctxs, intersec, matched);
+        }
 
         delete spL1Receiver;
-        delete in_values;
         delete out_vec_shares;
 
     MC_END();
-}
\ No newline at end of file
+}
@@ -3,6 +3,9 @@
 #include "coproto/Socket/Socket.h"
 #include "cryptoTools/Crypto/PRNG.h"
 #include "cryptoTools/Common/block.h"
+#include "../MultiOPRF/OtPool.h"
+#include "../CustomOPRF/CustomizedOPRF.h"
+#include "../Common/PreparedSet.h"
 #include "cryptoTools/Crypto/AES.h"
 #include <cstdint>
 #include <stddef.h>
@@ -16,14 +19,25 @@ namespace sparse_comp::fuzzy_l1 {
 
         osuCrypto::PRNG* prng;
         osuCrypto::AES* aes;
+        sparse_comp::multi_oprf::OtPool* otPool;
+        sparse_comp::multi_oprf::OtExtConfig otExt;
+        sparse_comp::custom_oprf::OprfBackend oprfBackend;
             
         public:
-            Sender(osuCrypto::PRNG& prng, osuCrypto::AES& aes) {
+            // otPool, otExt and oprfBackend are handed to the SpL1 sender of every run.
+            Sender(osuCrypto::PRNG& prng, osuCrypto::AES& aes, sparse_comp::multi_oprf::OtPool* otPool = nullptr, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf) {
                 this->prng = &prng;
                 this->aes = &aes;
+                this->otPool = otPool;
+                this->otExt = otExt;
+                this->oprfBackend = oprfBackend;
             }
 
             coproto::task<void> send(coproto::Socket& sock, std::array<point,t>& points);
+
+            // Same as send, on a set prepared for the same delta. prepared is only read, so concurrent sessions
+            // may share it.
+            coproto::task<void> send(coproto::Socket& sock, sparse_comp::fuzzy::PreparedSenderSet<t,d>& prepared);
     };
 
     template<size_t ts, size_t t, size_t d, uint8_t delta, uint8_t ssp>
@@ -31,14 +45,27 @@ namespace sparse_comp::fuzzy_l1 {
 
         osuCrypto::PRNG* prng;
         osuCrypto::AES* aes;
+        sparse_comp::multi_oprf::OtPool* otPool;
+        sparse_comp::multi_oprf::OtExtConfig otExt;
+        sparse_comp::custom_oprf::OprfBackend oprfBackend;
             
         public:
-            Receiver(osuCrypto::PRNG& prng, osuCrypto::AES& aes) {
+            // otPool, otExt and oprfBackend are handed to the SpL1 receiver of every run.
+            Receiver(osuCrypto::PRNG& prng, osuCrypto::AES& aes, sparse_comp::multi_oprf::OtPool* otPool = nullptr, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf) {
                 this->prng = &prng;
                 this->aes = &aes;
+                this->otPool = otPool;
+                this->otExt = otExt;
+                this->oprfBackend = oprfBackend;
             }
             
-            coproto::task<void> receive(coproto::Socket& sock, std::array<point,t>& points, std::vector<point>& intersec);
+            // Appends to intersec the sender points within delta of some point of points. If matched is given, it
+            // gets the index in points of a receiver point within delta of each appended point.
+            coproto::task<void> receive(coproto::Socket& sock, std::array<point,t>& points, std::vector<point>& intersec, std::vector<uint32_t>* matched = nullptr);
+
+            // Same as receive, on a set prepared for the same delta. prepared is only read, so concurrent sessions
+            // may share it.
+            coproto::task<void> receive(coproto::Socket& sock, sparse_comp::fuzzy::PreparedReceiverSet<t,d>& prepared, std::vector<point>& intersec, std::vector<uint32_t>* matched = nullptr);
     };
 
 }
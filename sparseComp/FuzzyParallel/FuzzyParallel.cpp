@@ -0,0 +1,213 @@
+#include "./FuzzyParallel.h"
+#include "../FuzzyBatch/FuzzyBatch.h"
+#include "../Common/Common.h"
+#include "../Common/Trace.h"
+#include "macoro/thread_pool.h"
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+using Proto = coproto::task<void>;
+
+namespace sparse_comp::fuzzy_parallel::detail {
+
+    // Points of each partition. A point also goes to the partition of the other column that the window of
+    // the given radius around its first coordinate reaches; radius < 2^COLUMN_BITS, so there is at most one.
+    inline void partition(std::span<const point> points, size_t partitions, uint64_t radius, std::vector<std::vector<point>>& members) {
+        members.assign(partitions, std::vector<point>());
+
+        for (const point& p : points) {
+            const uint64_t x = p[0];
+            const uint64_t lo = x >= radius ? x - radius : 0;
+            const uint64_t hi = std::min<uint64_t>(x + radius, 0xFFFFFFFFULL);
+
+            const size_t first = column_partition(lo, partitions);
+            members[first].push_back(p);
+
+            if ((lo >> COLUMN_BITS) != (hi >> COLUMN_BITS)) {
+                const size_t second = column_partition(hi, partitions);
+                if (second != first) members[second].push_back(p);
+            }
+        }
+    }
+
+    // Moves proto to a thread of pool and runs it there, keeping its outcome in result.
+    inline Proto run_on(macoro::thread_pool& pool, Proto proto, macoro::result<void>& result) {
+        MC_BEGIN(Proto, &pool, proto = std::move(proto), &result);
+
+            MC_AWAIT(pool.schedule());
+            MC_AWAIT_SET(result, std::move(proto) | macoro::wrap());
+
+        MC_END();
+    }
+
+    // Rethrows the first failure among the partition outcomes.
+    inline void check_results(std::vector<macoro::result<void>>& results) {
+        for (auto& result : results) {
+            if (result.has_error()) std::rethrow_exception(result.error());
+        }
+    }
+
+    // Starts the pool threads on the first run rather than on construction, so that the parties can be created
+    // before the process forks (as the process mode of the benchmarks does).
+    inline void start_pool(std::unique_ptr<macoro::thread_pool>& pool, std::unique_ptr<macoro::thread_pool::work>& work, size_t threads) {
+        if (pool != nullptr) return;
+
+        pool = std::make_unique<macoro::thread_pool>();
+        work = std::make_unique<macoro::thread_pool::work>(pool->make_work());
+        pool->create_threads(threads);
+    }
+
+    inline void check_partitions(size_t partitions) {
+        if (partitions == 0) throw std::invalid_argument("the number of partitions must be positive");
+    }
+
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t btr, size_t bts, size_t d, uint8_t delta, uint8_t ssp>
+sparse_comp::fuzzy_parallel::Sender<FuzzySender,btr,bts,d,delta,ssp>::Sender(
+                                                     osuCrypto::PRNG& prng,
+                                                     osuCrypto::AES& aes,
+                                                     size_t partitions,
+                                                     size_t memory_budget,
+                                                     sparse_comp::multi_oprf::OtExtConfig otExt,
+                                                     sparse_comp::custom_oprf::OprfBackend oprfBackend) {
+    sparse_comp::fuzzy_parallel::detail::check_partitions(partitions);
+
+    this->partitions = partitions;
+
+    // The AES key is only read by the instances; each needs a PRNG of its own
+    for (size_t i = 0; i < partitions; i++) {
+        this->prngs.push_back(std::make_unique<osuCrypto::PRNG>(prng.get<osuCrypto::block>()));
+        this->instances.push_back(std::make_unique<sparse_comp::fuzzy_batch::Sender<FuzzySender,btr,bts,d,delta,ssp>>(
+            *(this->prngs[i]), aes, memory_budget / partitions, nullptr, otExt, oprfBackend));
+    }
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t btr, size_t bts, size_t d, uint8_t delta, uint8_t ssp>
+sparse_comp::fuzzy_parallel::Sender<FuzzySender,btr,bts,d,delta,ssp>::~Sender() {
+    // Lets the pool threads exit once idle; the pool joins them
+    this->work.reset();
+    this->pool.reset();
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t btr, size_t bts, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::fuzzy_parallel::Sender<FuzzySender,btr,bts,d,delta,ssp>::send(
+                                                     coproto::Socket& sock,
+                                                     std::span<const point> points) {
+    MC_BEGIN(Proto, this, &sock, points,
+             members = std::vector<std::vector<point>>(),
+             socks = std::vector<coproto::Socket>(),
+             tasks = std::vector<Proto>(),
+             results = std::vector<macoro::result<void>>(),
+             i = size_t(0));
+
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "fuzzy_parallel.partition");
+
+            // Sender points only belong to the partition of their column
+            sparse_comp::fuzzy_parallel::detail::partition(points, this->partitions, 0, members);
+        }
+
+        sparse_comp::fuzzy_parallel::detail::start_pool(this->pool, this->work, this->partitions);
+
+        // Both parties fork in the same order, so that the i-th sub-channels are paired
+        for (i = 0; i < this->partitions; i++) socks.push_back(sock.fork());
+
+        results.resize(this->partitions);
+
+        for (i = 0; i < this->partitions; i++) {
+            tasks.push_back(sparse_comp::fuzzy_parallel::detail::run_on(*(this->pool), this->instances[i]->send(socks[i], members[i]), results[i]));
+        }
+
+        SPARSE_COMP_TRACE_BEGIN(sock, "fuzzy_parallel.run");
+        MC_AWAIT(macoro::when_all_ready(std::move(tasks)));
+        SPARSE_COMP_TRACE_END(sock, "fuzzy_parallel.run");
+
+        sparse_comp::fuzzy_parallel::detail::check_results(results);
+
+    MC_END();
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+         size_t bts, size_t btr, size_t d, uint8_t delta, uint8_t ssp>
+sparse_comp::fuzzy_parallel::Receiver<FuzzyReceiver,bts,btr,d,delta,ssp>::Receiver(
+                                                     osuCrypto::PRNG& prng,
+                                                     osuCrypto::AES& aes,
+                                                     size_t partitions,
+                                                     size_t memory_budget,
+                                                     sparse_comp::multi_oprf::OtExtConfig otExt,
+                                                     sparse_comp::custom_oprf::OprfBackend oprfBackend) {
+    sparse_comp::fuzzy_parallel::detail::check_partitions(partitions);
+
+    this->partitions = partitions;
+
+    // The AES key is only read by the instances; each needs a PRNG of its own
+    for (size_t i = 0; i < partitions; i++) {
+        this->prngs.push_back(std::make_unique<osuCrypto::PRNG>(prng.get<osuCrypto::block>()));
+        this->instances.push_back(std::make_unique<sparse_comp::fuzzy_batch::Receiver<FuzzyReceiver,bts,btr,d,delta,ssp>>(
+            *(this->prngs[i]), aes, memory_budget / partitions, nullptr, otExt, oprfBackend));
+    }
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+         size_t bts, size_t btr, size_t d, uint8_t delta, uint8_t ssp>
+sparse_comp::fuzzy_parallel::Receiver<FuzzyReceiver,bts,btr,d,delta,ssp>::~Receiver() {
+    // Lets the pool threads exit once idle; the pool joins them
+    this->work.reset();
+    this->pool.reset();
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+         size_t bts, size_t btr, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::fuzzy_parallel::Receiver<FuzzyReceiver,bts,btr,d,delta,ssp>::receive(
+                                                     coproto::Socket& sock,
+                                                     std::span<const point> points,
+                                                     std::vector<point>& intersec) {
+    MC_BEGIN(Proto, this, &sock, points, &intersec,
+             members = std::vector<std::vector<point>>(),
+             partials = std::vector<std::vector<point>>(),
+             socks = std::vector<coproto::Socket>(),
+             tasks = std::vector<Proto>(),
+             results = std::vector<macoro::result<void>>(),
+             i = size_t(0));
+
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "fuzzy_parallel.partition");
+
+            // Receiver points also go to the partition of the neighbouring column their delta ball reaches
+            sparse_comp::fuzzy_parallel::detail::partition(points, this->partitions, delta, members);
+        }
+
+        sparse_comp::fuzzy_parallel::detail::start_pool(this->pool, this->work, this->partitions);
+
+        // Both parties fork in the same order, so that the i-th sub-channels are paired
+        for (i = 0; i < this->partitions; i++) socks.push_back(sock.fork());
+
+        results.resize(this->partitions);
+        partials.resize(this->partitions);
+
+        for (i = 0; i < this->partitions; i++) {
+            tasks.push_back(sparse_comp::fuzzy_parallel::detail::run_on(*(this->pool), this->instances[i]->receive(socks[i], members[i], partials[i]), results[i]));
+        }
+
+        SPARSE_COMP_TRACE_BEGIN(sock, "fuzzy_parallel.run");
+        MC_AWAIT(macoro::when_all_ready(std::move(tasks)));
+        SPARSE_COMP_TRACE_END(sock, "fuzzy_parallel.run");
+
+        sparse_comp::fuzzy_parallel::detail::check_results(results);
+
+        // Every sender point belongs to a single partition, so the partition intersections are disjoint
+        for (i = 0; i < this->partitions; i++) {
+            intersec.insert(intersec.end(), partials[i].begin(), partials[i].end());
+        }
+
+    MC_END();
+}
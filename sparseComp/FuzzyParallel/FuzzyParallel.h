@@ -0,0 +1,91 @@
+#pragma once
+
+#include "coproto/Socket/Socket.h"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "macoro/thread_pool.h"
+#include "../MultiOPRF/OtExt.h"
+#include "../CustomOPRF/CustomizedOPRF.h"
+#include "../FuzzyBatch/FuzzyBatch.h"
+#include "../Common/Common.h"
+#include <cstdint>
+#include <memory>
+#include <stddef.h>
+#include <span>
+#include <vector>
+
+// Partition parallel mode of the Fuzzy PSI protocols (L1, L2 and L_inf).
+//
+// The first coordinate axis of the spatial hashing grid is cut into columns of 2^COLUMN_BITS values, and each
+// column is assigned to one of the partitions by a fixed hash of its index. A sender point goes to the
+// partition of the column of its first coordinate; a receiver point goes to the partitions of the columns its
+// delta ball reaches (one, or two near a column edge), so that every match lies within a partition. Both
+// parties derive the partitions from public values, so they agree on them without interaction.
+//
+// Each partition runs its own instance of the batched mode of FuzzyBatch.h, on a socket forked from the
+// session socket and on a worker thread of the party's pool, and the receiver appends the partition
+// intersections. Every instance gets its own PRNG, seeded from the party's, its own share of the memory
+// budget and its own OPRF setup. Besides what the batched mode reveals for each partition, the parties learn
+// the number of points of the other one in each partition.
+
+namespace sparse_comp::fuzzy_parallel {
+
+    constexpr size_t COLUMN_BITS = 16;
+
+    // Partition of the column holding first coordinate x
+    inline size_t column_partition(uint64_t x, size_t partitions) {
+        uint64_t key = (x >> COLUMN_BITS) * 0x9E3779B97F4A7C15ULL;
+        key ^= key >> 29;
+
+        return (size_t) (((key & 0xFFFFFFFFULL) * partitions) >> 32);
+    }
+
+    template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+             size_t btr, size_t bts, size_t d, uint8_t delta, uint8_t ssp>
+    class Sender {
+
+        size_t partitions;
+        std::vector<std::unique_ptr<osuCrypto::PRNG>> prngs;
+        std::vector<std::unique_ptr<sparse_comp::fuzzy_batch::Sender<FuzzySender, btr, bts, d, delta, ssp>>> instances;
+
+        std::unique_ptr<macoro::thread_pool> pool;
+        std::unique_ptr<macoro::thread_pool::work> work;
+
+        public:
+            // Runs the partitions on a pool of as many threads; both parties must pass the same number of
+            // partitions and batch capacities. memory_budget is shared evenly by the partitions, see
+            // fuzzy_batch::Sender for the other arguments.
+            Sender(osuCrypto::PRNG& prng, osuCrypto::AES& aes, size_t partitions, size_t memory_budget, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf);
+
+            ~Sender();
+
+            coproto::task<void> send(coproto::Socket& sock, std::span<const point> points);
+    };
+
+    template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+             size_t bts, size_t btr, size_t d, uint8_t delta, uint8_t ssp>
+    class Receiver {
+
+        size_t partitions;
+        std::vector<std::unique_ptr<osuCrypto::PRNG>> prngs;
+        std::vector<std::unique_ptr<sparse_comp::fuzzy_batch::Receiver<FuzzyReceiver, bts, btr, d, delta, ssp>>> instances;
+
+        std::unique_ptr<macoro::thread_pool> pool;
+        std::unique_ptr<macoro::thread_pool::work> work;
+
+        public:
+            // Runs the partitions on a pool of as many threads; both parties must pass the same number of
+            // partitions and batch capacities. memory_budget is shared evenly by the partitions, see
+            // fuzzy_batch::Receiver for the other arguments.
+            Receiver(osuCrypto::PRNG& prng, osuCrypto::AES& aes, size_t partitions, size_t memory_budget, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf);
+
+            ~Receiver();
+
+            // Appends to intersec the sender points within delta of some point of points, each once.
+            coproto::task<void> receive(coproto::Socket& sock, std::span<const point> points, std::vector<point>& intersec);
+    };
+
+}
+
+#include "./FuzzyParallel.cpp"
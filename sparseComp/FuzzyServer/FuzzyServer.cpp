@@ -0,0 +1,170 @@
+#include "./FuzzyServer.h"
+#include "../Common/PreparedSet.h"
+#include "../Common/Common.h"
+#include "../Common/Trace.h"
+#include "macoro/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using Proto = coproto::task<void>;
+
+inline double sparse_comp::fuzzy_server::ServerStats::sessions_per_second() const {
+    return this->busy_ms > 0 ? this->sessions / (this->busy_ms / 1000.0) : 0;
+}
+
+inline double sparse_comp::fuzzy_server::ServerStats::latency_quantile(double q) const {
+    if (this->latencies_ms.empty()) return 0;
+
+    std::vector<double> sorted = this->latencies_ms;
+    std::sort(sorted.begin(), sorted.end());
+
+    const size_t rank = (size_t) std::ceil(std::clamp(q, 0.0, 1.0) * sorted.size());
+
+    return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t tr, size_t ts, size_t d, uint8_t delta, uint8_t ssp>
+void sparse_comp::fuzzy_server::Server<FuzzySender,tr,ts,d,delta,ssp>::setup(
+                                                     osuCrypto::AES& aes,
+                                                     size_t threads,
+                                                     sparse_comp::multi_oprf::OtExtConfig otExt,
+                                                     sparse_comp::custom_oprf::OprfBackend oprfBackend) {
+    if (threads == 0) throw std::invalid_argument("the number of threads must be positive");
+
+    this->aes = &aes;
+    this->otExt = otExt;
+    this->oprfBackend = oprfBackend;
+    this->threads = threads;
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t tr, size_t ts, size_t d, uint8_t delta, uint8_t ssp>
+sparse_comp::fuzzy_server::Server<FuzzySender,tr,ts,d,delta,ssp>::Server(
+                                                     osuCrypto::PRNG& prng,
+                                                     osuCrypto::AES& aes,
+                                                     const std::array<point,ts>& points,
+                                                     size_t threads,
+                                                     sparse_comp::multi_oprf::OtExtConfig otExt,
+                                                     sparse_comp::custom_oprf::OprfBackend oprfBackend) : seeds(prng.get<osuCrypto::block>()) {
+    this->setup(aes, threads, otExt, oprfBackend);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    this->prepared = std::make_unique<sparse_comp::fuzzy::PreparedSenderSet<ts,d>>(aes, points, delta);
+
+    this->statistics.prepare_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t tr, size_t ts, size_t d, uint8_t delta, uint8_t ssp>
+sparse_comp::fuzzy_server::Server<FuzzySender,tr,ts,d,delta,ssp>::Server(
+                                                     osuCrypto::PRNG& prng,
+                                                     osuCrypto::AES& aes,
+                                                     std::unique_ptr<sparse_comp::fuzzy::PreparedSenderSet<ts,d>> prepared,
+                                                     size_t threads,
+                                                     sparse_comp::multi_oprf::OtExtConfig otExt,
+                                                     sparse_comp::custom_oprf::OprfBackend oprfBackend) : seeds(prng.get<osuCrypto::block>()) {
+    this->setup(aes, threads, otExt, oprfBackend);
+
+    if (prepared == nullptr) throw std::invalid_argument("the prepared set must not be null");
+    sparse_comp::fuzzy::check_prepared_delta(prepared->delta(), delta);
+
+    this->prepared = std::move(prepared);
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t tr, size_t ts, size_t d, uint8_t delta, uint8_t ssp>
+sparse_comp::fuzzy_server::Server<FuzzySender,tr,ts,d,delta,ssp>::~Server() {
+    // Lets the pool threads exit once idle; the pool joins them
+    this->work.reset();
+    this->pool.reset();
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t tr, size_t ts, size_t d, uint8_t delta, uint8_t ssp>
+osuCrypto::block sparse_comp::fuzzy_server::Server<FuzzySender,tr,ts,d,delta,ssp>::session_seed(std::chrono::steady_clock::time_point start) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (!this->started || start < this->first_start) this->first_start = start;
+    this->started = true;
+
+    return this->seeds.get<osuCrypto::block>();
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t tr, size_t ts, size_t d, uint8_t delta, uint8_t ssp>
+void sparse_comp::fuzzy_server::Server<FuzzySender,tr,ts,d,delta,ssp>::record(std::chrono::steady_clock::time_point start, bool failed) {
+    const auto end = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (failed) {
+        this->statistics.failures++;
+    } else {
+        this->statistics.sessions++;
+        this->statistics.latencies_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    this->statistics.busy_ms = std::chrono::duration<double, std::milli>(end - this->first_start).count();
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t tr, size_t ts, size_t d, uint8_t delta, uint8_t ssp>
+sparse_comp::fuzzy_server::ServerStats sparse_comp::fuzzy_server::Server<FuzzySender,tr,ts,d,delta,ssp>::stats() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->statistics;
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t tr, size_t ts, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::fuzzy_server::Server<FuzzySender,tr,ts,d,delta,ssp>::serve(coproto::Socket& sock) {
+    MC_BEGIN(Proto, this, &sock,
+             prng = (osuCrypto::PRNG*) nullptr,
+             sender = (FuzzySender<tr,ts,d,delta,ssp>*) nullptr,
+             start = std::chrono::steady_clock::time_point(),
+             result = macoro::result<void>(),
+             prt = Proto());
+
+        {
+            // Started on the first session rather than on construction, so that the server can be created
+            // before the process forks (as the process mode of the benchmarks does)
+            std::lock_guard<std::mutex> lock(this->mutex);
+
+            if (this->pool == nullptr) {
+                this->pool = std::make_unique<macoro::thread_pool>();
+                this->work = std::make_unique<macoro::thread_pool::work>(this->pool->make_work());
+                this->pool->create_threads(this->threads);
+            }
+        }
+
+        MC_AWAIT(this->pool->schedule());
+
+        start = std::chrono::steady_clock::now();
+
+        // Each session gets its own randomness; the prepared set and the AES key are only read
+        prng = new osuCrypto::PRNG(this->session_seed(start));
+        sender = new FuzzySender<tr,ts,d,delta,ssp>(*prng, *(this->aes), nullptr, this->otExt, this->oprfBackend);
+
+        SPARSE_COMP_TRACE_BEGIN(sock, "fuzzy_server.session");
+        prt = sender->send(sock, *(this->prepared));
+        MC_AWAIT_SET(result, std::move(prt) | macoro::wrap());
+        SPARSE_COMP_TRACE_END(sock, "fuzzy_server.session");
+
+        delete sender;
+        delete prng;
+
+        this->record(start, result.has_error());
+
+        if (result.has_error()) std::rethrow_exception(result.error());
+
+    MC_END();
+}
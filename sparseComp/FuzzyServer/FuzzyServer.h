@@ -0,0 +1,88 @@
+#pragma once
+
+#include "coproto/Socket/Socket.h"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "macoro/thread_pool.h"
+#include "../MultiOPRF/OtExt.h"
+#include "../CustomOPRF/CustomizedOPRF.h"
+#include "../Common/PreparedSet.h"
+#include "../Common/Common.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <vector>
+
+// Long lived sender of the Fuzzy PSI protocols (L1, L2 and L_inf), answering many receivers on one set.
+//
+// The server prepares its set once, on construction (see PreparedSet.h), or takes a prepared one, e.g. mapped
+// from a file. It then runs one session of the protocol given as FuzzySender per call to serve, each with a
+// fresh sender instance seeded from the server's PRNG. Sessions start on a thread of the server's pool and
+// only read the prepared set, so any number of them may run concurrently on sockets of different receivers.
+// The server records the latency of every session, from its start on the pool to the end of its run, and
+// the session throughput.
+
+namespace sparse_comp::fuzzy_server {
+
+    struct ServerStats {
+        double prepare_ms = 0;
+        uint64_t sessions = 0; // Completed sessions
+        uint64_t failures = 0;
+        std::vector<double> latencies_ms; // Of the completed sessions, in completion order
+        double busy_ms = 0; // From the start of the first session to the end of the last one
+
+        double sessions_per_second() const;
+
+        // q-quantile of the session latencies, 0 if no session completed
+        double latency_quantile(double q) const;
+    };
+
+    template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+             size_t tr, size_t ts, size_t d, uint8_t delta, uint8_t ssp>
+    class Server {
+
+        osuCrypto::AES* aes;
+        sparse_comp::multi_oprf::OtExtConfig otExt;
+        sparse_comp::custom_oprf::OprfBackend oprfBackend;
+        std::unique_ptr<sparse_comp::fuzzy::PreparedSenderSet<ts,d>> prepared;
+
+        size_t threads;
+        std::unique_ptr<macoro::thread_pool> pool;
+        std::unique_ptr<macoro::thread_pool::work> work;
+
+        // Guards the seed PRNG, the pool start and the statistics
+        std::mutex mutex;
+        osuCrypto::PRNG seeds;
+        ServerStats statistics;
+        std::chrono::steady_clock::time_point first_start;
+        bool started = false;
+
+        void setup(osuCrypto::AES& aes, size_t threads, sparse_comp::multi_oprf::OtExtConfig otExt, sparse_comp::custom_oprf::OprfBackend oprfBackend);
+        osuCrypto::block session_seed(std::chrono::steady_clock::time_point start);
+        void record(std::chrono::steady_clock::time_point start, bool failed);
+
+        public:
+            // Prepares points for the sessions and runs them on a pool of threads threads. The receivers must
+            // all hold tr points; otExt and oprfBackend are handed to every session, see FuzzySender.
+            Server(osuCrypto::PRNG& prng, osuCrypto::AES& aes, const std::array<point,ts>& points, size_t threads, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf);
+
+            // Same, on a set prepared beforehand, e.g. mapped from a file by PreparedSenderSet::open. Throws
+            // std::invalid_argument if it was prepared for another delta.
+            Server(osuCrypto::PRNG& prng, osuCrypto::AES& aes, std::unique_ptr<sparse_comp::fuzzy::PreparedSenderSet<ts,d>> prepared, size_t threads, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf);
+
+            ~Server();
+
+            // Runs one session with the receiver on sock. Rethrows the failure of the session, which does not
+            // affect the other ones.
+            coproto::task<void> serve(coproto::Socket& sock);
+
+            ServerStats stats();
+    };
+
+}
+
+#include "./FuzzyServer.cpp"
@@ -0,0 +1,300 @@
+#include "./FuzzyShard.h"
+#include "../FuzzyBatch/FuzzyBatch.h"
+#include "../Common/Common.h"
+#include "../Common/SockUtils.h"
+#include "../Common/CommStats.h"
+#include "../Common/Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+using Proto = coproto::task<void>;
+
+namespace sparse_comp::fuzzy_shard::detail {
+
+    constexpr uint64_t COORD_RANGE = (uint64_t) 1 << 32;
+
+    // Ships a shard to a worker: its size, then its points.
+    inline Proto send_points(coproto::Socket& sock, std::vector<point>& points) {
+        MC_BEGIN(Proto, &sock, &points,
+                 size = std::vector<uint64_t>(1),
+                 prt = Proto());
+
+            size[0] = points.size();
+            prt = sparse_comp::send<uint64_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, size);
+            MC_AWAIT(prt);
+
+            prt = sparse_comp::send<point,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, points);
+            MC_AWAIT(prt);
+
+        MC_END();
+    }
+
+    inline Proto receive_points(coproto::Socket& sock, std::vector<point>& points) {
+        MC_BEGIN(Proto, &sock, &points,
+                 size = std::vector<uint64_t>(),
+                 prt = Proto());
+
+            prt = sparse_comp::receive<uint64_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, 1, size);
+            MC_AWAIT(prt);
+
+            prt = sparse_comp::receive<point,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, size[0], points);
+            MC_AWAIT(prt);
+
+        MC_END();
+    }
+
+    // Ships every shard to its worker, then collects the worker reports.
+    inline Proto run_shards(std::vector<coproto::Socket>& workers, std::vector<std::vector<point>>& shards, std::vector<WorkerReport>& reports) {
+        MC_BEGIN(Proto, &workers, &shards, &reports,
+                 received = std::vector<WorkerReport>(),
+                 k = size_t(0),
+                 prt = Proto());
+
+            for (k = 0; k < workers.size(); k++) {
+                prt = send_points(workers[k], shards[k]);
+                MC_AWAIT(prt);
+
+                // The coordinator does not need the shard any more
+                std::vector<point>().swap(shards[k]);
+            }
+
+            reports.resize(workers.size());
+
+            for (k = 0; k < workers.size(); k++) {
+                prt = sparse_comp::receive<WorkerReport,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(workers[k], 1, received);
+                MC_AWAIT(prt);
+
+                reports[k] = received[0];
+            }
+
+        MC_END();
+    }
+
+    inline Proto send_report(coproto::Socket& sock, const WorkerReport& report) {
+        MC_BEGIN(Proto, &sock, reports = std::vector<WorkerReport>(1, report),
+                 prt = Proto());
+
+            prt = sparse_comp::send<WorkerReport,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, reports);
+            MC_AWAIT(prt);
+
+        MC_END();
+    }
+
+    inline double elapsed_ms(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+}
+
+inline size_t sparse_comp::fuzzy_shard::ShardPlan::shard_of(uint64_t x) const {
+    // The last shard starting at or before x; the empty shards before it have the same start
+    return (size_t) (std::upper_bound(this->bounds.begin(), this->bounds.end() - 1, x) - this->bounds.begin()) - 1;
+}
+
+inline sparse_comp::fuzzy_shard::ShardPlan sparse_comp::fuzzy_shard::uniform_plan(size_t shards) {
+    if (shards == 0) throw std::invalid_argument("the number of shards must be positive");
+
+    ShardPlan plan;
+    plan.bounds.resize(shards + 1);
+
+    for (size_t k = 0; k <= shards; k++) plan.bounds[k] = (detail::COORD_RANGE * k) / shards;
+
+    return plan;
+}
+
+inline sparse_comp::fuzzy_shard::ShardPlan sparse_comp::fuzzy_shard::balanced_plan(std::span<const point> points, size_t shards, uint64_t delta) {
+    if (shards == 0) throw std::invalid_argument("the number of shards must be positive");
+    if (points.empty()) return uniform_plan(shards);
+
+    std::vector<uint32_t> coords(points.size());
+    for (size_t i = 0; i < points.size(); i++) coords[i] = points[i][0];
+
+    std::sort(coords.begin(), coords.end());
+
+    const uint64_t side = std::max<uint64_t>(2 * delta, 1);
+
+    ShardPlan plan;
+    plan.bounds.resize(shards + 1);
+    plan.bounds[0] = 0;
+    plan.bounds[shards] = detail::COORD_RANGE;
+
+    for (size_t k = 1; k < shards; k++) {
+        const uint64_t quantile = coords[(coords.size() * k) / shards];
+        plan.bounds[k] = std::max(plan.bounds[k - 1], quantile - quantile % side);
+    }
+
+    return plan;
+}
+
+inline void sparse_comp::fuzzy_shard::split(const ShardPlan& plan, std::span<const point> points, uint64_t radius, std::vector<std::vector<point>>& shards) {
+    shards.assign(plan.shards(), std::vector<point>());
+
+    for (const point& p : points) {
+        const uint64_t x = p[0];
+        const size_t first = plan.shard_of(x >= radius ? x - radius : 0);
+        const size_t last = plan.shard_of(std::min(x + radius, detail::COORD_RANGE - 1));
+
+        for (size_t k = first; k <= last; k++) {
+            if (plan.bounds[k] < plan.bounds[k + 1]) shards[k].push_back(p);
+        }
+    }
+}
+
+inline Proto sparse_comp::fuzzy_shard::sender_coordinator(coproto::Socket& peer,
+                                                          std::vector<coproto::Socket>& workers,
+                                                          std::span<const point> points,
+                                                          std::vector<WorkerReport>& reports) {
+    MC_BEGIN(Proto, &peer, &workers, points, &reports,
+             plan = ShardPlan(),
+             shards = std::vector<std::vector<point>>(),
+             prt = Proto());
+
+        prt = sparse_comp::receive<uint64_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(peer, workers.size() + 1, plan.bounds);
+        MC_AWAIT(prt);
+
+        if (plan.bounds.front() != 0 || plan.bounds.back() != detail::COORD_RANGE || !std::is_sorted(plan.bounds.begin(), plan.bounds.end())) {
+            throw std::runtime_error("the receiver's coordinator sent malformed shard bounds");
+        }
+
+        {
+            SPARSE_COMP_TRACE_SCOPE(peer, "fuzzy_shard.split");
+
+            // Sender points only belong to the shard of their first coordinate
+            split(plan, points, 0, shards);
+        }
+
+        prt = detail::run_shards(workers, shards, reports);
+        MC_AWAIT(prt);
+
+    MC_END();
+}
+
+inline Proto sparse_comp::fuzzy_shard::receiver_coordinator(coproto::Socket& peer,
+                                                            std::vector<coproto::Socket>& workers,
+                                                            std::span<const point> points,
+                                                            uint64_t delta,
+                                                            std::vector<point>& intersec,
+                                                            std::vector<WorkerReport>& reports) {
+    MC_BEGIN(Proto, &peer, &workers, points, delta, &intersec, &reports,
+             plan = ShardPlan(),
+             shards = std::vector<std::vector<point>>(),
+             partial = std::vector<point>(),
+             k = size_t(0),
+             prt = Proto());
+
+        {
+            SPARSE_COMP_TRACE_SCOPE(peer, "fuzzy_shard.split");
+
+            plan = balanced_plan(points, workers.size(), delta);
+
+            // Receiver points also go to the neighbouring shards their delta ball reaches
+            split(plan, points, delta, shards);
+        }
+
+        prt = sparse_comp::send<uint64_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(peer, plan.bounds);
+        MC_AWAIT(prt);
+
+        prt = detail::run_shards(workers, shards, reports);
+        MC_AWAIT(prt);
+
+        // Every sender point belongs to a single shard, so the shard intersections are disjoint
+        for (k = 0; k < workers.size(); k++) {
+            prt = detail::receive_points(workers[k], partial);
+            MC_AWAIT(prt);
+
+            intersec.insert(intersec.end(), partial.begin(), partial.end());
+        }
+
+    MC_END();
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+         size_t btr, size_t bts, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::fuzzy_shard::sender_worker(coproto::Socket& coordinator,
+                                              coproto::Socket& peer,
+                                              osuCrypto::PRNG& prng,
+                                              osuCrypto::AES& aes,
+                                              size_t memory_budget,
+                                              sparse_comp::multi_oprf::OtExtConfig otExt,
+                                              sparse_comp::custom_oprf::OprfBackend oprfBackend) {
+    MC_BEGIN(Proto, &coordinator, &peer, &prng, &aes, memory_budget, otExt, oprfBackend,
+             points = std::vector<point>(),
+             batchSender = (sparse_comp::fuzzy_batch::Sender<FuzzySender,btr,bts,d,delta,ssp>*) nullptr,
+             report = WorkerReport(),
+             start = std::chrono::steady_clock::time_point(),
+             bytes = uint64_t(0),
+             prt = Proto());
+
+        // No pool: fuzzy_batch sets one up for the batches of the shard, see FuzzyBatch.h
+        batchSender = new sparse_comp::fuzzy_batch::Sender<FuzzySender,btr,bts,d,delta,ssp>(prng, aes, memory_budget, nullptr, otExt, oprfBackend);
+
+        prt = detail::receive_points(coordinator, points);
+        MC_AWAIT(prt);
+
+        start = std::chrono::steady_clock::now();
+        bytes = peer.bytesSent() + peer.bytesReceived();
+
+        prt = batchSender->send(peer, points);
+        MC_AWAIT(prt);
+
+        report.points = points.size();
+        report.bytes = peer.bytesSent() + peer.bytesReceived() - bytes;
+        report.wall_ms = detail::elapsed_ms(start);
+
+        prt = detail::send_report(coordinator, report);
+        MC_AWAIT(prt);
+
+        delete batchSender;
+
+    MC_END();
+}
+
+template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+         size_t bts, size_t btr, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::fuzzy_shard::receiver_worker(coproto::Socket& coordinator,
+                                                coproto::Socket& peer,
+                                                osuCrypto::PRNG& prng,
+                                                osuCrypto::AES& aes,
+                                                size_t memory_budget,
+                                                sparse_comp::multi_oprf::OtExtConfig otExt,
+                                                sparse_comp::custom_oprf::OprfBackend oprfBackend) {
+    MC_BEGIN(Proto, &coordinator, &peer, &prng, &aes, memory_budget, otExt, oprfBackend,
+             points = std::vector<point>(),
+             intersec = std::vector<point>(),
+             batchReceiver = (sparse_comp::fuzzy_batch::Receiver<FuzzyReceiver,bts,btr,d,delta,ssp>*) nullptr,
+             report = WorkerReport(),
+             start = std::chrono::steady_clock::time_point(),
+             bytes = uint64_t(0),
+             prt = Proto());
+
+        // No pool: fuzzy_batch sets one up for the batches of the shard, see FuzzyBatch.h
+        batchReceiver = new sparse_comp::fuzzy_batch::Receiver<FuzzyReceiver,bts,btr,d,delta,ssp>(prng, aes, memory_budget, nullptr, otExt, oprfBackend);
+
+        prt = detail::receive_points(coordinator, points);
+        MC_AWAIT(prt);
+
+        start = std::chrono::steady_clock::now();
+        bytes = peer.bytesSent() + peer.bytesReceived();
+
+        prt = batchReceiver->receive(peer, points, intersec);
+        MC_AWAIT(prt);
+
+        report.points = points.size();
+        report.matches = intersec.size();
+        report.bytes = peer.bytesSent() + peer.bytesReceived() - bytes;
+        report.wall_ms = detail::elapsed_ms(start);
+
+        prt = detail::send_report(coordinator, report);
+        MC_AWAIT(prt);
+
+        prt = detail::send_points(coordinator, intersec);
+        MC_AWAIT(prt);
+
+        delete batchReceiver;
+
+    MC_END();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "coproto/Socket/Socket.h"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "../MultiOPRF/OtExt.h"
+#include "../CustomOPRF/CustomizedOPRF.h"
+#include "../FuzzyBatch/FuzzyBatch.h"
+#include "../Common/Common.h"
+#include <cstdint>
+#include <stddef.h>
+#include <span>
+#include <vector>
+
+// Sharded deployment of the Fuzzy PSI protocols (L1, L2 and L_inf) over several machines.
+//
+// Each party runs a coordinator, which holds its whole set, and one worker per shard. The receiver's
+// coordinator range partitions the first coordinate of the spatial hashing grid into shards, at the quantiles
+// of its own points rounded down to cell edges, and sends the shard bounds to the sender's coordinator. Each
+// coordinator then ships the points of every shard to its worker for that shard; a receiver point also goes to
+// the neighbouring shards that its delta ball reaches, so that every match lies within a shard. The k-th
+// workers of both parties run the batched mode of FuzzyBatch.h against each other on their own connection,
+// and the receiver's workers send their intersections back to their coordinator, which appends them. Every
+// worker also reports its number of points and run time, so that the coordinators can account shard balance.
+//
+// All the functions below take plain coproto sockets: the links may be TCP connections between machines, or
+// between processes of one host. Besides what the batched mode reveals for each shard, the sender learns
+// the shard bounds, i.e. quantiles of the first coordinates of the receiver points.
+
+namespace sparse_comp::fuzzy_shard {
+
+    // Shard k holds the first coordinates in [bounds[k], bounds[k+1]). bounds[0] = 0 and bounds.back() = 2^32;
+    // consecutive bounds may be equal, leaving a shard empty.
+    struct ShardPlan {
+        std::vector<uint64_t> bounds;
+
+        size_t shards() const { return this->bounds.size() - 1; }
+
+        // Shard holding first coordinate x
+        size_t shard_of(uint64_t x) const;
+    };
+
+    // Shards of equal width
+    inline ShardPlan uniform_plan(size_t shards);
+
+    // Shards holding about as many points each, with bounds on the edges of the spatial hashing cells of
+    // side 2*delta.
+    inline ShardPlan balanced_plan(std::span<const point> points, size_t shards, uint64_t delta);
+
+    // Points of each shard. A point also goes to the shards that the window of the given radius around its
+    // first coordinate reaches.
+    inline void split(const ShardPlan& plan, std::span<const point> points, uint64_t radius, std::vector<std::vector<point>>& shards);
+
+    struct WorkerReport {
+        uint64_t points = 0;
+        uint64_t matches = 0; // Receiver workers only
+        uint64_t bytes = 0; // Exchanged with the peer worker
+        double wall_ms = 0; // From the arrival of the shard to the end of the run
+    };
+
+    // Coordinators. workers[k] is the link to the worker of shard k and peer the link to the other party's
+    // coordinator; both parties must have as many workers. reports[k] receives the report of worker k.
+    // The receiver's coordinator picks the shards, see balanced_plan.
+    inline coproto::task<void> sender_coordinator(coproto::Socket& peer, std::vector<coproto::Socket>& workers, std::span<const point> points, std::vector<WorkerReport>& reports);
+    inline coproto::task<void> receiver_coordinator(coproto::Socket& peer, std::vector<coproto::Socket>& workers, std::span<const point> points, uint64_t delta, std::vector<point>& intersec, std::vector<WorkerReport>& reports);
+
+    // Workers. coordinator is the link to the party's coordinator and peer the link to the other party's
+    // worker of the same shard. The other arguments are those of fuzzy_batch::Sender and fuzzy_batch::Receiver.
+    // The workers take no OtPool: the batched mode of every worker sets up a pool sized for the batches of its
+    // shard once the shard has arrived, so the OT extension runs once per shard rather than once per batch.
+    template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+             size_t btr, size_t bts, size_t d, uint8_t delta, uint8_t ssp>
+    coproto::task<void> sender_worker(coproto::Socket& coordinator, coproto::Socket& peer, osuCrypto::PRNG& prng, osuCrypto::AES& aes, size_t memory_budget, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf);
+
+    template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+             size_t bts, size_t btr, size_t d, uint8_t delta, uint8_t ssp>
+    coproto::task<void> receiver_worker(coproto::Socket& coordinator, coproto::Socket& peer, osuCrypto::PRNG& prng, osuCrypto::AES& aes, size_t memory_budget, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf);
+
+}
+
+#include "./FuzzyShard.cpp"
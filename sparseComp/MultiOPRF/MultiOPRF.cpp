@@ -1,12 +1,13 @@
 #include "./MultiOPRF.h"
 #include "libOTe/Base/BaseOT.h"
-#include "libOTe/TwoChooseOne/Kos/KosOtExtReceiver.h"
-#include "libOTe/TwoChooseOne/Kos/KosOtExtSender.h"
 #include "cryptoTools/Crypto/PRNG.h"
 #include "cryptoTools/Common/BitVector.h"
 #include "volePSI/Paxos.h"
 #include "../Common/BaxosUtils.h"
 #include "../Common/SockUtils.h"
+#include "../Common/CommStats.h"
+#include "../Common/Trace.h"
+#include "./OtPool.h"
 #include <vector>
 
 #define MULTI_OPRF_PAXOS_SSP 40
@@ -14,8 +15,8 @@
 
 static constexpr int64_t max_send_size_bytes(2147483648L); // 2 GBs
 
-using KosOtExtSender = osuCrypto::KosOtExtSender;
-using KosOtExtReceiver = osuCrypto::KosOtExtReceiver;
+using OtExtSender = osuCrypto::OtExtSender;
+using OtExtReceiver = osuCrypto::OtExtReceiver;
 using u8 = osuCrypto::u8;
 using Baxos = volePSI::Baxos;
 using PaxosParam = volePSI::PaxosParam;
@@ -23,41 +24,48 @@ using PaxosParam = volePSI::PaxosParam;
 static const size_t comp_sec = sparse_comp::multi_oprf::comp_sec_param;
 static const size_t ell = sparse_comp::multi_oprf::ell;
 
+sparse_comp::multi_oprf::Sender::Sender(block s, const block* randSetupOtMsgs) {
+    this->s = s;
+    this->randSetupOtMsgs = new std::vector<block>(randSetupOtMsgs, randSetupOtMsgs + ell);
+}
+
 sparse_comp::multi_oprf::Sender::~Sender() {
     delete this->randSetupOtMsgs;
     delete this->okvs;
 }
 
-Proto sparse_comp::multi_oprf::Sender::setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Sender*>& senders) {
-    MC_BEGIN(Proto, &sock, &prng, num_instances, &senders,
-             otRecv = KosOtExtReceiver(),
+Proto sparse_comp::multi_oprf::Sender::setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Sender*>& senders, OtExtConfig otExt) {
+    MC_BEGIN(Proto, &sock, &prng, num_instances, &senders, otExt,
+             otRecv = (OtExtReceiver*) nullptr,
              allRandSetupOtMsgs = (std::vector<block>*) nullptr,
              allRandSetupOtChoices = (BitVector*) nullptr,
-             choice_blocks = (block*) nullptr);
+             choice_blocks = (block*) nullptr,
+             scope = (sparse_comp::comm::CommScope*) nullptr);
             
         senders.resize(num_instances);    
         
-        otRecv.mIsMalicious = false;
+        otRecv = make_ot_ext_receiver(otExt);
 
         allRandSetupOtMsgs = new std::vector<block>(ell*num_instances);
         allRandSetupOtChoices = new BitVector(ell*num_instances);
 
         allRandSetupOtChoices->randomize(prng); // Sample random setup ot choices
 
-        MC_AWAIT(otRecv.genBaseOts(prng, sock));
+        scope = new sparse_comp::comm::CommScope(sock, "oprf.setup");
+        SPARSE_COMP_TRACE_BEGIN(sock, "oprf.setup");
+
+        MC_AWAIT(otRecv->genBaseOts(prng, sock));
+
+        MC_AWAIT(otRecv->receive(*allRandSetupOtChoices, *allRandSetupOtMsgs, prng, sock));
 
-        MC_AWAIT(otRecv.receive(*allRandSetupOtChoices, *allRandSetupOtMsgs, prng, sock));
+        SPARSE_COMP_TRACE_END(sock, "oprf.setup");
+        delete scope;
+        delete otRecv;
 
         choice_blocks = allRandSetupOtChoices->blocks();
 
         for (size_t i=0;i < num_instances;i++) {
-            senders[i] = new Sender();
-            senders[i]->s = choice_blocks[i];
-            senders[i]->randSetupOtMsgs = new std::vector<block>(ell);
-            
-            for (size_t j=0;j < ell;j++) {
-                senders[i]->randSetupOtMsgs->at(j) = allRandSetupOtMsgs->at(ell*i + j);
-            }
+            senders[i] = new Sender(choice_blocks[i], allRandSetupOtMsgs->data() + ell*i);
         }
 
         delete allRandSetupOtChoices;
@@ -66,34 +74,159 @@ Proto sparse_comp::multi_oprf::Sender::setup(coproto::Socket& sock, PRNG& prng,
     MC_END();
 }
 
+sparse_comp::multi_oprf::Receiver::Receiver(const std::array<block, 2>* randSetupOtMsgs) {
+    this->randSetupOtMsgs = new std::vector<std::array<block, 2>>(randSetupOtMsgs, randSetupOtMsgs + ell);
+}
+
 sparse_comp::multi_oprf::Receiver::~Receiver() {
     delete this->randSetupOtMsgs;
 }
 
-Proto sparse_comp::multi_oprf::Receiver::setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Receiver*>& receivers) {
-    MC_BEGIN(Proto, &sock, &prng, num_instances, &receivers,
+Proto sparse_comp::multi_oprf::Receiver::setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Receiver*>& receivers, OtExtConfig otExt) {
+    MC_BEGIN(Proto, &sock, &prng, num_instances, &receivers, otExt,
              allRandSetupOtMsgs = (std::vector<std::array<block, 2>>*) nullptr,
-             otSender = KosOtExtSender());
+             otSender = (OtExtSender*) nullptr,
+             scope = (sparse_comp::comm::CommScope*) nullptr);
 
-        otSender.mIsMalicious = false;
+        otSender = make_ot_ext_sender(otExt);
 
         allRandSetupOtMsgs = new std::vector<std::array<block, 2>>(ell*num_instances);
         prng.get((u8*)allRandSetupOtMsgs->data()->data(), sizeof(block) * 2 * allRandSetupOtMsgs->size());
 
-        MC_AWAIT(otSender.genBaseOts(prng, sock));
-        MC_AWAIT(otSender.send(*allRandSetupOtMsgs, prng, sock));
+        scope = new sparse_comp::comm::CommScope(sock, "oprf.setup");
+        SPARSE_COMP_TRACE_BEGIN(sock, "oprf.setup");
+
+        MC_AWAIT(otSender->genBaseOts(prng, sock));
+        MC_AWAIT(otSender->send(*allRandSetupOtMsgs, prng, sock));
+
+        SPARSE_COMP_TRACE_END(sock, "oprf.setup");
+        delete scope;
+        delete otSender;
 
         for (size_t i=0;i < num_instances;i++) {
-            receivers[i] = new Receiver();
-            receivers[i]->randSetupOtMsgs = new std::vector<std::array<block, 2>>(ell);
+            receivers[i] = new Receiver(allRandSetupOtMsgs->data() + ell*i);
+        }
+
+        delete allRandSetupOtMsgs;
+
+    MC_END();
+}
+
+Proto sparse_comp::multi_oprf::extend_random_ots(coproto::Socket& sock, PRNG& prng, bool is_leader, size_t ot_count,
+                                                 BitVector& recvOtChoices, std::vector<block>& recvOtMsgs, std::vector<std::array<block, 2>>& sendOtMsgs,
+                                                 OtExtConfig otExt) {
+    MC_BEGIN(Proto, &sock, &prng, is_leader, ot_count, &recvOtChoices, &recvOtMsgs, &sendOtMsgs, otExt,
+             otRecv = (OtExtReceiver*) nullptr,
+             otSender = (OtExtSender*) nullptr,
+             baseOtChoices = (BitVector*) nullptr,
+             base_ot_count = size_t(0),
+             scope = (sparse_comp::comm::CommScope*) nullptr);
+
+        otRecv = make_ot_ext_receiver(otExt);
+        otSender = make_ot_ext_sender(otExt);
 
-            for (size_t j=0;j < ell;j++) {
-                receivers[i]->randSetupOtMsgs->at(j)[0] = allRandSetupOtMsgs->at(ell*i + j)[0];
-                receivers[i]->randSetupOtMsgs->at(j)[1] = allRandSetupOtMsgs->at(ell*i + j)[1];
+        base_ot_count = otSender->baseOtCount();
+
+        scope = new sparse_comp::comm::CommScope(sock, "oprf.ot_extension");
+        SPARSE_COMP_TRACE_BEGIN(sock, "oprf.ot_extension");
+
+        if (is_leader) {
+            recvOtMsgs.resize(ot_count + base_ot_count);
+            recvOtChoices.resize(ot_count + base_ot_count);
+            recvOtChoices.randomize(prng);
+
+            MC_AWAIT(otRecv->genBaseOts(prng, sock));
+            MC_AWAIT(otRecv->receive(recvOtChoices, recvOtMsgs, prng, sock));
+
+            // The trailing OTs are the base OTs of the reverse extension, where we are the OT sender
+            baseOtChoices = new BitVector(base_ot_count);
+            for (size_t i=0;i < base_ot_count;i++) {
+                (*baseOtChoices)[i] = recvOtChoices[ot_count + i];
             }
+
+            otSender->setBaseOts(osuCrypto::span<block>(recvOtMsgs.data() + ot_count, base_ot_count), *baseOtChoices);
+            delete baseOtChoices;
+
+            recvOtMsgs.resize(ot_count);
+            recvOtChoices.resize(ot_count);
+
+            sendOtMsgs.resize(ot_count);
+            MC_AWAIT(otSender->send(sendOtMsgs, prng, sock));
+        } else {
+            sendOtMsgs.resize(ot_count + base_ot_count);
+
+            MC_AWAIT(otSender->genBaseOts(prng, sock));
+            MC_AWAIT(otSender->send(sendOtMsgs, prng, sock));
+
+            // The trailing OTs are the base OTs of the reverse extension, where we are the OT receiver
+            otRecv->setBaseOts(osuCrypto::span<std::array<block, 2>>(sendOtMsgs.data() + ot_count, base_ot_count));
+
+            sendOtMsgs.resize(ot_count);
+
+            recvOtMsgs.resize(ot_count);
+            recvOtChoices.resize(ot_count);
+            recvOtChoices.randomize(prng);
+
+            MC_AWAIT(otRecv->receive(recvOtChoices, recvOtMsgs, prng, sock));
         }
 
-        delete allRandSetupOtMsgs;
+        SPARSE_COMP_TRACE_END(sock, "oprf.ot_extension");
+        delete scope;
+        delete otRecv;
+        delete otSender;
+
+    MC_END();
+}
+
+Proto sparse_comp::multi_oprf::setup_session(coproto::Socket& sock, PRNG& prng, bool is_leader, size_t num_instances, std::vector<Sender*>& senders, std::vector<Receiver*>& receivers, OtExtConfig otExt) {
+    MC_BEGIN(Proto, &sock, &prng, is_leader, num_instances, &senders, &receivers, otExt,
+             recvOtMsgs = (std::vector<block>*) nullptr,
+             recvOtChoices = (BitVector*) nullptr,
+             sendOtMsgs = (std::vector<std::array<block, 2>>*) nullptr,
+             choice_blocks = (block*) nullptr);
+
+        senders.resize(num_instances);
+        receivers.resize(num_instances);
+
+        recvOtMsgs = new std::vector<block>();
+        recvOtChoices = new BitVector();
+        sendOtMsgs = new std::vector<std::array<block, 2>>();
+
+        MC_AWAIT(extend_random_ots(sock, prng, is_leader, ell*num_instances, *recvOtChoices, *recvOtMsgs, *sendOtMsgs, otExt));
+
+        choice_blocks = recvOtChoices->blocks();
+
+        for (size_t i=0;i < num_instances;i++) {
+            senders[i] = new Sender(choice_blocks[i], recvOtMsgs->data() + ell*i);
+            receivers[i] = new Receiver(sendOtMsgs->data() + ell*i);
+        }
+
+        delete recvOtMsgs;
+        delete recvOtChoices;
+        delete sendOtMsgs;
+
+    MC_END();
+}
+
+Proto sparse_comp::multi_oprf::setup_session(coproto::Socket& sock, OtPool& pool, size_t num_instances, std::vector<Sender*>& senders, std::vector<Receiver*>& receivers) {
+    MC_BEGIN(Proto, &sock, &pool, num_instances, &senders, &receivers,
+             recv_offset = size_t(0),
+             send_offset = size_t(0),
+             scope = (sparse_comp::comm::CommScope*) nullptr);
+
+        senders.resize(num_instances);
+        receivers.resize(num_instances);
+
+        scope = new sparse_comp::comm::CommScope(sock, "oprf.pool_reserve");
+        SPARSE_COMP_TRACE_BEGIN(sock, "oprf.pool_reserve");
+        MC_AWAIT(pool.reserve(sock, ell*num_instances, recv_offset, send_offset));
+        SPARSE_COMP_TRACE_END(sock, "oprf.pool_reserve");
+        delete scope;
+
+        for (size_t i=0;i < num_instances;i++) {
+            senders[i] = new Sender(pool.recvOtChoiceBlocks()[(recv_offset + ell*i) / 128], pool.recvOtMsgs() + recv_offset + ell*i);
+            receivers[i] = new Receiver(pool.sendOtMsgs() + send_offset + ell*i);
+        }
 
     MC_END();
 }
@@ -177,7 +310,6 @@ static void compute_Q_blocks(size_t ell,
     */
 
 
-    //std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
     for (size_t i=0; i < xs.size(); i++) {
         block x = xs[i];
         block ct = block(0,0);
@@ -198,29 +330,28 @@ static void compute_Q_blocks(size_t ell,
 
     delete[] q_prfs;
 
-    //std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
-    //std::chrono::duration<double> elapsed = end - start;
-    //std::cout << "Time taken to execute compute_Q_blocks third loop: " << elapsed.count() << " seconds" << std::endl;
-
 }
 
 Proto sparse_comp::multi_oprf::Sender::send(coproto::Socket& sock, size_t query_num) {
     MC_BEGIN(Proto, this, &sock, query_num,
              paxosBlockCount = size_t(0),
-             t = coproto::task<void>{});
-
-        //std::cout << "waiting to receive multioprf okvs (s)" << std::endl;
+             t = coproto::task<void>{},
+             scope = (sparse_comp::comm::CommScope*) nullptr);
 
         this->query_num = query_num;
 
         paxosBlockCount = sparse_comp::baxosBlockCount(query_num, MULTI_OPRF_PAXOS_SSP);
 
+        scope = new sparse_comp::comm::CommScope(sock, "multi_oprf.okvs");
+        SPARSE_COMP_TRACE_BEGIN(sock, "multi_oprf.okvs");
+
         t = sparse_comp::receive<block, max_send_size_bytes>(sock, paxosBlockCount, *okvs);
         MC_AWAIT(t);
 
-        //MC_AWAIT(sock.recvResize(*(this->okvs)));
+        SPARSE_COMP_TRACE_END(sock, "multi_oprf.okvs");
+        delete scope;
 
-        //std::cout << "received multioprf okvs (s); okvs byte size: " << (this->okvs->size() * sizeof(block)) << std::endl;
+        //MC_AWAIT(sock.recvResize(*(this->okvs)));
 
     MC_END();
 }
@@ -239,31 +370,27 @@ void sparse_comp::multi_oprf::Sender::eval(std::vector<block>& idxs, std::vector
     std::vector<block> ps(idxs.size());
     std::vector<block> vs(idxs.size());
 
-    //std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
-    compute_Q_blocks(ell, *(this->randSetupOtMsgs), idxs, qs);
-    //std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
-    //std::chrono::duration<double> elapsed = end - start;
-    //std::cout << "Time taken to execute compute_Q_blocks: " << elapsed.count() << " seconds" << std::endl;
-
-    //start = std::chrono::high_resolution_clock::now();
-    decode_okvs(idxs, ps, this->query_num, *(this->okvs));
-    //end = std::chrono::high_resolution_clock::now();
-    //elapsed = end - start;
-    //std::cout << "Time taken to execute decode_okvs: " << elapsed.count() << " seconds" << std::endl;
-
-    //start = std::chrono::high_resolution_clock::now();
-    for (size_t i=0;i < idxs.size();i++) {
-        vs[i] = qs[i] ^ ((this->s) & (ps[i]));
+    {
+        SPARSE_COMP_TRACE_NESTED("multi_oprf.compute_q");
+        compute_Q_blocks(ell, *(this->randSetupOtMsgs), idxs, qs);
+    }
+
+    {
+        SPARSE_COMP_TRACE_NESTED("multi_oprf.okvs_decode");
+        decode_okvs(idxs, ps, this->query_num, *(this->okvs));
+    }
+
+    {
+        SPARSE_COMP_TRACE_NESTED("multi_oprf.mask");
+        for (size_t i=0;i < idxs.size();i++) {
+            vs[i] = qs[i] ^ ((this->s) & (ps[i]));
+        }
+    }
+
+    {
+        SPARSE_COMP_TRACE_NESTED("multi_oprf.hash");
+        this->aes.hashBlocks(vs.data(), vs.size(), vals.data());
     }
-    //end = std::chrono::high_resolution_clock::now();
-    //elapsed = end - start;
-    //std::cout << "Time taken to execute vs->at(i) = qs->at(i) ^ ((this->s) & (ps->at(i)));: " << elapsed.count() << " seconds" << std::endl;
-
-    //start = std::chrono::high_resolution_clock::now();
-    this->aes.hashBlocks(vs.data(), vs.size(), vals.data());
-    //end = std::chrono::high_resolution_clock::now();
-    //elapsed = end - start;
-    //std::cout << "Time taken to execute >aes.hashBlocks: " << elapsed.count() << " seconds" << std::endl;
 }
 
 static void encode_okvs(std::vector<block>& idxs, std::vector<block>& vals, std::vector<block>& okvs) {
@@ -284,55 +411,44 @@ Proto sparse_comp::multi_oprf::Receiver::receive(coproto::Socket& sock, std::vec
             ec = macoro::result<void>{},
             i = size_t(0),
             t = coproto::task<void>{},
-            start = std::chrono::high_resolution_clock::time_point{},
-            end = std::chrono::high_resolution_clock::time_point{},
-            elapsed = std::chrono::duration<double>{});
+            scope = (sparse_comp::comm::CommScope*) nullptr);
 
         rs = new std::vector<block>(idxs.size());
         ts = new std::vector<block>(idxs.size());
         okvs = new std::vector<block>();
 
-        //start = std::chrono::high_resolution_clock::now();
-        compute_R_blocks(ell, *(this->randSetupOtMsgs), idxs, *rs);
-        //end = std::chrono::high_resolution_clock::now();
-        //elapsed = end - start;
-        //std::cout << "Time taken to execute compute_R_blocks: " << elapsed.count() << " seconds" << std::endl;
-
-        //compute_R_blocks(ell, *(this->randSetupOtMsgs), idxs, *rs);
-        //start = std::chrono::high_resolution_clock::now();
-        encode_okvs(idxs, *rs, *okvs);
-        //end = std::chrono::high_resolution_clock::now();
-        //elapsed = end - start;
-        //std::cout << "Time taken to execute encode_okvs: " << elapsed.count() << " seconds" << std::endl;
-        //encode_okvs(idxs, *rs, *okvs);
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "multi_oprf.compute_r");
+            compute_R_blocks(ell, *(this->randSetupOtMsgs), idxs, *rs);
+        }
 
-        // std::cout << "sending multioprf okvs (r)" << std::endl;
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "multi_oprf.okvs_encode");
+            encode_okvs(idxs, *rs, *okvs);
+        }
 
         //MC_AWAIT(sock.send(*okvs));
 
-        // std::cout << "okvs byte size: " << (okvs->size() * sizeof(block)) << std::endl;
+        scope = new sparse_comp::comm::CommScope(sock, "multi_oprf.okvs");
+        SPARSE_COMP_TRACE_BEGIN(sock, "multi_oprf.okvs");
 
         t = sparse_comp::send<block, max_send_size_bytes>(sock, *okvs);
         MC_AWAIT(t);
 
-        //MC_AWAIT_SET(ec, sock.send(std::move(*okvs)) | macoro::wrap());
-
-        // std::cout << "multioprf okvs sent (r)" << std::endl;
+        SPARSE_COMP_TRACE_END(sock, "multi_oprf.okvs");
+        delete scope;
 
-        //start = std::chrono::high_resolution_clock::now();
-        compute_T_blocks(ell, *(this->randSetupOtMsgs), idxs, *ts);
-        //end = std::chrono::high_resolution_clock::now();
-        //elapsed = end - start;
-        //std::cout << "Time taken to execute compute_T_blocks: " << elapsed.count() << " seconds" << std::endl;
-        //compute_T_blocks(ell, *(this->randSetupOtMsgs),idxs,*ts);
-
-        //start = std::chrono::high_resolution_clock::now();
-        this->aes.hashBlocks(ts->data(), ts->size(), vals.data());
+        //MC_AWAIT_SET(ec, sock.send(std::move(*okvs)) | macoro::wrap());
 
-        //end = std::chrono::high_resolution_clock::now();
-        //elapsed = end - start;
-        //std::cout << "Time taken to execute >aes.hashBlocks: " << elapsed.count() << " seconds" << std::endl;
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "multi_oprf.compute_t");
+            compute_T_blocks(ell, *(this->randSetupOtMsgs), idxs, *ts);
+        }
 
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "multi_oprf.hash");
+            this->aes.hashBlocks(ts->data(), ts->size(), vals.data());
+        }
 
         delete rs;
         delete ts;
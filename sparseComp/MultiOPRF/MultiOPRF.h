@@ -5,6 +5,7 @@
 #include "cryptoTools/Crypto/AES.h"
 #include "cryptoTools/Crypto/PRNG.h"
 #include "cryptoTools/Common/BitVector.h"
+#include "./OtExt.h"
 #include <cstdint>
 #include <vector>
 #include <array>
@@ -21,6 +22,24 @@ namespace sparse_comp::multi_oprf {
     const size_t ell = 128;
     const size_t comp_sec_param = 128;
 
+    class Sender;
+    class Receiver;
+    class OtPool;
+
+    // Runs a single base OT phase and ot_count random OTs in each direction. The leader is the OT receiver
+    // of the first extension, whose trailing baseOtCount() OTs seed the reverse direction extension.
+    // Both parties must pass the same otExt.
+    Proto extend_random_ots(coproto::Socket& sock, PRNG& prng, bool is_leader, size_t ot_count,
+                            BitVector& recvOtChoices, std::vector<block>& recvOtMsgs, std::vector<std::array<block, 2>>& sendOtMsgs,
+                            OtExtConfig otExt = OtExtConfig());
+
+    // Sets up num_instances senders and receivers over a single base OT phase. The leader plays the
+    // part of Sender::setup followed by Receiver::setup, the other party the reverse.
+    Proto setup_session(coproto::Socket& sock, PRNG& prng, bool is_leader, size_t num_instances, std::vector<Sender*>& senders, std::vector<Receiver*>& receivers, OtExtConfig otExt = OtExtConfig());
+
+    // Same as above, but the setup OTs are taken from a fresh slice of a pool shared with the peer.
+    Proto setup_session(coproto::Socket& sock, OtPool& pool, size_t num_instances, std::vector<Sender*>& senders, std::vector<Receiver*>& receivers);
+
     class Sender {
         private:
             std::vector<block>* randSetupOtMsgs = nullptr;
@@ -30,9 +49,10 @@ namespace sparse_comp::multi_oprf {
             AES aes = AES(block(13133210048402866,17132091720387928));
 
         public:
+            Sender(block s, const block* randSetupOtMsgs);
             ~Sender();
 
-            static Proto setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Sender*>& senders);
+            static Proto setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Sender*>& senders, OtExtConfig otExt = OtExtConfig());
 
             Proto send(coproto::Socket& sock, size_t query_num);
             void eval(std::vector<block>& idxs, std::vector<block>& vals);
@@ -44,9 +64,10 @@ namespace sparse_comp::multi_oprf {
             AES aes = AES(block(13133210048402866,17132091720387928));
        
         public:
+            Receiver(const std::array<block, 2>* randSetupOtMsgs);
             ~Receiver();
 
-            static Proto setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Receiver*>& receivers);
+            static Proto setup(coproto::Socket& sock, PRNG& prng, size_t num_instances, std::vector<Receiver*>& receivers, OtExtConfig otExt = OtExtConfig());
 
             Proto receive(coproto::Socket& sock, std::vector<block>& idxs, std::vector<block>& vals);
 
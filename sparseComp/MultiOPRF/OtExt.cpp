@@ -0,0 +1,104 @@
+#include "./OtExt.h"
+#include "libOTe/config.h"
+#include <stdexcept>
+#include <string>
+
+#ifdef ENABLE_KOS
+#include "libOTe/TwoChooseOne/Kos/KosOtExtReceiver.h"
+#include "libOTe/TwoChooseOne/Kos/KosOtExtSender.h"
+#endif
+
+#ifdef ENABLE_IKNP
+#include "libOTe/TwoChooseOne/Iknp/IknpOtExtReceiver.h"
+#include "libOTe/TwoChooseOne/Iknp/IknpOtExtSender.h"
+#endif
+
+#ifdef ENABLE_SOFTSPOKEN_OT
+#include "libOTe/TwoChooseOne/SoftSpokenOT/SoftSpokenShOtExt.h"
+#endif
+
+using OtExtBackend = sparse_comp::multi_oprf::OtExtBackend;
+using OtExtConfig = sparse_comp::multi_oprf::OtExtConfig;
+
+static void throw_unavailable(OtExtBackend backend) {
+    throw std::runtime_error(std::string("OT extension backend ") + sparse_comp::multi_oprf::ot_ext_backend_name(backend) + " is not enabled in libOTe");
+}
+
+const char* sparse_comp::multi_oprf::ot_ext_backend_name(OtExtBackend backend) {
+    switch (backend) {
+        case OtExtBackend::Kos: return "kos";
+        case OtExtBackend::Iknp: return "iknp";
+        case OtExtBackend::SoftSpoken: return "softspoken";
+    }
+
+    return "unknown";
+}
+
+bool sparse_comp::multi_oprf::ot_ext_backend_available(OtExtBackend backend) {
+    switch (backend) {
+#ifdef ENABLE_KOS
+        case OtExtBackend::Kos: return true;
+#endif
+#ifdef ENABLE_IKNP
+        case OtExtBackend::Iknp: return true;
+#endif
+#ifdef ENABLE_SOFTSPOKEN_OT
+        case OtExtBackend::SoftSpoken: return true;
+#endif
+        default: return false;
+    }
+}
+
+osuCrypto::OtExtSender* sparse_comp::multi_oprf::make_ot_ext_sender(const OtExtConfig& config) {
+    switch (config.backend) {
+#ifdef ENABLE_KOS
+        case OtExtBackend::Kos: {
+            osuCrypto::KosOtExtSender* otSender = new osuCrypto::KosOtExtSender();
+            otSender->mIsMalicious = false;
+            return otSender;
+        }
+#endif
+#ifdef ENABLE_IKNP
+        case OtExtBackend::Iknp:
+            return new osuCrypto::IknpOtExtSender();
+#endif
+#ifdef ENABLE_SOFTSPOKEN_OT
+        case OtExtBackend::SoftSpoken: {
+            osuCrypto::SoftSpokenShOtSender<>* otSender = new osuCrypto::SoftSpokenShOtSender<>();
+            otSender->init(config.soft_spoken_field_bits, true); // Random OTs, which is all the setup needs
+            return otSender;
+        }
+#endif
+        default:
+            throw_unavailable(config.backend);
+    }
+
+    return nullptr;
+}
+
+osuCrypto::OtExtReceiver* sparse_comp::multi_oprf::make_ot_ext_receiver(const OtExtConfig& config) {
+    switch (config.backend) {
+#ifdef ENABLE_KOS
+        case OtExtBackend::Kos: {
+            osuCrypto::KosOtExtReceiver* otRecv = new osuCrypto::KosOtExtReceiver();
+            otRecv->mIsMalicious = false;
+            return otRecv;
+        }
+#endif
+#ifdef ENABLE_IKNP
+        case OtExtBackend::Iknp:
+            return new osuCrypto::IknpOtExtReceiver();
+#endif
+#ifdef ENABLE_SOFTSPOKEN_OT
+        case OtExtBackend::SoftSpoken: {
+            osuCrypto::SoftSpokenShOtReceiver<>* otRecv = new osuCrypto::SoftSpokenShOtReceiver<>();
+            otRecv->init(config.soft_spoken_field_bits, true);
+            return otRecv;
+        }
+#endif
+        default:
+            throw_unavailable(config.backend);
+    }
+
+    return nullptr;
+}
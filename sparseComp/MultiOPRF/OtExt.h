@@ -0,0 +1,36 @@
+#pragma once
+
+#include "libOTe/TwoChooseOne/OTExtInterface.h"
+#include <cstdint>
+#include <stddef.h>
+
+namespace sparse_comp::multi_oprf {
+
+    // Semi-honest OT extension used by the OPRF setup. Backends that were not compiled into libOTe
+    // (ENABLE_KOS, ENABLE_IKNP, ENABLE_SOFTSPOKEN_OT) are rejected at setup time.
+    enum class OtExtBackend {
+        Kos,
+        Iknp,
+        SoftSpoken
+    };
+
+    struct OtExtConfig {
+        OtExtBackend backend = OtExtBackend::Kos;
+        // SoftSpokenOT field size in bits; larger fields trade computation for less communication.
+        size_t soft_spoken_field_bits = 2;
+
+        OtExtConfig() = default;
+        OtExtConfig(OtExtBackend backend, size_t soft_spoken_field_bits = 2) {
+            this->backend = backend;
+            this->soft_spoken_field_bits = soft_spoken_field_bits;
+        }
+    };
+
+    const char* ot_ext_backend_name(OtExtBackend backend);
+    bool ot_ext_backend_available(OtExtBackend backend);
+
+    // Both throw std::runtime_error if the backend is not available. The caller owns the returned instance.
+    osuCrypto::OtExtSender* make_ot_ext_sender(const OtExtConfig& config);
+    osuCrypto::OtExtReceiver* make_ot_ext_receiver(const OtExtConfig& config);
+
+};
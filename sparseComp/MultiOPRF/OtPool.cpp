@@ -0,0 +1,262 @@
+#include "./OtPool.h"
+#include "./MultiOPRF.h"
+#include "../Common/CommStats.h"
+#include "../Common/FileUtils.h"
+#include "cryptoTools/Common/BitVector.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using BitVector = osuCrypto::BitVector;
+
+static const char POOL_MAGIC[8] = {'S','P','C','O','T','P','L','\0'};
+static const char CURSOR_MAGIC[8] = {'S','P','C','O','T','C','R','\0'};
+
+struct pool_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t is_leader;
+    uint64_t ot_count;
+    uint64_t pool_id[2];
+    uint8_t reserved[24];
+};
+
+static_assert(sizeof(pool_header) == 64, "the pool header must keep the sections 16 bytes aligned");
+
+struct cursor_record {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t pool_id[2];
+    uint64_t recv_cursor;
+    uint64_t send_cursor;
+};
+
+static size_t pool_file_size(size_t ot_count) {
+    return sizeof(pool_header) + ot_count / 8 + ot_count * sizeof(block) + ot_count * 2 * sizeof(block);
+}
+
+static std::string cursor_path(const std::string& path) {
+    return path + ".cursor";
+}
+
+static void write_cursor_file(const std::string& path, const block& pool_id, size_t recv_cursor, size_t send_cursor) {
+    cursor_record rec;
+    std::memset(&rec, 0, sizeof(rec));
+    std::memcpy(rec.magic, CURSOR_MAGIC, sizeof(CURSOR_MAGIC));
+    rec.version = sparse_comp::multi_oprf::OtPool::VERSION;
+    rec.pool_id[0] = pool_id.get<uint64_t>(0);
+    rec.pool_id[1] = pool_id.get<uint64_t>(1);
+    rec.recv_cursor = recv_cursor;
+    rec.send_cursor = send_cursor;
+
+    sparse_comp::write_file_atomically(cursor_path(path), {{&rec, sizeof(rec)}});
+}
+
+Proto sparse_comp::multi_oprf::OtPool::create(coproto::Socket& sock, PRNG& prng, bool is_leader, size_t ot_count, const std::string& path, OtExtConfig otExt) {
+    MC_BEGIN(Proto, &sock, &prng, is_leader, ot_count, &path, otExt,
+             recvOtChoices = (BitVector*) nullptr,
+             recvOtMsgs = (std::vector<block>*) nullptr,
+             sendOtMsgs = (std::vector<std::array<block, 2>>*) nullptr,
+             header = pool_header{},
+             pool_id = block(0,0));
+
+        ot_count = (ot_count + 127) / 128 * 128;
+
+        recvOtChoices = new BitVector();
+        recvOtMsgs = new std::vector<block>();
+        sendOtMsgs = new std::vector<std::array<block, 2>>();
+
+        MC_AWAIT(extend_random_ots(sock, prng, is_leader, ot_count, *recvOtChoices, *recvOtMsgs, *sendOtMsgs, otExt));
+
+        if (is_leader) {
+            pool_id = prng.get<block>();
+            MC_AWAIT(sock.send(pool_id));
+        } else {
+            MC_AWAIT(sock.recv(pool_id));
+        }
+
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, POOL_MAGIC, sizeof(POOL_MAGIC));
+        header.version = OtPool::VERSION;
+        header.is_leader = is_leader ? 1 : 0;
+        header.ot_count = ot_count;
+        header.pool_id[0] = pool_id.get<uint64_t>(0);
+        header.pool_id[1] = pool_id.get<uint64_t>(1);
+
+        sparse_comp::write_file_atomically(path, {{&header, sizeof(header)},
+                                     {recvOtChoices->data(), ot_count / 8},
+                                     {recvOtMsgs->data(), ot_count * sizeof(block)},
+                                     {sendOtMsgs->data(), ot_count * 2 * sizeof(block)}});
+        write_cursor_file(path, pool_id, 0, 0);
+
+        delete recvOtChoices;
+        delete recvOtMsgs;
+        delete sendOtMsgs;
+
+    MC_END();
+}
+
+Proto sparse_comp::multi_oprf::OtPool::create_in_memory(coproto::Socket& sock, PRNG& prng, bool is_leader, size_t ot_count, OtPool*& pool, OtExtConfig otExt) {
+    MC_BEGIN(Proto, &sock, &prng, is_leader, ot_count, &pool, otExt,
+             recvOtChoices = (BitVector*) nullptr,
+             recvOtMsgs = (std::vector<block>*) nullptr,
+             sendOtMsgs = (std::vector<std::array<block, 2>>*) nullptr,
+             pool_id = block(0,0));
+
+        ot_count = (ot_count + 127) / 128 * 128;
+
+        recvOtChoices = new BitVector();
+        recvOtMsgs = new std::vector<block>();
+        sendOtMsgs = new std::vector<std::array<block, 2>>();
+
+        MC_AWAIT(extend_random_ots(sock, prng, is_leader, ot_count, *recvOtChoices, *recvOtMsgs, *sendOtMsgs, otExt));
+
+        if (is_leader) {
+            pool_id = prng.get<block>();
+            MC_AWAIT(sock.send(pool_id));
+        } else {
+            MC_AWAIT(sock.recv(pool_id));
+        }
+
+        pool = new OtPool();
+        pool->pool_id = pool_id;
+        pool->is_leader = is_leader;
+        pool->ot_count = ot_count;
+
+        // Same layout as the sections of a pool file: choice bits, chosen messages, message pairs
+        pool->memory.resize(ot_count / 128 + ot_count + ot_count * 2);
+        std::memcpy(pool->memory.data(), recvOtChoices->data(), ot_count / 8);
+        std::memcpy(pool->memory.data() + ot_count / 128, recvOtMsgs->data(), ot_count * sizeof(block));
+        std::memcpy(pool->memory.data() + ot_count / 128 + ot_count, sendOtMsgs->data(), ot_count * 2 * sizeof(block));
+
+        pool->recv_choice_blocks = pool->memory.data();
+        pool->recv_msgs = pool->memory.data() + ot_count / 128;
+        pool->send_msgs = (const std::array<block, 2>*) (pool->memory.data() + ot_count / 128 + ot_count);
+
+        delete recvOtChoices;
+        delete recvOtMsgs;
+        delete sendOtMsgs;
+
+    MC_END();
+}
+
+sparse_comp::multi_oprf::OtPool* sparse_comp::multi_oprf::OtPool::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("could not open OT pool " + path);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(pool_header)) {
+        ::close(fd);
+        throw std::runtime_error("malformed OT pool " + path);
+    }
+
+    void* map = ::mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (map == MAP_FAILED) throw std::runtime_error("could not map OT pool " + path);
+
+    OtPool* pool = new OtPool();
+    pool->path = path;
+    pool->map = map;
+    pool->map_size = (size_t) st.st_size;
+
+    const pool_header* header = (const pool_header*) map;
+
+    if (std::memcmp(header->magic, POOL_MAGIC, sizeof(POOL_MAGIC)) != 0 || header->version != OtPool::VERSION ||
+        header->ot_count % 128 != 0 || pool_file_size(header->ot_count) != pool->map_size) {
+        delete pool;
+        throw std::runtime_error("malformed or unsupported OT pool " + path);
+    }
+
+    pool->pool_id = block(header->pool_id[1], header->pool_id[0]);
+    pool->is_leader = header->is_leader != 0;
+    pool->ot_count = header->ot_count;
+
+    const uint8_t* sections = (const uint8_t*) map + sizeof(pool_header);
+    pool->recv_choice_blocks = (const block*) sections;
+    pool->recv_msgs = (const block*) (sections + pool->ot_count / 8);
+    pool->send_msgs = (const std::array<block, 2>*) (sections + pool->ot_count / 8 + pool->ot_count * sizeof(block));
+
+    // Without a valid cursor we cannot tell which OTs were already used, so the pool is refused
+    cursor_record rec;
+    fd = ::open(cursor_path(path).c_str(), O_RDONLY);
+
+    if (fd < 0 || ::read(fd, &rec, sizeof(rec)) != (ssize_t) sizeof(rec) ||
+        std::memcmp(rec.magic, CURSOR_MAGIC, sizeof(CURSOR_MAGIC)) != 0 || rec.version != OtPool::VERSION ||
+        rec.pool_id[0] != header->pool_id[0] || rec.pool_id[1] != header->pool_id[1]) {
+        if (fd >= 0) ::close(fd);
+        delete pool;
+        throw std::runtime_error("missing or malformed OT pool cursor " + cursor_path(path));
+    }
+
+    ::close(fd);
+
+    pool->recv_cursor = rec.recv_cursor;
+    pool->send_cursor = rec.send_cursor;
+
+    return pool;
+}
+
+sparse_comp::multi_oprf::OtPool::~OtPool() {
+    if (this->map != nullptr) ::munmap(this->map, this->map_size);
+}
+
+size_t sparse_comp::multi_oprf::OtPool::available() const {
+    return this->ot_count - std::min(this->ot_count, std::max(this->recv_cursor, this->send_cursor));
+}
+
+void sparse_comp::multi_oprf::OtPool::store_cursors(size_t recv_cursor, size_t send_cursor) {
+    // Pools kept in memory have no path
+    if (!this->path.empty()) write_cursor_file(this->path, this->pool_id, recv_cursor, send_cursor);
+
+    this->recv_cursor = recv_cursor;
+    this->send_cursor = send_cursor;
+}
+
+Proto sparse_comp::multi_oprf::OtPool::reserve(coproto::Socket& sock, size_t num_ots, size_t& recv_offset, size_t& send_offset) {
+    MC_BEGIN(Proto, this, &sock, num_ots, &recv_offset, &send_offset,
+             local = std::array<uint64_t, 6>{},
+             remote = std::array<uint64_t, 6>{});
+
+        if (num_ots % 128 != 0) throw std::runtime_error("OT pool slices must be a multiple of 128 OTs");
+
+        local[0] = this->pool_id.get<uint64_t>(0);
+        local[1] = this->pool_id.get<uint64_t>(1);
+        local[2] = this->recv_cursor;
+        local[3] = this->send_cursor;
+        local[4] = this->ot_count;
+        local[5] = this->is_leader ? 1 : 0;
+
+        if (this->is_leader) {
+            sparse_comp::comm::note_send(sock);
+            MC_AWAIT(sock.send(local));
+            sparse_comp::comm::note_recv(sock);
+            MC_AWAIT(sock.recv(remote));
+        } else {
+            sparse_comp::comm::note_recv(sock);
+            MC_AWAIT(sock.recv(remote));
+            sparse_comp::comm::note_send(sock);
+            MC_AWAIT(sock.send(local));
+        }
+
+        if (remote[0] != local[0] || remote[1] != local[1] || remote[4] != local[4]) throw std::runtime_error("the peer holds a different OT pool");
+        if (remote[5] == local[5]) throw std::runtime_error("the peer holds the same half of the OT pool");
+
+        // Our receiver section is paired with the peer's sender section and vice versa. Taking the
+        // max skips slices that only one side managed to persist.
+        recv_offset = std::max(this->recv_cursor, (size_t) remote[3]);
+        send_offset = std::max(this->send_cursor, (size_t) remote[2]);
+
+        if (recv_offset + num_ots > this->ot_count || send_offset + num_ots > this->ot_count) throw std::runtime_error("OT pool exhausted");
+
+        this->store_cursors(recv_offset + num_ots, send_offset + num_ots);
+
+    MC_END();
+}
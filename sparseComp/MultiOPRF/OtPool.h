@@ -0,0 +1,90 @@
+#pragma once
+
+#include "coproto/Socket/Socket.h"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "./OtExt.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using PRNG = osuCrypto::PRNG;
+using block = osuCrypto::block;
+
+using Proto = coproto::task<void>;
+
+namespace sparse_comp::multi_oprf {
+
+    // OTs per direction that one run of an SpX protocol, or of a fuzzy protocol, takes from a pool: 128 for
+    // each of its 2 OPRF instances. A pool of n * RUN_POOL_OTS OTs serves n runs.
+    constexpr size_t RUN_POOL_OTS = 2 * 128;
+
+    // Pool of random OTs shared by two fixed peers and stored on disk, so that sessions between them can skip
+    // base OTs and OT extension. Each side keeps the OTs where it is the OT receiver (choice bits and chosen
+    // messages) and those where it is the OT sender (message pairs). The pool file is mapped read only; the
+    // consumed prefix of each section is tracked in a cursor file next to it (<path>.cursor), which is replaced
+    // atomically before any OT of a reserved slice is handed out, so that no OT is ever used twice.
+    //
+    // The SpX and fuzzy protocols take an optional pool (their otPool constructor argument). With one, the OPRF
+    // setup of each run goes through setup_session on a fresh slice of the pool instead of running base OTs and
+    // OT extension, and otExt is unused; without one, both parties must pass the same otExt. Only the MultiOprf
+    // backend draws from a pool, the RsOprf backend needs no setup OTs. Both peers must hold the two halves of
+    // the same pool, created together by create.
+    class OtPool {
+        private:
+            std::string path;
+            void* map = nullptr;
+            size_t map_size = 0;
+
+            block pool_id;
+            bool is_leader = false;
+            size_t ot_count = 0;
+            size_t recv_cursor = 0;
+            size_t send_cursor = 0;
+
+            // Sections of a pool kept in memory rather than mapped, see create_in_memory
+            std::vector<block> memory;
+
+            const block* recv_choice_blocks = nullptr;
+            const block* recv_msgs = nullptr;
+            const std::array<block, 2>* send_msgs = nullptr;
+
+            OtPool() = default;
+
+            void store_cursors(size_t recv_cursor, size_t send_cursor);
+
+        public:
+            static constexpr uint32_t VERSION = 1;
+
+            ~OtPool();
+
+            OtPool(const OtPool&) = delete;
+            OtPool& operator=(const OtPool&) = delete;
+
+            // Runs base OTs and OT extension with the peer once and writes a pool of ot_count OTs per direction
+            // to path. ot_count is rounded up to a multiple of 128.
+            static Proto create(coproto::Socket& sock, PRNG& prng, bool is_leader, size_t ot_count, const std::string& path, OtExtConfig otExt = OtExtConfig());
+
+            // Same as create, but keeps the pool in memory for the runs of a single session, e.g. the batches of
+            // fuzzy_batch; its cursors are not persisted. The caller owns the returned pool.
+            static Proto create_in_memory(coproto::Socket& sock, PRNG& prng, bool is_leader, size_t ot_count, OtPool*& pool, OtExtConfig otExt = OtExtConfig());
+
+            // Maps the pool at path; throws std::runtime_error if the file is missing or malformed.
+            static OtPool* open(const std::string& path);
+
+            // Agrees with the peer on the next slice of num_ots unused OTs per direction and persists the advanced cursors.
+            // num_ots must be a multiple of 128. Throws std::runtime_error if the peer holds another pool, the other half of a
+            // pool of another size or the same half, or if the pool is exhausted.
+            Proto reserve(coproto::Socket& sock, size_t num_ots, size_t& recv_offset, size_t& send_offset);
+
+            bool leader() const { return this->is_leader; }
+            size_t size() const { return this->ot_count; }
+            size_t available() const;
+
+            const block* recvOtChoiceBlocks() const { return this->recv_choice_blocks; }
+            const block* recvOtMsgs() const { return this->recv_msgs; }
+            const std::array<block, 2>* sendOtMsgs() const { return this->send_msgs; }
+    };
+
+};
@@ -7,6 +7,8 @@
 #include "cryptoTools/Crypto/AES.h"
 #include "../Common/BaxosUtils.h"
 #include "../Common/SockUtils.h"
+#include "../Common/CommStats.h"
+#include "../Common/Trace.h"
 #include <vector>
 #include <array>
 #include <iostream>
@@ -204,28 +206,18 @@ static vector<block>* encode_okvs(const AES& aes, vector<block>& pointHashes, ar
     paxos.init(t*k*n, sparse_comp::baxosBinSize(t*k*n), 3, SSP, PaxosParam::GF128, oc::ZeroBlock);
     vector<block>* paxos_structure = new vector<block>(paxos.size());
 
-    // std::cout << okvs_idxs.size() << ";" << okvs_values.size() << std::endl;
-
-    //std::cout << "sender encoded values: " << (okvs_values[0] & (block(0,-1) >> 62)) << " , " << (okvs_values[1] & (block(0,-1) >> 62)) << std::endl;
-
     paxos.solve<block>(okvs_idxs, okvs_values, *paxos_structure, nullptr, NUM_THREADS);
 
-    // std::cout << "TEST" << std::endl;
-
     return paxos_structure;
 }
 
-size_t calc_compact_okvs_struct_size(size_t okvs_struct_size, uint8_t keep_nbits) {
+inline size_t calc_compact_okvs_struct_size(size_t okvs_struct_size, uint8_t keep_nbits) {
     return ceil(((double) (okvs_struct_size*keep_nbits))/((double) 64));
 }
 
-vector<uint64_t>* truncate_okvs(vector<block>& okvs_struct, uint8_t keep_nbits) {
-
-    //std::cout << "okvs_struct_size: " << okvs_struct.size() << std::endl;
-    //std::cout << "keep_nbits: " << uint64_t(keep_nbits) << std::endl;
+inline vector<uint64_t>* truncate_okvs(vector<block>& okvs_struct, uint8_t keep_nbits) {
 
     const size_t cmpct_okvs_strcut_size = calc_compact_okvs_struct_size(okvs_struct.size(), keep_nbits);
-    //std::cout << "cmpct_okvs_strcut_size: " << cmpct_okvs_strcut_size << std::endl;
     vector<uint64_t>* cmpct_paxos_struct_p = new vector<uint64_t>(cmpct_okvs_strcut_size);
     vector<uint64_t>& cmpct_paxos_struct = *cmpct_paxos_struct_p;
 
@@ -255,7 +247,7 @@ vector<uint64_t>* truncate_okvs(vector<block>& okvs_struct, uint8_t keep_nbits)
 
 }
 
-void reconstruct_okvs(vector<uint64_t>& compressed_okvs, uint8_t keep_nbits, vector<block>& okvs_struct) {
+inline void reconstruct_okvs(vector<uint64_t>& compressed_okvs, uint8_t keep_nbits, vector<block>& okvs_struct) {
     size_t curr_cmpt_struct_idx = 0;
     size_t curr_cell_bit_offset = 0;
     for (size_t i=0;i < okvs_struct.size();i++) {
@@ -302,29 +294,29 @@ Proto sendTruncatedOkvsStructure(Socket& sock, vector<block>& okvs_struct) {
     MC_BEGIN(Proto, &sock, &okvs_struct,
              truncated_okvs = (vector<uint64_t>*) nullptr,
              log2M = uint8_t(0),
-             t = coproto::task<void>());
+             t = coproto::task<void>(),
+             scope = (sparse_comp::comm::CommScope*) nullptr);
         
         log2M = ceil(log2(M));
 
-//	std::cout << "computing truncated okvs (s)" << std::endl;
-
-        truncated_okvs = truncate_okvs(okvs_struct, log2M);
-
-//	std::cout << "truncated okvs computed (s)" << std::endl;
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "spbsot.truncate");
+            truncated_okvs = truncate_okvs(okvs_struct, log2M);
+        }
 
-//	std::cout << "truncated okvs vec size: " << truncated_okvs->size() << std::endl;
-    
         // print_truncated_okvs(okvs_struct);
 
         //MC_AWAIT(sock.send(std::move(*truncated_okvs)));
 
-        //std::cout << "sending truncated okvs (s); okvs byte size" << truncated_okvs->size() * sizeof(uint64_t) << std::endl;
+        scope = new sparse_comp::comm::CommScope(sock, "spbsot.okvs");
+        SPARSE_COMP_TRACE_BEGIN(sock, "spbsot.okvs");
 
         t = sparse_comp::send<uint64_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, *truncated_okvs);
 
         MC_AWAIT(t);
 
-        //std::cout << "sent truncated okvs (s)" << std::endl;
+        SPARSE_COMP_TRACE_END(sock, "spbsot.okvs");
+        delete scope;
 
         delete truncated_okvs;
     
@@ -341,13 +333,10 @@ Proto sender_query_oprf(coproto::Socket& sock, OprfReceiver& oprfRecv, const vec
         g = 0;
 
         for (size_t i=0;i < t;i++) {
-            // std::cout << "i = " << i << std::endl;
-            // std::cout << sparse_point.coords[0] << ";" << sparse_point.coords[1] << std::endl;
 
             for (size_t j=0;j < k;j++) {
                 
                 oprf_points[g] = oprf_point(ordIndexSet[i], j, 0);
-                // std::cout << "coord[0] = " << oprf_points[g].point.coords[0] << " coord[1] = " << oprf_points[g].point.coords[1] << " sot_ix = " << (+oprf_points[g].sot_idx) << " sot_choice_share = " << (+oprf_points[g].sot_choice_share) << std::endl;
 
                 g++;
             }
@@ -360,8 +349,8 @@ Proto sender_query_oprf(coproto::Socket& sock, OprfReceiver& oprfRecv, const vec
 }
 
 template<size_t tr, size_t t, size_t k, size_t n, uint64_t M>
-Proto sparse_comp::sp_bsot::Sender<tr,t,k,n,M>::send(coproto::Socket& sock, vector<block>& ordIndexSet, array<array<array<ZN<M>,n>,k>,t>& msg_vecs, array<array<ZN<n>,k>,t>& choice_vec_shares, array<array<ZN<M>,k>,t>& output_shares) {
-    MC_BEGIN(Proto, this, &sock, &ordIndexSet, &msg_vecs, &choice_vec_shares, &output_shares,
+Proto sparse_comp::sp_bsot::Sender<tr,t,k,n,M>::send(coproto::Socket& sock, vector<block>& ordIndexSet, array<array<array<ZN<M>,n>,k>,t>& msg_vecs, array<array<ZN<n>,k>,t>& choice_vec_shares, array<array<ZN<M>,k>,t>& output_shares, bool output_shares_presampled) {
+    MC_BEGIN(Proto, this, &sock, &ordIndexSet, &msg_vecs, &choice_vec_shares, &output_shares, output_shares_presampled,
     oprfSendProto = Proto(),
     oprfRecvProto = Proto(),
     msg_vecs_masked_with_r = (array<VecMatrix<ZN<M>>*,t>*) nullptr,
@@ -369,67 +358,38 @@ Proto sparse_comp::sp_bsot::Sender<tr,t,k,n,M>::send(coproto::Socket& sock, vect
     okvs_structure = (vector<block>*) nullptr,
     h_vec = vector<block>(t*k)
     );
-        // std::cout << "(SENDER) SENDING OPRF" << std::endl;
-
-        // std::cout << "spsot bytes sent: " << sock.bytesSent() << std::endl;
-        // std::cout << "spsot bytes received: " << sock.bytesReceived() << std::endl;
-
-        //	std::cout << "oprf sending" << std::endl;
 
+        SPARSE_COMP_TRACE_BEGIN(sock, "spbsot.oprf");
         oprfSendProto = this->oprfSender->send(sock,k*tr);
         oprfRecvProto = sender_query_oprf<t,k>(sock,*(this->oprfReceiver), ordIndexSet, h_vec);
         MC_AWAIT(oprfSendProto);
         MC_AWAIT(oprfRecvProto);
+        SPARSE_COMP_TRACE_END(sock, "spbsot.oprf");
 
-        //	std::cout << "oprf sent 2" << std::endl;
-
-        ZN<M>::template sample<t,k>(*(this->prng), output_shares);
-
-        msg_vecs_masked_with_r = mask_msg_vectors_with_r_values<t,k,n,M>(output_shares, msg_vecs);
-
-//	std::cout << "msg_vecs_masked_with_r (s)" << std::endl;
-
-        //std::cout << "sender output share: " << (output_shares[0][0].to_uint64_t()) << std::endl;
-        //std::cout << "sender msg vec: " << (msg_vecs[0][0][0]).to_uint64_t() << "," << (msg_vecs[0][0][1]).to_uint64_t() << std::endl;
-        //std::cout << "sender msg vec masked with r: " << ((*msg_vecs_masked_with_r)[0]->row(0)[0]).to_uint64_t() << "," << ((*msg_vecs_masked_with_r)[0]->row(0)[1]).to_uint64_t() << std::endl;
-
-        cshift_masked_matrices<n,M,k,t>(*msg_vecs_masked_with_r,choice_vec_shares);
-
-//	std::cout << "cshift_masked_matrices (s)" << std::endl;
-
-        //std::cout << "cshifted sender msg vec masked with r: " << ((*msg_vecs_masked_with_r)[0]->row(0)[0]).to_uint64_t() << "," << ((*msg_vecs_masked_with_r)[0]->row(0)[1]).to_uint64_t() << std::endl;
-
-        block_matrix = ZN_matrix_array_to_block_matrix_array<t,k,n,M>(*msg_vecs_masked_with_r);
-        sparse_comp::free_array<VecMatrix<ZN<M>>,t>(msg_vecs_masked_with_r);
-
-//	std::cout << "ZN_matrix_array_to_block_matrix_array (s)" << std::endl;
-
-        //std::cout << "shifted sender msg vec as block: " << (*block_matrix)[0]->row(0)[0] << " , " << (*block_matrix)[0]->row(0)[1] << std::endl;
-
-
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "spbsot.mask");
 
-        //std::cout << "spsot bytes sent: " << sock.bytesSent() << std::endl;
-        //std::cout << "spsot bytes received: " << sock.bytesReceived() << std::endl;
+            if (!output_shares_presampled) ZN<M>::template sample<t,k>(*(this->prng), output_shares);
 
-        // std::cout << "(SENDER) OPRF SENT" << std::endl;
+            msg_vecs_masked_with_r = mask_msg_vectors_with_r_values<t,k,n,M>(output_shares, msg_vecs);
 
-        mask_block_mtx_using_oprf<t,k,n>(*(this->oprfSender), ordIndexSet, *block_matrix);
-        mask_block_mtx_using_h_vec<t,k,n>(*block_matrix, h_vec);
+            cshift_masked_matrices<n,M,k,t>(*msg_vecs_masked_with_r,choice_vec_shares);
 
+            block_matrix = ZN_matrix_array_to_block_matrix_array<t,k,n,M>(*msg_vecs_masked_with_r);
+            sparse_comp::free_array<VecMatrix<ZN<M>>,t>(msg_vecs_masked_with_r);
 
-//	std::cout << "mask_block_mtx_using_oprf (s)" << std::endl;
-
-        // std::cout << "(SENDER) ENCODING OKVS AS PART OF SP SOT" << std::endl;
-
-        okvs_structure = encode_okvs<t,k,n>(this->aes, ordIndexSet, *block_matrix);
-        sparse_comp::free_array<VecMatrix<block>,t>(block_matrix);
+            mask_block_mtx_using_oprf<t,k,n>(*(this->oprfSender), ordIndexSet, *block_matrix);
+            mask_block_mtx_using_h_vec<t,k,n>(*block_matrix, h_vec);
+        }
 
-//	std::cout << "sending truncated okvs" << std::endl;
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "spbsot.okvs_encode");
+            okvs_structure = encode_okvs<t,k,n>(this->aes, ordIndexSet, *block_matrix);
+            sparse_comp::free_array<VecMatrix<block>,t>(block_matrix);
+        }
 
         MC_AWAIT(sendTruncatedOkvsStructure<M>(sock,*okvs_structure));
 
-//	std::cout << "sent truncated okvs" << std::endl;
-
         //REMBER TO FREE/DELETE ALLOCATED LISTS AND MATRICES!!!!!!
 
         delete okvs_structure;
@@ -457,17 +417,10 @@ static vector<block>* decode_okvs(const AES& aes, const vector<block>& ordIndexS
 
     }
 
-    //std::cout << "before block paxos decoding" << std::endl;
-    //std::cout << paxos_structure.size() << std::endl;
-
     Baxos paxos;
     paxos.init(ts*k*n, sparse_comp::baxosBinSize(ts*k*n), 3, SSP, PaxosParam::GF128, oc::ZeroBlock);
     paxos.decode<block>(okvs_idxs, *okvs_values, paxos_structure);
 
-    //std::cout << "receiver paxos decoded values:" << std::endl;
-
-    //std::cout << "after block paxos decoding" << std::endl;
-
     return okvs_values;
 }
 
@@ -481,12 +434,7 @@ void extract_shares_from_okvs_values(CustomOPRFSender& oprfSender, vector<block>
     size_t g = 0;
 
 
-    //auto start = std::chrono::high_resolution_clock::now();
-    //std::cout << "before oprfSender.eval" << std::endl;
     oprfSender.eval(ordIndexSet, k, h_oprf_vals);
-    //auto end = std::chrono::high_resolution_clock::now();
-    //std::chrono::duration<double> elapsed = end - start;
-    //std::cout << "Time taken to execute oprfSender.eval: " << elapsed.count() << " seconds" << std::endl;
 
     for (size_t i=0;i < t;i++) {
         array<ZN<M>,k>& output_shares_row = output_shares_mtx.at(i);
@@ -513,14 +461,11 @@ Proto receiver_query_oprf(coproto::Socket& sock, OprfReceiver& oprfReceiver,  co
         g = 0;
 
         for (size_t i=0;i < t;i++) {
-            // std::cout << "i = " << i << std::endl;
-            // std::cout << sparse_point.coords[0] << ";" << sparse_point.coords[1] << std::endl;
             array<ZN<n>,k>& choice_vec_share = choice_vec_shares[i];
 
             for (size_t j=0;j < k;j++) {
                 
                 oprf_points[g] = oprf_point(ordIndexSet[i], j, choice_vec_share[j].to_size_t());
-                // std::cout << "coord[0] = " << oprf_points[g].point.coords[0] << " coord[1] = " << oprf_points[g].point.coords[1] << " sot_ix = " << (+oprf_points[g].sot_idx) << " sot_choice_share = " << (+oprf_points[g].sot_choice_share) << std::endl;
 
                 g++;
             }
@@ -532,38 +477,33 @@ Proto receiver_query_oprf(coproto::Socket& sock, OprfReceiver& oprfReceiver,  co
     MC_END();
 } 
 
-template<size_t ts, size_t t, size_t k, size_t n, uint64_t M>
-static void internalReceive(const AES& aes, vector<block>& oprf_vals, CustomOPRFSender& oprfSender, vector<block>& paxos_structure, vector<block>& ordIndexSet, array<array<ZN<n>,k>,t>& choice_vec_shares, array<array<ZN<M>,k>,t>& output_shares) {
-    auto okvs_vals = decode_okvs<ts,t,k,n>(aes, ordIndexSet,choice_vec_shares, paxos_structure);
-
-    extract_shares_from_okvs_values<t,k,n,M>(oprfSender, ordIndexSet,*okvs_vals, oprf_vals, output_shares);
-
-    delete okvs_vals;
-}
-
 template<uint64_t M>
 Proto receiveTruncatedOkvsStructure(coproto::Socket& sock, vector<block>& okvs_struct) {
     MC_BEGIN(Proto, &sock, &okvs_struct,
              truncated_okvs = (vector<uint64_t>*) nullptr,
              log2M = uint8_t(0),
-             t = coproto::task<void>());
+             t = coproto::task<void>(),
+             scope = (sparse_comp::comm::CommScope*) nullptr);
         log2M = ceil(log2(M));
 
         truncated_okvs = new vector<uint64_t>(calc_compact_okvs_struct_size(okvs_struct.size(), log2M));
 
-        // std::cout << "received trucated okvs size: " << calc_compact_okvs_struct_size(okvs_struct.size(), log2M) << std::endl;
-
-        //std::cout << "receiving truncated okvs (r)" << std::endl;
+        scope = new sparse_comp::comm::CommScope(sock, "spbsot.okvs");
+        SPARSE_COMP_TRACE_BEGIN(sock, "spbsot.okvs");
 
         t = sparse_comp::receive<uint64_t,sparse_comp::COPROTO_MAX_SEND_SIZE_BYTES>(sock, truncated_okvs->size() ,*truncated_okvs);
 
         MC_AWAIT(t);
 
-        //std::cout << "received truncated okvs (r)" << std::endl;
+        SPARSE_COMP_TRACE_END(sock, "spbsot.okvs");
+        delete scope;
 
         //MC_AWAIT(sock.recvResize(*truncated_okvs));
 
-        reconstruct_okvs(*truncated_okvs, log2M, okvs_struct);
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "spbsot.reconstruct");
+            reconstruct_okvs(*truncated_okvs, log2M, okvs_struct);
+        }
 
         delete truncated_okvs;
 
@@ -576,13 +516,13 @@ Proto sparse_comp::sp_bsot::Receiver<ts,tr,k,n,M>::receive(coproto::Socket& sock
     oprf_values = vector<block>(tr*k),
     paxos = Baxos{},
     paxos_structure = (vector<block>*) nullptr,
+    okvs_values = (vector<block>*) nullptr,
     proto = Proto(),
     oprfSendProto = Proto(),
     i = size_t(0)
     );
-        // std::cout << "(RECEIVER) BEFORE SP SOT OPRF QUERY" << std::endl;
 
-//	std::cout << "receiving oprf (r)" << std::endl;
+        SPARSE_COMP_TRACE_BEGIN(sock, "spbsot.oprf");
 
         proto = receiver_query_oprf<tr,k,n>(sock,*(this->oprfReceiver), ordIndexSet, choice_vec_shares, oprf_values);
 
@@ -591,29 +531,28 @@ Proto sparse_comp::sp_bsot::Receiver<ts,tr,k,n,M>::receive(coproto::Socket& sock
         MC_AWAIT(proto);
         MC_AWAIT(oprfSendProto);
 
-//	std::cout << "oprf received (r)" << std::endl;
-
-        // std::cout << "(RECEIVER) AFTER SP SOT OPRF QUERY" << std::endl;
+        SPARSE_COMP_TRACE_END(sock, "spbsot.oprf");
 
         paxos = Baxos();
         paxos.init(ts*k*n, sparse_comp::baxosBinSize(ts*k*n), 3, SSP, PaxosParam::GF128, oc::ZeroBlock);
 
         paxos_structure = new vector<block>(paxos.size());
 
-//	std::cout << "wainting truncated okvs (r)" << std::endl;
-
         MC_AWAIT(
             receiveTruncatedOkvsStructure<M>(sock, *paxos_structure)
         );
 
-//	std::cout << "received truncated okvs (r)" << std::endl;	
-
-
-        internalReceive<ts,tr,k,n,M>(this->aes,oprf_values,*(this->oprfSender), *paxos_structure, ordIndexSet, choice_vec_shares, output_shares);
-
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "spbsot.okvs_decode");
+            okvs_values = decode_okvs<ts,tr,k,n>(this->aes, ordIndexSet, choice_vec_shares, *paxos_structure);
+        }
 
-//	std::cout << "internal received (r)" << std::endl;
+        {
+            SPARSE_COMP_TRACE_SCOPE(sock, "spbsot.extract");
+            extract_shares_from_okvs_values<tr,k,n,M>(*(this->oprfSender), ordIndexSet, *okvs_values, oprf_values, output_shares);
+        }
 
+        delete okvs_values;
         delete paxos_structure;
 
      MC_END();
@@ -4,6 +4,9 @@
 #include "cryptoTools/Crypto/PRNG.h"
 #include "cryptoTools/Crypto/AES.h"
 #include "cryptoTools/Common/block.h"
+#include "../MultiOPRF/OtPool.h"
+#include "../CustomOPRF/CustomizedOPRF.h"
+#include "../Common/OfflineBundle.h"
 #include <cstdint>
 #include <stddef.h>
 #include <vector>
@@ -24,14 +27,28 @@ namespace sparse_comp::sp_l1 {
 
         osuCrypto::PRNG* prng;
         osuCrypto::AES* aes;
+        sparse_comp::multi_oprf::OtPool* otPool;
+        sparse_comp::multi_oprf::OtExtConfig otExt;
+        sparse_comp::custom_oprf::OprfBackend oprfBackend;
             
         public:
-            Sender(osuCrypto::PRNG& prng, osuCrypto::AES& aes) {
+            Sender(osuCrypto::PRNG& prng, osuCrypto::AES& aes, sparse_comp::multi_oprf::OtPool* otPool = nullptr, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf) {
                 this->prng = &prng;
                 this->aes = &aes;
+                this->otPool = otPool;
+                this->otExt = otExt;
+                this->oprfBackend = oprfBackend;
             }
 
+            // Same as preprocess followed by online.
             Proto send(coproto::Socket& sock, vector<block>& ordIndexHashSet, array<array<uint32_t,d>,ts>& in_values, array<array<block,1>,ts>& z_vec_shares);
+
+            using Offline = sparse_comp::SenderOfflineBundle<ts,d,d*(delta + 1) + 1>;
+
+            // Input independent part of send: OPRF setup and sampling of the output shares and message masks.
+            Proto preprocess(coproto::Socket& sock, Offline& offline);
+            // Input dependent part of send; offline must come from preprocess and is consumed.
+            Proto online(coproto::Socket& sock, Offline& offline, vector<block>& ordIndexHashSet, array<array<uint32_t,d>,ts>& in_values, array<array<block,1>,ts>& z_vec_shares);
     };
 
     template<size_t ts, size_t tr, size_t d, uint8_t delta, uint8_t ssp>
@@ -39,14 +56,28 @@ namespace sparse_comp::sp_l1 {
 
         osuCrypto::PRNG* prng;
         osuCrypto::AES* aes;
+        sparse_comp::multi_oprf::OtPool* otPool;
+        sparse_comp::multi_oprf::OtExtConfig otExt;
+        sparse_comp::custom_oprf::OprfBackend oprfBackend;
             
         public:
-            Receiver(osuCrypto::PRNG& prng, osuCrypto::AES& aes) {
+            Receiver(osuCrypto::PRNG& prng, osuCrypto::AES& aes, sparse_comp::multi_oprf::OtPool* otPool = nullptr, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf) {
                 this->prng = &prng;
                 this->aes = &aes;
+                this->otPool = otPool;
+                this->otExt = otExt;
+                this->oprfBackend = oprfBackend;
             }
             
+            // Same as preprocess followed by online.
             Proto receive(coproto::Socket& sock, vector<osuCrypto::block>& ordIndexHashSet, array<array<uint32_t,d>,tr>& in_values, array<array<block,1>,tr>& z_vec_shares);
+
+            using Offline = sparse_comp::ReceiverOfflineBundle;
+
+            // Input independent part of receive: OPRF setup.
+            Proto preprocess(coproto::Socket& sock, Offline& offline);
+            // Input dependent part of receive; offline must come from preprocess and is consumed.
+            Proto online(coproto::Socket& sock, Offline& offline, vector<osuCrypto::block>& ordIndexHashSet, array<array<uint32_t,d>,tr>& in_values, array<array<block,1>,tr>& z_vec_shares);
     };
 
 }
@@ -3,9 +3,11 @@
 #include "../SpBSOT/SpBSOT.h"
 #include "../BlockSpBSOT/BlockSpBSOT.h"
 #include "../CustomOPRF/CustomizedOPRF.h"
+#include "../Common/Trace.h"
 #include "coproto/Socket/Socket.h"
 #include <array>
 #include <cmath>
+#include <stdexcept>
 
 #define MAX_SSP 128
 #define IN_COMP_BIT_LEN 8
@@ -126,7 +128,7 @@ static Proto sender_compute_h_shares(OprfSender* oprfSender,
 
         gen_zero_shares<ts,twotol>(*zero_shares);
 
-        MC_AWAIT(bsotSender->send(sock, ordIndexHashSet, *msg_vecs, *zero_shares, h_shares));
+        MC_AWAIT(bsotSender->send(sock, ordIndexHashSet, *msg_vecs, *zero_shares, h_shares, true)); // h_shares are presampled
 
         delete zero_shares;
         delete msg_vecs;
@@ -198,10 +200,11 @@ static Proto sender_comp_z_shares(OprfSender* oprfSender,
                                   PRNG& prng,
                                   vector<block>& ordIndexHashSet,
                                   array<array<ZN<M>,1>,ts>& g_vec_shares,
+                                  array<block,ts>& z_masks,
                                   array<array<block,1>,ts>& z_vec_shares) {
     static_assert(M == 2*(delta + 1) + 1,"the following identity must be fulfilled: M = 2*(delta + 1) + 1");
 
-    MC_BEGIN(Proto, oprfSender, oprfReceiver, &sock, &prng, &ordIndexHashSet, &g_vec_shares, &z_vec_shares,
+    MC_BEGIN(Proto, oprfSender, oprfReceiver, &sock, &prng, &ordIndexHashSet, &g_vec_shares, &z_masks, &z_vec_shares,
              msg_vecs = (array<array<array<block,M>,1>,ts>*) nullptr,
              bsotSender = (BlockSpBSOTSender<tr,ts, 1, M>*) nullptr,
              zb = block(0,0),
@@ -210,7 +213,7 @@ static Proto sender_comp_z_shares(OprfSender* oprfSender,
         bsotSender = new BlockSpBSOTSender<tr,ts, 1, M>(prng, oprfSender, oprfReceiver);
 
         for (size_t i=0;i < ts;i++) {
-            r = prng.get<block>();
+            r = z_masks[i];
             for (size_t j=0;j < M;j++) {
                 if(j <= delta) {
                     msg_vecs->at(i)[0][j] = block(0,0);
@@ -220,7 +223,7 @@ static Proto sender_comp_z_shares(OprfSender* oprfSender,
             }
         }
 
-        MC_AWAIT(bsotSender->send(sock, ordIndexHashSet, *msg_vecs, g_vec_shares, z_vec_shares));
+        MC_AWAIT(bsotSender->send(sock, ordIndexHashSet, *msg_vecs, g_vec_shares, z_vec_shares, true)); // z_vec_shares are presampled
 
         delete msg_vecs;
         delete bsotSender;
@@ -288,10 +291,31 @@ static void compute_intersec_hashed_z_shares(AES& aes,
 }
 
 template<size_t tr, size_t ts, uint8_t delta, uint8_t ssp>
-Proto sparse_comp::sp_l2::Sender<tr,ts,delta,ssp>::send(Socket& sock, 
-                                                        vector<block>& ordIndexHashSet,
-                                                        array<array<uint32_t,2>,ts>& in_values,
-                                                        array<array<block,1>,ts>& z_vec_shares) {
+Proto sparse_comp::sp_l2::Sender<tr,ts,delta,ssp>::preprocess(Socket& sock, Offline& offline) {
+    constexpr const size_t oprf_instances = 2;
+
+    MC_BEGIN(Proto, this, &sock, &offline);
+
+        if (offline.ready) throw std::runtime_error("the offline bundle was already preprocessed");
+
+        if (this->otPool != nullptr && this->oprfBackend == sparse_comp::custom_oprf::OprfBackend::MultiOprf) {
+            MC_AWAIT(sparse_comp::custom_oprf::setup_session(sock, *(this->otPool), oprf_instances, offline.oprfSenders, offline.oprfReceivers)); // Setup OPRFs from the OT pool
+        } else {
+            MC_AWAIT(sparse_comp::custom_oprf::setup_session(sock, *(this->prng), true, oprf_instances, offline.oprfSenders, offline.oprfReceivers, this->otExt, this->oprfBackend)); // Setup OPRFs
+        }
+
+        offline.sample(*(this->prng));
+        offline.ready = true;
+
+    MC_END();
+}
+
+template<size_t tr, size_t ts, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::sp_l2::Sender<tr,ts,delta,ssp>::online(Socket& sock, 
+                                                          Offline& offline,
+                                                          vector<block>& ordIndexHashSet,
+                                                          array<array<uint32_t,2>,ts>& in_values,
+                                                          array<array<block,1>,ts>& z_vec_shares) {
     static_assert(ssp <= MAX_SSP,"ssp must be less or equal to 128");
     
     constexpr uint8_t l = IN_COMP_BIT_LEN;
@@ -299,41 +323,32 @@ Proto sparse_comp::sp_l2::Sender<tr,ts,delta,ssp>::send(Socket& sock,
     constexpr const uint16_t twotol = (uint16_t) pow(2, l);
     constexpr const uint64_t M = 2*(delta + 1) + 1;
 
-    //constexpr const uint64_t two_to_ssp = std::pow(2,ssp);
-
-    constexpr const size_t oprf_instances = 2;
-
-    MC_BEGIN(Proto, this, &sock, &ordIndexHashSet, &in_values, &z_vec_shares, 
+    MC_BEGIN(Proto, this, &sock, &offline, &ordIndexHashSet, &in_values, &z_vec_shares, 
              zn_in_values = (array<array<ZN<twotol>,2>,ts>*) nullptr,
-             h_vec_shares = (array<array<ZN<M>,2>,ts>*) nullptr,
              g_vec_shares = (array<array<ZN<M>,1>,ts>*) nullptr,
-             hashed_z_shares = vector<block>(),
-             oprfSenders = std::vector<OprfSender*>(oprf_instances),
-             oprfReceivers = std::vector<OprfReceiver*>(oprf_instances),
              prt = Proto());
 
-        MC_AWAIT(OprfSender::setup(sock, *(this->prng), oprf_instances, oprfSenders)); // Setup OPRFs
-        MC_AWAIT(OprfReceiver::setup(sock, *(this->prng), oprf_instances, oprfReceivers)); // Setup OPRFs
+        if (!offline.ready) throw std::runtime_error("the offline bundle is not preprocessed or was already used");
+        offline.ready = false;
 
         zn_in_values = new array<array<ZN<twotol>,2>,ts>();
         in_values_to_zn<ts,twotol>(in_values, *zn_in_values);
 
-        h_vec_shares = new array<array<ZN<M>,2>,ts>();
-        prt = sender_compute_h_shares<tr,ts,twotol,delta,M>(oprfSenders[0], oprfReceivers[0], sock, *(this->prng), ordIndexHashSet, *zn_in_values, *h_vec_shares);
+        // The OPRF instances are handed over to (and freed by) the SpBSOT runs
+        prt = sender_compute_h_shares<tr,ts,twotol,delta,M>(offline.oprfSenders[0], offline.oprfReceivers[0], sock, *(this->prng), ordIndexHashSet, *zn_in_values, offline.h_shares);
+        offline.oprfSenders[0] = nullptr;
+        offline.oprfReceivers[0] = nullptr;
         MC_AWAIT(prt);
         delete zn_in_values;
 
-        //std::cout << "(s) h_vec_shares[0][0]: " << h_vec_shares->at(0)[0].to_uint64_t() << " h_vec_shares[0][1]: " << h_vec_shares->at(0)[1].to_uint64_t() << std::endl;
-        //std::cout << "(s) h_vec_shares[1][0]: " << h_vec_shares->at(1)[0].to_uint64_t() << " h_vec_shares[1][1]: " << h_vec_shares->at(1)[1].to_uint64_t() << std::endl;
-
         g_vec_shares = new array<array<ZN<M>,1>,ts>();
-        comp_g_shares<ts,delta,M>(*h_vec_shares, *g_vec_shares);
-        delete h_vec_shares;
+        comp_g_shares<ts,delta,M>(offline.h_shares, *g_vec_shares);
 
-        //std::cout << "(s) g_vec_shares[0][0]: " << g_vec_shares->at(0)[0].to_uint64_t() << std::endl;
-        //std::cout << "(s) g_vec_shares[1][0]: " << g_vec_shares->at(1)[0].to_uint64_t() << std::endl;
+        z_vec_shares = offline.z_shares;
 
-        prt = sender_comp_z_shares<tr,ts,delta,M>(oprfSenders[1], oprfReceivers[1], sock, *(this->prng), ordIndexHashSet, *g_vec_shares, z_vec_shares);
+        prt = sender_comp_z_shares<tr,ts,delta,M>(offline.oprfSenders[1], offline.oprfReceivers[1], sock, *(this->prng), ordIndexHashSet, *g_vec_shares, offline.z_masks, z_vec_shares);
+        offline.oprfSenders[1] = nullptr;
+        offline.oprfReceivers[1] = nullptr;
         MC_AWAIT(prt);
         delete g_vec_shares;
 
@@ -341,11 +356,55 @@ Proto sparse_comp::sp_l2::Sender<tr,ts,delta,ssp>::send(Socket& sock,
 
 }
 
+template<size_t tr, size_t ts, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::sp_l2::Sender<tr,ts,delta,ssp>::send(Socket& sock, 
+                                                        vector<block>& ordIndexHashSet,
+                                                        array<array<uint32_t,2>,ts>& in_values,
+                                                        array<array<block,1>,ts>& z_vec_shares) {
+    MC_BEGIN(Proto, this, &sock, &ordIndexHashSet, &in_values, &z_vec_shares,
+             offline = (Offline*) nullptr);
+
+        offline = new Offline();
+
+        SPARSE_COMP_TRACE_BEGIN(sock, "spx.offline");
+        MC_AWAIT(this->preprocess(sock, *offline));
+        SPARSE_COMP_TRACE_END(sock, "spx.offline");
+
+        SPARSE_COMP_TRACE_BEGIN(sock, "spx.online");
+        MC_AWAIT(this->online(sock, *offline, ordIndexHashSet, in_values, z_vec_shares));
+        SPARSE_COMP_TRACE_END(sock, "spx.online");
+
+        delete offline;
+
+    MC_END();
+
+}
+
 template<size_t ts, size_t tr, uint8_t delta, uint8_t ssp>
-Proto sparse_comp::sp_l2::Receiver<ts,tr,delta,ssp>::receive(Socket& sock, 
-                                                             vector<block>& ordIndexHashSet, 
-                                                             array<array<uint32_t,2>,tr>& in_values, 
-                                                             array<array<block,1>,tr>& z_vec_shares) {
+Proto sparse_comp::sp_l2::Receiver<ts,tr,delta,ssp>::preprocess(Socket& sock, Offline& offline) {
+    constexpr const size_t oprf_instances = 2;
+
+    MC_BEGIN(Proto, this, &sock, &offline);
+
+        if (offline.ready) throw std::runtime_error("the offline bundle was already preprocessed");
+
+        if (this->otPool != nullptr && this->oprfBackend == sparse_comp::custom_oprf::OprfBackend::MultiOprf) {
+            MC_AWAIT(sparse_comp::custom_oprf::setup_session(sock, *(this->otPool), oprf_instances, offline.oprfSenders, offline.oprfReceivers)); // Setup OPRFs from the OT pool
+        } else {
+            MC_AWAIT(sparse_comp::custom_oprf::setup_session(sock, *(this->prng), false, oprf_instances, offline.oprfSenders, offline.oprfReceivers, this->otExt, this->oprfBackend)); // Setup OPRFs
+        }
+
+        offline.ready = true;
+
+    MC_END();
+}
+
+template<size_t ts, size_t tr, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::sp_l2::Receiver<ts,tr,delta,ssp>::online(Socket& sock, 
+                                                            Offline& offline,
+                                                            vector<block>& ordIndexHashSet, 
+                                                            array<array<uint32_t,2>,tr>& in_values, 
+                                                            array<array<block,1>,tr>& z_vec_shares) {
     static_assert(ssp <= MAX_SSP,"ssp must be less or equal to 128");
 
     constexpr const uint8_t l = IN_COMP_BIT_LEN;
@@ -353,44 +412,60 @@ Proto sparse_comp::sp_l2::Receiver<ts,tr,delta,ssp>::receive(Socket& sock,
     constexpr const uint16_t twotol = (uint16_t) pow(2, l);
     constexpr const uint64_t M = 2*(delta + 1) + 1;
 
-    //constexpr const uint64_t two_to_ssp = std::pow(2,ssp);
-
-    constexpr const size_t oprf_instances = 2;
-
-    MC_BEGIN(Proto, this, &sock, &ordIndexHashSet, &in_values, &z_vec_shares,
+    MC_BEGIN(Proto, this, &sock, &offline, &ordIndexHashSet, &in_values, &z_vec_shares,
              zn_in_values = (array<array<ZN<twotol>,2>,tr>*) nullptr,
              h_vec_shares = (array<array<ZN<M>,2>,tr>*) nullptr,
              g_vec_shares = (array<array<ZN<M>,1>,tr>*) nullptr,
-             sender_hashed_z_sender_shares = vector<block>(),
-             oprfReceivers = std::vector<OprfReceiver*>(oprf_instances),
-             oprfSenders = std::vector<OprfSender*>(oprf_instances),
              prt = Proto());
 
-        MC_AWAIT(OprfReceiver::setup(sock, *(this->prng), oprf_instances, oprfReceivers)); // Setup OPRFs
-        MC_AWAIT(OprfSender::setup(sock, *(this->prng), oprf_instances, oprfSenders)); // Setup OPRFs
+        if (!offline.ready) throw std::runtime_error("the offline bundle is not preprocessed or was already used");
+        offline.ready = false;
         
         zn_in_values = new array<array<ZN<twotol>,2>,tr>();
         in_values_to_zn<tr,twotol>(in_values, *zn_in_values);
 
+        // The OPRF instances are handed over to (and freed by) the SpBSOT runs
         h_vec_shares = new array<array<ZN<M>,2>,tr>();
-        prt = recvr_compute_h_shares<ts,tr,twotol,delta,M>(oprfReceivers[0], oprfSenders[0], sock, *(this->prng), ordIndexHashSet, *zn_in_values, *h_vec_shares);
+        prt = recvr_compute_h_shares<ts,tr,twotol,delta,M>(offline.oprfReceivers[0], offline.oprfSenders[0], sock, *(this->prng), ordIndexHashSet, *zn_in_values, *h_vec_shares);
+        offline.oprfReceivers[0] = nullptr;
+        offline.oprfSenders[0] = nullptr;
         MC_AWAIT(prt);
         delete zn_in_values;
 
-        //std::cout << "(r) h_vec_shares[0][0]: " << h_vec_shares->at(0)[0].to_uint64_t() << " h_vec_shares[0][1]: " << h_vec_shares->at(0)[1].to_uint64_t() << std::endl;
-        //std::cout << "(r) h_vec_shares[1][0]: " << h_vec_shares->at(1)[0].to_uint64_t() << " h_vec_shares[1][1]: " << h_vec_shares->at(1)[1].to_uint64_t() << std::endl;
-
         g_vec_shares = new array<array<ZN<M>,1>,tr>();
         comp_g_shares<tr,delta,M>(*h_vec_shares, *g_vec_shares);
         delete h_vec_shares;
 
-        //std::cout << "(r) g_vec_shares[0][0]: " << g_vec_shares->at(0)[0].to_uint64_t() << std::endl;
-        //std::cout << "(r) g_vec_shares[1][0]: " << g_vec_shares->at(1)[0].to_uint64_t() << std::endl;
-
-        prt = receiver_comp_z_shares<ts,tr,delta,M>(oprfReceivers[1], oprfSenders[1], sock, *(this->prng), ordIndexHashSet, *g_vec_shares, z_vec_shares);
+        prt = receiver_comp_z_shares<ts,tr,delta,M>(offline.oprfReceivers[1], offline.oprfSenders[1], sock, *(this->prng), ordIndexHashSet, *g_vec_shares, z_vec_shares);
+        offline.oprfReceivers[1] = nullptr;
+        offline.oprfSenders[1] = nullptr;
         MC_AWAIT(prt);
         delete g_vec_shares;
     
     MC_END();
 
+}
+
+template<size_t ts, size_t tr, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::sp_l2::Receiver<ts,tr,delta,ssp>::receive(Socket& sock, 
+                                                             vector<block>& ordIndexHashSet, 
+                                                             array<array<uint32_t,2>,tr>& in_values, 
+                                                             array<array<block,1>,tr>& z_vec_shares) {
+    MC_BEGIN(Proto, this, &sock, &ordIndexHashSet, &in_values, &z_vec_shares,
+             offline = (Offline*) nullptr);
+
+        offline = new Offline();
+
+        SPARSE_COMP_TRACE_BEGIN(sock, "spx.offline");
+        MC_AWAIT(this->preprocess(sock, *offline));
+        SPARSE_COMP_TRACE_END(sock, "spx.offline");
+
+        SPARSE_COMP_TRACE_BEGIN(sock, "spx.online");
+        MC_AWAIT(this->online(sock, *offline, ordIndexHashSet, in_values, z_vec_shares));
+        SPARSE_COMP_TRACE_END(sock, "spx.online");
+
+        delete offline;
+
+    MC_END();
+
 }
\ No newline at end of file
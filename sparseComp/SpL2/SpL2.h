@@ -2,6 +2,9 @@
 
 #include "coproto/Socket/Socket.h"
 #include "cryptoTools/Common/block.h"
+#include "../MultiOPRF/OtPool.h"
+#include "../CustomOPRF/CustomizedOPRF.h"
+#include "../Common/OfflineBundle.h"
 #include <cstdint>
 #include <stddef.h>
 #include <vector>
@@ -14,14 +17,28 @@ namespace sparse_comp::sp_l2 {
 
         osuCrypto::PRNG* prng;
         osuCrypto::AES* aes;
+        sparse_comp::multi_oprf::OtPool* otPool;
+        sparse_comp::multi_oprf::OtExtConfig otExt;
+        sparse_comp::custom_oprf::OprfBackend oprfBackend;
             
         public:
-            Sender(osuCrypto::PRNG& prng, osuCrypto::AES& aes) {
+            Sender(osuCrypto::PRNG& prng, osuCrypto::AES& aes, sparse_comp::multi_oprf::OtPool* otPool = nullptr, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf) {
                 this->prng = &prng;
                 this->aes = &aes;
+                this->otPool = otPool;
+                this->otExt = otExt;
+                this->oprfBackend = oprfBackend;
             }
 
+            // Same as preprocess followed by online.
             coproto::task<void> send(coproto::Socket& sock, std::vector<osuCrypto::block>& ordIndexHashSet, std::array<std::array<uint32_t,2>,ts>& in_values, std::array<std::array<block,1>,ts>& z_vec_shares);
+
+            using Offline = sparse_comp::SenderOfflineBundle<ts,2,2*(delta + 1) + 1>;
+
+            // Input independent part of send: OPRF setup and sampling of the output shares and message masks.
+            coproto::task<void> preprocess(coproto::Socket& sock, Offline& offline);
+            // Input dependent part of send; offline must come from preprocess and is consumed.
+            coproto::task<void> online(coproto::Socket& sock, Offline& offline, std::vector<osuCrypto::block>& ordIndexHashSet, std::array<std::array<uint32_t,2>,ts>& in_values, std::array<std::array<block,1>,ts>& z_vec_shares);
     };
 
     template<size_t ts, size_t tr, uint8_t delta, uint8_t ssp>
@@ -29,14 +46,28 @@ namespace sparse_comp::sp_l2 {
 
         osuCrypto::PRNG* prng;
         osuCrypto::AES* aes;
+        sparse_comp::multi_oprf::OtPool* otPool;
+        sparse_comp::multi_oprf::OtExtConfig otExt;
+        sparse_comp::custom_oprf::OprfBackend oprfBackend;
             
         public:
-            Receiver(osuCrypto::PRNG& prng, osuCrypto::AES& aes) {
+            Receiver(osuCrypto::PRNG& prng, osuCrypto::AES& aes, sparse_comp::multi_oprf::OtPool* otPool = nullptr, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf) {
                 this->prng = &prng;
                 this->aes = &aes;
+                this->otPool = otPool;
+                this->otExt = otExt;
+                this->oprfBackend = oprfBackend;
             }
             
+            // Same as preprocess followed by online.
             coproto::task<void> receive(coproto::Socket& sock, std::vector<osuCrypto::block>& ordIndexHashSet, std::array<std::array<uint32_t,2>,tr>& in_values, std::array<std::array<block,1>,tr>& z_vec_shares);
+
+            using Offline = sparse_comp::ReceiverOfflineBundle;
+
+            // Input independent part of receive: OPRF setup.
+            coproto::task<void> preprocess(coproto::Socket& sock, Offline& offline);
+            // Input dependent part of receive; offline must come from preprocess and is consumed.
+            coproto::task<void> online(coproto::Socket& sock, Offline& offline, std::vector<osuCrypto::block>& ordIndexHashSet, std::array<std::array<uint32_t,2>,tr>& in_values, std::array<std::array<block,1>,tr>& z_vec_shares);
     };
 
 }
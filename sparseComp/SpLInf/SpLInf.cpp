@@ -3,11 +3,13 @@
 #include "../SpBSOT/SpBSOT.h"
 #include "../BlockSpBSOT/BlockSpBSOT.h"
 #include "../CustomOPRF/CustomizedOPRF.h"
+#include "../Common/Trace.h"
 #include "cryptoTools/Crypto/PRNG.h"
 #include "../Common/SockUtils.h"
 #include "../Common/HashUtils.h"
 #include <array>
 #include <cmath>
+#include <stdexcept>
 #include <iostream>
 #include <unordered_set>
 #include <vector>
@@ -109,15 +111,16 @@ Proto sender_comp_z_shares(
                        PRNG& prng,
                        vector<block>& ordIndexSet,
                        array<array<ZN<d+1>,1>,ts>& g_vec_shares,
+                       array<block,ts>& z_masks,
                        array<array<block,1>,ts>& z_vec_shares) {
-    MC_BEGIN(Proto, &sock, oprfSender, oprfReceiver, &prng, &ordIndexSet, &g_vec_shares, &z_vec_shares,
+    MC_BEGIN(Proto, &sock, oprfSender, oprfReceiver, &prng, &ordIndexSet, &g_vec_shares, &z_masks, &z_vec_shares,
              msg_vecs = (array<array<array<block,d+1>,1>,ts>*) nullptr,
              bsotSender = (BlockSpBSOTSender<tr, ts, 1, d+1>*) nullptr);
         msg_vecs = new array<array<array<block,d+1>,1>,ts>();
         bsotSender = new BlockSpBSOTSender<tr, ts, 1, d+1>(prng, oprfSender, oprfReceiver);
 
         for (size_t i=0;i < ts;i++) {
-            (*msg_vecs)[i][0][0] = prng.get<block>();
+            (*msg_vecs)[i][0][0] = z_masks[i];
             (*msg_vecs)[i][0][d] = block(0,0);
 
             for (size_t j=1;j < d;j++) {
@@ -125,7 +128,7 @@ Proto sender_comp_z_shares(
             }
         }
 
-        MC_AWAIT(bsotSender->send(sock, ordIndexSet, *msg_vecs, g_vec_shares, z_vec_shares));
+        MC_AWAIT(bsotSender->send(sock, ordIndexSet, *msg_vecs, g_vec_shares, z_vec_shares, true)); // z_vec_shares are presampled
 
         delete bsotSender;
         delete msg_vecs;
@@ -201,7 +204,7 @@ Proto sender_comp_polydom_intrvl(OprfSender* oprfSender,
 
         gen_zero_shares<t,d,twotol>(*zero_shares);
 
-        MC_AWAIT(bsotSender->send(sock, ordIndexSet, *msg_vecs, *zero_shares, out_vec_shares));
+        MC_AWAIT(bsotSender->send(sock, ordIndexSet, *msg_vecs, *zero_shares, out_vec_shares, true)); // out_vec_shares are presampled
 
         delete bsotSender;
         delete zero_shares;
@@ -230,8 +233,29 @@ Proto receiver_comp_polydom_intrvl(OprfReceiver* oprfReceiver,
 }
 
 template<size_t tr, size_t t, size_t d, uint8_t delta, uint8_t ssp>
-Proto sparse_comp::sp_linf::Sender<tr,t,d,delta,ssp>::send(
+Proto sparse_comp::sp_linf::Sender<tr,t,d,delta,ssp>::preprocess(Socket& sock, Offline& offline) {
+    constexpr const size_t oprf_instances = 2;
+
+    MC_BEGIN(Proto, this, &sock, &offline);
+
+        if (offline.ready) throw std::runtime_error("the offline bundle was already preprocessed");
+
+        if (this->otPool != nullptr && this->oprfBackend == sparse_comp::custom_oprf::OprfBackend::MultiOprf) {
+            MC_AWAIT(sparse_comp::custom_oprf::setup_session(sock, *(this->otPool), oprf_instances, offline.oprfSenders, offline.oprfReceivers)); // Setup OPRFs from the OT pool
+        } else {
+            MC_AWAIT(sparse_comp::custom_oprf::setup_session(sock, *(this->prng), true, oprf_instances, offline.oprfSenders, offline.oprfReceivers, this->otExt, this->oprfBackend)); // Setup OPRFs
+        }
+
+        offline.sample(*(this->prng));
+        offline.ready = true;
+
+    MC_END();
+}
+
+template<size_t tr, size_t t, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::sp_linf::Sender<tr,t,d,delta,ssp>::online(
                                                     Socket& sock, 
+                                                    Offline& offline,
                                                     vector<block>& ordIndexSet, 
                                                     array<array<uint32_t,d>,t>& in_values,
                                                     array<array<block,1>,t>& z_vec_shares) {
@@ -241,42 +265,85 @@ Proto sparse_comp::sp_linf::Sender<tr,t,d,delta,ssp>::send(
     static_assert(l <= 8,"l must be less or equal to 8");
     constexpr const uint16_t twotol = (uint16_t) pow(2, l);
 
-    constexpr const size_t oprf_instances = 2;
-
-    MC_BEGIN(Proto, this, &sock, &ordIndexSet, &in_values, &z_vec_shares,
+    MC_BEGIN(Proto, this, &sock, &offline, &ordIndexSet, &in_values, &z_vec_shares,
              zn_in_values = (array<array<ZN<twotol>,d>,t>*) nullptr,
-             h_vec_shares = (array<array<ZN<d+1>,d>,t>*) nullptr,
              g_shares = (array<array<ZN<d+1>,1>,t>*) nullptr,
-             oprfSenders = std::vector<OprfSender*>(oprf_instances),
-             oprfReceivers = std::vector<OprfReceiver*>(oprf_instances),
-             prt = Proto(),
-             prt2 = Proto());
+             prt = Proto());
 
-        MC_AWAIT(OprfSender::setup(sock, *(this->prng), oprf_instances, oprfSenders)); // Setup OPRFs
-        MC_AWAIT(OprfReceiver::setup(sock, *(this->prng), oprf_instances, oprfReceivers)); // Setup OPRFs
+        if (!offline.ready) throw std::runtime_error("the offline bundle is not preprocessed or was already used");
+        offline.ready = false;
 
         zn_in_values = new array<array<ZN<twotol>,d>,t>();
         in_values_to_zn<t,d,twotol>(in_values, *zn_in_values);
 
-        h_vec_shares = new array<array<ZN<d+1>,d>,t>();
-        prt = sender_comp_polydom_intrvl<tr,t,twotol,d,delta>(oprfSenders[0], oprfReceivers[0], sock, *(this->prng), ordIndexSet, *zn_in_values, *h_vec_shares);
+        // The OPRF instances are handed over to (and freed by) the SpBSOT runs
+        prt = sender_comp_polydom_intrvl<tr,t,twotol,d,delta>(offline.oprfSenders[0], offline.oprfReceivers[0], sock, *(this->prng), ordIndexSet, *zn_in_values, offline.h_shares);
+        offline.oprfSenders[0] = nullptr;
+        offline.oprfReceivers[0] = nullptr;
         MC_AWAIT(prt);
         delete zn_in_values;
 
         g_shares = new array<array<ZN<d+1>,1>,t>();
-        comp_g_shares<t,d>(*h_vec_shares, *g_shares);
-        delete h_vec_shares;
+        comp_g_shares<t,d>(offline.h_shares, *g_shares);
 
-        prt = sender_comp_z_shares<tr,t,d>(oprfSenders[1], oprfReceivers[1], sock, *(this->prng), ordIndexSet, *g_shares, z_vec_shares);
+        z_vec_shares = offline.z_shares;
+
+        prt = sender_comp_z_shares<tr,t,d>(offline.oprfSenders[1], offline.oprfReceivers[1], sock, *(this->prng), ordIndexSet, *g_shares, offline.z_masks, z_vec_shares);
+        offline.oprfSenders[1] = nullptr;
+        offline.oprfReceivers[1] = nullptr;
         MC_AWAIT(prt);
         delete g_shares;
 
     MC_END();
 }
 
+template<size_t tr, size_t t, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::sp_linf::Sender<tr,t,d,delta,ssp>::send(
+                                                    Socket& sock, 
+                                                    vector<block>& ordIndexSet, 
+                                                    array<array<uint32_t,d>,t>& in_values,
+                                                    array<array<block,1>,t>& z_vec_shares) {
+    MC_BEGIN(Proto, this, &sock, &ordIndexSet, &in_values, &z_vec_shares,
+             offline = (Offline*) nullptr);
+
+        offline = new Offline();
+
+        SPARSE_COMP_TRACE_BEGIN(sock, "spx.offline");
+        MC_AWAIT(this->preprocess(sock, *offline));
+        SPARSE_COMP_TRACE_END(sock, "spx.offline");
+
+        SPARSE_COMP_TRACE_BEGIN(sock, "spx.online");
+        MC_AWAIT(this->online(sock, *offline, ordIndexSet, in_values, z_vec_shares));
+        SPARSE_COMP_TRACE_END(sock, "spx.online");
+
+        delete offline;
+
+    MC_END();
+}
+
 template<size_t ts, size_t t, size_t d, uint8_t delta, uint8_t ssp>
-Proto sparse_comp::sp_linf::Receiver<ts,t,d,delta,ssp>::receive(
+Proto sparse_comp::sp_linf::Receiver<ts,t,d,delta,ssp>::preprocess(Socket& sock, Offline& offline) {
+    constexpr const size_t oprf_instances = 2;
+
+    MC_BEGIN(Proto, this, &sock, &offline);
+
+        if (offline.ready) throw std::runtime_error("the offline bundle was already preprocessed");
+
+        if (this->otPool != nullptr && this->oprfBackend == sparse_comp::custom_oprf::OprfBackend::MultiOprf) {
+            MC_AWAIT(sparse_comp::custom_oprf::setup_session(sock, *(this->otPool), oprf_instances, offline.oprfSenders, offline.oprfReceivers)); // Setup OPRFs from the OT pool
+        } else {
+            MC_AWAIT(sparse_comp::custom_oprf::setup_session(sock, *(this->prng), false, oprf_instances, offline.oprfSenders, offline.oprfReceivers, this->otExt, this->oprfBackend)); // Setup OPRFs
+        }
+
+        offline.ready = true;
+
+    MC_END();
+}
+
+template<size_t ts, size_t t, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::sp_linf::Receiver<ts,t,d,delta,ssp>::online(
                                                     Socket& sock, 
+                                                    Offline& offline,
                                                     vector<osuCrypto::block>& ordIndexSet, 
                                                     array<array<uint32_t,d>,t>& in_values, 
                                                     array<array<block,1>,t>& z_vec_shares) {
@@ -286,26 +353,24 @@ Proto sparse_comp::sp_linf::Receiver<ts,t,d,delta,ssp>::receive(
     static_assert(l <= 8,"l must be less or equal to 8");
     constexpr const uint16_t twotol = (uint16_t) pow(2, l);
 
-    constexpr const size_t oprf_instances = 2;
-
-    MC_BEGIN(Proto, this, &sock, &ordIndexSet, &in_values, &z_vec_shares,
+    MC_BEGIN(Proto, this, &sock, &offline, &ordIndexSet, &in_values, &z_vec_shares,
              zn_in_values = (array<array<ZN<twotol>,d>,t>*) nullptr,
              h_vec_shares = (array<array<ZN<d+1>,d>,t>*) nullptr,
              g_shares = (array<array<ZN<d+1>,1>,t>*) nullptr,
-             oprfReceivers = std::vector<OprfReceiver*>(oprf_instances),
-             oprfSenders = std::vector<OprfSender*>(oprf_instances),
-             prt = Proto(),
-             prt2 = Proto());
+             prt = Proto());
 
-        MC_AWAIT(OprfReceiver::setup(sock, *(this->prng), oprf_instances, oprfReceivers)); // Setup OPRFs
-        MC_AWAIT(OprfSender::setup(sock, *(this->prng), oprf_instances, oprfSenders)); // Setup OPRFs
+        if (!offline.ready) throw std::runtime_error("the offline bundle is not preprocessed or was already used");
+        offline.ready = false;
 
         zn_in_values = new array<array<ZN<twotol>,d>,t>();
         h_vec_shares = new array<array<ZN<d+1>,d>,t>();
         
         in_values_to_zn<t,d,twotol>(in_values, *zn_in_values);
 
-        prt = receiver_comp_polydom_intrvl<ts,t,twotol,d,delta>(oprfReceivers[0], oprfSenders[0], sock, *(this->prng), ordIndexSet, *zn_in_values, *h_vec_shares);
+        // The OPRF instances are handed over to (and freed by) the SpBSOT runs
+        prt = receiver_comp_polydom_intrvl<ts,t,twotol,d,delta>(offline.oprfReceivers[0], offline.oprfSenders[0], sock, *(this->prng), ordIndexSet, *zn_in_values, *h_vec_shares);
+        offline.oprfReceivers[0] = nullptr;
+        offline.oprfSenders[0] = nullptr;
         MC_AWAIT(prt);
         delete zn_in_values;
 
@@ -313,10 +378,36 @@ Proto sparse_comp::sp_linf::Receiver<ts,t,d,delta,ssp>::receive(
         comp_g_shares<t,d>(*h_vec_shares, *g_shares);
         delete h_vec_shares;
 
-        prt = receiver_comp_z_shares<ts,t,d>(oprfReceivers[1], oprfSenders[1], sock, *(this->prng), ordIndexSet, *g_shares, z_vec_shares);
+        prt = receiver_comp_z_shares<ts,t,d>(offline.oprfReceivers[1], offline.oprfSenders[1], sock, *(this->prng), ordIndexSet, *g_shares, z_vec_shares);
+        offline.oprfReceivers[1] = nullptr;
+        offline.oprfSenders[1] = nullptr;
         MC_AWAIT(prt);
 
         delete g_shares;
 
+     MC_END();
+}
+
+template<size_t ts, size_t t, size_t d, uint8_t delta, uint8_t ssp>
+Proto sparse_comp::sp_linf::Receiver<ts,t,d,delta,ssp>::receive(
+                                                    Socket& sock, 
+                                                    vector<osuCrypto::block>& ordIndexSet, 
+                                                    array<array<uint32_t,d>,t>& in_values, 
+                                                    array<array<block,1>,t>& z_vec_shares) {
+    MC_BEGIN(Proto, this, &sock, &ordIndexSet, &in_values, &z_vec_shares,
+             offline = (Offline*) nullptr);
+
+        offline = new Offline();
+
+        SPARSE_COMP_TRACE_BEGIN(sock, "spx.offline");
+        MC_AWAIT(this->preprocess(sock, *offline));
+        SPARSE_COMP_TRACE_END(sock, "spx.offline");
+
+        SPARSE_COMP_TRACE_BEGIN(sock, "spx.online");
+        MC_AWAIT(this->online(sock, *offline, ordIndexSet, in_values, z_vec_shares));
+        SPARSE_COMP_TRACE_END(sock, "spx.online");
+
+        delete offline;
+
      MC_END();
 }
\ No newline at end of file
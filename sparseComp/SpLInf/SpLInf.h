@@ -3,6 +3,9 @@
 #include "coproto/Socket/Socket.h"
 #include "cryptoTools/Crypto/PRNG.h"
 #include "cryptoTools/Common/block.h"
+#include "../MultiOPRF/OtPool.h"
+#include "../CustomOPRF/CustomizedOPRF.h"
+#include "../Common/OfflineBundle.h"
 #include "cryptoTools/Crypto/AES.h"
 #include <cstdint>
 #include <stddef.h>
@@ -16,14 +19,28 @@ namespace sparse_comp::sp_linf {
 
         osuCrypto::PRNG* prng;
         osuCrypto::AES* aes;
+        sparse_comp::multi_oprf::OtPool* otPool;
+        sparse_comp::multi_oprf::OtExtConfig otExt;
+        sparse_comp::custom_oprf::OprfBackend oprfBackend;
             
         public:
-            Sender(osuCrypto::PRNG& prng, osuCrypto::AES& aes) {
+            Sender(osuCrypto::PRNG& prng, osuCrypto::AES& aes, sparse_comp::multi_oprf::OtPool* otPool = nullptr, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf) {
                 this->prng = &prng;
                 this->aes = &aes;
+                this->otPool = otPool;
+                this->otExt = otExt;
+                this->oprfBackend = oprfBackend;
             }
 
+            // Same as preprocess followed by online.
             coproto::task<void> send(coproto::Socket& sock, std::vector<block>& ordIndexHashSet, std::array<std::array<uint32_t,d>,t>& in_values, std::array<std::array<block,1>,t>& out_vec_shares);
+
+            using Offline = sparse_comp::SenderOfflineBundle<t,d,d+1>;
+
+            // Input independent part of send: OPRF setup and sampling of the output shares and message masks.
+            coproto::task<void> preprocess(coproto::Socket& sock, Offline& offline);
+            // Input dependent part of send; offline must come from preprocess and is consumed.
+            coproto::task<void> online(coproto::Socket& sock, Offline& offline, std::vector<block>& ordIndexHashSet, std::array<std::array<uint32_t,d>,t>& in_values, std::array<std::array<block,1>,t>& out_vec_shares);
     };
 
     template<size_t ts, size_t t, size_t d, uint8_t delta, uint8_t ssp>
@@ -31,14 +48,28 @@ namespace sparse_comp::sp_linf {
 
         osuCrypto::PRNG* prng;
         osuCrypto::AES* aes;
+        sparse_comp::multi_oprf::OtPool* otPool;
+        sparse_comp::multi_oprf::OtExtConfig otExt;
+        sparse_comp::custom_oprf::OprfBackend oprfBackend;
             
         public:
-            Receiver(osuCrypto::PRNG& prng, osuCrypto::AES& aes) {
+            Receiver(osuCrypto::PRNG& prng, osuCrypto::AES& aes, sparse_comp::multi_oprf::OtPool* otPool = nullptr, sparse_comp::multi_oprf::OtExtConfig otExt = sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend oprfBackend = sparse_comp::custom_oprf::OprfBackend::MultiOprf) {
                 this->prng = &prng;
                 this->aes = &aes;
+                this->otPool = otPool;
+                this->otExt = otExt;
+                this->oprfBackend = oprfBackend;
             }
             
+            // Same as preprocess followed by online.
             coproto::task<void> receive(coproto::Socket& sock, std::vector<osuCrypto::block>& ordIndexHashSet, std::array<std::array<uint32_t,d>,t>& in_values, std::array<std::array<block,1>,t>& z_vec_shares);
+
+            using Offline = sparse_comp::ReceiverOfflineBundle;
+
+            // Input independent part of receive: OPRF setup.
+            coproto::task<void> preprocess(coproto::Socket& sock, Offline& offline);
+            // Input dependent part of receive; offline must come from preprocess and is consumed.
+            coproto::task<void> online(coproto::Socket& sock, Offline& offline, std::vector<osuCrypto::block>& ordIndexHashSet, std::array<std::array<uint32_t,d>,t>& in_values, std::array<std::array<block,1>,t>& z_vec_shares);
     };
 
 }
@@ -0,0 +1,59 @@
+#include "catch2/catch_test_macros.hpp"
+#include "../sparseComp/Common/BlockUtils.h"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include <cstdint>
+#include <vector>
+
+using osuCrypto::block;
+
+static block keep_low_bits(const block& b, size_t nbits) {
+    uint64_t low = b.get<uint64_t>(0);
+    uint64_t high = b.get<uint64_t>(1);
+
+    if (nbits < 64) {
+        low &= (uint64_t(1) << nbits) - 1;
+        high = 0;
+    } else if (nbits == 64) {
+        high = 0;
+    } else if (nbits < 128) {
+        high &= (uint64_t(1) << (nbits - 64)) - 1;
+    }
+
+    return block(high, low);
+}
+
+static void check_pack_unpack(size_t n, size_t nbits) {
+    auto prng = osuCrypto::PRNG(block(13133210048402866,17132091720387928));
+
+    std::vector<block> blocks(n);
+    std::vector<block> unpacked(n);
+    std::vector<uint64_t> packed;
+
+    for (size_t i = 0; i < n; i++) {
+        blocks[i] = prng.get<block>();
+    }
+
+    sparse_comp::pack_blocks(blocks, nbits, packed);
+
+    REQUIRE(packed.size() == sparse_comp::packed_blocks_word_count(n, nbits));
+
+    sparse_comp::unpack_blocks(packed, nbits, unpacked);
+
+    for (size_t i = 0; i < n; i++) {
+        REQUIRE(unpacked[i] == keep_low_bits(blocks[i], nbits));
+    }
+}
+
+TEST_CASE("pack/unpack blocks with nbits <= 64") {
+    check_pack_unpack(1000, 1);
+    check_pack_unpack(1000, 40);
+    check_pack_unpack(1000, 56);
+    check_pack_unpack(1000, 64);
+}
+
+TEST_CASE("pack/unpack blocks with nbits > 64") {
+    check_pack_unpack(1000, 65);
+    check_pack_unpack(1000, 104);
+    check_pack_unpack(1000, 128);
+}
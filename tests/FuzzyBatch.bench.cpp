@@ -0,0 +1,192 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "coproto/Socket/LocalAsyncSock.h"
+#include "./support/TwoPartyBench.h"
+#include "./support/GroundTruth.h"
+#include "./support/Workloads.h"
+#include "./support/MemoryProfile.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "../sparseComp/Common/Common.h"
+#include "../sparseComp/FuzzyL1/FuzzyL1.h"
+#include "../sparseComp/FuzzyBatch/FuzzyBatch.h"
+#include "../sparseComp/Common/PointFile.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Batched runs of Fuzzy L1 (see FuzzyBatch.h) over growing sets with a fixed batch capacity. The peak RSS
+// printed after every measurement ("Memory run ... peak rss") should stay flat from 2^16 to 2^20 points,
+// apart from the inputs and the output, while the time grows with the number of batches. The other fuzzy
+// protocols are batched the same way; their implementations cannot share a translation unit.
+//
+// The file cases run the same protocols on point files mapped from the temporary directory (see PointFile.h)
+// and stream the matches to a result file, so the protocols hold neither the sets nor the intersection in
+// memory. They print the records written and the peak RSS, which includes the copy of the sets the benchmark
+// keeps for checking the output.
+
+using sparse_comp::point;
+
+using coproto::LocalAsyncSocket;
+
+using PRNG = osuCrypto::PRNG;
+using osuCrypto::block;
+using AES = osuCrypto::AES;
+
+using sparse_comp::bench::Metric;
+using sparse_comp::bench::Workload;
+using sparse_comp::bench::expected_intersect;
+using sparse_comp::bench::is_intersec_correct;
+using sparse_comp::bench::is_close;
+
+namespace {
+
+    constexpr size_t MEMORY_BUDGET = size_t(8) << 30;
+    constexpr size_t BATCH = size_t(1) << 12;
+
+    template<Metric metric,
+             template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+             template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+             size_t d, uint8_t delta, uint8_t ssp>
+    void bench_batched(size_t n, block seed) {
+        static_assert(sparse_comp::fuzzy_batch::batch_memory_bytes(BATCH, BATCH, d) <= MEMORY_BUDGET);
+
+        const std::string name = "n=m=2^" + std::to_string(std::bit_width(n) - 1) + " d=" + std::to_string(d) +
+                                 " delta=" + std::to_string(delta) + " batch=" + std::to_string(BATCH);
+
+        BENCHMARK_ADVANCED(name.c_str())(Catch::Benchmark::Chronometer meter) {
+            auto socks = LocalAsyncSocket::makePair();
+            PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+            PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+            AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+            std::vector<point> senderPoints(n);
+            std::vector<point> receiverPoints(n);
+            std::vector<point> intersec;
+
+            sparse_comp::bench::load_or_gen_workload(Workload::Uniform, seed, {d, delta, 29}, receiverPoints, senderPoints);
+
+            sparse_comp::fuzzy_batch::Sender<FuzzySender, BATCH, BATCH, d, delta, ssp> batchSender(senderPRNG, aes, MEMORY_BUDGET);
+            sparse_comp::fuzzy_batch::Receiver<FuzzyReceiver, BATCH, BATCH, d, delta, ssp> batchRecvr(receiverPRNG, aes, MEMORY_BUDGET);
+
+            auto parties = sparse_comp::bench::measure_parties(meter, socks,
+                [&](coproto::Socket& sock) { return batchSender.send(sock, senderPoints); },
+                [&](coproto::Socket& sock) { return batchRecvr.receive(sock, receiverPoints, intersec); }, intersec);
+
+            std::vector<point> expected_intersec;
+
+            expected_intersect<metric>(receiverPoints, senderPoints, d, delta, expected_intersec);
+
+            REQUIRE(is_intersec_correct(intersec, expected_intersec));
+
+            const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0;
+
+            SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+            sparse_comp::bench::print_perf(parties.perf, 2 * n);
+        };
+    }
+
+    template<Metric metric,
+             template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+             template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+             size_t d, uint8_t delta, uint8_t ssp>
+    void bench_batched_files(size_t n, block seed) {
+        const std::string name = "files n=m=2^" + std::to_string(std::bit_width(n) - 1) + " d=" + std::to_string(d) +
+                                 " delta=" + std::to_string(delta) + " batch=" + std::to_string(BATCH);
+
+        BENCHMARK_ADVANCED(name.c_str())(Catch::Benchmark::Chronometer meter) {
+            PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+            PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+            AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+            const std::filesystem::path dir = std::filesystem::temp_directory_path();
+            const std::string senderPath = (dir / "fuzzy_batch_sender.pts").string();
+            const std::string receiverPath = (dir / "fuzzy_batch_receiver.pts").string();
+            const std::string resultPath = (dir / "fuzzy_batch_result.bin").string();
+
+            std::vector<point> senderPoints(n);
+            std::vector<point> receiverPoints(n);
+
+            sparse_comp::bench::load_or_gen_workload(Workload::Uniform, seed, {d, delta, 29}, receiverPoints, senderPoints);
+
+            sparse_comp::write_point_file(senderPath, senderPoints, d);
+            sparse_comp::write_point_file(receiverPath, receiverPoints, d);
+
+            sparse_comp::PointFile senderFile(senderPath);
+            sparse_comp::PointFile receiverFile(receiverPath);
+
+            sparse_comp::fuzzy_batch::Sender<FuzzySender, BATCH, BATCH, d, delta, ssp> batchSender(senderPRNG, aes, MEMORY_BUDGET);
+            sparse_comp::fuzzy_batch::Receiver<FuzzyReceiver, BATCH, BATCH, d, delta, ssp> batchRecvr(receiverPRNG, aes, MEMORY_BUDGET);
+
+            sparse_comp::bench::reset_peak_rss();
+
+            meter.measure([&] {
+                auto socks = LocalAsyncSocket::makePair();
+                sparse_comp::ResultWriter results(resultPath, d);
+
+                macoro::sync_wait(macoro::when_all_ready(batchSender.send(socks[0], senderFile.points()),
+                                                         batchRecvr.receive(socks[1], receiverFile.points(), results)));
+
+                results.close();
+            });
+
+            const uint64_t peak_rss_kb = sparse_comp::bench::read_memory().peak_rss_kb;
+
+            sparse_comp::ResultFile resultFile(resultPath);
+            std::vector<point> intersec;
+
+            // Every record must pair a sender point with a receiver point within delta of it
+            for (size_t i = 0; i < resultFile.size(); i++) {
+                const point pt = resultFile[i];
+
+                REQUIRE(resultFile.index(i) < n);
+                REQUIRE(is_close<metric>(receiverPoints[resultFile.index(i)], pt, d, delta));
+
+                intersec.push_back(pt);
+            }
+
+            std::sort(intersec.begin(), intersec.end(), sparse_comp::bench::coords_less);
+            intersec.erase(std::unique(intersec.begin(), intersec.end(), sparse_comp::bench::coords_equal), intersec.end());
+
+            std::vector<point> expected_intersec;
+
+            expected_intersect<metric>(receiverPoints, senderPoints, d, delta, expected_intersec);
+
+            REQUIRE(is_intersec_correct(intersec, expected_intersec));
+
+            std::cout << "Result records: " << resultFile.size() << " peak rss MB: " << ((double) peak_rss_kb)/1024.0 << std::endl;
+
+            std::remove(senderPath.c_str());
+            std::remove(receiverPath.c_str());
+            std::remove(resultPath.c_str());
+        };
+    }
+
+};
+
+TEST_CASE("fuzzy_batch l1 (d=2 delta=10 ssp=40)", "[fuzzy_batch][fuzzyl1]") {
+    for (size_t log_n : {16, 18, 20}) {
+        bench_batched<Metric::L1, sparse_comp::fuzzy_l1::Sender, sparse_comp::fuzzy_l1::Receiver, 2, 10, 40>(
+            size_t(1) << log_n, block(9536629026107651350ULL, 2724119864341290560ULL + log_n));
+    }
+}
+
+TEST_CASE("fuzzy_batch l1 (d=6 delta=10 ssp=40)", "[fuzzy_batch][fuzzyl1]") {
+    for (size_t log_n : {16, 18, 20}) {
+        bench_batched<Metric::L1, sparse_comp::fuzzy_l1::Sender, sparse_comp::fuzzy_l1::Receiver, 6, 10, 40>(
+            size_t(1) << log_n, block(15356386812547896003ULL, 6761862989666286475ULL + log_n));
+    }
+}
+
+TEST_CASE("fuzzy_batch l1 on point files (d=2 delta=10 ssp=40)", "[fuzzy_batch][fuzzyl1][files]") {
+    for (size_t log_n : {18, 20}) {
+        bench_batched_files<Metric::L1, sparse_comp::fuzzy_l1::Sender, sparse_comp::fuzzy_l1::Receiver, 2, 10, 40>(
+            size_t(1) << log_n, block(9536629026107651350ULL, 2724119864341290560ULL + log_n));
+    }
+}
@@ -0,0 +1,193 @@
+#include "catch2/catch_test_macros.hpp"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "coproto/Socket/LocalAsyncSock.h"
+#include "./support/GroundTruth.h"
+#include "./support/TempPath.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "../sparseComp/Common/Common.h"
+#include "../sparseComp/MultiOPRF/OtPool.h"
+#include "../sparseComp/FuzzyL1/FuzzyL1.h"
+#include "../sparseComp/FuzzyBatch/FuzzyBatch.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <vector>
+
+using sparse_comp::point;
+
+using coproto::LocalAsyncSocket;
+
+using PRNG = osuCrypto::PRNG;
+using osuCrypto::block;
+using AES = osuCrypto::AES;
+
+using sparse_comp::bench::Metric;
+using sparse_comp::bench::expected_intersect;
+using sparse_comp::bench::is_intersec_correct;
+using sparse_comp::bench::TempPath;
+using sparse_comp::multi_oprf::OtPool;
+using sparse_comp::multi_oprf::RUN_POOL_OTS;
+
+using macoro::sync_wait;
+using macoro::when_all_ready;
+
+namespace {
+
+    constexpr size_t N = 96;
+    constexpr size_t BATCH = 16;
+    constexpr size_t D = 2;
+    constexpr uint8_t DELTA = 10;
+    constexpr uint8_t SSP = 40;
+    constexpr size_t MEMORY_BUDGET = size_t(1) << 30;
+
+    constexpr size_t MATCHES = 12;
+    constexpr size_t BOUNDARY_MATCHES = 4;
+
+    using BatchSender = sparse_comp::fuzzy_batch::Sender<sparse_comp::fuzzy_l1::Sender, BATCH, BATCH, D, DELTA, SSP>;
+    using BatchReceiver = sparse_comp::fuzzy_batch::Receiver<sparse_comp::fuzzy_l1::Receiver, BATCH, BATCH, D, DELTA, SSP>;
+
+    uint32_t random_coordinate(PRNG& prng, uint64_t range) {
+        return (uint32_t) (2 * DELTA + prng.get<uint64_t>() % (range - 4 * DELTA));
+    }
+
+    // Points whose first coordinates lie in the first 2^30 values, i.e. in the first two slabs for N points in
+    // batches of BATCH, so that both slabs need several batches on both sides. The first MATCHES sender points
+    // lie within delta of distinct receiver points, and BOUNDARY_MATCHES more match across the edge of the two
+    // slabs, half of them with the receiver point below it and half above.
+    void gen_batch_inputs(block seed, std::vector<point>& receiverPoints, std::vector<point>& senderPoints) {
+        PRNG prng(seed);
+        const size_t slabs = sparse_comp::fuzzy_batch::slab_count(N, N, BATCH, BATCH);
+        const uint32_t edge = (uint32_t) sparse_comp::fuzzy_batch::detail::slab_lo(1, slabs);
+        uint32_t c[D];
+
+        receiverPoints.resize(N);
+        senderPoints.resize(N);
+
+        for (size_t i = 0; i < N; i++) {
+            c[0] = random_coordinate(prng, (uint64_t) 1 << 30);
+            c[1] = random_coordinate(prng, (uint64_t) 1 << 32);
+            receiverPoints[i] = point(D, c);
+
+            c[0] = random_coordinate(prng, (uint64_t) 1 << 30);
+            c[1] = random_coordinate(prng, (uint64_t) 1 << 32);
+            senderPoints[i] = point(D, c);
+        }
+
+        for (size_t i = 0; i < MATCHES; i++) {
+            senderPoints[i] = receiverPoints[i * (N / MATCHES)];
+            senderPoints[i][0] += DELTA / 2;
+        }
+
+        for (size_t b = 0; b < BOUNDARY_MATCHES; b++) {
+            const size_t r = MATCHES + b * (N / MATCHES) + 1;
+            const bool below = b % 2 == 0;
+
+            receiverPoints[r][0] = below ? edge - 1 - (uint32_t) b : edge + (uint32_t) b;
+            senderPoints[MATCHES + b] = receiverPoints[r];
+            senderPoints[MATCHES + b][0] = below ? receiverPoints[r][0] + DELTA / 2 : receiverPoints[r][0] - DELTA / 2;
+        }
+    }
+
+    // Number of batches the parties run on the given points, and whether some slab needs several of them
+    size_t planned_batches(const std::vector<point>& receiverPoints, const std::vector<point>& senderPoints, size_t& max_chunks) {
+        const size_t slabs = sparse_comp::fuzzy_batch::slab_count(receiverPoints.size(), senderPoints.size(), BATCH, BATCH);
+        std::vector<std::vector<uint32_t>> members;
+        std::vector<uint32_t> receiver_chunks;
+        std::vector<uint32_t> sender_chunks;
+
+        sparse_comp::fuzzy_batch::detail::partition(std::span<const point>(receiverPoints), slabs, DELTA, members);
+        sparse_comp::fuzzy_batch::detail::chunk_counts(members, BATCH, receiver_chunks);
+        sparse_comp::fuzzy_batch::detail::partition(std::span<const point>(senderPoints), slabs, 0, members);
+        sparse_comp::fuzzy_batch::detail::chunk_counts(members, BATCH, sender_chunks);
+
+        max_chunks = 0;
+        for (size_t s = 0; s < slabs; s++) max_chunks = std::max<size_t>(max_chunks, std::min(receiver_chunks[s], sender_chunks[s]));
+
+        return sparse_comp::fuzzy_batch::detail::batch_count(receiver_chunks, sender_chunks);
+    }
+
+}
+
+TEST_CASE("Fuzzy batch : several slabs and chunks per slab (n=m=96, batch=16, d=2, delta=10, ssp=40)","[fuzzybatch]")
+{
+    auto socks = LocalAsyncSocket::makePair();
+    PRNG senderPRNG = PRNG(block(742130310438916676ULL, 11803924226990735076ULL));
+    PRNG receiverPRNG = PRNG(block(2457938039974938056ULL, 17910068785450354990ULL));
+    AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+    std::vector<point> receiverPoints;
+    std::vector<point> senderPoints;
+    std::vector<point> intersec;
+
+    gen_batch_inputs(block(5736302581720391125ULL,10247762139804557141ULL), receiverPoints, senderPoints);
+
+    size_t max_chunks = 0;
+    REQUIRE(planned_batches(receiverPoints, senderPoints, max_chunks) > 2);
+    REQUIRE(max_chunks > 1);
+
+    BatchSender batchSender(senderPRNG, aes, MEMORY_BUDGET);
+    BatchReceiver batchRecvr(receiverPRNG, aes, MEMORY_BUDGET);
+
+    auto r = sync_wait(when_all_ready(batchSender.send(socks[0], senderPoints),
+                                      batchRecvr.receive(socks[1], receiverPoints, intersec)));
+    std::get<0>(r).result();
+    std::get<1>(r).result();
+
+    std::vector<point> expected_intersec;
+
+    expected_intersect<Metric::L1>(receiverPoints, senderPoints, D, DELTA, expected_intersec);
+    REQUIRE(expected_intersec.size() == MATCHES + BOUNDARY_MATCHES);
+
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
+    REQUIRE(intersec.size() == expected_intersec.size());
+}
+
+TEST_CASE("Fuzzy batch : all batches from a pool sized for the session (n=m=96, batch=16, d=2, delta=10, ssp=40)","[fuzzybatch]")
+{
+    PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+    PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+    AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+    std::vector<point> receiverPoints;
+    std::vector<point> senderPoints;
+    std::vector<point> intersec;
+
+    gen_batch_inputs(block(13830928014367432193ULL,2877411608127591054ULL), receiverPoints, senderPoints);
+
+    size_t max_chunks = 0;
+    const size_t batches = planned_batches(receiverPoints, senderPoints, max_chunks);
+
+    TempPath leaderPath("leader.otpool");
+    TempPath followerPath("follower.otpool");
+
+    auto poolSocks = LocalAsyncSocket::makePair();
+    sync_wait(when_all_ready(OtPool::create(poolSocks[0], senderPRNG, true, batches * RUN_POOL_OTS, leaderPath.str()),
+                             OtPool::create(poolSocks[1], receiverPRNG, false, batches * RUN_POOL_OTS, followerPath.str())));
+
+    std::unique_ptr<OtPool> leaderPool(OtPool::open(leaderPath.str()));
+    std::unique_ptr<OtPool> followerPool(OtPool::open(followerPath.str()));
+
+    auto socks = LocalAsyncSocket::makePair();
+
+    BatchSender batchSender(senderPRNG, aes, MEMORY_BUDGET, leaderPool.get());
+    BatchReceiver batchRecvr(receiverPRNG, aes, MEMORY_BUDGET, followerPool.get());
+
+    auto r = sync_wait(when_all_ready(batchSender.send(socks[0], senderPoints),
+                                      batchRecvr.receive(socks[1], receiverPoints, intersec)));
+    std::get<0>(r).result();
+    std::get<1>(r).result();
+
+    // Every batch took one run's worth of OTs, and no OT extension ran during the session
+    REQUIRE(leaderPool->available() == 0);
+    REQUIRE(followerPool->available() == 0);
+
+    std::vector<point> expected_intersec;
+
+    expected_intersect<Metric::L1>(receiverPoints, senderPoints, D, DELTA, expected_intersec);
+
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
+    REQUIRE(intersec.size() == expected_intersec.size());
+}
@@ -2,17 +2,21 @@
 #include "cryptoTools/Crypto/PRNG.h"
 #include "cryptoTools/Common/block.h"
 #include "coproto/Socket/LocalAsyncSock.h"
+#include "./support/GroundTruth.h"
+#include "./support/TempPath.h"
 #include "cryptoTools/Crypto/AES.h"
 #include "../sparseComp/Common/Common.h"
 #include "../sparseComp/Common/HashUtils.h"
+#include "../sparseComp/Common/PreparedSet.h"
 #include "../sparseComp/FuzzyL1/FuzzyL1.h"
 #include <cstdint>
 #include <array>
 #include <vector>
 #include <set>
-#include <unordered_map>
 #include <utility>
 #include <cmath>
+#include <stdexcept>
+#include <string>
 
 static const int64_t MAX_U8_BIT_VAL = 255;
 static const int64_t MAX_U32_BIT_VAL = 4294967295;
@@ -25,13 +29,16 @@ using PRNG = osuCrypto::PRNG;
 using osuCrypto::block;
 using AES = osuCrypto::AES;
 
+using sparse_comp::bench::Metric;
+using sparse_comp::bench::expected_intersect;
+using sparse_comp::bench::is_intersec_correct;
+using sparse_comp::bench::TempPath;
+
 using std::chrono::high_resolution_clock;
 using std::chrono::milliseconds;
-using sparse_comp::hash_point;
 
 using std::array;
 using std::set;
-using std::unordered_map;
 
 using macoro::sync_wait;
 using macoro::when_all_ready;
@@ -217,119 +224,6 @@ static void gen_constrained_rand_inputs(block seed,
                                          sndr_points);
 }
 
-template<size_t d>
-static bool is_l1_close(point& pt,
-                        point& ball_center, 
-                        uint64_t delta) {
-    int64_t acc_dist = 0;
-    int64_t i64_delta = (int64_t) delta;
-
-    for (size_t i = 0; i < d; i++) {
-
-        int64_t i64_pt_i = pt[i];
-        int64_t i64_ball_center_i = ball_center[i];
-
-        int64_t dist = std::abs(i64_pt_i - i64_ball_center_i);
-
-        if (dist > i64_delta) {
-            return false;
-        }
-
-        acc_dist += dist;
-    }
-
-    return acc_dist <= i64_delta;
-
-}
-
-template<size_t tr, size_t ts, size_t d, uint8_t delta>
-static void expected_l1_intersect(AES& aes,
-                                    array<point, tr> & rcvr_points,
-                                    array<point, ts> & sndr_points,
-                                    vector<point>& intersec) {
-    constexpr const size_t twotod = ((size_t) pow(2, d));
-    constexpr const size_t recvr_cell_count = ((size_t) pow(2, d)) * tr;
-                                        
-    unordered_map<block,size_t> rcvr_pts_hashes;
-
-    std::vector<block> rcvr_stcell_hashes;
-    std::vector<block> sndr_st_hashes;
-
-    sparse_comp::spatial_cell_hash<tr, d, recvr_cell_count>(aes, rcvr_points, rcvr_stcell_hashes, delta);
-    sparse_comp::spatial_hash<ts>(aes, sndr_points, sndr_st_hashes, d, delta);
-
-    for (size_t i=0;i < tr;i++) {
-        for (size_t j=0;j < twotod;j++) {
-            rcvr_pts_hashes.insert(std::make_pair(rcvr_stcell_hashes[twotod*i+j],i));
-        }
-    }
-                                    
-    for (size_t i = 0; i < ts; i++) {
-        block hash = sndr_st_hashes[i];
-        if (rcvr_pts_hashes.contains(hash)) {
-            size_t r_idx = rcvr_pts_hashes[hash];
-
-            if (is_l1_close<d>(rcvr_points[r_idx], sndr_points[i], delta)) {
-                intersec.push_back(sndr_points[i]);
-            }
-        }
-    }
-
-}
-
-template<size_t tr, size_t ts, size_t d, uint8_t delta>
-static void safer_expected_l1_intersect(AES& aes,
-                                    array<point, tr> & rcvr_points,
-                                    array<point, ts> & sndr_points,
-                                    vector<point>& intersec) {
-    int64_t int64_delta = (int64_t) delta;
-
-    for (size_t i = 0; i < ts; i++) {
-        for (size_t j = 0; j < tr; j++) {            
-            int64_t total_dist = 0;
-
-            for (size_t k = 0; k < d; k++) {
-                int64_t sndr_point = ((int64_t) sndr_points[i][k]);
-                int64_t rcvr_point = ((int64_t) rcvr_points[j][k]);
-
-                int64_t dist = std::abs(sndr_point - rcvr_point);
-                if (dist > int64_delta) {
-                    total_dist = int64_delta + 1;
-                    break;
-                }
-
-                total_dist += dist;
-            }
-
-            if (total_dist <= int64_delta) {
-                intersec.push_back(sndr_points[i]);
-                break;
-            }
-        }
-    }
-}
-
-bool is_intersec_correct(AES& aes, std::vector<point>& intersec, std::vector<point>& expected_intersec) {
-    
-    if (intersec.size() != expected_intersec.size()) {
-        return false;
-    }
-
-    unordered_map<block, bool> intersec_map;
-
-    for (size_t i = 0; i < intersec.size(); i++) {
-        intersec_map.insert(std::make_pair(sparse_comp::hash_point(aes, intersec[i]), true));
-    }
-
-    for (size_t i = 0; i < expected_intersec.size(); i++) {
-        if (!intersec_map.contains(sparse_comp::hash_point(aes, expected_intersec[i]))) {
-            return false;
-        }
-    }
-
-    return true;
-
-}
 /*
 
 TEST_CASE("Fuzzy L_inf : simple test 1 (t_s=2, t_r=2, d=2, delta=10, ssp=40)","[splinf][simple]")
@@ -375,15 +269,12 @@ TEST_CASE("Fuzzy L_inf : simple test 1 (t_s=2, t_r=2, d=2, delta=10, ssp=40)","[
 
     vector<point> expected_intersec;
 
-    safer_expected_l1_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::L1>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
 
 }
 
@@ -433,15 +324,12 @@ TEST_CASE("Fuzzy L_inf : simple test 2 (t_s=2, t_r=2, d=2, delta=10, ssp=40)","[
 
     vector<point> expected_intersec;
 
-    safer_expected_l1_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::L1>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
 
 }
 */
@@ -480,16 +368,13 @@ TEST_CASE("Fuzzy L_1 : random test (t_s=2, t_r=2, d=2, delta=10, ssp=40)","[spli
 
     std::vector<point> expected_intersec;
 
-    safer_expected_l1_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::L1>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     REQUIRE(expected_intersec.size() == target_matching_points);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
     REQUIRE(intersec.size() == target_matching_points);
 
 }
@@ -529,17 +414,14 @@ TEST_CASE("Fuzzy L_inf : random test (t_s=2, t_r=2, d=6, delta=10, ssp=40)","[sp
 
     std::vector<point> expected_intersec;
 
-    expected_l1_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::L1>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     REQUIRE(expected_intersec.size() == target_matching_points);
 
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
     REQUIRE(intersec.size() == target_matching_points);
 }
 
@@ -578,16 +460,13 @@ TEST_CASE("Fuzzy L_inf : random test (t_s=10, t_r=10, d=2, delta=10, ssp=40)","[
 
     std::vector<point> expected_intersec;
 
-    expected_l1_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::L1>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     REQUIRE(expected_intersec.size() == target_matching_points);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
     REQUIRE(intersec.size() == target_matching_points);
 
 }
@@ -627,16 +506,13 @@ TEST_CASE("Fuzzy L_inf : random test (t_s=10, t_r=10, d=6, delta=10, ssp=40)","[
 
     std::vector<point> expected_intersec;
 
-    expected_l1_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::L1>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     REQUIRE(expected_intersec.size() == target_matching_points);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
     REQUIRE(intersec.size() == target_matching_points);
 
 }
@@ -676,16 +552,13 @@ TEST_CASE("Fuzzy L_inf : safer random test (t_s=10, t_r=10, d=2, delta=10, ssp=4
 
     std::vector<point> expected_intersec;
 
-    safer_expected_l1_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::L1>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     REQUIRE(expected_intersec.size() == target_matching_points);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
     REQUIRE(intersec.size() == target_matching_points);
 
 }
@@ -725,16 +598,13 @@ TEST_CASE("Fuzzy L_inf : safer random test (t_s=10, t_r=10, d=6, delta=10, ssp=4
 
     std::vector<point> expected_intersec;
 
-    safer_expected_l1_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::L1>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     REQUIRE(expected_intersec.size() == target_matching_points);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
     REQUIRE(intersec.size() == target_matching_points);
 
 }
@@ -774,17 +644,136 @@ TEST_CASE("Fuzzy L_inf : safer random test (t_s=256, t_r=256, d=2, delta=10, ssp
 
     std::vector<point> expected_intersec;
 
-    safer_expected_l1_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::L1>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     REQUIRE(expected_intersec.size() == target_matching_points);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
     REQUIRE(intersec.size() == target_matching_points);
 
 }
 
+
+TEST_CASE("Fuzzy L_1 : prepared sets saved and mapped back (t_s=256, t_r=256, d=2, delta=10, ssp=40)","[fuzzyl1][prepared]")
+{
+    constexpr size_t TS = 256;
+    constexpr size_t TR = 256;
+    constexpr size_t D = 2;
+    constexpr size_t DELTA = 10;
+    constexpr size_t ssp = 40;
+    size_t target_matching_points = 3;
+
+    block seed = block(1624052788173641207ULL,9014321672890153318ULL);
+    PRNG senderPRNG = PRNG(block(742130310438916676ULL, 11803924226990735076ULL));
+    PRNG receiverPRNG = PRNG(block(2457938039974938056ULL, 17910068785450354990ULL));
+    AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+    std::array<point, TS> *senderPoints = new std::array<point, TS>();
+    std::array<point, TR> *receiverPoints = new std::array<point, TR>();
+
+    gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
+                                                  target_matching_points,
+                                                  *receiverPoints,
+                                                  *senderPoints);
+
+    // Declared before the mapped sets, so that the files outlive them
+    TempPath senderFile("fuzzy_l1_sender.prep");
+    TempPath receiverFile("fuzzy_l1_receiver.prep");
+    const std::string& senderPath = senderFile.str();
+    const std::string& receiverPath = receiverFile.str();
+
+    sparse_comp::fuzzy::PreparedSenderSet<TS, D>(aes, *senderPoints, DELTA).save(senderPath);
+    sparse_comp::fuzzy::PreparedReceiverSet<TR, D>(aes, *receiverPoints, DELTA).save(receiverPath);
+
+    auto preparedSender = sparse_comp::fuzzy::PreparedSenderSet<TS, D>::open(senderPath, aes, DELTA);
+    auto preparedReceiver = sparse_comp::fuzzy::PreparedReceiverSet<TR, D>::open(receiverPath, aes, DELTA);
+
+    REQUIRE_THROWS_AS(sparse_comp::fuzzy::PreparedSenderSet<TS, D>::open(senderPath, aes, DELTA + 1), std::runtime_error);
+    REQUIRE_THROWS_AS(sparse_comp::fuzzy::PreparedReceiverSet<TR, D>::open(senderPath, aes, DELTA), std::runtime_error);
+
+    std::vector<point> expected_intersec;
+
+    expected_intersect<Metric::L1>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
+    REQUIRE(expected_intersec.size() == target_matching_points);
+
+    // Two sessions on the same prepared sets
+    for (size_t session = 0; session < 2; session++) {
+        auto socks = LocalAsyncSocket::makePair();
+        std::vector<point> intersec;
+
+        sparse_comp::fuzzy_l1::Sender<TR, TS, D, DELTA, ssp> fuzzyL1Sender(senderPRNG, aes);
+        sparse_comp::fuzzy_l1::Receiver<TS, TR, D, DELTA, ssp> fuzzyL1Recvr(receiverPRNG, aes);
+
+        auto sender_proto = fuzzyL1Sender.send(socks[0], *preparedSender);
+        auto receiver_proto = fuzzyL1Recvr.receive(socks[1], *preparedReceiver, intersec);
+
+        sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto)));
+
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
+    }
+
+    delete senderPoints;
+    delete receiverPoints;
+
+}
+
+// Runs the tests below with the given OT extension, or skips the test case if it was not compiled into libOTe.
+static void check_fuzzy_l1_with_ot_ext(sparse_comp::multi_oprf::OtExtConfig otExt) {
+    constexpr size_t TS = 10;
+    constexpr size_t TR = 10;
+    constexpr size_t D = 2;
+    constexpr size_t DELTA = 10;
+    constexpr size_t ssp = 40;
+    size_t target_matching_points = 3;
+
+    if (!sparse_comp::multi_oprf::ot_ext_backend_available(otExt.backend)) {
+        SKIP(sparse_comp::multi_oprf::ot_ext_backend_name(otExt.backend) << " not compiled into libOTe");
+    }
+
+    auto socks = LocalAsyncSocket::makePair();
+
+    block seed = block(9536629026107651350ULL,2724119864341290560ULL);
+    PRNG senderPRNG = PRNG(block(742130310438916676ULL, 11803924226990735076ULL));
+    PRNG receiverPRNG = PRNG(block(2457938039974938056ULL, 17910068785450354990ULL));
+    AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+    std::array<point, TS> *senderPoints = new std::array<point, TS>();
+    std::array<point, TR> *receiverPoints = new std::array<point, TR>();
+    std::vector<point> intersec;
+
+    gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
+                                                  target_matching_points,
+                                                  *receiverPoints,
+                                                  *senderPoints);
+
+    sparse_comp::fuzzy_l1::Sender<TR, TS, D, DELTA, ssp> fuzzyL1Sender(senderPRNG, aes, nullptr, otExt);
+    sparse_comp::fuzzy_l1::Receiver<TS, TR, D, DELTA, ssp> fuzzyL1Recvr(receiverPRNG, aes, nullptr, otExt);
+
+    auto sender_proto = fuzzyL1Sender.send(socks[0], *senderPoints);
+    auto receiver_proto = fuzzyL1Recvr.receive(socks[1], *receiverPoints, intersec);
+
+    sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto)));
+
+    std::vector<point> expected_intersec;
+
+    expected_intersect<Metric::L1>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
+    REQUIRE(expected_intersec.size() == target_matching_points);
+
+    delete senderPoints;
+    delete receiverPoints;
+
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
+    REQUIRE(intersec.size() == target_matching_points);
+}
+
+TEST_CASE("Fuzzy L_1 : IKNP OT extension (t_s=10, t_r=10, d=2, delta=10, ssp=40)","[fuzzyl1][otext]")
+{
+    check_fuzzy_l1_with_ot_ext(sparse_comp::multi_oprf::OtExtConfig(sparse_comp::multi_oprf::OtExtBackend::Iknp));
+}
+
+TEST_CASE("Fuzzy L_1 : SoftSpokenOT extension (t_s=10, t_r=10, d=2, delta=10, ssp=40)","[fuzzyl1][otext]")
+{
+    check_fuzzy_l1_with_ot_ext(sparse_comp::multi_oprf::OtExtConfig(sparse_comp::multi_oprf::OtExtBackend::SoftSpoken));
+}
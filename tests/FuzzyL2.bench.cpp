@@ -3,11 +3,15 @@
 #include "cryptoTools/Crypto/PRNG.h"
 #include "cryptoTools/Common/block.h"
 #include "coproto/Socket/LocalAsyncSock.h"
+#include "./support/TwoPartyBench.h"
+#include "./support/EmulatedNetwork.h"
+#include "./support/GroundTruth.h"
 #include "cryptoTools/Crypto/AES.h"
 #include "../sparseComp/Common/Common.h"
 #include "../sparseComp/Common/HashUtils.h"
 #include "../sparseComp/FuzzyL2/FuzzyL2.h"
 #include <cstdint>
+#include <iostream>
 #include <chrono>
 #include <utility>
 #include <vector>
@@ -24,6 +28,10 @@ using PRNG = osuCrypto::PRNG;
 using osuCrypto::block;
 using AES = osuCrypto::AES;
 
+using sparse_comp::bench::Metric;
+using sparse_comp::bench::expected_intersect;
+using sparse_comp::bench::is_intersec_correct;
+
 using std::chrono::high_resolution_clock;
 using std::chrono::milliseconds;
 using sparse_comp::hash_point;
@@ -298,51 +306,6 @@ static void gen_constrained_rand_inputs(block seed,
                                                sndr_points);
 }
 
-static bool is_l2_close(point& pt,
-                        point& ball_center, 
-                        uint8_t delta) {
-    int64_t delta_sq = ((int64_t) delta)*((int64_t) delta);
-    int64_t d_abs[2] = {(int64_t) pt[0] - (int64_t) ball_center[0], (int64_t) pt[1] - (int64_t) ball_center[1]};
-
-    return (d_abs[0]*d_abs[0] + d_abs[1]*d_abs[1]) <= delta_sq;
-}
-
-template<size_t tr, size_t ts, uint8_t delta>
-static void expected_l2_intersect(AES& aes,
-                                    array<point, tr> & rcvr_points,
-                                    array<point, ts> & sndr_points,
-                                    vector<point>& intersec) {
-    constexpr const size_t d = 2;
-    constexpr const size_t twotod = ((size_t) pow(2, d));
-    constexpr const size_t recvr_cell_count = ((size_t) pow(2, d)) * tr;
-
-    unordered_map<block,size_t> rcvr_pts_hashes;
-
-    std::vector<block> rcvr_stcell_hashes;
-    std::vector<block> sndr_st_hashes;
-
-    sparse_comp::spatial_cell_hash<tr, d, recvr_cell_count>(aes, rcvr_points, rcvr_stcell_hashes, delta);
-    sparse_comp::spatial_hash<ts>(aes, sndr_points, sndr_st_hashes, d, delta);
-
-    for (size_t i=0;i < tr;i++) {
-        for (size_t j=0;j < twotod;j++) {
-            rcvr_pts_hashes.insert(std::make_pair(rcvr_stcell_hashes[twotod*i+j],i));
-        }
-    }
-
-    for (size_t i = 0; i < ts; i++) {
-        block hash = sndr_st_hashes[i];
-        if (rcvr_pts_hashes.contains(hash)) {
-            size_t r_idx = rcvr_pts_hashes[hash];
-
-            if (is_l2_close(rcvr_points[r_idx], sndr_points[i], delta)) {
-                intersec.push_back(sndr_points[i]);
-            }
-        }
-    }
-
-}
-
 template<size_t tr, size_t ts>
 static void intersec_from_z_shares(array<array<block,1>,tr>& rcvr_z_shares,
                                    array<array<block,1>,ts>& sndr_z_shares,
@@ -362,32 +325,6 @@ static void intersec_from_z_shares(array<array<block,1>,tr>& rcvr_z_shares,
     
 }
 
-bool is_intersec_correct(AES& aes, std::vector<point>& intersec, std::vector<point>& expected_intersec) {
-    
-    if (intersec.size() != expected_intersec.size()) {
-        return false;
-    }
-
-    unordered_map<block, bool> intersec_map;
-
-    for (size_t i = 0; i < intersec.size(); i++) {
-        intersec_map.insert(std::make_pair(sparse_comp::hash_point(aes, intersec[i]), true));
-    }
-
-    for (size_t i = 0; i < expected_intersec.size(); i++) {
-        
-        if (!intersec_map.contains(sparse_comp::hash_point(aes, expected_intersec[i]))) {
-            
-            
-            
-            return false;
-        }
-    }
-
-    return true;
-
-}
-
 TEST_CASE("fuzzyl2 (n=m=256 d=2 delta=10 ssp=40)","[fuzzyl2][n=m=2^8]") {
 
     BENCHMARK_ADVANCED("n=m=256 d=2 delta=10 ssp=40")(Catch::Benchmark::Chronometer meter) {
@@ -416,26 +353,22 @@ TEST_CASE("fuzzyl2 (n=m=256 d=2 delta=10 ssp=40)","[fuzzyl2][n=m=2^8]") {
         sparse_comp::fuzzy_l2::Sender<TR, TS, D, DELTA, ssp> fuzzyL2Sender(senderPRNG, aes);
         sparse_comp::fuzzy_l2::Receiver<TS, TR, D, DELTA, ssp> fuzzyL2Recvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyL2Sender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyL2Recvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyL2Sender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyL2Recvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_l2_intersect<TR, TS, DELTA>(aes,
-                                                *receiverPoints,
-                                                *senderPoints,
-                                                expected_intersec);
+        expected_intersect<Metric::L2>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
         REQUIRE(expected_intersec.size() == target_matching_points);
         
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -469,27 +402,23 @@ TEST_CASE("fuzzyl2 (n=m=4096 d=2 delta=10 ssp=40)","[fuzzyl2][n=m=2^8]") {
         sparse_comp::fuzzy_l2::Sender<TR, TS, D, DELTA, ssp> fuzzyL2Sender(senderPRNG, aes);
         sparse_comp::fuzzy_l2::Receiver<TS, TR, D, DELTA, ssp> fuzzyL2Recvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyL2Sender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyL2Recvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyL2Sender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyL2Recvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_l2_intersect<TR, TS, DELTA>(aes,
-                                                *receiverPoints,
-                                                *senderPoints,
-                                                expected_intersec);
+        expected_intersect<Metric::L2>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
         REQUIRE(expected_intersec.size() == target_matching_points);
         
         delete senderPoints;
         delete receiverPoints;
 
-        is_intersec_correct(aes, intersec, expected_intersec);
+        is_intersec_correct(intersec, expected_intersec);
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -523,26 +452,22 @@ TEST_CASE("fuzzyl2 (n=m=65536 d=2 delta=10 ssp=40)","[fuzzyl2][n=m=2^8]") {
         sparse_comp::fuzzy_l2::Sender<TR, TS, D, DELTA, ssp> fuzzyL2Sender(senderPRNG, aes);
         sparse_comp::fuzzy_l2::Receiver<TS, TR, D, DELTA, ssp> fuzzyL2Recvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyL2Sender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyL2Recvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyL2Sender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyL2Recvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_l2_intersect<TR, TS, DELTA>(aes,
-                                                *receiverPoints,
-                                                *senderPoints,
-                                                expected_intersec);
+        expected_intersect<Metric::L2>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
         REQUIRE(expected_intersec.size() == target_matching_points);
         
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -576,26 +501,22 @@ TEST_CASE("fuzzyl2 (n=m=256 d=2 delta=30 ssp=40)","[fuzzyl2][n=m=2^8]") {
         sparse_comp::fuzzy_l2::Sender<TR, TS, D, DELTA, ssp> fuzzyL2Sender(senderPRNG, aes);
         sparse_comp::fuzzy_l2::Receiver<TS, TR, D, DELTA, ssp> fuzzyL2Recvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyL2Sender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyL2Recvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyL2Sender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyL2Recvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_l2_intersect<TR, TS, DELTA>(aes,
-                                                *receiverPoints,
-                                                *senderPoints,
-                                                expected_intersec);
+        expected_intersect<Metric::L2>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
         REQUIRE(expected_intersec.size() == target_matching_points);
         
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -629,26 +550,22 @@ TEST_CASE("fuzzyl2 (n=m=4096 d=2 delta=30 ssp=40)","[fuzzyl2][n=m=2^8]") {
         sparse_comp::fuzzy_l2::Sender<TR, TS, D, DELTA, ssp> fuzzyL2Sender(senderPRNG, aes);
         sparse_comp::fuzzy_l2::Receiver<TS, TR, D, DELTA, ssp> fuzzyL2Recvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyL2Sender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyL2Recvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyL2Sender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyL2Recvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_l2_intersect<TR, TS, DELTA>(aes,
-                                                *receiverPoints,
-                                                *senderPoints,
-                                                expected_intersec);
+        expected_intersect<Metric::L2>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
         REQUIRE(expected_intersec.size() == target_matching_points);
         
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -682,27 +599,82 @@ TEST_CASE("fuzzyl2 (n=m=65536 d=2 delta=30 ssp=40)","[fuzzyl2][n=m=2^8]") {
         sparse_comp::fuzzy_l2::Sender<TR, TS, D, DELTA, ssp> fuzzyL2Sender(senderPRNG, aes);
         sparse_comp::fuzzy_l2::Receiver<TS, TR, D, DELTA, ssp> fuzzyL2Recvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyL2Sender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyL2Recvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyL2Sender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyL2Recvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_l2_intersect<TR, TS, DELTA>(aes,
-                                                *receiverPoints,
-                                                *senderPoints,
-                                                expected_intersec);
+        expected_intersect<Metric::L2>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
         REQUIRE(expected_intersec.size() == target_matching_points);
         
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
 }
+
+// Same inputs as the first n=m=256 case, over emulated LAN and WAN links. The link emulation only
+// applies to the default local party mode.
+TEST_CASE("fuzzyl2 lan/wan (n=m=256 d=2 delta=10 ssp=40)","[fuzzyl2][n=m=2^8][network]") {
+    for (const sparse_comp::bench::NetworkProfile& profile : {sparse_comp::bench::NetworkProfile::lan(), sparse_comp::bench::NetworkProfile::wan()}) {
+        size_t rounds = 0;
+
+        BENCHMARK_ADVANCED(profile.name + " n=m=256 d=2 delta=10 ssp=40")(Catch::Benchmark::Chronometer meter) {
+            constexpr size_t TS = 256;
+            constexpr size_t TR = 256;
+            constexpr size_t D = 2;
+            constexpr size_t DELTA = 10;
+            constexpr size_t ssp = 40;
+            size_t target_matching_points = 29;
+
+            sparse_comp::bench::EmulatedNetwork net(profile);
+            auto socks = net.makePair();
+            block seed = block(9536629026107651350ULL,2724119864341290560ULL);
+            PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+            PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+            AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+            std::array<point, TS>* senderPoints = new std::array<point, TS>();
+            std::array<point, TR>* receiverPoints = new std::array<point, TR>();
+            std::vector<point> intersec;
+
+            gen_constrained_rand_inputs<TR, TS, DELTA>(seed,
+                                                          target_matching_points,
+                                                          *receiverPoints,
+                                                          *senderPoints);
+
+            sparse_comp::fuzzy_l2::Sender<TR, TS, D, DELTA, ssp> fuzzyL2Sender(senderPRNG, aes);
+            sparse_comp::fuzzy_l2::Receiver<TS, TR, D, DELTA, ssp> fuzzyL2Recvr(receiverPRNG, aes);
+    
+            auto parties = sparse_comp::bench::measure_parties(meter, socks,
+                [&](coproto::Socket& sock) { return fuzzyL2Sender.send(sock, *senderPoints); },
+                [&](coproto::Socket& sock) { return fuzzyL2Recvr.receive(sock, *receiverPoints, intersec); }, intersec);
+
+            std::vector<point> expected_intersec;
+
+            expected_intersect<Metric::L2>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
+            REQUIRE(expected_intersec.size() == target_matching_points);
+        
+            delete senderPoints;
+            delete receiverPoints;
+    
+            REQUIRE(is_intersec_correct(intersec, expected_intersec));
+            REQUIRE(intersec.size() == target_matching_points);
+
+            const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
+
+            SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+
+            rounds = net.rounds();
+        };
+
+        std::cout << profile.name << " number of rounds: " << rounds << std::endl; // Latency is the benchmark time
+    }
+}
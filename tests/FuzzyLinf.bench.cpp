@@ -3,15 +3,18 @@
 #include "cryptoTools/Crypto/PRNG.h"
 #include "cryptoTools/Common/block.h"
 #include "coproto/Socket/LocalAsyncSock.h"
+#include "./support/TwoPartyBench.h"
+#include "./support/EmulatedNetwork.h"
+#include "./support/GroundTruth.h"
 #include "cryptoTools/Crypto/AES.h"
 #include "../sparseComp/Common/Common.h"
 #include "../sparseComp/Common/HashUtils.h"
 #include "../sparseComp/FuzzyLinf/FuzzyLinf.h"
 #include <cstdint>
+#include <iostream>
 #include <array>
 #include <vector>
 #include <set>
-#include <unordered_map>
 #include <utility>
 #include <cmath>
 
@@ -23,8 +26,11 @@ using PRNG = osuCrypto::PRNG;
 using osuCrypto::block;
 using AES = osuCrypto::AES;
 
+using sparse_comp::bench::Metric;
+using sparse_comp::bench::expected_intersect;
+using sparse_comp::bench::is_intersec_correct;
+
 using std::set;
-using std::unordered_map;
 
 using macoro::sync_wait;
 using macoro::when_all_ready;
@@ -210,106 +216,6 @@ static void gen_constrained_rand_inputs(block seed,
     
 }
 
-template<size_t d>
-inline static bool is_linf_close(point& pt, point& ball_center, int64_t delta) {
-    
-    for (size_t i = 0; i < d; i++) {
-        int64_t dist = std::abs((int64_t) pt[i] - (int64_t) ball_center[i]);
-
-        if (dist > delta) {
-            return false;
-        }
-    }
-
-    return true;
-
-}
-
-template<size_t tr, size_t ts, size_t d, uint8_t delta>
-static void expected_linf_intersect(AES& aes,
-                                    array<point, tr> & rcvr_points,
-                                    array<point, ts> & sndr_points,
-                                    vector<point>& intersec) {
-    constexpr const size_t twotod = ((size_t) pow(2, d));
-    constexpr const size_t recvr_cell_count = ((size_t) pow(2, d)) * tr;
-                                        
-    unordered_map<block,size_t> rcvr_pts_hashes;
-
-    vector<block> rcvr_stcell_hashes(recvr_cell_count);
-    vector<block> sndr_st_hashes(ts);
-
-    sparse_comp::spatial_cell_hash<tr, d, recvr_cell_count>(aes, rcvr_points, rcvr_stcell_hashes, delta);
-    sparse_comp::spatial_hash<ts>(aes, sndr_points, sndr_st_hashes, d, delta);
-
-    for (size_t i=0;i < tr;i++) {
-        for (size_t j=0;j < twotod;j++) {
-            rcvr_pts_hashes.insert(std::make_pair( rcvr_stcell_hashes[twotod*i+j],i));
-        }
-    }
-
-    for (size_t i = 0; i < ts; i++) {
-        block hash = sndr_st_hashes[i];
-        if (rcvr_pts_hashes.contains(hash)) {
-            size_t r_idx = rcvr_pts_hashes[hash];
-
-            if (is_linf_close<d>(rcvr_points[r_idx], sndr_points[i], delta)) {
-                intersec.push_back(sndr_points[i]);
-            }
-        }
-    }
-
-}
-
-template<size_t tr, size_t ts, size_t d, uint8_t delta>
-static void safer_expected_linf_intersect(AES& aes,
-                                    array<point, tr> & rcvr_points,
-                                    array<point, ts> & sndr_points,
-                                    vector<point>& intersec) {
-    int64_t int64_delta = (int64_t) delta;
-
-    for (size_t i = 0; i < ts; i++) {
-        for (size_t j = 0; j < tr; j++) {
-            bool close = true;            
-            
-            for (size_t k = 0; k < d; k++) {
-                int64_t dist = std::abs((int64_t) sndr_points[i][k] - (int64_t) rcvr_points[j][k]);
-
-                if (dist > int64_delta) {
-                    close = false;
-                    break;
-                }
-            }
-
-            if (close) {
-                intersec.push_back(sndr_points[i]);
-                break;
-            }
-        }
-    }
-}
-
-bool is_intersec_correct(AES& aes, std::vector<point>& intersec, std::vector<point>& expected_intersec) {
-    
-    if (intersec.size() != expected_intersec.size()) {
-        return false;
-    }
-
-    unordered_map<block, bool> intersec_map;
-
-    for (size_t i = 0; i < intersec.size(); i++) {
-        intersec_map.insert(std::make_pair(sparse_comp::hash_point(aes, intersec[i]), true));
-    }
-
-    for (size_t i = 0; i < expected_intersec.size(); i++) {
-        if (!intersec_map.contains(sparse_comp::hash_point(aes, expected_intersec[i]))) {
-            return false;
-        }
-    }
-
-    return true;
-
-}
-
 // START OF TESTS FOR N=M=2^8
 
 TEST_CASE("fuzzylinf (n=m=256 d=2 delta=10 ssp=40)","[splinf][n=m=2^8]") {
@@ -340,25 +246,21 @@ TEST_CASE("fuzzylinf (n=m=256 d=2 delta=10 ssp=40)","[splinf][n=m=2^8]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
         
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -392,27 +294,23 @@ TEST_CASE("fuzzylinf (n=m=256 d=6 delta=10 ssp=40)","[splinf][n=m=2^8]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -446,25 +344,21 @@ TEST_CASE("fuzzylinf (n=m=256 d=10 delta=10 ssp=40)","[splinf][n=m=2^8]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
         
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -498,27 +392,23 @@ TEST_CASE("fuzzylinf (n=m=256 d=2 delta=30 ssp=40)","[splinf][n=m=2^8]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -552,27 +442,23 @@ TEST_CASE("fuzzylinf (n=m=256 d=6 delta=30 ssp=40)","[splinf][n=m=2^8]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -606,27 +492,23 @@ TEST_CASE("fuzzylinf (n=m=256 d=10 delta=30 ssp=40)","[splinf][n=m=2^8]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -665,27 +547,23 @@ TEST_CASE("fuzzylinf (n=m=4096 d=2 delta=10 ssp=40)","[splinf][n=m=2^12]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -719,27 +597,23 @@ TEST_CASE("fuzzylinf (n=m=4096 d=6 delta=10 ssp=40)","[splinf][n=m=2^12]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -773,27 +647,23 @@ TEST_CASE("fuzzylinf (n=m=4096 d=10 delta=10 ssp=40)","[splinf][n=m=2^12]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -827,27 +697,23 @@ TEST_CASE("fuzzylinf (n=m=4096 d=2 delta=30 ssp=40)","[splinf][n=m=2^12]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -881,27 +747,23 @@ TEST_CASE("fuzzylinf (n=m=4096 d=6 delta=30 ssp=40)","[splinf][n=m=2^12]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -935,27 +797,23 @@ TEST_CASE("fuzzylinf (n=m=4096 d=10 delta=30 ssp=40)","[splinf][n=m=2^12]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -995,27 +853,23 @@ TEST_CASE("fuzzylinf (n=m=65536 d=2 delta=10 ssp=40)","[splinf][n=m=2^16]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1049,27 +903,23 @@ TEST_CASE("fuzzylinf (n=m=65536 d=6 delta=10 ssp=40)","[splinf][n=m=2^16]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1103,27 +953,23 @@ TEST_CASE("fuzzylinf (n=m=65536 d=10 delta=10 ssp=40)","[splinf][n=m=2^16]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1157,27 +1003,23 @@ TEST_CASE("fuzzylinf (n=m=65536 d=2 delta=30 ssp=40)","[splinf][n=m=2^16]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1211,27 +1053,23 @@ TEST_CASE("fuzzylinf (n=m=65536 d=6 delta=30 ssp=40)","[splinf][n=m=2^16]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1265,27 +1103,23 @@ TEST_CASE("fuzzylinf (n=m=65536 d=10 delta=30 ssp=40)","[splinf][n=m=2^16]") {
         sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
         sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
     
-        auto sender_proto = fuzzyLinfSender.send(socks[0], *senderPoints);
-        auto receiver_proto = fuzzyLinfRecvr.receive(socks[1], *receiverPoints, intersec);
-    
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+            [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
 
         std::vector<point> expected_intersec;
 
-        expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                        *receiverPoints,
-                                        *senderPoints,
-                                        expected_intersec);
+        expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
         
     
         delete senderPoints;
         delete receiverPoints;
     
-        REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+        REQUIRE(is_intersec_correct(intersec, expected_intersec));
         REQUIRE(intersec.size() == target_matching_points);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1293,3 +1127,61 @@ TEST_CASE("fuzzylinf (n=m=65536 d=10 delta=30 ssp=40)","[splinf][n=m=2^16]") {
 
 
 // END OF TESTS FOR N=M=2^16
+
+// Same inputs as the first n=m=256 case, over emulated LAN and WAN links. The link emulation only
+// applies to the default local party mode.
+TEST_CASE("fuzzylinf lan/wan (n=m=256 d=2 delta=10 ssp=40)","[fuzzylinf][n=m=2^8][network]") {
+    for (const sparse_comp::bench::NetworkProfile& profile : {sparse_comp::bench::NetworkProfile::lan(), sparse_comp::bench::NetworkProfile::wan()}) {
+        size_t rounds = 0;
+
+        BENCHMARK_ADVANCED(profile.name + " n=m=256 d=2 delta=10 ssp=40")(Catch::Benchmark::Chronometer meter) {
+            constexpr size_t TS = 256;
+            constexpr size_t TR = 256;
+            constexpr size_t D = 2;
+            constexpr size_t DELTA = 10;
+            constexpr size_t ssp = 40;
+            size_t target_matching_points = 29;
+
+            sparse_comp::bench::EmulatedNetwork net(profile);
+            auto socks = net.makePair();
+            block seed = block(9536629026107651350ULL,2724119864341290560ULL);
+            PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+            PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+            AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+            std::array<point, TS>* senderPoints = new std::array<point, TS>();
+            std::array<point, TR>* receiverPoints = new std::array<point, TR>();
+            std::vector<point> intersec;
+
+            gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
+                                                          target_matching_points,
+                                                          *receiverPoints,
+                                                          *senderPoints);
+
+            sparse_comp::fuzzy_linf::Sender<TR, TS, D, DELTA, ssp> fuzzyLinfSender(senderPRNG, aes);
+            sparse_comp::fuzzy_linf::Receiver<TS, TR, D, DELTA, ssp> fuzzyLinfRecvr(receiverPRNG, aes);
+    
+            auto parties = sparse_comp::bench::measure_parties(meter, socks,
+                [&](coproto::Socket& sock) { return fuzzyLinfSender.send(sock, *senderPoints); },
+                [&](coproto::Socket& sock) { return fuzzyLinfRecvr.receive(sock, *receiverPoints, intersec); }, intersec);
+
+            std::vector<point> expected_intersec;
+
+            expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
+        
+            delete senderPoints;
+            delete receiverPoints;
+    
+            REQUIRE(is_intersec_correct(intersec, expected_intersec));
+            REQUIRE(intersec.size() == target_matching_points);
+
+            const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
+
+            SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+
+            rounds = net.rounds();
+        };
+
+        std::cout << profile.name << " number of rounds: " << rounds << std::endl; // Latency is the benchmark time
+    }
+}
@@ -2,6 +2,7 @@
 #include "cryptoTools/Crypto/PRNG.h"
 #include "cryptoTools/Common/block.h"
 #include "coproto/Socket/LocalAsyncSock.h"
+#include "./support/GroundTruth.h"
 #include "cryptoTools/Crypto/AES.h"
 #include "../sparseComp/Common/Common.h"
 #include "../sparseComp/Common/HashUtils.h"
@@ -10,7 +11,6 @@
 #include <array>
 #include <vector>
 #include <set>
-#include <unordered_map>
 #include <utility>
 #include <cmath>
 
@@ -22,8 +22,11 @@ using PRNG = osuCrypto::PRNG;
 using osuCrypto::block;
 using AES = osuCrypto::AES;
 
+using sparse_comp::bench::Metric;
+using sparse_comp::bench::expected_intersect;
+using sparse_comp::bench::is_intersec_correct;
+
 using std::set;
-using std::unordered_map;
 
 using macoro::sync_wait;
 using macoro::when_all_ready;
@@ -209,107 +212,6 @@ static void gen_constrained_rand_inputs(block seed,
     
 }
 
-template<size_t d>
-inline static bool is_linf_close(point& pt, point& ball_center, int64_t delta) {
-    
-    for (size_t i = 0; i < d; i++) {
-        int64_t dist = std::abs((int64_t) pt[i] - (int64_t) ball_center[i]);
-
-        if (dist > delta) {
-            return false;
-        }
-    }
-
-    return true;
-
-}
-
-
-template<size_t tr, size_t ts, size_t d, uint8_t delta>
-static void expected_linf_intersect(AES& aes,
-                                    array<point, tr> & rcvr_points,
-                                    array<point, ts> & sndr_points,
-                                    vector<point>& intersec) {
-    constexpr const size_t twotod = ((size_t) pow(2, d));
-    constexpr const size_t recvr_cell_count = ((size_t) pow(2, d)) * tr;
-                                        
-    unordered_map<block,size_t> rcvr_pts_hashes;
-
-    vector<block> rcvr_stcell_hashes(recvr_cell_count);
-    vector<block> sndr_st_hashes(ts);
-
-    sparse_comp::spatial_cell_hash<tr, d, recvr_cell_count>(aes, rcvr_points, rcvr_stcell_hashes, delta);
-    sparse_comp::spatial_hash<ts>(aes, sndr_points, sndr_st_hashes, d, delta);
-
-    for (size_t i=0;i < tr;i++) {
-        for (size_t j=0;j < twotod;j++) {
-            rcvr_pts_hashes.insert(std::make_pair( rcvr_stcell_hashes[twotod*i+j],i));
-        }
-    }
-
-    for (size_t i = 0; i < ts; i++) {
-        block hash = sndr_st_hashes[i];
-        if (rcvr_pts_hashes.contains(hash)) {
-            size_t r_idx = rcvr_pts_hashes[hash];
-
-            if (is_linf_close<d>(rcvr_points[r_idx], sndr_points[i], delta)) {
-                intersec.push_back(sndr_points[i]);
-            }
-        }
-    }
-
-}
-
-template<size_t tr, size_t ts, size_t d, uint8_t delta>
-static void safer_expected_linf_intersect(AES& aes,
-                                    array<point, tr> & rcvr_points,
-                                    array<point, ts> & sndr_points,
-                                    vector<point>& intersec) {
-    int64_t int64_delta = (int64_t) delta;
-
-    for (size_t i = 0; i < ts; i++) {
-        for (size_t j = 0; j < tr; j++) {
-            bool close = true;            
-            
-            for (size_t k = 0; k < d; k++) {
-                int64_t dist = std::abs((int64_t) sndr_points[i][k] - (int64_t) rcvr_points[j][k]);
-
-                if (dist > int64_delta) {
-                    close = false;
-                    break;
-                }
-            }
-
-            if (close) {
-                intersec.push_back(sndr_points[i]);
-                break;
-            }
-        }
-    }
-}
-
-bool is_intersec_correct(AES& aes, std::vector<point>& intersec, std::vector<point>& expected_intersec) {
-    
-    if (intersec.size() != expected_intersec.size()) {
-        return false;
-    }
-
-    unordered_map<block, bool> intersec_map;
-
-    for (size_t i = 0; i < intersec.size(); i++) {
-        intersec_map.insert(std::make_pair(sparse_comp::hash_point(aes, intersec[i]), true));
-    }
-
-    for (size_t i = 0; i < expected_intersec.size(); i++) {
-        if (!intersec_map.contains(sparse_comp::hash_point(aes, expected_intersec[i]))) {
-            return false;
-        }
-    }
-
-    return true;
-
-}
-
 TEST_CASE("Fuzzy L_inf : simple test (t_s=2, t_r=2, d=2, delta=10, ssp=40)","[splinf][simple]")
 {
     constexpr size_t TS = 2;
@@ -353,15 +255,12 @@ TEST_CASE("Fuzzy L_inf : simple test (t_s=2, t_r=2, d=2, delta=10, ssp=40)","[sp
 
     vector<point> expected_intersec;
 
-    expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
     
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
 
 }
 
@@ -400,15 +299,12 @@ TEST_CASE("Fuzzy L_inf : random test (t_s=2, t_r=2, d=2, delta=10, ssp=40)","[sp
 
     std::vector<point> expected_intersec;
 
-    expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
     REQUIRE(intersec.size() == target_matching_points);
 
 }
@@ -448,15 +344,12 @@ TEST_CASE("Fuzzy L_inf : random test (t_s=2, t_r=2, d=6, delta=10, ssp=40)","[sp
 
     std::vector<point> expected_intersec;
 
-    expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
     REQUIRE(intersec.size() == target_matching_points);
 }
 
@@ -495,15 +388,12 @@ TEST_CASE("Fuzzy L_inf : random test (t_s=10, t_r=10, d=2, delta=10, ssp=40)","[
 
     std::vector<point> expected_intersec;
 
-    expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
     REQUIRE(intersec.size() == target_matching_points);
 
 }
@@ -543,15 +433,12 @@ TEST_CASE("Fuzzy L_inf : random test (t_s=10, t_r=10, d=6, delta=10, ssp=40)","[
 
     std::vector<point> expected_intersec;
 
-    expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
     REQUIRE(intersec.size() == target_matching_points);
 
 }
@@ -591,15 +478,12 @@ TEST_CASE("Fuzzy L_inf : safer random test (t_s=10, t_r=10, d=2, delta=10, ssp=4
 
     std::vector<point> expected_intersec;
 
-    safer_expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
     REQUIRE(intersec.size() == target_matching_points);
 
 }
@@ -639,15 +523,12 @@ TEST_CASE("Fuzzy L_inf : safer random test (t_s=10, t_r=10, d=6, delta=10, ssp=4
 
     std::vector<point> expected_intersec;
 
-    safer_expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
     REQUIRE(intersec.size() == target_matching_points);
 
 }
@@ -687,15 +568,12 @@ TEST_CASE("Fuzzy L_inf : safer random test (t_s=256, t_r=256, d=2, delta=10, ssp
 
     std::vector<point> expected_intersec;
 
-    safer_expected_linf_intersect<TR, TS, D, DELTA>(aes,
-                                    *receiverPoints,
-                                    *senderPoints,
-                                    expected_intersec);
+    expected_intersect<Metric::Linf>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
 
     delete senderPoints;
     delete receiverPoints;
 
-    REQUIRE(is_intersec_correct(aes, intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(intersec, expected_intersec));
     REQUIRE(intersec.size() == target_matching_points);
 
 }
@@ -0,0 +1,144 @@
+#include "catch2/catch_test_macros.hpp"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "coproto/Socket/LocalAsyncSock.h"
+#include "./support/GroundTruth.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "../sparseComp/Common/Common.h"
+#include "../sparseComp/FuzzyL1/FuzzyL1.h"
+#include "../sparseComp/FuzzyParallel/FuzzyParallel.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+using sparse_comp::point;
+
+using coproto::LocalAsyncSocket;
+
+using PRNG = osuCrypto::PRNG;
+using osuCrypto::block;
+using AES = osuCrypto::AES;
+
+using sparse_comp::bench::Metric;
+using sparse_comp::bench::expected_intersect;
+using sparse_comp::bench::is_intersec_correct;
+using sparse_comp::fuzzy_parallel::COLUMN_BITS;
+using sparse_comp::fuzzy_parallel::column_partition;
+
+using macoro::sync_wait;
+using macoro::when_all_ready;
+
+namespace {
+
+    constexpr size_t N = 64;
+    constexpr size_t BATCH = 16;
+    constexpr size_t D = 2;
+    constexpr uint8_t DELTA = 10;
+    constexpr uint8_t SSP = 40;
+    constexpr size_t PARTITIONS = 4;
+    constexpr size_t MEMORY_BUDGET = size_t(1) << 30;
+
+    constexpr size_t MATCHES = 8;
+    constexpr size_t BOUNDARY_MATCHES = 4;
+
+    uint32_t random_coordinate(PRNG& prng, uint64_t range) {
+        return (uint32_t) (2 * DELTA + prng.get<uint64_t>() % (range - 4 * DELTA));
+    }
+
+    // Points whose first coordinates span 256 columns, so that every partition gets some of them. The first
+    // MATCHES sender points lie within delta of distinct receiver points, and BOUNDARY_MATCHES more match across
+    // the edge of two columns of different partitions, with the receiver point on either side of it, one of them
+    // right on the edge. One more sender point lies just beyond delta of a receiver point across such an edge.
+    void gen_parallel_inputs(block seed, std::array<point,N>& receiverPoints, std::array<point,N>& senderPoints) {
+        PRNG prng(seed);
+        uint32_t c[D];
+
+        for (size_t i = 0; i < N; i++) {
+            c[0] = random_coordinate(prng, (uint64_t) 1 << 24);
+            c[1] = random_coordinate(prng, (uint64_t) 1 << 32);
+            receiverPoints[i] = point(D, c);
+
+            c[0] = random_coordinate(prng, (uint64_t) 1 << 24);
+            c[1] = random_coordinate(prng, (uint64_t) 1 << 32);
+            senderPoints[i] = point(D, c);
+        }
+
+        for (size_t i = 0; i < MATCHES; i++) {
+            senderPoints[i] = receiverPoints[i * (N / MATCHES)];
+            senderPoints[i][0] += DELTA / 2;
+        }
+
+        uint64_t column = 1;
+
+        for (size_t b = 0; b < BOUNDARY_MATCHES; b++) {
+            while (column_partition((column - 1) << COLUMN_BITS, PARTITIONS) == column_partition(column << COLUMN_BITS, PARTITIONS)) column++;
+
+            const uint32_t edge = (uint32_t) (column << COLUMN_BITS);
+            const size_t r = b * (N / MATCHES) + 1;
+            const bool below = b % 2 == 0;
+
+            receiverPoints[r][0] = below ? edge - 1 - (uint32_t) b : edge + (uint32_t) b - 1;
+            senderPoints[MATCHES + b] = receiverPoints[r];
+            senderPoints[MATCHES + b][0] = below ? receiverPoints[r][0] + DELTA / 2 : receiverPoints[r][0] - DELTA / 2;
+
+            column++;
+        }
+
+        senderPoints[MATCHES + BOUNDARY_MATCHES] = receiverPoints[1];
+        senderPoints[MATCHES + BOUNDARY_MATCHES][0] += DELTA + 1;
+    }
+
+}
+
+TEST_CASE("Fuzzy parallel : same result as the sequential protocol (t_s=64, t_r=64, d=2, delta=10, ssp=40, 4 partitions)","[fuzzyparallel]")
+{
+    AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+    std::array<point,N> *senderPoints = new std::array<point,N>();
+    std::array<point,N> *receiverPoints = new std::array<point,N>();
+
+    gen_parallel_inputs(block(9536629126107612350ULL,2721317164341290561ULL), *receiverPoints, *senderPoints);
+
+    std::vector<point> sequential_intersec;
+    {
+        auto socks = LocalAsyncSocket::makePair();
+        PRNG senderPRNG = PRNG(block(742130310438916676ULL, 11803924226990735076ULL));
+        PRNG receiverPRNG = PRNG(block(2457938039974938056ULL, 17910068785450354990ULL));
+
+        sparse_comp::fuzzy_l1::Sender<N, N, D, DELTA, SSP> fuzzyL1Sender(senderPRNG, aes);
+        sparse_comp::fuzzy_l1::Receiver<N, N, D, DELTA, SSP> fuzzyL1Recvr(receiverPRNG, aes);
+
+        auto r = sync_wait(when_all_ready(fuzzyL1Sender.send(socks[0], *senderPoints),
+                                          fuzzyL1Recvr.receive(socks[1], *receiverPoints, sequential_intersec)));
+        std::get<0>(r).result();
+        std::get<1>(r).result();
+    }
+
+    std::vector<point> parallel_intersec;
+    {
+        auto socks = LocalAsyncSocket::makePair();
+        PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+        PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+
+        sparse_comp::fuzzy_parallel::Sender<sparse_comp::fuzzy_l1::Sender, BATCH, BATCH, D, DELTA, SSP> parallelSender(senderPRNG, aes, PARTITIONS, MEMORY_BUDGET);
+        sparse_comp::fuzzy_parallel::Receiver<sparse_comp::fuzzy_l1::Receiver, BATCH, BATCH, D, DELTA, SSP> parallelRecvr(receiverPRNG, aes, PARTITIONS, MEMORY_BUDGET);
+
+        auto r = sync_wait(when_all_ready(parallelSender.send(socks[0], std::span<const point>(*senderPoints)),
+                                          parallelRecvr.receive(socks[1], std::span<const point>(*receiverPoints), parallel_intersec)));
+        std::get<0>(r).result();
+        std::get<1>(r).result();
+    }
+
+    std::vector<point> expected_intersec;
+
+    expected_intersect<Metric::L1>(*receiverPoints, *senderPoints, D, DELTA, expected_intersec);
+    REQUIRE(expected_intersec.size() == MATCHES + BOUNDARY_MATCHES);
+
+    delete senderPoints;
+    delete receiverPoints;
+
+    REQUIRE(is_intersec_correct(sequential_intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(parallel_intersec, sequential_intersec));
+}
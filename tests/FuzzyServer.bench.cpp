@@ -0,0 +1,150 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "coproto/Socket/LocalAsyncSock.h"
+#include "macoro/thread_pool.h"
+#include "./support/GroundTruth.h"
+#include "./support/Workloads.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "../sparseComp/Common/Common.h"
+#include "../sparseComp/FuzzyL1/FuzzyL1.h"
+#include "../sparseComp/FuzzyServer/FuzzyServer.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Concurrent sessions of a Fuzzy L1 server (see FuzzyServer.h) holding 2^12 points, against 1, 4 and 16
+// receivers of 2^8 points each. Every receiver runs on a thread of its own pool, and both pools have one
+// thread per session up to the number of cores. After every measurement the benchmark prints the session
+// throughput, the session latencies recorded by the server and the time it took to prepare its set, which
+// a sender without the server would spend again in every session. The other fuzzy protocols are served the
+// same way; their implementations cannot share a translation unit.
+
+using sparse_comp::point;
+
+using coproto::LocalAsyncSocket;
+
+using PRNG = osuCrypto::PRNG;
+using osuCrypto::block;
+using AES = osuCrypto::AES;
+
+using sparse_comp::bench::Metric;
+using sparse_comp::bench::Workload;
+using sparse_comp::bench::expected_intersect;
+using sparse_comp::bench::is_intersec_correct;
+
+namespace {
+
+    constexpr size_t SERVER_POINTS = size_t(1) << 12;
+    constexpr size_t SESSION_POINTS = size_t(1) << 8;
+
+    // Moves proto to a thread of pool and runs it there.
+    Proto run_on(macoro::thread_pool& pool, Proto proto) {
+        MC_BEGIN(Proto, &pool, proto = std::move(proto));
+
+            MC_AWAIT(pool.schedule());
+            MC_AWAIT(std::move(proto));
+
+        MC_END();
+    }
+
+    template<size_t d, uint8_t delta, uint8_t ssp>
+    void bench_server(size_t sessions, block seed) {
+        using Server = sparse_comp::fuzzy_server::Server<sparse_comp::fuzzy_l1::Sender, SESSION_POINTS, SERVER_POINTS, d, delta, ssp>;
+        using Receiver = sparse_comp::fuzzy_l1::Receiver<SERVER_POINTS, SESSION_POINTS, d, delta, ssp>;
+
+        const std::string name = "sessions=" + std::to_string(sessions) + " ts=2^" + std::to_string(std::bit_width(SERVER_POINTS) - 1) +
+                                 " tr=2^" + std::to_string(std::bit_width(SESSION_POINTS) - 1) + " d=" + std::to_string(d) + " delta=" + std::to_string(delta);
+
+        BENCHMARK_ADVANCED(name.c_str())(Catch::Benchmark::Chronometer meter) {
+            PRNG serverPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+            PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+            AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+            std::vector<point> senderPoints(SERVER_POINTS);
+            std::vector<point> receiverPoints(sessions * SESSION_POINTS);
+
+            sparse_comp::bench::load_or_gen_workload(Workload::Uniform, seed, {d, delta, 29}, receiverPoints, senderPoints);
+
+            auto senderSet = std::make_unique<std::array<point,SERVER_POINTS>>();
+            std::copy(senderPoints.begin(), senderPoints.end(), senderSet->begin());
+
+            const size_t threads = std::min<size_t>(sessions, std::max(1u, std::thread::hardware_concurrency()));
+
+            Server server(serverPRNG, aes, *senderSet, threads);
+
+            std::vector<std::unique_ptr<std::array<point,SESSION_POINTS>>> receiverSets;
+            std::vector<std::unique_ptr<PRNG>> receiverPRNGs;
+            std::vector<std::unique_ptr<Receiver>> receivers;
+            std::vector<std::vector<point>> intersecs(sessions);
+
+            for (size_t i = 0; i < sessions; i++) {
+                receiverSets.push_back(std::make_unique<std::array<point,SESSION_POINTS>>());
+                std::copy_n(receiverPoints.begin() + i * SESSION_POINTS, SESSION_POINTS, receiverSets[i]->begin());
+
+                receiverPRNGs.push_back(std::make_unique<PRNG>(receiverPRNG.get<block>()));
+                receivers.push_back(std::make_unique<Receiver>(*receiverPRNGs[i], aes));
+            }
+
+            macoro::thread_pool receiverPool;
+            auto work = receiverPool.make_work();
+            receiverPool.create_threads(threads);
+
+            double wall_ms = 0;
+            size_t runs = 0;
+
+            meter.measure([&] {
+                std::vector<std::array<LocalAsyncSocket,2>> socks;
+                std::vector<Proto> tasks;
+
+                // The sessions refer to their sockets, which must not move
+                socks.reserve(sessions);
+
+                for (size_t i = 0; i < sessions; i++) {
+                    intersecs[i].clear();
+                    socks.push_back(LocalAsyncSocket::makePair());
+
+                    tasks.push_back(server.serve(socks[i][0]));
+                    tasks.push_back(run_on(receiverPool, receivers[i]->receive(socks[i][1], *receiverSets[i], intersecs[i])));
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                macoro::sync_wait(macoro::when_all_ready(std::move(tasks)));
+                wall_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                runs++;
+            });
+
+            for (size_t i = 0; i < sessions; i++) {
+                std::vector<point> expected_intersec;
+
+                expected_intersect<Metric::L1>(std::span<const point>(receiverPoints).subspan(i * SESSION_POINTS, SESSION_POINTS), senderPoints, d, delta, expected_intersec);
+
+                REQUIRE(is_intersec_correct(intersecs[i], expected_intersec));
+            }
+
+            const sparse_comp::fuzzy_server::ServerStats stats = server.stats();
+
+            REQUIRE(stats.failures == 0);
+
+            std::cout << "Sessions per second: " << (wall_ms > 0 ? (double) (runs * sessions) / (wall_ms / 1000.0) : 0)
+                      << " latency ms p50: " << stats.latency_quantile(0.5) << " p90: " << stats.latency_quantile(0.9)
+                      << " max: " << stats.latency_quantile(1.0) << " preparation ms: " << stats.prepare_ms << std::endl;
+        };
+    }
+
+};
+
+TEST_CASE("fuzzy_server l1 (ts=2^12 tr=2^8 d=2 delta=10 ssp=40)", "[fuzzy_server][fuzzyl1]") {
+    for (size_t sessions : {1, 4, 16}) {
+        bench_server<2, 10, 40>(sessions, block(3418562871926377610ULL, 12764090374216409381ULL + sessions));
+    }
+}
@@ -0,0 +1,139 @@
+#include "catch2/catch_test_macros.hpp"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "coproto/Socket/LocalAsyncSock.h"
+#include "macoro/thread_pool.h"
+#include "./support/GroundTruth.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "../sparseComp/Common/Common.h"
+#include "../sparseComp/FuzzyL1/FuzzyL1.h"
+#include "../sparseComp/FuzzyServer/FuzzyServer.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+using sparse_comp::point;
+
+using coproto::LocalAsyncSocket;
+
+using PRNG = osuCrypto::PRNG;
+using osuCrypto::block;
+using AES = osuCrypto::AES;
+
+using sparse_comp::bench::Metric;
+using sparse_comp::bench::expected_intersect;
+using sparse_comp::bench::is_intersec_correct;
+
+using macoro::sync_wait;
+using macoro::when_all_ready;
+
+namespace {
+
+    constexpr size_t TS = 32;
+    constexpr size_t TR = 16;
+    constexpr size_t D = 2;
+    constexpr uint8_t DELTA = 10;
+    constexpr uint8_t SSP = 40;
+    constexpr size_t SESSIONS = 2;
+
+    // Matches of each session, on distinct sender points
+    constexpr size_t SESSION_MATCHES[SESSIONS] = {3, 5};
+
+    using Server = sparse_comp::fuzzy_server::Server<sparse_comp::fuzzy_l1::Sender, TR, TS, D, DELTA, SSP>;
+    using Receiver = sparse_comp::fuzzy_l1::Receiver<TS, TR, D, DELTA, SSP>;
+
+    // Moves proto to a thread of pool and runs it there.
+    Proto run_on(macoro::thread_pool& pool, Proto proto) {
+        MC_BEGIN(Proto, &pool, proto = std::move(proto));
+
+            MC_AWAIT(pool.schedule());
+            MC_AWAIT(std::move(proto));
+
+        MC_END();
+    }
+
+    template<size_t n>
+    void gen_random_points(PRNG& prng, std::array<point,n>& points) {
+        uint32_t c[D];
+
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < D; j++) c[j] = (uint32_t) (2 * DELTA + prng.get<uint64_t>() % (((uint64_t) 1 << 32) - 4 * DELTA));
+            points[i] = point(D, c);
+        }
+    }
+
+}
+
+TEST_CASE("Fuzzy server : concurrent sessions on one prepared set (t_s=32, t_r=16, d=2, delta=10, ssp=40, 2 sessions)","[fuzzyserver]")
+{
+    PRNG inputPRNG = PRNG(block(9536629126107612350ULL, 2721317164341290561ULL));
+    PRNG serverPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+    PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+    AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+    auto senderSet = std::make_unique<std::array<point,TS>>();
+    std::vector<std::unique_ptr<std::array<point,TR>>> receiverSets;
+
+    gen_random_points(inputPRNG, *senderSet);
+
+    // Each session matches sender points of its own
+    for (size_t s = 0, next = 0; s < SESSIONS; s++) {
+        receiverSets.push_back(std::make_unique<std::array<point,TR>>());
+        gen_random_points(inputPRNG, *receiverSets[s]);
+
+        for (size_t i = 0; i < SESSION_MATCHES[s]; i++, next++) {
+            (*senderSet)[next] = (*receiverSets[s])[i * (TR / SESSION_MATCHES[s])];
+            (*senderSet)[next][0] += DELTA / 2;
+        }
+    }
+
+    Server server(serverPRNG, aes, *senderSet, SESSIONS);
+
+    std::vector<std::unique_ptr<PRNG>> receiverPRNGs;
+    std::vector<std::unique_ptr<Receiver>> receivers;
+    std::vector<std::vector<point>> intersecs(SESSIONS);
+
+    for (size_t s = 0; s < SESSIONS; s++) {
+        receiverPRNGs.push_back(std::make_unique<PRNG>(receiverPRNG.get<block>()));
+        receivers.push_back(std::make_unique<Receiver>(*receiverPRNGs[s], aes));
+    }
+
+    macoro::thread_pool receiverPool;
+    auto work = receiverPool.make_work();
+    receiverPool.create_threads(SESSIONS);
+
+    {
+        std::vector<std::array<LocalAsyncSocket,2>> socks;
+        std::vector<Proto> tasks;
+
+        // The sessions refer to their sockets, which must not move
+        socks.reserve(SESSIONS);
+
+        for (size_t s = 0; s < SESSIONS; s++) {
+            socks.push_back(LocalAsyncSocket::makePair());
+
+            tasks.push_back(server.serve(socks[s][0]));
+            tasks.push_back(run_on(receiverPool, receivers[s]->receive(socks[s][1], *receiverSets[s], intersecs[s])));
+        }
+
+        auto results = sync_wait(when_all_ready(std::move(tasks)));
+        for (auto& result : results) result.result();
+    }
+
+    for (size_t s = 0; s < SESSIONS; s++) {
+        std::vector<point> expected_intersec;
+
+        expected_intersect<Metric::L1>(*receiverSets[s], *senderSet, D, DELTA, expected_intersec);
+        REQUIRE(expected_intersec.size() == SESSION_MATCHES[s]);
+
+        REQUIRE(is_intersec_correct(intersecs[s], expected_intersec));
+    }
+
+    const sparse_comp::fuzzy_server::ServerStats stats = server.stats();
+
+    REQUIRE(stats.sessions == SESSIONS);
+    REQUIRE(stats.failures == 0);
+    REQUIRE(stats.latencies_ms.size() == SESSIONS);
+}
@@ -0,0 +1,281 @@
+#include "catch2/catch_test_macros.hpp"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "coproto/Socket/Socket.h"
+#include "coproto/Socket/LocalAsyncSock.h"
+#include "./support/GroundTruth.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "../sparseComp/Common/Common.h"
+#include "../sparseComp/FuzzyL1/FuzzyL1.h"
+#include "../sparseComp/FuzzyBatch/FuzzyBatch.h"
+#include "../sparseComp/FuzzyShard/FuzzyShard.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+using sparse_comp::point;
+
+using coproto::LocalAsyncSocket;
+
+using PRNG = osuCrypto::PRNG;
+using osuCrypto::block;
+using AES = osuCrypto::AES;
+
+using sparse_comp::bench::Metric;
+using sparse_comp::bench::expected_intersect;
+using sparse_comp::bench::is_intersec_correct;
+using sparse_comp::fuzzy_shard::ShardPlan;
+using sparse_comp::fuzzy_shard::WorkerReport;
+
+using macoro::sync_wait;
+using macoro::when_all_ready;
+
+namespace {
+
+    constexpr size_t N = 64;
+    constexpr size_t BATCH = 16;
+    constexpr size_t D = 2;
+    constexpr uint8_t DELTA = 10;
+    constexpr uint8_t SSP = 40;
+    constexpr size_t SHARDS = 2;
+    constexpr size_t MEMORY_BUDGET = size_t(1) << 30;
+
+    constexpr size_t MATCHES = 8;
+    constexpr size_t BOUNDARY_MATCHES = 2;
+
+    constexpr uint64_t COORD_RANGE = (uint64_t) 1 << 32;
+
+    uint32_t random_coordinate(PRNG& prng) {
+        return (uint32_t) (2 * DELTA + prng.get<uint64_t>() % (COORD_RANGE - 4 * DELTA));
+    }
+
+    void gen_random_points(PRNG& prng, std::vector<point>& points) {
+        uint32_t c[D];
+
+        points.resize(N);
+
+        for (size_t i = 0; i < N; i++) {
+            c[0] = random_coordinate(prng);
+            c[1] = random_coordinate(prng);
+            points[i] = point(D, c);
+        }
+    }
+
+    // Random sets where the first MATCHES sender points lie within delta of distinct receiver points, and
+    // BOUNDARY_MATCHES more match across the bound of the two shards that balanced_plan picks for the receiver
+    // points, with the receiver point in the lower shard and the sender point in the upper one.
+    void gen_shard_inputs(block seed, std::vector<point>& receiverPoints, std::vector<point>& senderPoints) {
+        PRNG prng(seed);
+
+        gen_random_points(prng, receiverPoints);
+        gen_random_points(prng, senderPoints);
+
+        for (size_t i = 0; i < MATCHES; i++) {
+            senderPoints[i] = receiverPoints[i * (N / MATCHES)];
+            senderPoints[i][0] += DELTA / 2;
+        }
+
+        const uint64_t bound = sparse_comp::fuzzy_shard::balanced_plan(receiverPoints, SHARDS, DELTA).bounds[1];
+
+        // Moving receiver points of the lower shard closer to the bound leaves the quantile, hence the plan, as is
+        for (size_t b = 0, r = 0; b < BOUNDARY_MATCHES; r++) {
+            if (r % (N / MATCHES) == 0 || receiverPoints[r][0] + DELTA >= bound) continue;
+
+            receiverPoints[r][0] = (uint32_t) (bound - 1 - b);
+            senderPoints[MATCHES + b] = receiverPoints[r];
+            senderPoints[MATCHES + b][0] = (uint32_t) (bound - 1 - b + DELTA / 2);
+
+            b++;
+        }
+    }
+
+}
+
+TEST_CASE("Fuzzy shard : shard_of skips empty shards","[fuzzyshard]")
+{
+    ShardPlan plan;
+    plan.bounds = {0, 100, 100, 200, COORD_RANGE};
+
+    REQUIRE(plan.shards() == 4);
+    REQUIRE(plan.shard_of(0) == 0);
+    REQUIRE(plan.shard_of(99) == 0);
+    REQUIRE(plan.shard_of(100) == 2);
+    REQUIRE(plan.shard_of(199) == 2);
+    REQUIRE(plan.shard_of(200) == 3);
+    REQUIRE(plan.shard_of(COORD_RANGE - 1) == 3);
+}
+
+TEST_CASE("Fuzzy shard : balanced_plan cuts at cell edges into shards of about as many points","[fuzzyshard]")
+{
+    constexpr size_t PLAN_SHARDS = 4;
+
+    PRNG prng(block(9536629126107612350ULL, 2721317164341290561ULL));
+    std::vector<point> points;
+    gen_random_points(prng, points);
+
+    const ShardPlan plan = sparse_comp::fuzzy_shard::balanced_plan(points, PLAN_SHARDS, DELTA);
+
+    REQUIRE(plan.shards() == PLAN_SHARDS);
+    REQUIRE(plan.bounds.front() == 0);
+    REQUIRE(plan.bounds.back() == COORD_RANGE);
+    REQUIRE(std::is_sorted(plan.bounds.begin(), plan.bounds.end()));
+
+    for (size_t k = 1; k < PLAN_SHARDS; k++) REQUIRE(plan.bounds[k] % (2 * DELTA) == 0);
+
+    std::vector<std::vector<point>> shards;
+    sparse_comp::fuzzy_shard::split(plan, points, 0, shards);
+
+    for (const auto& shard : shards) REQUIRE(shard.size() == N / PLAN_SHARDS);
+
+    // Without points, the shards are of equal width
+    const ShardPlan empty = sparse_comp::fuzzy_shard::balanced_plan(std::span<const point>(), PLAN_SHARDS, DELTA);
+    for (size_t k = 0; k <= PLAN_SHARDS; k++) REQUIRE(empty.bounds[k] == COORD_RANGE * k / PLAN_SHARDS);
+
+    REQUIRE_THROWS_AS(sparse_comp::fuzzy_shard::balanced_plan(points, 0, DELTA), std::invalid_argument);
+}
+
+TEST_CASE("Fuzzy shard : split replicates points into the shards within the radius","[fuzzyshard]")
+{
+    constexpr uint64_t BOUND = 1000;
+
+    ShardPlan plan;
+    plan.bounds = {0, BOUND, COORD_RANGE};
+
+    const std::vector<point> points = {
+        point(0, 7),                                         // Lowest coordinate
+        point((uint32_t) (BOUND - DELTA - 1), 7),            // Radius ends right below the bound
+        point((uint32_t) (BOUND - DELTA), 7),                // Radius reaches the bound
+        point((uint32_t) (BOUND - 1), 7),
+        point((uint32_t) BOUND, 7),
+        point((uint32_t) (BOUND + DELTA - 1), 7),
+        point((uint32_t) (BOUND + DELTA), 7),                // Radius starts at the bound
+        point((uint32_t) (COORD_RANGE - 1), 7),              // Highest coordinate
+    };
+
+    const std::vector<size_t> lower = {0, 1, 2, 3, 4, 5};
+    const std::vector<size_t> upper = {2, 3, 4, 5, 6, 7};
+
+    auto indices = [&](const std::vector<point>& shard) {
+        std::vector<size_t> found;
+
+        for (const point& p : shard) {
+            for (size_t i = 0; i < points.size(); i++) {
+                if (points[i][0] == p[0]) found.push_back(i);
+            }
+        }
+
+        return found;
+    };
+
+    std::vector<std::vector<point>> shards;
+
+    sparse_comp::fuzzy_shard::split(plan, points, DELTA, shards);
+    REQUIRE(shards.size() == 2);
+    REQUIRE(indices(shards[0]) == lower);
+    REQUIRE(indices(shards[1]) == upper);
+
+    // Without radius, as sender points are, every point is in a single shard
+    sparse_comp::fuzzy_shard::split(plan, points, 0, shards);
+    REQUIRE(indices(shards[0]) == std::vector<size_t>({0, 1, 2, 3}));
+    REQUIRE(indices(shards[1]) == std::vector<size_t>({4, 5, 6, 7}));
+
+    // Empty shards get no points
+    plan.bounds = {0, BOUND, BOUND, COORD_RANGE};
+    sparse_comp::fuzzy_shard::split(plan, points, DELTA, shards);
+    REQUIRE(shards[1].empty());
+    REQUIRE(indices(shards[0]) == lower);
+    REQUIRE(indices(shards[2]) == upper);
+}
+
+TEST_CASE("Fuzzy shard : the shards find the unsharded intersection (n=m=64, batch=16, d=2, delta=10, ssp=40, 2 shards)","[fuzzyshard]")
+{
+    AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+    std::vector<point> receiverPoints;
+    std::vector<point> senderPoints;
+
+    gen_shard_inputs(block(5736302581720391125ULL, 10247762139804557141ULL), receiverPoints, senderPoints);
+
+    const ShardPlan plan = sparse_comp::fuzzy_shard::balanced_plan(receiverPoints, SHARDS, DELTA);
+    for (size_t b = 0; b < BOUNDARY_MATCHES; b++) REQUIRE(plan.shard_of(senderPoints[MATCHES + b][0]) == 1);
+
+    std::vector<point> unsharded_intersec;
+    {
+        auto socks = LocalAsyncSocket::makePair();
+        PRNG senderPRNG = PRNG(block(742130310438916676ULL, 11803924226990735076ULL));
+        PRNG receiverPRNG = PRNG(block(2457938039974938056ULL, 17910068785450354990ULL));
+
+        sparse_comp::fuzzy_batch::Sender<sparse_comp::fuzzy_l1::Sender, BATCH, BATCH, D, DELTA, SSP> batchSender(senderPRNG, aes, MEMORY_BUDGET);
+        sparse_comp::fuzzy_batch::Receiver<sparse_comp::fuzzy_l1::Receiver, BATCH, BATCH, D, DELTA, SSP> batchRecvr(receiverPRNG, aes, MEMORY_BUDGET);
+
+        auto r = sync_wait(when_all_ready(batchSender.send(socks[0], std::span<const point>(senderPoints)),
+                                          batchRecvr.receive(socks[1], std::span<const point>(receiverPoints), unsharded_intersec)));
+        std::get<0>(r).result();
+        std::get<1>(r).result();
+    }
+
+    std::vector<point> sharded_intersec;
+    std::vector<WorkerReport> receiver_reports;
+    std::vector<WorkerReport> sender_reports;
+    {
+        auto peers = LocalAsyncSocket::makePair();
+        auto receiverLinks = std::vector<std::array<LocalAsyncSocket, 2>>();
+        auto senderLinks = std::vector<std::array<LocalAsyncSocket, 2>>();
+        auto workerLinks = std::vector<std::array<LocalAsyncSocket, 2>>();
+        std::vector<coproto::Socket> receiverWorkers;
+        std::vector<coproto::Socket> senderWorkers;
+
+        for (size_t k = 0; k < SHARDS; k++) {
+            receiverLinks.push_back(LocalAsyncSocket::makePair());
+            senderLinks.push_back(LocalAsyncSocket::makePair());
+            workerLinks.push_back(LocalAsyncSocket::makePair());
+
+            receiverWorkers.push_back(receiverLinks[k][0]);
+            senderWorkers.push_back(senderLinks[k][0]);
+        }
+
+        PRNG senderPRNG0 = PRNG(block(15914074867899273501ULL, 0));
+        PRNG senderPRNG1 = PRNG(block(15914074867899273501ULL, 1));
+        PRNG receiverPRNG0 = PRNG(block(6427781726132732903ULL, 0));
+        PRNG receiverPRNG1 = PRNG(block(6427781726132732903ULL, 1));
+
+        auto r = sync_wait(when_all_ready(
+            sparse_comp::fuzzy_shard::sender_coordinator(peers[0], senderWorkers, senderPoints, sender_reports),
+            sparse_comp::fuzzy_shard::receiver_coordinator(peers[1], receiverWorkers, receiverPoints, DELTA, sharded_intersec, receiver_reports),
+            sparse_comp::fuzzy_shard::sender_worker<sparse_comp::fuzzy_l1::Sender, BATCH, BATCH, D, DELTA, SSP>(senderLinks[0][1], workerLinks[0][0], senderPRNG0, aes, MEMORY_BUDGET),
+            sparse_comp::fuzzy_shard::sender_worker<sparse_comp::fuzzy_l1::Sender, BATCH, BATCH, D, DELTA, SSP>(senderLinks[1][1], workerLinks[1][0], senderPRNG1, aes, MEMORY_BUDGET),
+            sparse_comp::fuzzy_shard::receiver_worker<sparse_comp::fuzzy_l1::Receiver, BATCH, BATCH, D, DELTA, SSP>(receiverLinks[0][1], workerLinks[0][1], receiverPRNG0, aes, MEMORY_BUDGET),
+            sparse_comp::fuzzy_shard::receiver_worker<sparse_comp::fuzzy_l1::Receiver, BATCH, BATCH, D, DELTA, SSP>(receiverLinks[1][1], workerLinks[1][1], receiverPRNG1, aes, MEMORY_BUDGET)));
+        std::get<0>(r).result();
+        std::get<1>(r).result();
+        std::get<2>(r).result();
+        std::get<3>(r).result();
+        std::get<4>(r).result();
+        std::get<5>(r).result();
+    }
+
+    std::vector<point> expected_intersec;
+
+    expected_intersect<Metric::L1>(receiverPoints, senderPoints, D, DELTA, expected_intersec);
+    REQUIRE(expected_intersec.size() == MATCHES + BOUNDARY_MATCHES);
+
+    REQUIRE(is_intersec_correct(unsharded_intersec, expected_intersec));
+    REQUIRE(is_intersec_correct(sharded_intersec, unsharded_intersec));
+
+    // The receiver points near the bound were shipped to both shards, the sender points to a single one
+    uint64_t receiver_points = 0, sender_points = 0, matches = 0;
+
+    for (size_t k = 0; k < SHARDS; k++) {
+        receiver_points += receiver_reports[k].points;
+        sender_points += sender_reports[k].points;
+        matches += receiver_reports[k].matches;
+    }
+
+    REQUIRE(receiver_points >= N + BOUNDARY_MATCHES);
+    REQUIRE(sender_points == N);
+    REQUIRE(matches == sharded_intersec.size());
+}
@@ -0,0 +1,141 @@
+#include "catch2/catch_test_macros.hpp"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "coproto/Socket/LocalAsyncSock.h"
+#include "../sparseComp/MultiOPRF/OtPool.h"
+#include "./support/TempPath.h"
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+using coproto::LocalAsyncSocket;
+
+using PRNG = osuCrypto::PRNG;
+using osuCrypto::block;
+
+using sparse_comp::multi_oprf::OtPool;
+using sparse_comp::multi_oprf::RUN_POOL_OTS;
+using sparse_comp::bench::TempPath;
+
+using macoro::sync_wait;
+using macoro::when_all_ready;
+
+// Creates the two halves of a pool of ot_count OTs per direction at leader_path and follower_path
+static void create_pool_pair(block seed, size_t ot_count, const std::string& leader_path, const std::string& follower_path) {
+    auto socks = LocalAsyncSocket::makePair();
+    PRNG leaderPRNG = PRNG(seed);
+    PRNG followerPRNG = PRNG(seed ^ block(1, 1));
+
+    auto r = sync_wait(when_all_ready(OtPool::create(socks[0], leaderPRNG, true, ot_count, leader_path),
+                                      OtPool::create(socks[1], followerPRNG, false, ot_count, follower_path)));
+    std::get<0>(r).result();
+    std::get<1>(r).result();
+}
+
+static bool choice_bit(const block* choice_blocks, size_t i) {
+    return (choice_blocks[i / 128].get<uint8_t>((i % 128) / 8) >> (i % 8)) & 1;
+}
+
+TEST_CASE("OT pool : a pool sized for n runs serves exactly n of them","[otpool]")
+{
+    constexpr size_t RUNS = 3;
+
+    TempPath leaderPath("leader.otpool");
+    TempPath followerPath("follower.otpool");
+
+    create_pool_pair(block(742130310438916676ULL, 11803924226990735076ULL), RUNS * RUN_POOL_OTS, leaderPath.str(), followerPath.str());
+
+    std::unique_ptr<OtPool> leader(OtPool::open(leaderPath.str()));
+    std::unique_ptr<OtPool> follower(OtPool::open(followerPath.str()));
+
+    REQUIRE(leader->leader());
+    REQUIRE(!follower->leader());
+    REQUIRE(leader->size() == RUNS * RUN_POOL_OTS);
+    REQUIRE(leader->available() == RUNS * RUN_POOL_OTS);
+
+    auto socks = LocalAsyncSocket::makePair();
+
+    for (size_t run = 0; run < RUNS; run++) {
+        size_t leader_recv = 0, leader_send = 0, follower_recv = 0, follower_send = 0;
+
+        auto r = sync_wait(when_all_ready(leader->reserve(socks[0], RUN_POOL_OTS, leader_recv, leader_send),
+                                          follower->reserve(socks[1], RUN_POOL_OTS, follower_recv, follower_send)));
+        std::get<0>(r).result();
+        std::get<1>(r).result();
+
+        REQUIRE(leader_recv == run * RUN_POOL_OTS);
+        REQUIRE(leader_send == run * RUN_POOL_OTS);
+        REQUIRE(follower_recv == leader_send);
+        REQUIRE(follower_send == leader_recv);
+        REQUIRE(leader->available() == (RUNS - run - 1) * RUN_POOL_OTS);
+        REQUIRE(follower->available() == leader->available());
+
+        // The slices are correlated: each receiver holds the message of its choice among the sender's pair
+        for (size_t i = 0; i < RUN_POOL_OTS; i++) {
+            const size_t l = leader_recv + i;
+            const size_t f = follower_recv + i;
+
+            REQUIRE(leader->recvOtMsgs()[l] == follower->sendOtMsgs()[l][choice_bit(leader->recvOtChoiceBlocks(), l)]);
+            REQUIRE(follower->recvOtMsgs()[f] == leader->sendOtMsgs()[f][choice_bit(follower->recvOtChoiceBlocks(), f)]);
+        }
+    }
+
+    size_t leader_recv = 0, leader_send = 0, follower_recv = 0, follower_send = 0;
+
+    auto r = sync_wait(when_all_ready(leader->reserve(socks[0], RUN_POOL_OTS, leader_recv, leader_send),
+                                      follower->reserve(socks[1], RUN_POOL_OTS, follower_recv, follower_send)));
+    REQUIRE_THROWS_AS(std::get<0>(r).result(), std::runtime_error);
+    REQUIRE_THROWS_AS(std::get<1>(r).result(), std::runtime_error);
+
+    // The cursors were persisted, so the pool is still exhausted once mapped again
+    leader.reset(OtPool::open(leaderPath.str()));
+    REQUIRE(leader->available() == 0);
+}
+
+TEST_CASE("OT pool : mismatching pools are rejected","[otpool]")
+{
+    TempPath leaderPath("leader.otpool");
+    TempPath followerPath("follower.otpool");
+    TempPath otherLeaderPath("other_leader.otpool");
+    TempPath otherFollowerPath("other_follower.otpool");
+    TempPath largerLeaderPath("larger_leader.otpool");
+    TempPath largerFollowerPath("larger_follower.otpool");
+
+    create_pool_pair(block(2457938039974938056ULL, 17910068785450354990ULL), RUN_POOL_OTS, leaderPath.str(), followerPath.str());
+    create_pool_pair(block(15914074867899273501ULL, 6004108516319388444ULL), RUN_POOL_OTS, otherLeaderPath.str(), otherFollowerPath.str());
+    create_pool_pair(block(6427781726132732903ULL, 8471345356057289138ULL), 2 * RUN_POOL_OTS, largerLeaderPath.str(), largerFollowerPath.str());
+
+    // Each pair of halves that do not belong together, the last one being both halves of the same side
+    const std::pair<const TempPath*, const TempPath*> mismatches[] = {
+        {&leaderPath, &otherFollowerPath},
+        {&leaderPath, &largerFollowerPath},
+        {&leaderPath, &leaderPath},
+    };
+
+    for (const auto& [first, second] : mismatches) {
+        std::unique_ptr<OtPool> a(OtPool::open(first->str()));
+        std::unique_ptr<OtPool> b(OtPool::open(second->str()));
+
+        auto socks = LocalAsyncSocket::makePair();
+        size_t a_recv = 0, a_send = 0, b_recv = 0, b_send = 0;
+
+        auto r = sync_wait(when_all_ready(a->reserve(socks[0], RUN_POOL_OTS, a_recv, a_send),
+                                          b->reserve(socks[1], RUN_POOL_OTS, b_recv, b_send)));
+        REQUIRE_THROWS_AS(std::get<0>(r).result(), std::runtime_error);
+        REQUIRE_THROWS_AS(std::get<1>(r).result(), std::runtime_error);
+
+        // Nothing was taken from the pools
+        REQUIRE(a->available() == a->size());
+        REQUIRE(b->available() == b->size());
+    }
+
+    // Slices that are not a multiple of 128 OTs are refused before talking to the peer
+    std::unique_ptr<OtPool> leader(OtPool::open(leaderPath.str()));
+    auto socks = LocalAsyncSocket::makePair();
+    size_t recv_offset = 0, send_offset = 0;
+
+    auto r = sync_wait(when_all_ready(leader->reserve(socks[0], 100, recv_offset, send_offset)));
+    REQUIRE_THROWS_AS(std::get<0>(r).result(), std::runtime_error);
+}
@@ -0,0 +1,196 @@
+#include "catch2/catch_test_macros.hpp"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "../sparseComp/Common/Common.h"
+#include "../sparseComp/Common/PointFile.h"
+#include "./support/TempPath.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using sparse_comp::point;
+using sparse_comp::PointFile;
+using sparse_comp::ResultWriter;
+using sparse_comp::ResultFile;
+
+using PRNG = osuCrypto::PRNG;
+using osuCrypto::block;
+
+using sparse_comp::bench::TempPath;
+
+namespace {
+
+    constexpr size_t D = 3;
+
+    std::vector<point> random_points(PRNG& prng, size_t n) {
+        std::vector<point> points(n);
+        uint32_t c[point::MAX_DIM] = {};
+
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < D; j++) c[j] = prng.get<uint32_t>();
+            points[i] = point(D, c);
+        }
+
+        return points;
+    }
+
+    bool same_point(const point& a, const point& b) {
+        if (a.coord_dim != b.coord_dim) return false;
+
+        for (size_t j = 0; j < a.coord_dim; j++) {
+            if (a[j] != b[j]) return false;
+        }
+
+        return true;
+    }
+
+    // Overwrites the bytes of the file at path from offset with those of value
+    template<typename T>
+    void patch_file(const std::string& path, size_t offset, const T& value) {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp((std::streamoff) offset);
+        file.write((const char*) &value, sizeof(T));
+    }
+
+    // Offsets of the fields of the header of both kinds of files
+    constexpr size_t MAGIC_OFFSET = 0;
+    constexpr size_t VERSION_OFFSET = 8;
+
+}
+
+TEST_CASE("Point file : points written are mapped back column by column","[pointfile]")
+{
+    constexpr size_t N = 1000;
+
+    PRNG prng(block(742130310438916676ULL, 11803924226990735076ULL));
+    const std::vector<point> points = random_points(prng, N);
+
+    TempPath path("points.spc");
+    sparse_comp::write_point_file(path.str(), points, D);
+
+    PointFile file(path.str());
+
+    REQUIRE(file.size() == N);
+    REQUIRE(file.dimension() == D);
+    REQUIRE(std::filesystem::file_size(path.str()) == 32 + N * D * sizeof(uint32_t));
+
+    for (size_t i = 0; i < N; i++) {
+        REQUIRE(same_point(file.points()[i], points[i]));
+
+        for (size_t j = 0; j < D; j++) REQUIRE(file.points().column(j)[i] == points[i][j]);
+    }
+
+    // An empty set is a valid point file
+    TempPath emptyPath("empty.spc");
+    sparse_comp::write_point_file(emptyPath.str(), std::span<const point>(), D);
+    REQUIRE(PointFile(emptyPath.str()).size() == 0);
+
+    REQUIRE_THROWS_AS(sparse_comp::write_point_file(path.str(), points, 0), std::invalid_argument);
+    REQUIRE_THROWS_AS(sparse_comp::write_point_file(path.str(), points, point::MAX_DIM + 1), std::invalid_argument);
+}
+
+TEST_CASE("Point file : records written are read back","[pointfile]")
+{
+    // More records than the writer buffers, so that some are flushed before close
+    constexpr size_t RECORDS = size_t(1) << 17;
+
+    PRNG prng(block(2457938039974938056ULL, 17910068785450354990ULL));
+    const std::vector<point> points = random_points(prng, RECORDS);
+
+    TempPath path("results.spc");
+
+    {
+        ResultWriter writer(path.str(), D);
+
+        for (size_t i = 0; i < RECORDS; i++) writer.write(3 * (uint64_t) i + 1, points[i]);
+
+        REQUIRE(writer.records() == RECORDS);
+
+        writer.close();
+
+        REQUIRE_THROWS_AS(writer.write(0, points[0]), std::runtime_error);
+        REQUIRE_THROWS_AS(writer.close(), std::runtime_error);
+    }
+
+    REQUIRE(!std::filesystem::exists(path.str() + ".tmp"));
+
+    ResultFile file(path.str());
+
+    REQUIRE(file.size() == RECORDS);
+    REQUIRE(file.dimension() == D);
+
+    for (size_t i = 0; i < RECORDS; i++) {
+        REQUIRE(file.index(i) == 3 * (uint64_t) i + 1);
+        REQUIRE(same_point(file[i], points[i]));
+    }
+
+    // A writer destroyed before close leaves nothing behind
+    TempPath abandonedPath("abandoned.spc");
+
+    {
+        ResultWriter writer(abandonedPath.str(), D);
+        writer.write(0, points[0]);
+    }
+
+    REQUIRE(!std::filesystem::exists(abandonedPath.str()));
+    REQUIRE(!std::filesystem::exists(abandonedPath.str() + ".tmp"));
+
+    REQUIRE_THROWS_AS(ResultWriter(abandonedPath.str(), 0), std::invalid_argument);
+}
+
+TEST_CASE("Point file : truncated files and bad headers are rejected","[pointfile]")
+{
+    constexpr size_t N = 100;
+
+    PRNG prng(block(15914074867899273501ULL, 6004108516319388444ULL));
+    const std::vector<point> points = random_points(prng, N);
+
+    TempPath pointPath("points.spc");
+    TempPath resultPath("results.spc");
+
+    auto write_files = [&]() {
+        sparse_comp::write_point_file(pointPath.str(), points, D);
+
+        ResultWriter writer(resultPath.str(), D);
+        for (size_t i = 0; i < N; i++) writer.write(i, points[i]);
+        writer.close();
+    };
+
+    write_files();
+
+    // Each kind of file only opens as its own kind
+    REQUIRE_THROWS_AS(PointFile(resultPath.str()), std::runtime_error);
+    REQUIRE_THROWS_AS(ResultFile(pointPath.str()), std::runtime_error);
+
+    // Missing a few bytes of the last point or record
+    std::filesystem::resize_file(pointPath.str(), std::filesystem::file_size(pointPath.str()) - 4);
+    std::filesystem::resize_file(resultPath.str(), std::filesystem::file_size(resultPath.str()) - 1);
+    REQUIRE_THROWS_AS(PointFile(pointPath.str()), std::runtime_error);
+    REQUIRE_THROWS_AS(ResultFile(resultPath.str()), std::runtime_error);
+
+    // Shorter than the header
+    std::filesystem::resize_file(pointPath.str(), 16);
+    std::filesystem::resize_file(resultPath.str(), 16);
+    REQUIRE_THROWS_AS(PointFile(pointPath.str()), std::runtime_error);
+    REQUIRE_THROWS_AS(ResultFile(resultPath.str()), std::runtime_error);
+
+    write_files();
+
+    patch_file(pointPath.str(), MAGIC_OFFSET, 'X');
+    patch_file(resultPath.str(), MAGIC_OFFSET, 'X');
+    REQUIRE_THROWS_AS(PointFile(pointPath.str()), std::runtime_error);
+    REQUIRE_THROWS_AS(ResultFile(resultPath.str()), std::runtime_error);
+
+    write_files();
+
+    patch_file(pointPath.str(), VERSION_OFFSET, PointFile::VERSION + 1);
+    patch_file(resultPath.str(), VERSION_OFFSET, ResultWriter::VERSION + 1);
+    REQUIRE_THROWS_AS(PointFile(pointPath.str()), std::runtime_error);
+    REQUIRE_THROWS_AS(ResultFile(resultPath.str()), std::runtime_error);
+
+    REQUIRE_THROWS_AS(PointFile(pointPath.str() + ".missing"), std::runtime_error);
+}
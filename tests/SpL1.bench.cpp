@@ -3,6 +3,7 @@
 #include "cryptoTools/Crypto/PRNG.h"
 #include "cryptoTools/Common/block.h"
 #include "coproto/Socket/LocalAsyncSock.h"
+#include "./support/TwoPartyBench.h"
 #include "cryptoTools/Crypto/AES.h"
 #include "../sparseComp/Common/Common.h"
 #include "../sparseComp/Common/HashUtils.h"
@@ -382,10 +383,9 @@ TEST_CASE("spl1 (t_s=256 t_r=1024 d=2 delta=10 ssp=40)","[spl1][n=m=2^8]") {
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -407,9 +407,10 @@ TEST_CASE("spl1 (t_s=256 t_r=1024 d=2 delta=10 ssp=40)","[spl1][n=m=2^8]") {
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 }
 
@@ -459,10 +460,9 @@ TEST_CASE("spl1 (t_s=256 t_r=16384 d=6 delta=10 ssp=40)","[spl1][n=m=2^8]") {
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -486,9 +486,10 @@ TEST_CASE("spl1 (t_s=256 t_r=16384 d=6 delta=10 ssp=40)","[spl1][n=m=2^8]") {
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 }
 
@@ -537,10 +538,9 @@ TEST_CASE("spl1 (t_s=256 t_r=262144 d=10 delta=10 ssp=40)","[spl1][n=m=2^8]") {
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -564,9 +564,10 @@ TEST_CASE("spl1 (t_s=256 t_r=262144 d=10 delta=10 ssp=40)","[spl1][n=m=2^8]") {
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 }
 
@@ -615,10 +616,9 @@ TEST_CASE("spl1 (t_s=256 t_r=1024 d=2 delta=30 ssp=40)","[spl1][n=m=2^8]") {
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -642,9 +642,10 @@ TEST_CASE("spl1 (t_s=256 t_r=1024 d=2 delta=30 ssp=40)","[spl1][n=m=2^8]") {
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 }
 
@@ -694,10 +695,9 @@ TEST_CASE("spl1 (t_s=256 t_r=16384 d=6 delta=30 ssp=40)","[spl1][n=m=2^8]") {
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -721,9 +721,10 @@ TEST_CASE("spl1 (t_s=256 t_r=16384 d=6 delta=30 ssp=40)","[spl1][n=m=2^8]") {
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 
 }
@@ -773,10 +774,9 @@ TEST_CASE("spl1 (t_s=256 t_r=262144 d=10 delta=30 ssp=40)","[spl1][n=m=2^8]") {
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -800,9 +800,10 @@ TEST_CASE("spl1 (t_s=256 t_r=262144 d=10 delta=30 ssp=40)","[spl1][n=m=2^8]") {
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 
 }
@@ -856,10 +857,9 @@ TEST_CASE("spl1 (t_s=4096 t_r=16384 d=2 delta=10 ssp=40)","[spl1][n=m=2^12]") {
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -883,9 +883,10 @@ TEST_CASE("spl1 (t_s=4096 t_r=16384 d=2 delta=10 ssp=40)","[spl1][n=m=2^12]") {
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 }
 
@@ -935,10 +936,9 @@ TEST_CASE("spl1 (t_s=4096 t_r=262144 d=6 delta=10 ssp=40)","[spl1][n=m=2^12]") {
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -962,9 +962,10 @@ TEST_CASE("spl1 (t_s=4096 t_r=262144 d=6 delta=10 ssp=40)","[spl1][n=m=2^12]") {
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 }
 
@@ -1013,10 +1014,9 @@ TEST_CASE("spl1 (t_s=4096 t_r=4194304 d=10 delta=10 ssp=40)","[spl1][n=m=2^12]")
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1040,9 +1040,10 @@ TEST_CASE("spl1 (t_s=4096 t_r=4194304 d=10 delta=10 ssp=40)","[spl1][n=m=2^12]")
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 }
 
@@ -1091,10 +1092,9 @@ TEST_CASE("spl1 (t_s=4096 t_r=16384 d=2 delta=30 ssp=40)","[spl1][n=m=2^12]") {
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1118,9 +1118,10 @@ TEST_CASE("spl1 (t_s=4096 t_r=16384 d=2 delta=30 ssp=40)","[spl1][n=m=2^12]") {
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 }
 
@@ -1170,10 +1171,9 @@ TEST_CASE("spl1 (t_s=4096 t_r=262144 d=6 delta=30 ssp=40)","[spl1][n=m=2^12]") {
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1197,9 +1197,10 @@ TEST_CASE("spl1 (t_s=4096 t_r=262144 d=6 delta=30 ssp=40)","[spl1][n=m=2^12]") {
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 
 }
@@ -1249,10 +1250,9 @@ TEST_CASE("spl1 (t_s=4096 t_r=4194304 d=10 delta=30 ssp=40)","[spl1][n=m=2^12]")
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1276,9 +1276,10 @@ TEST_CASE("spl1 (t_s=4096 t_r=4194304 d=10 delta=30 ssp=40)","[spl1][n=m=2^12]")
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 
 }
@@ -1332,10 +1333,9 @@ TEST_CASE("spl1 (t_s=65536 t_r=262144 d=2 delta=10 ssp=40)","[spl1][n=m=2^16]")
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1359,9 +1359,10 @@ TEST_CASE("spl1 (t_s=65536 t_r=262144 d=2 delta=10 ssp=40)","[spl1][n=m=2^16]")
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 }
 
@@ -1411,10 +1412,9 @@ TEST_CASE("spl1 (t_s=65536 t_r=4194304 d=6 delta=10 ssp=40)","[spl1][n=m=2^16]")
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1438,9 +1438,10 @@ TEST_CASE("spl1 (t_s=65536 t_r=4194304 d=6 delta=10 ssp=40)","[spl1][n=m=2^16]")
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 }
 
@@ -1489,10 +1490,9 @@ TEST_CASE("spl1 (t_s=65536 t_r=67108864 d=10 delta=10 ssp=40)","[spl1][n=m=2^16]
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1516,9 +1516,10 @@ TEST_CASE("spl1 (t_s=65536 t_r=67108864 d=10 delta=10 ssp=40)","[spl1][n=m=2^16]
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 }
 
@@ -1567,10 +1568,9 @@ TEST_CASE("spl1 (t_s=65536 t_r=262144 d=2 delta=30 ssp=40)","[spl1][n=m=2^16]")
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1592,9 +1592,10 @@ TEST_CASE("spl1 (t_s=65536 t_r=262144 d=2 delta=30 ssp=40)","[spl1][n=m=2^16]")
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 }
 
@@ -1644,10 +1645,9 @@ TEST_CASE("spl1 (t_s=65536 t_r=4194304 d=6 delta=30 ssp=40)","[spl1][n=m=2^16]")
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1671,9 +1671,10 @@ TEST_CASE("spl1 (t_s=65536 t_r=4194304 d=6 delta=30 ssp=40)","[spl1][n=m=2^16]")
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 
 }
@@ -1723,10 +1724,9 @@ TEST_CASE("spl1 (t_s=65536 t_r=67108864 d=10 delta=30 ssp=40)","[spl1][n=m=2^16]
         sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
         sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL1Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL1Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL1Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL1Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1750,12 +1750,125 @@ TEST_CASE("spl1 (t_s=65536 t_r=67108864 d=10 delta=30 ssp=40)","[spl1][n=m=2^16]
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
     };
 
 }
 
 
-// END OF TESTS FOR N=M=2^16
\ No newline at end of file
+// END OF TESTS FOR N=M=2^16
+
+// START OF OFFLINE/ONLINE SPLIT TESTS
+
+TEST_CASE("spl1 offline/online (t_s=256 t_r=1024 d=2 delta=10 ssp=40)","[spl1][n=m=2^8][offline-online]") {
+    constexpr size_t TS = 256;
+    constexpr size_t TR = 1024;
+    constexpr size_t D = 2;
+    constexpr size_t DELTA = 10;
+    constexpr size_t ssp = 40;
+
+    BENCHMARK_ADVANCED("offline t_s=256 t_r=1024 d=2 delta=10 ssp=40")(Catch::Benchmark::Chronometer meter) {
+        auto socks = LocalAsyncSocket::makePair();
+        PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+        PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+        AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+        sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> sender(senderPRNG, aes);
+        sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> recvr(receiverPRNG, aes);
+
+        auto* sender_offline = new sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp>::Offline();
+        auto* recvr_offline = new sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp>::Offline();
+
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return sender.preprocess(sock, *sender_offline); },
+            [&](coproto::Socket& sock) { return recvr.preprocess(sock, *recvr_offline); });
+
+        delete sender_offline;
+        delete recvr_offline;
+
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
+
+        SUCCEED("Number of MBs exchanged (offline): " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
+    };
+
+    BENCHMARK_ADVANCED("online t_s=256 t_r=1024 d=2 delta=10 ssp=40")(Catch::Benchmark::Chronometer meter) {
+        size_t min_num_matching_bins = 53;
+        size_t min_num_matching_pts = 17;
+
+        auto socks = LocalAsyncSocket::makePair();
+        block seed = block(9536629026107651350ULL,2724119864341290560ULL);
+        PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+        PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+        AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+        std::array<point, TS> *senderSparsePoints = new std::array<point, TS>();
+        std::array<point, TR> *receiverSparsePoints = new std::array<point, TR>();
+        array<array<uint32_t, D>, TS> *sender_in_values = new array<array<uint32_t, D>, TS>();
+        array<array<uint32_t, D>, TR> *receiver_in_values = new array<array<uint32_t, D>, TR>();
+        array<array<block, 1>, TS>* snder_out_shares = new array<array<block, 1>, TS>();
+        array<array<block, 1>, TR>* rcvr_out_shares = new array<array<block, 1>, TR>();
+        vector<block> senderSparsePointsVec(TS);
+        vector<block> receiverSparsePointsVec(TR);
+        set<size_t> intersec;
+
+        gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed, 
+                                                  min_num_matching_bins,
+                                                  min_num_matching_pts,
+                                                  *receiverSparsePoints,
+                                                  *receiver_in_values, 
+                                                  *senderSparsePoints, 
+                                                  *sender_in_values);
+
+        for (size_t i = 0; i < TS; i++) {
+            senderSparsePointsVec[i] = sparse_comp::hash_point(aes, (*senderSparsePoints)[i]);
+        }
+        for (size_t i = 0; i < TR; i++) {
+            receiverSparsePointsVec[i] = sparse_comp::hash_point(aes, (*receiverSparsePoints)[i]);
+        }
+
+        sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> sender(senderPRNG, aes);
+        sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> recvr(receiverPRNG, aes);
+
+        auto* sender_offline = new sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp>::Offline();
+        auto* recvr_offline = new sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp>::Offline();
+
+        sync_wait(when_all_ready(sender.preprocess(socks[0], *sender_offline), recvr.preprocess(socks[1], *recvr_offline)));
+
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return sender.online(sock, *sender_offline, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return recvr.online(sock, *recvr_offline, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
+
+        intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
+
+        set<size_t> expected_intersec;
+        expected_l1_intersect<TR, TS, D, DELTA>(aes, 
+                                                receiverSparsePointsVec, 
+                                                *receiver_in_values, 
+                                                senderSparsePointsVec, 
+                                                *sender_in_values, 
+                                                expected_intersec);
+        REQUIRE(expected_intersec.size() >= min_num_matching_pts);
+
+        delete sender_offline;
+        delete recvr_offline;
+        delete senderSparsePoints;
+        delete receiverSparsePoints;
+        delete sender_in_values;
+        delete receiver_in_values;
+        delete snder_out_shares;
+        delete rcvr_out_shares;
+
+        REQUIRE(intersec == expected_intersec);
+
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
+
+        SUCCEED("Number of MBs exchanged (online): " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, TS + TR);
+    };
+}
+
+// END OF OFFLINE/ONLINE SPLIT TESTS
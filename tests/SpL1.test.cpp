@@ -6,8 +6,13 @@
 #include "../sparseComp/Common/Common.h"
 #include "../sparseComp/Common/HashUtils.h"
 #include "../sparseComp/SpL1/SpL1.h"
+#include "../sparseComp/MultiOPRF/OtPool.h"
+#include "./support/TempPath.h"
 #include <cstdint>
 #include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
 #include <utility>
 #include <vector>
 #include <algorithm>
@@ -25,6 +30,9 @@ using AES = osuCrypto::AES;
 using std::chrono::high_resolution_clock;
 using std::chrono::milliseconds;
 using sparse_comp::hash_point;
+using sparse_comp::multi_oprf::OtPool;
+using sparse_comp::multi_oprf::RUN_POOL_OTS;
+using sparse_comp::bench::TempPath;
 
 using std::array;
 using std::set;
@@ -730,3 +738,267 @@ TEST_CASE("Sparse L_1 : random constrained test (t_s=256, t_r=1024, d=2, delta=1
 
     REQUIRE(intersec == expected_intersec);
 }
+
+// Random constrained inputs of the tests below, hashed as the protocols take them, and the intersection they
+// should produce. They are large for big sets, so allocate them on the heap.
+template<size_t tr, size_t ts, size_t d, uint8_t delta>
+struct l1_test_inputs {
+    array<point, tr> receiverSparsePoints;
+    array<point, ts> senderSparsePoints;
+    array<array<uint32_t, d>, tr> receiver_in_values;
+    array<array<uint32_t, d>, ts> sender_in_values;
+    vector<block> receiverSparsePointsVec = vector<block>(tr);
+    vector<block> senderSparsePointsVec = vector<block>(ts);
+    set<size_t> expected_intersec;
+
+    l1_test_inputs(block seed, AES& aes, size_t min_num_matching_bins, size_t min_num_matching_pts) {
+        gen_constrained_rand_inputs<tr, ts, d, delta>(seed,
+                                                      min_num_matching_bins,
+                                                      min_num_matching_pts,
+                                                      this->receiverSparsePoints,
+                                                      this->receiver_in_values,
+                                                      this->senderSparsePoints,
+                                                      this->sender_in_values);
+
+        for (size_t i = 0; i < ts; i++) {
+            this->senderSparsePointsVec[i] = sparse_comp::hash_point(aes, this->senderSparsePoints[i]);
+        }
+        for (size_t i = 0; i < tr; i++) {
+            this->receiverSparsePointsVec[i] = sparse_comp::hash_point(aes, this->receiverSparsePoints[i]);
+        }
+
+        expected_l1_intersect<tr, ts, d, delta>(aes,
+                                                this->receiverSparsePointsVec,
+                                                this->receiver_in_values,
+                                                this->senderSparsePointsVec,
+                                                this->sender_in_values,
+                                                this->expected_intersec);
+    }
+};
+
+// Runs send and receive on the inputs and recovers the intersection from the output shares. Rethrows the error
+// of the sender, then of the receiver, if a run fails.
+template<size_t tr, size_t ts, size_t d, uint8_t delta, uint8_t ssp>
+static void run_l1(sparse_comp::sp_l1::Sender<tr,ts,d,delta,ssp>& sender,
+                   sparse_comp::sp_l1::Receiver<ts,tr,d,delta,ssp>& receiver,
+                   l1_test_inputs<tr,ts,d,delta>& inputs,
+                   set<size_t>& intersec) {
+    auto socks = LocalAsyncSocket::makePair();
+    array<array<block, 1>, ts>* snder_out_shares = new array<array<block, 1>, ts>();
+    array<array<block, 1>, tr>* rcvr_out_shares = new array<array<block, 1>, tr>();
+
+    auto r = sync_wait(when_all_ready(sender.send(socks[0], inputs.senderSparsePointsVec, inputs.sender_in_values, *snder_out_shares),
+                                      receiver.receive(socks[1], inputs.receiverSparsePointsVec, inputs.receiver_in_values, *rcvr_out_shares)));
+
+    try {
+        std::get<0>(r).result();
+        std::get<1>(r).result();
+    } catch (...) {
+        delete snder_out_shares;
+        delete rcvr_out_shares;
+        throw;
+    }
+
+    intersec_from_z_shares<tr,ts>(*rcvr_out_shares, *snder_out_shares, intersec);
+
+    delete snder_out_shares;
+    delete rcvr_out_shares;
+}
+
+TEST_CASE("Sparse L_1 : runs from an OT pool until it is exhausted (t_s=64, t_r=64, d=2, delta=10, ssp=40)") {
+    constexpr size_t TS = 64;
+    constexpr size_t TR = 64;
+    constexpr size_t D = 2;
+    constexpr size_t DELTA = 10;
+    constexpr size_t ssp = 40;
+    constexpr size_t RUNS = 2;
+
+    block seed = block(3185860462513187422ULL,12455347301447460587ULL);
+    PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+    PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+    AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+    auto inputs = std::make_unique<l1_test_inputs<TR, TS, D, DELTA>>(seed, aes, 17, 5);
+    REQUIRE(inputs->expected_intersec.size() >= 5);
+
+    TempPath leaderPath("leader.otpool");
+    TempPath followerPath("follower.otpool");
+
+    auto socks = LocalAsyncSocket::makePair();
+    sync_wait(when_all_ready(OtPool::create(socks[0], senderPRNG, true, RUNS * RUN_POOL_OTS, leaderPath.str()),
+                             OtPool::create(socks[1], receiverPRNG, false, RUNS * RUN_POOL_OTS, followerPath.str())));
+
+    std::unique_ptr<OtPool> leaderPool(OtPool::open(leaderPath.str()));
+    std::unique_ptr<OtPool> followerPool(OtPool::open(followerPath.str()));
+
+    sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes, leaderPool.get());
+    sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes, followerPool.get());
+
+    for (size_t run = 0; run < RUNS; run++) {
+        set<size_t> intersec;
+        run_l1(spL1Sender, spL1Recvr, *inputs, intersec);
+
+        REQUIRE(intersec == inputs->expected_intersec);
+    }
+
+    REQUIRE(leaderPool->available() == 0);
+
+    set<size_t> intersec;
+    REQUIRE_THROWS_AS(run_l1(spL1Sender, spL1Recvr, *inputs, intersec), std::runtime_error);
+}
+
+TEST_CASE("Sparse L_1 : preprocess then online matches a single-shot run (t_s=64, t_r=256, d=2, delta=10, ssp=40)") {
+    constexpr size_t TS = 64;
+    constexpr size_t TR = 256;
+    constexpr size_t D = 2;
+    constexpr size_t DELTA = 10;
+    constexpr size_t ssp = 40;
+
+    block seed = block(13267093958710528113ULL,5418220985034407816ULL);
+    PRNG senderPRNG = PRNG(block(742130310438916676ULL, 11803924226990735076ULL));
+    PRNG receiverPRNG = PRNG(block(2457938039974938056ULL, 17910068785450354990ULL));
+    AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+    auto inputs = std::make_unique<l1_test_inputs<TR, TS, D, DELTA>>(seed, aes, 29, 11);
+    REQUIRE(inputs->expected_intersec.size() >= 11);
+
+    sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
+    sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
+
+    set<size_t> single_shot_intersec;
+    run_l1(spL1Sender, spL1Recvr, *inputs, single_shot_intersec);
+
+    auto socks = LocalAsyncSocket::makePair();
+    auto senderOffline = std::make_unique<sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp>::Offline>();
+    auto receiverOffline = std::make_unique<sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp>::Offline>();
+    array<array<block, 1>, TS>* snder_out_shares = new array<array<block, 1>, TS>();
+    array<array<block, 1>, TR>* rcvr_out_shares = new array<array<block, 1>, TR>();
+
+    auto offline_r = sync_wait(when_all_ready(spL1Sender.preprocess(socks[0], *senderOffline),
+                                              spL1Recvr.preprocess(socks[1], *receiverOffline)));
+    std::get<0>(offline_r).result();
+    std::get<1>(offline_r).result();
+
+    // A bundle is preprocessed once
+    auto again_r = sync_wait(when_all_ready(spL1Sender.preprocess(socks[0], *senderOffline),
+                                            spL1Recvr.preprocess(socks[1], *receiverOffline)));
+    REQUIRE_THROWS_AS(std::get<0>(again_r).result(), std::runtime_error);
+    REQUIRE_THROWS_AS(std::get<1>(again_r).result(), std::runtime_error);
+
+    auto online_r = sync_wait(when_all_ready(spL1Sender.online(socks[0], *senderOffline, inputs->senderSparsePointsVec, inputs->sender_in_values, *snder_out_shares),
+                                             spL1Recvr.online(socks[1], *receiverOffline, inputs->receiverSparsePointsVec, inputs->receiver_in_values, *rcvr_out_shares)));
+    std::get<0>(online_r).result();
+    std::get<1>(online_r).result();
+
+    set<size_t> intersec;
+    intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
+
+    // The online step consumed the bundles
+    auto reused_r = sync_wait(when_all_ready(spL1Sender.online(socks[0], *senderOffline, inputs->senderSparsePointsVec, inputs->sender_in_values, *snder_out_shares),
+                                             spL1Recvr.online(socks[1], *receiverOffline, inputs->receiverSparsePointsVec, inputs->receiver_in_values, *rcvr_out_shares)));
+    REQUIRE_THROWS_AS(std::get<0>(reused_r).result(), std::runtime_error);
+    REQUIRE_THROWS_AS(std::get<1>(reused_r).result(), std::runtime_error);
+
+    delete snder_out_shares;
+    delete rcvr_out_shares;
+
+    REQUIRE(intersec == single_shot_intersec);
+    REQUIRE(intersec == inputs->expected_intersec);
+}
+
+TEST_CASE("Sparse L_1 : online without preprocess is rejected (t_s=64, t_r=64, d=2, delta=10, ssp=40)") {
+    constexpr size_t TS = 64;
+    constexpr size_t TR = 64;
+    constexpr size_t D = 2;
+    constexpr size_t DELTA = 10;
+    constexpr size_t ssp = 40;
+
+    block seed = block(3185860462513187422ULL,12455347301447460587ULL);
+    PRNG senderPRNG = PRNG(block(742130310438916676ULL, 11803924226990735076ULL));
+    PRNG receiverPRNG = PRNG(block(2457938039974938056ULL, 17910068785450354990ULL));
+    AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+    auto inputs = std::make_unique<l1_test_inputs<TR, TS, D, DELTA>>(seed, aes, 17, 5);
+
+    sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> spL1Sender(senderPRNG, aes);
+    sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> spL1Recvr(receiverPRNG, aes);
+
+    auto socks = LocalAsyncSocket::makePair();
+    auto senderOffline = std::make_unique<sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp>::Offline>();
+    auto receiverOffline = std::make_unique<sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp>::Offline>();
+    array<array<block, 1>, TS>* snder_out_shares = new array<array<block, 1>, TS>();
+    array<array<block, 1>, TR>* rcvr_out_shares = new array<array<block, 1>, TR>();
+
+    auto r = sync_wait(when_all_ready(spL1Sender.online(socks[0], *senderOffline, inputs->senderSparsePointsVec, inputs->sender_in_values, *snder_out_shares),
+                                      spL1Recvr.online(socks[1], *receiverOffline, inputs->receiverSparsePointsVec, inputs->receiver_in_values, *rcvr_out_shares)));
+
+    delete snder_out_shares;
+    delete rcvr_out_shares;
+
+    REQUIRE_THROWS_AS(std::get<0>(r).result(), std::runtime_error);
+    REQUIRE_THROWS_AS(std::get<1>(r).result(), std::runtime_error);
+}
+
+// Runs the tests below with the given OT extension, or skips the test case if it was not compiled into libOTe.
+template<size_t tr, size_t ts, size_t d, uint8_t delta, uint8_t ssp>
+static void check_l1_with_ot_ext(sparse_comp::multi_oprf::OtExtConfig otExt) {
+    if (!sparse_comp::multi_oprf::ot_ext_backend_available(otExt.backend)) {
+        SKIP(sparse_comp::multi_oprf::ot_ext_backend_name(otExt.backend) << " not compiled into libOTe");
+    }
+
+    block seed = block(11840934557411024393ULL,1490238757208353120ULL);
+    PRNG senderPRNG = PRNG(block(742130310438916676ULL, 11803924226990735076ULL));
+    PRNG receiverPRNG = PRNG(block(2457938039974938056ULL, 17910068785450354990ULL));
+    AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+    auto inputs = std::make_unique<l1_test_inputs<tr, ts, d, delta>>(seed, aes, 17, 5);
+    REQUIRE(inputs->expected_intersec.size() >= 5);
+
+    sparse_comp::sp_l1::Sender<tr,ts,d,delta,ssp> spL1Sender(senderPRNG, aes, nullptr, otExt);
+    sparse_comp::sp_l1::Receiver<ts,tr,d,delta,ssp> spL1Recvr(receiverPRNG, aes, nullptr, otExt);
+
+    set<size_t> intersec;
+    run_l1(spL1Sender, spL1Recvr, *inputs, intersec);
+
+    REQUIRE(intersec == inputs->expected_intersec);
+}
+
+TEST_CASE("Sparse L_1 : IKNP OT extension (t_s=64, t_r=64, d=2, delta=10, ssp=40)") {
+    check_l1_with_ot_ext<64,64,2,10,40>(sparse_comp::multi_oprf::OtExtConfig(sparse_comp::multi_oprf::OtExtBackend::Iknp));
+}
+
+TEST_CASE("Sparse L_1 : SoftSpokenOT extension (t_s=64, t_r=64, d=2, delta=10, ssp=40)") {
+    check_l1_with_ot_ext<64,64,2,10,40>(sparse_comp::multi_oprf::OtExtConfig(sparse_comp::multi_oprf::OtExtBackend::SoftSpoken));
+    check_l1_with_ot_ext<64,64,2,10,40>(sparse_comp::multi_oprf::OtExtConfig(sparse_comp::multi_oprf::OtExtBackend::SoftSpoken, 4));
+}
+
+TEST_CASE("Sparse L_1 : RsOprf backend matches the MultiOprf backend (t_s=64, t_r=256, d=2, delta=10, ssp=40)") {
+    constexpr size_t TS = 64;
+    constexpr size_t TR = 256;
+    constexpr size_t D = 2;
+    constexpr size_t DELTA = 10;
+    constexpr size_t ssp = 40;
+
+    block seed = block(8024561371126807283ULL,14697034180945502537ULL);
+    PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+    PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+    AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+    auto inputs = std::make_unique<l1_test_inputs<TR, TS, D, DELTA>>(seed, aes, 29, 11);
+    REQUIRE(inputs->expected_intersec.size() >= 11);
+
+    sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> multiOprfSender(senderPRNG, aes);
+    sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> multiOprfRecvr(receiverPRNG, aes);
+
+    set<size_t> multi_oprf_intersec;
+    run_l1(multiOprfSender, multiOprfRecvr, *inputs, multi_oprf_intersec);
+
+    sparse_comp::sp_l1::Sender<TR,TS,D,DELTA,ssp> rsOprfSender(senderPRNG, aes, nullptr, sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend::RsOprf);
+    sparse_comp::sp_l1::Receiver<TS,TR,D,DELTA,ssp> rsOprfRecvr(receiverPRNG, aes, nullptr, sparse_comp::multi_oprf::OtExtConfig(), sparse_comp::custom_oprf::OprfBackend::RsOprf);
+
+    set<size_t> rs_oprf_intersec;
+    run_l1(rsOprfSender, rsOprfRecvr, *inputs, rs_oprf_intersec);
+
+    REQUIRE(rs_oprf_intersec == multi_oprf_intersec);
+    REQUIRE(rs_oprf_intersec == inputs->expected_intersec);
+}
@@ -3,6 +3,7 @@
 #include "cryptoTools/Crypto/PRNG.h"
 #include "cryptoTools/Common/block.h"
 #include "coproto/Socket/LocalAsyncSock.h"
+#include "./support/TwoPartyBench.h"
 #include "cryptoTools/Crypto/AES.h"
 #include "../sparseComp/Common/Common.h"
 #include "../sparseComp/Common/HashUtils.h"
@@ -411,10 +412,9 @@ TEST_CASE("spl2 (t_s=256 t_r=1024 d=2 delta=10 ssp=40)","[spl2][n=m=2^8]") {
         sparse_comp::sp_l2::Sender<TR,TS,DELTA,ssp> spL2Sender(senderPRNG, aes);
         sparse_comp::sp_l2::Receiver<TS,TR,DELTA,ssp> spL2Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL2Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL2Recvr.receive(socks[1],  receiverSparsePointsVec, *receiver_in_values,  *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL2Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL2Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         set<size_t> expected_intersec;
                intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
@@ -437,7 +437,7 @@ TEST_CASE("spl2 (t_s=256 t_r=1024 d=2 delta=10 ssp=40)","[spl2][n=m=2^8]") {
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -487,10 +487,9 @@ TEST_CASE("spl2 (t_s=256 t_r=1024 d=2 delta=30 ssp=40)","[spl2][n=m=2^8]") {
         sparse_comp::sp_l2::Sender<TR,TS,DELTA,ssp> spL2Sender(senderPRNG, aes);
         sparse_comp::sp_l2::Receiver<TS,TR,DELTA,ssp> spL2Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL2Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL2Recvr.receive(socks[1],  receiverSparsePointsVec, *receiver_in_values,  *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL2Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL2Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
         
         set<size_t> expected_intersec;
                intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
@@ -513,7 +512,7 @@ TEST_CASE("spl2 (t_s=256 t_r=1024 d=2 delta=30 ssp=40)","[spl2][n=m=2^8]") {
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -567,10 +566,9 @@ TEST_CASE("spl2 (t_s=4096 t_r=16384 d=2 delta=10 ssp=40)","[spl2][n=m=2^12]") {
         sparse_comp::sp_l2::Sender<TR,TS,DELTA,ssp> spL2Sender(senderPRNG, aes);
         sparse_comp::sp_l2::Receiver<TS,TR,DELTA,ssp> spL2Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL2Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL2Recvr.receive(socks[1],  receiverSparsePointsVec, *receiver_in_values,  *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL2Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL2Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
         
         set<size_t> expected_intersec;
                intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
@@ -593,7 +591,7 @@ TEST_CASE("spl2 (t_s=4096 t_r=16384 d=2 delta=10 ssp=40)","[spl2][n=m=2^12]") {
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -643,10 +641,9 @@ TEST_CASE("spl2 (t_s=4096 t_r=16384 d=2 delta=30 ssp=40)","[spl2][n=m=2^12]") {
         sparse_comp::sp_l2::Sender<TR,TS,DELTA,ssp> spL2Sender(senderPRNG, aes);
         sparse_comp::sp_l2::Receiver<TS,TR,DELTA,ssp> spL2Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL2Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL2Recvr.receive(socks[1],  receiverSparsePointsVec, *receiver_in_values,  *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL2Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL2Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
         
         set<size_t> expected_intersec;
                intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
@@ -669,7 +666,7 @@ TEST_CASE("spl2 (t_s=4096 t_r=16384 d=2 delta=30 ssp=40)","[spl2][n=m=2^12]") {
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -723,10 +720,9 @@ TEST_CASE("spl2 (t_s=65536 t_r=262144 d=2 delta=10 ssp=40)","[spl2][n=m=2^16]")
         sparse_comp::sp_l2::Sender<TR,TS,DELTA,ssp> spL2Sender(senderPRNG, aes);
         sparse_comp::sp_l2::Receiver<TS,TR,DELTA,ssp> spL2Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL2Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL2Recvr.receive(socks[1],  receiverSparsePointsVec, *receiver_in_values,  *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL2Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL2Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         set<size_t> expected_intersec;
                intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
@@ -749,7 +745,7 @@ TEST_CASE("spl2 (t_s=65536 t_r=262144 d=2 delta=10 ssp=40)","[spl2][n=m=2^16]")
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -799,10 +795,9 @@ TEST_CASE("spl2 (t_s=65536 t_r=262144 d=2 delta=30 ssp=40)","[spl2][n=m=2^12]")
         sparse_comp::sp_l2::Sender<TR,TS,DELTA,ssp> spL2Sender(senderPRNG, aes);
         sparse_comp::sp_l2::Receiver<TS,TR,DELTA,ssp> spL2Recvr(receiverPRNG, aes);
 
-        auto sender_proto = spL2Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spL2Recvr.receive(socks[1],  receiverSparsePointsVec, *receiver_in_values,  *rcvr_out_shares);
-
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spL2Sender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spL2Recvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         set<size_t> expected_intersec;
                intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
@@ -825,10 +820,119 @@ TEST_CASE("spl2 (t_s=65536 t_r=262144 d=2 delta=30 ssp=40)","[spl2][n=m=2^12]")
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
 }
 
-// END OF TESTS FOR N=M=2^16
\ No newline at end of file
+// END OF TESTS FOR N=M=2^16
+
+// START OF OFFLINE/ONLINE SPLIT TESTS
+
+TEST_CASE("spl2 offline/online (t_s=256 t_r=1024 d=2 delta=10 ssp=40)","[spl2][n=m=2^8][offline-online]") {
+    constexpr size_t TS = 256;
+    constexpr size_t TR = 1024;
+    constexpr size_t DELTA = 10;
+    constexpr size_t ssp = 40;
+
+    BENCHMARK_ADVANCED("offline t_s=256 t_r=1024 d=2 delta=10 ssp=40")(Catch::Benchmark::Chronometer meter) {
+        auto socks = LocalAsyncSocket::makePair();
+        PRNG senderPRNG = PRNG(block(742130310438916676ULL, 11803924226990735076ULL));
+        PRNG receiverPRNG = PRNG(block(2457938039974938056ULL, 17910068785450354990ULL));
+        AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+        sparse_comp::sp_l2::Sender<TR,TS,DELTA,ssp> sender(senderPRNG, aes);
+        sparse_comp::sp_l2::Receiver<TS,TR,DELTA,ssp> recvr(receiverPRNG, aes);
+
+        auto* sender_offline = new sparse_comp::sp_l2::Sender<TR,TS,DELTA,ssp>::Offline();
+        auto* recvr_offline = new sparse_comp::sp_l2::Receiver<TS,TR,DELTA,ssp>::Offline();
+
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return sender.preprocess(sock, *sender_offline); },
+            [&](coproto::Socket& sock) { return recvr.preprocess(sock, *recvr_offline); });
+
+        delete sender_offline;
+        delete recvr_offline;
+
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
+
+        SUCCEED("Number of MBs exchanged (offline): " << nMBsExchanged);
+    };
+
+    BENCHMARK_ADVANCED("online t_s=256 t_r=1024 d=2 delta=10 ssp=40")(Catch::Benchmark::Chronometer meter) {
+        size_t min_num_matching_bins = 53;
+        size_t min_num_matching_pts = 17;
+
+        auto socks = LocalAsyncSocket::makePair();
+        block seed = block(9536629026107651350ULL,2724119864341290560ULL);
+        PRNG senderPRNG = PRNG(block(742130310438916676ULL, 11803924226990735076ULL));
+        PRNG receiverPRNG = PRNG(block(2457938039974938056ULL, 17910068785450354990ULL));
+        AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+        std::array<point, TS> *senderSparsePoints = new std::array<point, TS>();
+        std::array<point, TR> *receiverSparsePoints = new std::array<point, TR>();
+        array<array<uint32_t, 2>, TS> *sender_in_values = new array<array<uint32_t, 2>, TS>();
+        array<array<uint32_t, 2>, TR> *receiver_in_values = new array<array<uint32_t, 2>, TR>();
+        array<array<block, 1>, TS>* snder_out_shares = new array<array<block, 1>, TS>();
+        array<array<block, 1>, TR>* rcvr_out_shares = new array<array<block, 1>, TR>();
+        vector<block> senderSparsePointsVec(TS);
+        vector<block> receiverSparsePointsVec(TR);
+        set<size_t> intersec;
+
+        gen_constrained_rand_inputs<TR, TS, DELTA>(seed, 
+                                                  min_num_matching_bins,
+                                                  min_num_matching_pts,
+                                                  *receiverSparsePoints,
+                                                  *receiver_in_values, 
+                                                  *senderSparsePoints, 
+                                                  *sender_in_values);
+
+        for (size_t i = 0; i < TS; i++) {
+            senderSparsePointsVec[i] = sparse_comp::hash_point(aes, (*senderSparsePoints)[i]);
+        }
+        for (size_t i = 0; i < TR; i++) {
+            receiverSparsePointsVec[i] = sparse_comp::hash_point(aes, (*receiverSparsePoints)[i]);
+        }
+
+        sparse_comp::sp_l2::Sender<TR,TS,DELTA,ssp> sender(senderPRNG, aes);
+        sparse_comp::sp_l2::Receiver<TS,TR,DELTA,ssp> recvr(receiverPRNG, aes);
+
+        auto* sender_offline = new sparse_comp::sp_l2::Sender<TR,TS,DELTA,ssp>::Offline();
+        auto* recvr_offline = new sparse_comp::sp_l2::Receiver<TS,TR,DELTA,ssp>::Offline();
+
+        sync_wait(when_all_ready(sender.preprocess(socks[0], *sender_offline), recvr.preprocess(socks[1], *recvr_offline)));
+
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return sender.online(sock, *sender_offline, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return recvr.online(sock, *recvr_offline, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
+
+        intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
+
+        set<size_t> expected_intersec;
+        expected_l2_intersect<TR, TS, DELTA>(aes, 
+                                                *receiverSparsePoints, 
+                                                *receiver_in_values, 
+                                                *senderSparsePoints, 
+                                                *sender_in_values, 
+                                                expected_intersec);
+        REQUIRE(expected_intersec.size() >= min_num_matching_pts);
+
+        delete sender_offline;
+        delete recvr_offline;
+        delete senderSparsePoints;
+        delete receiverSparsePoints;
+        delete sender_in_values;
+        delete receiver_in_values;
+        delete snder_out_shares;
+        delete rcvr_out_shares;
+
+        REQUIRE(intersec == expected_intersec);
+
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
+
+        SUCCEED("Number of MBs exchanged (online): " << nMBsExchanged);
+    };
+}
+
+// END OF OFFLINE/ONLINE SPLIT TESTS
@@ -8,6 +8,9 @@
 #include "../sparseComp/SpL2/SpL2.h"
 #include <cstdint>
 #include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
 #include <utility>
 #include <vector>
 #include <algorithm>
@@ -720,3 +723,98 @@ sync_wait(when_all_ready(std::move(sender_proto),std::move(receiver_proto)));
     REQUIRE(intersec == expected_intersec);
 
 }
+
+TEST_CASE("Sparse L_2 : preprocess then online matches a single-shot run (t_s=64, t_r=256, d=2, delta=10, ssp=40)") {
+    constexpr size_t TS = 64;
+    constexpr size_t TR = 256;
+    constexpr uint8_t DELTA = 10;
+    constexpr size_t ssp = 40;
+    size_t min_num_matching_bins = 29;
+    size_t min_num_matching_pts = 11;
+
+    auto socks = LocalAsyncSocket::makePair();
+    block seed = block(13267093958710528113ULL,5418220985034407816ULL);
+    PRNG senderPRNG = PRNG(block(742130310438916676ULL, 11803924226990735076ULL));
+    PRNG receiverPRNG = PRNG(block(2457938039974938056ULL, 17910068785450354990ULL));
+    AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+    std::array<point, TS>* senderSparsePoints = new std::array<point, TS>();
+    std::array<point, TR>* receiverSparsePoints = new std::array<point, TR>();
+    array<array<uint32_t, 2>, TS>* sender_in_values = new array<array<uint32_t, 2>, TS>();
+    array<array<uint32_t, 2>, TR>* receiver_in_values = new array<array<uint32_t, 2>, TR>();
+    array<array<block, 1>, TS>* snder_out_shares = new array<array<block, 1>, TS>();
+    array<array<block, 1>, TR>* rcvr_out_shares = new array<array<block, 1>, TR>();
+    vector<block> senderSparsePointsVec(TS);
+    vector<block> receiverSparsePointsVec(TR);
+
+    gen_constrained_rand_inputs<TR, TS, DELTA>(seed, 
+                                               min_num_matching_bins,
+                                               min_num_matching_pts,
+                                               *receiverSparsePoints,
+                                               *receiver_in_values, 
+                                               *senderSparsePoints, 
+                                               *sender_in_values);
+
+    for (size_t i = 0; i < TS; i++) {
+        senderSparsePointsVec[i] = sparse_comp::hash_point(aes, (*senderSparsePoints)[i]);
+    }
+    for (size_t i = 0; i < TR; i++) {
+        receiverSparsePointsVec[i] = sparse_comp::hash_point(aes, (*receiverSparsePoints)[i]);
+    }
+
+    sparse_comp::sp_l2::Sender<TR,TS,DELTA,ssp> spL2Sender(senderPRNG, aes);
+    sparse_comp::sp_l2::Receiver<TS,TR,DELTA,ssp> spL2Recvr(receiverPRNG, aes);
+
+    set<size_t> single_shot_intersec;
+
+    sync_wait(when_all_ready(spL2Sender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares),
+                             spL2Recvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares)));
+
+    intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, single_shot_intersec);
+
+    auto senderOffline = std::make_unique<sparse_comp::sp_l2::Sender<TR,TS,DELTA,ssp>::Offline>();
+    auto receiverOffline = std::make_unique<sparse_comp::sp_l2::Receiver<TS,TR,DELTA,ssp>::Offline>();
+
+    sync_wait(when_all_ready(spL2Sender.preprocess(socks[0], *senderOffline),
+                             spL2Recvr.preprocess(socks[1], *receiverOffline)));
+
+    // A bundle is preprocessed once
+    auto again_r = sync_wait(when_all_ready(spL2Sender.preprocess(socks[0], *senderOffline),
+                                            spL2Recvr.preprocess(socks[1], *receiverOffline)));
+    REQUIRE_THROWS_AS(std::get<0>(again_r).result(), std::runtime_error);
+    REQUIRE_THROWS_AS(std::get<1>(again_r).result(), std::runtime_error);
+
+    auto online_r = sync_wait(when_all_ready(spL2Sender.online(socks[0], *senderOffline, senderSparsePointsVec, *sender_in_values, *snder_out_shares),
+                                             spL2Recvr.online(socks[1], *receiverOffline, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares)));
+    std::get<0>(online_r).result();
+    std::get<1>(online_r).result();
+
+    set<size_t> intersec;
+    intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
+
+    // Online without a preprocessed bundle, here the one consumed above
+    auto reused_r = sync_wait(when_all_ready(spL2Sender.online(socks[0], *senderOffline, senderSparsePointsVec, *sender_in_values, *snder_out_shares),
+                                             spL2Recvr.online(socks[1], *receiverOffline, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares)));
+    REQUIRE_THROWS_AS(std::get<0>(reused_r).result(), std::runtime_error);
+    REQUIRE_THROWS_AS(std::get<1>(reused_r).result(), std::runtime_error);
+
+    set<size_t> expected_intersec;
+
+    expected_l2_intersect<TR, TS, DELTA>(aes, 
+                                         receiverSparsePointsVec, 
+                                         *receiver_in_values, 
+                                         senderSparsePointsVec, 
+                                         *sender_in_values, 
+                                         expected_intersec);
+    REQUIRE(expected_intersec.size() >= min_num_matching_pts);
+
+    delete senderSparsePoints;
+    delete receiverSparsePoints;
+    delete sender_in_values;
+    delete receiver_in_values;
+    delete snder_out_shares;
+    delete rcvr_out_shares;
+
+    REQUIRE(intersec == single_shot_intersec);
+    REQUIRE(intersec == expected_intersec);
+}
@@ -3,6 +3,7 @@
 #include "cryptoTools/Crypto/PRNG.h"
 #include "cryptoTools/Common/block.h"
 #include "coproto/Socket/LocalAsyncSock.h"
+#include "./support/TwoPartyBench.h"
 #include "cryptoTools/Crypto/AES.h"
 #include "../sparseComp/Common/Common.h"
 #include "../sparseComp/Common/HashUtils.h"
@@ -410,9 +411,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -434,7 +435,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -486,9 +487,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -510,7 +511,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -561,9 +562,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -585,7 +586,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -636,9 +637,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -660,7 +661,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
 
@@ -713,9 +714,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -737,7 +738,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -790,9 +791,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -814,7 +815,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -871,9 +872,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -895,7 +896,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -948,9 +949,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -972,7 +973,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1024,9 +1025,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1048,7 +1049,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1100,9 +1101,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1124,7 +1125,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1177,9 +1178,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1201,7 +1202,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1254,9 +1255,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1278,7 +1279,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1336,9 +1337,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1360,7 +1361,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1413,9 +1414,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1437,7 +1438,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1489,9 +1490,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1513,7 +1514,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1565,9 +1566,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1589,7 +1590,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1642,9 +1643,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1666,7 +1667,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1719,9 +1720,9 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
         sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
         sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
 
-        auto sender_proto = spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares);
-        auto receiver_proto = spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares);
-        meter.measure([&sender_proto,&receiver_proto]() { sync_wait(when_all_ready(std::move(sender_proto), std::move(receiver_proto))); });
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return spLinfSender.send(sock, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return spLinfRecvr.receive(sock, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
 
         intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
 
@@ -1743,7 +1744,7 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
         REQUIRE(intersec == expected_intersec);
 
-        const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0; 
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
 
         SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
     };
@@ -1753,3 +1754,112 @@ gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed,
 
 // END OF TESTS FOR N=M=2^16
 
+// START OF OFFLINE/ONLINE SPLIT TESTS
+
+TEST_CASE("splinf offline/online (t_s=256 t_r=1024 d=2 delta=10 ssp=40)","[splinf][n=m=2^8][offline-online]") {
+    constexpr size_t TS = 256;
+    constexpr size_t TR = 1024;
+    constexpr size_t D = 2;
+    constexpr size_t DELTA = 10;
+    constexpr size_t ssp = 40;
+
+    BENCHMARK_ADVANCED("offline t_s=256 t_r=1024 d=2 delta=10 ssp=40")(Catch::Benchmark::Chronometer meter) {
+        auto socks = LocalAsyncSocket::makePair();
+        PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+        PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+        AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+        sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> sender(senderPRNG, aes);
+        sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> recvr(receiverPRNG, aes);
+
+        auto* sender_offline = new sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp>::Offline();
+        auto* recvr_offline = new sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp>::Offline();
+
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return sender.preprocess(sock, *sender_offline); },
+            [&](coproto::Socket& sock) { return recvr.preprocess(sock, *recvr_offline); });
+
+        delete sender_offline;
+        delete recvr_offline;
+
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
+
+        SUCCEED("Number of MBs exchanged (offline): " << nMBsExchanged);
+    };
+
+    BENCHMARK_ADVANCED("online t_s=256 t_r=1024 d=2 delta=10 ssp=40")(Catch::Benchmark::Chronometer meter) {
+        size_t min_num_matching_bins = 53;
+        size_t min_num_matching_pts = 17;
+
+        auto socks = LocalAsyncSocket::makePair();
+        block seed = block(9536629026107651350ULL,2724119864341290560ULL);
+        PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+        PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+        AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+        std::array<point, TS> *senderSparsePoints = new std::array<point, TS>();
+        std::array<point, TR> *receiverSparsePoints = new std::array<point, TR>();
+        array<array<uint32_t, D>, TS> *sender_in_values = new array<array<uint32_t, D>, TS>();
+        array<array<uint32_t, D>, TR> *receiver_in_values = new array<array<uint32_t, D>, TR>();
+        array<array<block, 1>, TS>* snder_out_shares = new array<array<block, 1>, TS>();
+        array<array<block, 1>, TR>* rcvr_out_shares = new array<array<block, 1>, TR>();
+        vector<block> senderSparsePointsVec(TS);
+        vector<block> receiverSparsePointsVec(TR);
+        set<size_t> intersec;
+
+        gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed, 
+                                                  min_num_matching_bins,
+                                                  min_num_matching_pts,
+                                                  *receiverSparsePoints,
+                                                  *receiver_in_values, 
+                                                  *senderSparsePoints, 
+                                                  *sender_in_values);
+
+        for (size_t i = 0; i < TS; i++) {
+            senderSparsePointsVec[i] = sparse_comp::hash_point(aes, (*senderSparsePoints)[i]);
+        }
+        for (size_t i = 0; i < TR; i++) {
+            receiverSparsePointsVec[i] = sparse_comp::hash_point(aes, (*receiverSparsePoints)[i]);
+        }
+
+        sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> sender(senderPRNG, aes);
+        sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> recvr(receiverPRNG, aes);
+
+        auto* sender_offline = new sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp>::Offline();
+        auto* recvr_offline = new sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp>::Offline();
+
+        sync_wait(when_all_ready(sender.preprocess(socks[0], *sender_offline), recvr.preprocess(socks[1], *recvr_offline)));
+
+        auto parties = sparse_comp::bench::measure_parties(meter, socks,
+            [&](coproto::Socket& sock) { return sender.online(sock, *sender_offline, senderSparsePointsVec, *sender_in_values, *snder_out_shares); },
+            [&](coproto::Socket& sock) { return recvr.online(sock, *recvr_offline, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares); }, *rcvr_out_shares);
+
+        intersec_from_z_shares(*rcvr_out_shares, *snder_out_shares, intersec);
+
+        set<size_t> expected_intersec;
+        expected_linf_intersect<TR, TS, D, DELTA>(aes, 
+                                                receiverSparsePointsVec, 
+                                                *receiver_in_values, 
+                                                senderSparsePointsVec, 
+                                                *sender_in_values, 
+                                                expected_intersec);
+        REQUIRE(expected_intersec.size() >= min_num_matching_pts);
+
+        delete sender_offline;
+        delete recvr_offline;
+        delete senderSparsePoints;
+        delete receiverSparsePoints;
+        delete sender_in_values;
+        delete receiver_in_values;
+        delete snder_out_shares;
+        delete rcvr_out_shares;
+
+        REQUIRE(intersec == expected_intersec);
+
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0; 
+
+        SUCCEED("Number of MBs exchanged (online): " << nMBsExchanged);
+    };
+}
+
+// END OF OFFLINE/ONLINE SPLIT TESTS
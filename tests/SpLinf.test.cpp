@@ -8,6 +8,9 @@
 #include "../sparseComp/SpLInf/SpLInf.h"
 #include <cstdint>
 #include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
 #include <utility>
 #include <vector>
 #include <algorithm>
@@ -690,4 +693,98 @@ TEST_CASE("Sparse L_inf : random constrained test (t_s=256, t_r=1024, d=2, delta
     delete rcvr_out_shares;
 
     REQUIRE(intersec == expected_intersec);
-}
\ No newline at end of file
+}
+TEST_CASE("Sparse L_inf : preprocess then online matches a single-shot run (t_s=64, t_r=256, d=2, delta=10, ssp=40)") {
+    constexpr size_t TS = 64;
+    constexpr size_t TR = 256;
+    constexpr size_t D = 2;
+    constexpr size_t DELTA = 10;
+    constexpr size_t ssp = 40;
+    size_t min_num_matching_bins = 29;
+    size_t min_num_matching_pts = 11;
+
+    auto socks = LocalAsyncSocket::makePair();
+    block seed = block(13267093958710528113ULL,5418220985034407816ULL);
+    PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+    PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+    AES aes = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+    std::array<point, TS> *senderSparsePoints = new std::array<point, TS>();
+    std::array<point, TR> *receiverSparsePoints = new std::array<point, TR>();
+    array<array<uint32_t, D>, TS> *sender_in_values = new array<array<uint32_t, D>, TS>();
+    array<array<uint32_t, D>, TR> *receiver_in_values = new array<array<uint32_t, D>, TR>();
+    array<array<block, 1>, TS>* snder_out_shares = new array<array<block, 1>, TS>();
+    array<array<block, 1>, TR>* rcvr_out_shares = new array<array<block, 1>, TR>();
+
+    gen_constrained_rand_inputs<TR, TS, D, DELTA>(seed, 
+                                                  min_num_matching_bins,
+                                                  min_num_matching_pts,
+                                                  *receiverSparsePoints,
+                                                  *receiver_in_values, 
+                                                  *senderSparsePoints, 
+                                                  *sender_in_values);
+
+    vector<block> senderSparsePointsVec(TS);
+    vector<block> receiverSparsePointsVec(TR);
+    for (size_t i = 0; i < TS; i++) {
+        senderSparsePointsVec[i] = sparse_comp::hash_point(aes, (*senderSparsePoints)[i]);
+    }
+    for (size_t i = 0; i < TR; i++) {
+        receiverSparsePointsVec[i] = sparse_comp::hash_point(aes, (*receiverSparsePoints)[i]);
+    }
+
+    sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp> spLinfSender(senderPRNG, aes);
+    sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp> spLinfRecvr(receiverPRNG, aes);
+
+    set<size_t> single_shot_intersec;
+
+    sync_wait(when_all_ready(spLinfSender.send(socks[0], senderSparsePointsVec, *sender_in_values, *snder_out_shares),
+                             spLinfRecvr.receive(socks[1], receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares)));
+
+    intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, single_shot_intersec);
+
+    auto senderOffline = std::make_unique<sparse_comp::sp_linf::Sender<TR, TS, D, DELTA, ssp>::Offline>();
+    auto receiverOffline = std::make_unique<sparse_comp::sp_linf::Receiver<TS, TR, D, DELTA, ssp>::Offline>();
+
+    sync_wait(when_all_ready(spLinfSender.preprocess(socks[0], *senderOffline),
+                             spLinfRecvr.preprocess(socks[1], *receiverOffline)));
+
+    // A bundle is preprocessed once
+    auto again_r = sync_wait(when_all_ready(spLinfSender.preprocess(socks[0], *senderOffline),
+                                            spLinfRecvr.preprocess(socks[1], *receiverOffline)));
+    REQUIRE_THROWS_AS(std::get<0>(again_r).result(), std::runtime_error);
+    REQUIRE_THROWS_AS(std::get<1>(again_r).result(), std::runtime_error);
+
+    auto online_r = sync_wait(when_all_ready(spLinfSender.online(socks[0], *senderOffline, senderSparsePointsVec, *sender_in_values, *snder_out_shares),
+                                             spLinfRecvr.online(socks[1], *receiverOffline, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares)));
+    std::get<0>(online_r).result();
+    std::get<1>(online_r).result();
+
+    set<size_t> intersec;
+    intersec_from_z_shares<TR,TS>(*rcvr_out_shares, *snder_out_shares, intersec);
+
+    // Online without a preprocessed bundle, here the one consumed above
+    auto reused_r = sync_wait(when_all_ready(spLinfSender.online(socks[0], *senderOffline, senderSparsePointsVec, *sender_in_values, *snder_out_shares),
+                                             spLinfRecvr.online(socks[1], *receiverOffline, receiverSparsePointsVec, *receiver_in_values, *rcvr_out_shares)));
+    REQUIRE_THROWS_AS(std::get<0>(reused_r).result(), std::runtime_error);
+    REQUIRE_THROWS_AS(std::get<1>(reused_r).result(), std::runtime_error);
+
+    set<size_t> expected_intersec;
+    expected_linf_intersect<TR, TS, D, DELTA>(aes, 
+                                              receiverSparsePointsVec, 
+                                              *receiver_in_values, 
+                                              senderSparsePointsVec, 
+                                              *sender_in_values, 
+                                              expected_intersec);
+    REQUIRE(expected_intersec.size() >= min_num_matching_pts);
+
+    delete senderSparsePoints;
+    delete receiverSparsePoints;
+    delete sender_in_values;
+    delete receiver_in_values;
+    delete snder_out_shares;
+    delete rcvr_out_shares;
+
+    REQUIRE(intersec == single_shot_intersec);
+    REQUIRE(intersec == expected_intersec);
+}
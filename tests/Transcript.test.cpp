@@ -0,0 +1,190 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_string.hpp"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "coproto/Socket/Socket.h"
+#include "./support/EmulatedNetwork.h"
+#include "./support/GroundTruth.h"
+#include "./support/TempPath.h"
+#include "./support/Transcript.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "../sparseComp/Common/Common.h"
+#include "../sparseComp/FuzzyL1/FuzzyL1.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using sparse_comp::point;
+
+using PRNG = osuCrypto::PRNG;
+using osuCrypto::block;
+using AES = osuCrypto::AES;
+
+using sparse_comp::bench::EmulatedNetwork;
+using sparse_comp::bench::LinkMessage;
+using sparse_comp::bench::NetworkProfile;
+using sparse_comp::bench::ReplayStream;
+using sparse_comp::bench::TempPath;
+using sparse_comp::bench::Transcript;
+using sparse_comp::bench::is_intersec_correct;
+
+using macoro::sync_wait;
+using macoro::when_all_ready;
+
+namespace {
+
+    constexpr size_t TS = 10;
+    constexpr size_t TR = 10;
+    constexpr size_t D = 2;
+    constexpr uint8_t DELTA = 10;
+    constexpr uint8_t SSP = 40;
+    constexpr size_t MATCHES = 3;
+
+    const block SENDER_SEED = block(742130310438916676ULL, 11803924226990735076ULL);
+    const block RECEIVER_SEED = block(2457938039974938056ULL, 17910068785450354990ULL);
+    const block AES_KEY = block(14034463513942181890ULL, 16276202269246990858ULL);
+
+    using Sender = sparse_comp::fuzzy_l1::Sender<TR, TS, D, DELTA, SSP>;
+    using Receiver = sparse_comp::fuzzy_l1::Receiver<TS, TR, D, DELTA, SSP>;
+
+    struct Inputs {
+        std::array<point,TS> senderPoints;
+        std::array<point,TR> receiverPoints;
+
+        explicit Inputs(block seed) {
+            PRNG prng(seed);
+            uint32_t c[D];
+
+            for (size_t i = 0; i < TS; i++) {
+                for (size_t j = 0; j < D; j++) c[j] = (uint32_t) (2 * DELTA + prng.get<uint64_t>() % (((uint64_t) 1 << 32) - 4 * DELTA));
+                this->senderPoints[i] = point(D, c);
+            }
+
+            for (size_t i = 0; i < TR; i++) {
+                for (size_t j = 0; j < D; j++) c[j] = (uint32_t) (2 * DELTA + prng.get<uint64_t>() % (((uint64_t) 1 << 32) - 4 * DELTA));
+                this->receiverPoints[i] = point(D, c);
+            }
+
+            for (size_t i = 0; i < MATCHES; i++) {
+                this->senderPoints[i] = this->receiverPoints[i * (TR / MATCHES)];
+                this->senderPoints[i][0] += DELTA / 2;
+            }
+        }
+    };
+
+    // Runs both parties over an EmulatedNetwork pair and returns the messages of the run
+    Transcript record(Inputs& inputs, block sender_seed, std::vector<point>& intersec) {
+        Transcript transcript;
+        PRNG senderPRNG(sender_seed);
+        PRNG receiverPRNG(RECEIVER_SEED);
+        AES aes(AES_KEY);
+
+        EmulatedNetwork net(NetworkProfile::loopback());
+        net.record(&transcript.messages);
+
+        {
+            auto socks = net.makePair();
+
+            Sender sender(senderPRNG, aes);
+            Receiver receiver(receiverPRNG, aes);
+
+            auto r = sync_wait(when_all_ready(sender.send(socks[0], inputs.senderPoints),
+                                              receiver.receive(socks[1], inputs.receiverPoints, intersec)));
+            std::get<0>(r).result();
+            std::get<1>(r).result();
+        }
+
+        net.record(nullptr);
+
+        return transcript;
+    }
+
+    std::vector<uint8_t> sent_by(const Transcript& transcript, uint8_t party) {
+        std::vector<uint8_t> bytes;
+
+        for (const LinkMessage& message : transcript.messages) {
+            if (message.from == party) bytes.insert(bytes.end(), message.data.begin(), message.data.end());
+        }
+
+        return bytes;
+    }
+
+    void replay_sender(const Transcript& transcript, Inputs& inputs, block sender_seed) {
+        PRNG senderPRNG(sender_seed);
+        AES aes(AES_KEY);
+        Sender sender(senderPRNG, aes);
+
+        ReplayStream stream(transcript, 0);
+        coproto::Socket sock = stream.socket();
+
+        stream.replay(sender.send(sock, inputs.senderPoints), "sender");
+    }
+
+}
+
+TEST_CASE("Transcript : a recorded run replays, and a changed party reports where it diverged","[transcript]")
+{
+    Inputs inputs(block(9536629126107612350ULL, 2721317164341290561ULL));
+    std::vector<point> recorded_intersec;
+
+    TempPath path("fuzzy_l1.transcript");
+    record(inputs, SENDER_SEED, recorded_intersec).save(path.str());
+
+    const Transcript transcript = Transcript::load(path.str());
+
+    // Each party alone, with the seeds of the recording, sends exactly its recorded messages
+    replay_sender(transcript, inputs, SENDER_SEED);
+
+    {
+        PRNG receiverPRNG(RECEIVER_SEED);
+        AES aes(AES_KEY);
+        Receiver receiver(receiverPRNG, aes);
+        std::vector<point> intersec;
+
+        ReplayStream stream(transcript, 1);
+        coproto::Socket sock = stream.socket();
+
+        stream.replay(receiver.receive(sock, inputs.receiverPoints, intersec), "receiver");
+
+        REQUIRE(recorded_intersec.size() == MATCHES);
+        REQUIRE(is_intersec_correct(intersec, recorded_intersec));
+    }
+
+    // With another seed, the sender's sends first differ from the recorded ones where those of a run recorded with
+    // that seed do
+    const block other_seed = SENDER_SEED ^ block(0, 1);
+    std::vector<point> other_intersec;
+
+    const std::vector<uint8_t> recorded = sent_by(transcript, 0);
+    const std::vector<uint8_t> changed = sent_by(record(inputs, other_seed, other_intersec), 0);
+
+    const size_t common = std::min(recorded.size(), changed.size());
+    const size_t offset = (size_t) (std::mismatch(recorded.begin(), recorded.begin() + common, changed.begin()).first - recorded.begin());
+
+    REQUIRE(offset < recorded.size());
+
+    REQUIRE_THROWS_WITH(replay_sender(transcript, inputs, other_seed),
+                        Catch::Matchers::ContainsSubstring("the sender diverged from the transcript at byte " + std::to_string(offset) + " of its sends"));
+}
+
+TEST_CASE("Transcript : malformed transcripts are rejected","[transcript]")
+{
+    TempPath path("bad.transcript");
+
+    REQUIRE_THROWS_AS(Transcript::load(path.str()), std::runtime_error);
+
+    Transcript transcript;
+    transcript.messages.push_back(LinkMessage{0, std::vector<uint8_t>(100, 7)});
+    transcript.save(path.str());
+
+    REQUIRE(Transcript::load(path.str()).messages.size() == 1);
+
+    std::filesystem::resize_file(path.str(), std::filesystem::file_size(path.str()) - 1);
+    REQUIRE_THROWS_AS(Transcript::load(path.str()), std::runtime_error);
+}
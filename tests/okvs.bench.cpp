@@ -3,6 +3,7 @@
 #include "cryptoTools/Common/block.h"
 #include "volePSI/Paxos.h"
 #include "../sparseComp/Common/BaxosUtils.h"
+#include "./support/PerfCounters.h"
 
 using osuCrypto::block;
 using osuCrypto::PRNG;
@@ -33,7 +34,7 @@ static void gen_decode_keys(vector<block>& keys, size_t n) {
 }
 
 
-static size_t baxos_enc_dec(vector<block>& keys, vector<block>& vals, vector<block>& decoded_keys, size_t ssp) {
+static size_t baxos_enc_dec(vector<block>& keys, vector<block>& vals, vector<block>& decoded_keys, size_t ssp, sparse_comp::bench::PerfReport& perf) {
     std::vector<block>* okvs = new std::vector<block>();
     size_t n_encd_items = keys.size();
 
@@ -42,14 +43,20 @@ static size_t baxos_enc_dec(vector<block>& keys, vector<block>& vals, vector<blo
     
     okvs->resize(senderPaxos.size());
 
-    senderPaxos.solve<block>(keys, vals, *okvs, nullptr, 1);
+    {
+        sparse_comp::bench::PerfScope encode(perf, "okvs.encode");
+        senderPaxos.solve<block>(keys, vals, *okvs, nullptr, 1);
+    }
 
     Baxos receiverPaxos;
     receiverPaxos.init(n_encd_items, sparse_comp::baxosBinSize(n_encd_items), 3, ssp, PaxosParam::GF128, oc::ZeroBlock);
     
     vector<block>* decoded_vals = new vector<block>(decoded_keys.size());
 
-    receiverPaxos.decode<block>(decoded_keys, *decoded_vals, *okvs);
+    {
+        sparse_comp::bench::PerfScope decode(perf, "okvs.decode");
+        receiverPaxos.decode<block>(decoded_keys, *decoded_vals, *okvs);
+    }
 
     size_t okvs_size = okvs->size();
 
@@ -66,11 +73,15 @@ static size_t bench_baxos_enc_dec(Catch::Benchmark::Chronometer meter, size_t n_
     gen_decode_keys(*decoded_keys, n_decoded_items);
 
     size_t paxos_size;
+    sparse_comp::bench::PerfReport perf;
 
-    meter.measure([keys, vals, decoded_keys, &paxos_size, ssp] {
-        paxos_size = baxos_enc_dec(*keys, *vals, *decoded_keys, ssp);
+    meter.measure([keys, vals, decoded_keys, &paxos_size, ssp, &perf] {
+        paxos_size = baxos_enc_dec(*keys, *vals, *decoded_keys, ssp, perf);
     });
 
+    sparse_comp::bench::print_perf_phase("okvs.encode", perf["okvs.encode"], n_encd_items);
+    sparse_comp::bench::print_perf_phase("okvs.decode", perf["okvs.decode"], n_decoded_items);
+
     delete keys;
     delete vals;
     delete decoded_keys;
@@ -1,10 +1,14 @@
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/benchmark/catch_benchmark.hpp"
 #include "../sparseComp/MultiOPRF/MultiOPRF.h"
+#include "../sparseComp/MultiOPRF/OtPool.h"
+#include "../sparseComp/CustomOPRF/CustomizedOPRF.h"
 #include "coproto/Socket/Socket.h"
 #include "cryptoTools/Common/block.h"
 #include <vector>
 #include <cmath>
+#include <filesystem>
+#include <string>
 #include <iostream>
 
 using std::pow;
@@ -16,10 +20,16 @@ using macoro::when_all_ready;
 
 using namespace sparse_comp::multi_oprf;
 
+using OprfBackend = sparse_comp::custom_oprf::OprfBackend;
+using CustomOprfSender = sparse_comp::custom_oprf::Sender;
+using CustomOprfReceiver = sparse_comp::custom_oprf::Receiver;
+using oprf_point = sparse_comp::custom_oprf::oprf_point;
+
 double bench_oprf(Catch::Benchmark::Chronometer meter, 
                 size_t n_oprf_instances, 
                 vector<size_t> n_qs, 
-                vector<size_t> n_es) {
+                vector<size_t> n_es,
+                bool session_setup = true) {
 
     assert(n_qs.size() == n_oprf_instances && n_es.size() == n_oprf_instances);
 
@@ -49,12 +59,26 @@ double bench_oprf(Catch::Benchmark::Chronometer meter,
 
     vector<Sender*> senders(n_oprf_instances);
     vector<Receiver*> receivers(n_oprf_instances);
+    vector<Sender*> rev_senders(n_oprf_instances); // Reverse direction instances of a session setup, unused here
+    vector<Receiver*> rev_receivers(n_oprf_instances);
+
+    meter.measure([n_oprf_instances, session_setup, &n_es, &n_qs, &socks, &senders, &receivers, &rev_senders, &rev_receivers, &senderPRNG, &receiverPRNG, &qpts, &qvals, &epts, &evals] {
+        if (session_setup) {
+            Proto sender_setup = setup_session(socks[0], senderPRNG, true, n_oprf_instances, senders, rev_receivers);
+            Proto receiver_setup = setup_session(socks[1], receiverPRNG, false, n_oprf_instances, rev_senders, receivers);
 
-    meter.measure([n_oprf_instances, &n_es, &n_qs, &socks, &senders, &receivers, &senderPRNG, &receiverPRNG, &qpts, &qvals, &epts, &evals] {
-        Proto sender_setup = Sender::setup(socks[0], senderPRNG, n_oprf_instances, senders);
-        Proto receiver_setup = Receiver::setup(socks[1], receiverPRNG, n_oprf_instances, receivers);
+            sync_wait(when_all_ready(sender_setup, receiver_setup));
 
-        sync_wait(when_all_ready(sender_setup, receiver_setup));
+            for (size_t i = 0; i < n_oprf_instances; i++) {
+                delete rev_senders[i];
+                delete rev_receivers[i];
+            }
+        } else {
+            Proto sender_setup = Sender::setup(socks[0], senderPRNG, n_oprf_instances, senders);
+            Proto receiver_setup = Receiver::setup(socks[1], receiverPRNG, n_oprf_instances, receivers);
+
+            sync_wait(when_all_ready(sender_setup, receiver_setup));
+        }
 
         for (size_t i = 0; i < n_oprf_instances; i++) {
             auto p1 = senders[i]->send(socks[0], n_qs[i]);
@@ -80,6 +104,184 @@ double bench_oprf(Catch::Benchmark::Chronometer meter,
     return nMBsExchanged;
 }
 
+// Setup, one query run and the sender evaluation of a custom_oprf session, with the same query and
+// evaluation counts as the multi_oprf cases below.
+double bench_custom_oprf(Catch::Benchmark::Chronometer meter, OprfBackend backend, size_t set_size, size_t d) {
+    const size_t n_oprf_instances = 2;
+    const size_t two_to_d = pow(2,d);
+    const vector<size_t> n_qs = {set_size*d, set_size};
+    const vector<size_t> n_es = {set_size*two_to_d*d, set_size*two_to_d};
+
+    auto socks = LocalAsyncSocket::makePair();
+    PRNG senderPRNG = PRNG(block(742130310438916676ULL, 11803924226990735076ULL));
+    PRNG receiverPRNG = PRNG(block(2457938039974938056ULL, 17910068785450354990ULL));
+
+    vector<vector<oprf_point>*> qpts(n_oprf_instances);
+    vector<vector<block>*> qvals(n_oprf_instances);
+    vector<vector<block>*> epts(n_oprf_instances);
+    vector<vector<block>*> evals(n_oprf_instances);
+
+    for (size_t i = 0; i < n_oprf_instances; i++) {
+        qpts[i] = new vector<oprf_point>(n_qs[i]);
+        qvals[i] = new vector<block>(n_qs[i]);
+        epts[i] = new vector<block>(n_es[i]);
+        evals[i] = new vector<block>(n_es[i]);
+
+        for (size_t j = 0; j < n_qs[i]; j++) {
+            qpts[i]->at(j) = oprf_point(receiverPRNG.get<block>(), 0, 0);
+        }
+
+        for (size_t j = 0; j < n_es[i]; j++) {
+            epts[i]->at(j) = senderPRNG.get<block>();
+        }
+    }
+
+    vector<CustomOprfSender*> senders[2] = {vector<CustomOprfSender*>(n_oprf_instances), vector<CustomOprfSender*>(n_oprf_instances)};
+    vector<CustomOprfReceiver*> receivers[2] = {vector<CustomOprfReceiver*>(n_oprf_instances), vector<CustomOprfReceiver*>(n_oprf_instances)};
+
+    meter.measure([n_oprf_instances, backend, &n_qs, &socks, &senders, &receivers, &senderPRNG, &receiverPRNG, &qpts, &qvals, &epts, &evals] {
+        sync_wait(when_all_ready(sparse_comp::custom_oprf::setup_session(socks[0], senderPRNG, true, n_oprf_instances, senders[0], receivers[0], OtExtConfig(), backend),
+                                 sparse_comp::custom_oprf::setup_session(socks[1], receiverPRNG, false, n_oprf_instances, senders[1], receivers[1], OtExtConfig(), backend)));
+
+        for (size_t i = 0; i < n_oprf_instances; i++) {
+            auto p1 = senders[0][i]->send(socks[0], n_qs[i]);
+            auto p2 = receivers[1][i]->receive(socks[1], n_qs[i], *qpts[i], *qvals[i]);
+
+            sync_wait(when_all_ready(p1, p2));
+
+            senders[0][i]->eval(*epts[i], 1, *evals[i]);
+        }
+
+        for (size_t p = 0; p < 2; p++) {
+            for (size_t i = 0; i < n_oprf_instances; i++) {
+                delete senders[p][i];
+                delete receivers[p][i];
+            }
+        }
+    });
+
+    const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()))/1024.0/1024.0/meter.runs();
+
+    for (size_t i = 0; i < n_oprf_instances; i++) {
+        delete qpts[i];
+        delete qvals[i];
+        delete epts[i];
+        delete evals[i];
+    }
+
+    return nMBsExchanged;
+}
+
+// Session setup latency. A cold setup runs base OTs and OT extension with the given backend, a warm
+// one takes its OTs from pools created ahead of the measurement.
+double bench_session_setup(Catch::Benchmark::Chronometer meter, size_t n_oprf_instances, bool warm, OtExtConfig otExt = OtExtConfig()) {
+    auto socks = LocalAsyncSocket::makePair();
+    PRNG senderPRNG = PRNG(block(742130310438916676ULL, 11803924226990735076ULL));
+    PRNG receiverPRNG = PRNG(block(2457938039974938056ULL, 17910068785450354990ULL));
+
+    const std::string leader_path = (std::filesystem::temp_directory_path() / "sparse_comp_leader.otpool").string();
+    const std::string follower_path = (std::filesystem::temp_directory_path() / "sparse_comp_follower.otpool").string();
+
+    OtPool* leader_pool = nullptr;
+    OtPool* follower_pool = nullptr;
+
+    if (warm) {
+        size_t pool_size = meter.runs() * ell * n_oprf_instances;
+
+        sync_wait(when_all_ready(OtPool::create(socks[0], senderPRNG, true, pool_size, leader_path),
+                                 OtPool::create(socks[1], receiverPRNG, false, pool_size, follower_path)));
+
+        leader_pool = OtPool::open(leader_path);
+        follower_pool = OtPool::open(follower_path);
+    }
+
+    const size_t pool_creation_bytes = socks[0].bytesSent() + socks[0].bytesReceived();
+
+    vector<Sender*> senders[2] = {vector<Sender*>(n_oprf_instances), vector<Sender*>(n_oprf_instances)};
+    vector<Receiver*> receivers[2] = {vector<Receiver*>(n_oprf_instances), vector<Receiver*>(n_oprf_instances)};
+
+    meter.measure([n_oprf_instances, warm, otExt, &socks, &senders, &receivers, &senderPRNG, &receiverPRNG, leader_pool, follower_pool] {
+        if (warm) {
+            sync_wait(when_all_ready(setup_session(socks[0], *leader_pool, n_oprf_instances, senders[0], receivers[0]),
+                                     setup_session(socks[1], *follower_pool, n_oprf_instances, senders[1], receivers[1])));
+        } else {
+            sync_wait(when_all_ready(setup_session(socks[0], senderPRNG, true, n_oprf_instances, senders[0], receivers[0], otExt),
+                                     setup_session(socks[1], receiverPRNG, false, n_oprf_instances, senders[1], receivers[1], otExt)));
+        }
+
+        for (size_t p = 0; p < 2; p++) {
+            for (size_t i = 0; i < n_oprf_instances; i++) {
+                delete senders[p][i];
+                delete receivers[p][i];
+            }
+        }
+    });
+
+    const double nMBsExchanged = ((double)(socks[0].bytesSent()+socks[0].bytesReceived()-pool_creation_bytes))/1024.0/1024.0/meter.runs();
+
+    if (warm) {
+        delete leader_pool;
+        delete follower_pool;
+
+        for (const std::string& path : {leader_path, follower_path}) {
+            std::filesystem::remove(path);
+            std::filesystem::remove(path + ".cursor");
+        }
+    }
+
+    return nMBsExchanged;
+}
+
+TEST_CASE("session setup, cold", "[oprf][setup][cold]") {
+    double nMBsExchanged = -1;
+
+    BENCHMARK_ADVANCED("session setup, cold")(Catch::Benchmark::Chronometer meter) {
+        nMBsExchanged = bench_session_setup(meter, 2, false);
+    };
+
+    std::cout << "Number of MBs exchanged per setup: " << nMBsExchanged << std::endl;
+}
+
+TEST_CASE("session setup, warm", "[oprf][setup][warm]") {
+    double nMBsExchanged = -1;
+
+    BENCHMARK_ADVANCED("session setup, warm")(Catch::Benchmark::Chronometer meter) {
+        nMBsExchanged = bench_session_setup(meter, 2, true);
+    };
+
+    std::cout << "Number of MBs exchanged per setup: " << nMBsExchanged << std::endl;
+}
+
+// Cold session setup for each OT extension backend enabled in libOTe
+void bench_backend_setup(OtExtConfig otExt, const std::string& name) {
+    if (!ot_ext_backend_available(otExt.backend)) {
+        WARN(name << " is not enabled in libOTe, skipping");
+        return;
+    }
+
+    double nMBsExchanged = -1;
+
+    BENCHMARK_ADVANCED(name)(Catch::Benchmark::Chronometer meter) {
+        nMBsExchanged = bench_session_setup(meter, 2, false, otExt);
+    };
+
+    std::cout << name << ", number of MBs exchanged per setup: " << nMBsExchanged << std::endl;
+}
+
+TEST_CASE("session setup, kos", "[oprf][setup][backend][kos]") {
+    bench_backend_setup(OtExtConfig(OtExtBackend::Kos), "session setup, kos");
+}
+
+TEST_CASE("session setup, iknp", "[oprf][setup][backend][iknp]") {
+    bench_backend_setup(OtExtConfig(OtExtBackend::Iknp), "session setup, iknp");
+}
+
+TEST_CASE("session setup, softspoken", "[oprf][setup][backend][softspoken]") {
+    for (size_t field_bits : {2, 4, 8}) {
+        bench_backend_setup(OtExtConfig(OtExtBackend::SoftSpoken, field_bits), "session setup, softspoken k=" + std::to_string(field_bits));
+    }
+}
+
 TEST_CASE("oprf (n=1, q=1, e=1)", "[oprf][n=1][q=1][e=1]") {
     BENCHMARK_ADVANCED("n=1, q=1, e=1")(Catch::Benchmark::Chronometer meter) {
         size_t n_oprf_instances = 1;
@@ -111,6 +313,25 @@ TEST_CASE("nA=nB=2^8, d=2", "[oprf][nA=nB=2^8][d=2]") {
     std::cout << "Number of MBs exchanged: " << nMBsExchanged << std::endl;
 }
 
+TEST_CASE("nA=nB=2^8, d=2, separate setups", "[oprf][nA=nB=2^8][d=2][separate-setups]") {
+    double nMBsExchanged = -1;
+    
+    BENCHMARK_ADVANCED("nA=nB=2^8, d=2, separate setups")(Catch::Benchmark::Chronometer meter) {
+        size_t set_size = 256;
+        size_t d = 2;
+
+        size_t two_to_d = pow(2,d);
+        size_t n_oprf_instances = 2;
+        vector<size_t> n_qs = {set_size*d, set_size};
+        vector<size_t> n_es = {set_size*two_to_d*d, set_size*two_to_d};
+
+        nMBsExchanged = bench_oprf(meter, n_oprf_instances, n_qs, n_es, false);
+
+    };
+
+    std::cout << "Number of MBs exchanged: " << nMBsExchanged << std::endl;
+}
+
 TEST_CASE("nA=nB=2^8, d=6", "[oprf][nA=nB=2^8][d=6]") {
     double nMBsExchanged = -1;
 
@@ -268,3 +489,18 @@ TEST_CASE("nA=nB=2^16, d=10", "[oprf][nA=nB=2^16][d=10]") {
 
     std::cout << "Number of MBs exchanged: " << nMBsExchanged << std::endl;
 }
+
+TEST_CASE("custom oprf backends, d=2", "[oprf][custom-oprf][d=2]") {
+    for (size_t set_size : {256, 4096, 65536}) {
+        for (OprfBackend backend : {OprfBackend::MultiOprf, OprfBackend::RsOprf}) {
+            const std::string name = std::string(backend == OprfBackend::RsOprf ? "rs-oprf" : "multi-oprf") + ", n=" + std::to_string(set_size) + ", d=2";
+            double nMBsExchanged = -1;
+
+            BENCHMARK_ADVANCED(name)(Catch::Benchmark::Chronometer meter) {
+                nMBsExchanged = bench_custom_oprf(meter, backend, set_size, 2);
+            };
+
+            std::cout << name << ", number of MBs exchanged per run: " << nMBsExchanged << std::endl;
+        }
+    }
+}
@@ -0,0 +1,15 @@
+#include "./Parallel.h"
+#include "../../sparseComp/FuzzyLinf/FuzzyLinf.h"
+
+using osuCrypto::block;
+using sparse_comp::bench::Metric;
+
+TEST_CASE("fuzzy_parallel linf (n=m=2^16 d=2 delta=10 ssp=40)", "[fuzzy_parallel][fuzzylinf][n=m=2^16]") {
+    sparse_comp::bench::bench_parallel<Metric::Linf, sparse_comp::fuzzy_linf::Sender, sparse_comp::fuzzy_linf::Receiver, 2, 10, 40>(
+        size_t(1) << 16, block(9536629026107651350ULL, 2724119864341290560ULL));
+}
+
+TEST_CASE("fuzzy_parallel linf (n=m=2^18 d=2 delta=10 ssp=40)", "[fuzzy_parallel][fuzzylinf][n=m=2^18]") {
+    sparse_comp::bench::bench_parallel<Metric::Linf, sparse_comp::fuzzy_linf::Sender, sparse_comp::fuzzy_linf::Receiver, 2, 10, 40>(
+        size_t(1) << 18, block(15356386812547896003ULL, 6761862989666286475ULL));
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "cryptoTools/Common/block.h"
+#include "coproto/Socket/LocalAsyncSock.h"
+#include "../support/TwoPartyBench.h"
+#include "../support/GroundTruth.h"
+#include "../support/Workloads.h"
+#include "../../sparseComp/Common/Common.h"
+#include "../../sparseComp/FuzzyParallel/FuzzyParallel.h"
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Core scaling benchmark of the partition parallel mode (see FuzzyParallel.h). Every protocol has its own
+// translation unit, <Protocol>.parallel.cpp, since the protocol implementations cannot share one. Each
+// benchmark runs the same inputs on 1, 2, 4 and 8 partitions, one worker thread per partition and party,
+// skipping the partition counts above the number of cores. The output is checked against GroundTruth.h.
+
+namespace sparse_comp::bench {
+
+    constexpr size_t PARALLEL_MEMORY_BUDGET = size_t(16) << 30;
+    constexpr size_t PARALLEL_BATCH = size_t(1) << 12;
+
+    template<Metric metric,
+             template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+             template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+             size_t d, uint8_t delta, uint8_t ssp>
+    void bench_parallel(size_t n, osuCrypto::block seed) {
+        for (size_t partitions : {1, 2, 4, 8}) {
+            if (partitions > std::max(1u, std::thread::hardware_concurrency())) continue;
+
+            const std::string name = "n=m=2^" + std::to_string(std::bit_width(n) - 1) + " d=" + std::to_string(d) +
+                                     " delta=" + std::to_string(delta) + " partitions=" + std::to_string(partitions);
+
+            BENCHMARK_ADVANCED(name.c_str())(Catch::Benchmark::Chronometer meter) {
+                auto socks = coproto::LocalAsyncSocket::makePair();
+                osuCrypto::PRNG senderPRNG = osuCrypto::PRNG(osuCrypto::block(15914074867899273501ULL, 6004108516319388444ULL));
+                osuCrypto::PRNG receiverPRNG = osuCrypto::PRNG(osuCrypto::block(6427781726132732903ULL, 8471345356057289138ULL));
+                osuCrypto::AES aes = osuCrypto::AES(osuCrypto::block(14034463513942181890ULL, 16276202269246990858ULL));
+
+                std::vector<point> senderPoints(n);
+                std::vector<point> receiverPoints(n);
+                std::vector<point> intersec;
+
+                load_or_gen_workload(Workload::Uniform, seed, {d, delta, 29}, receiverPoints, senderPoints);
+
+                sparse_comp::fuzzy_parallel::Sender<FuzzySender, PARALLEL_BATCH, PARALLEL_BATCH, d, delta, ssp> parallelSender(senderPRNG, aes, partitions, PARALLEL_MEMORY_BUDGET);
+                sparse_comp::fuzzy_parallel::Receiver<FuzzyReceiver, PARALLEL_BATCH, PARALLEL_BATCH, d, delta, ssp> parallelRecvr(receiverPRNG, aes, partitions, PARALLEL_MEMORY_BUDGET);
+
+                auto parties = measure_parties(meter, socks,
+                    [&](coproto::Socket& sock) { return parallelSender.send(sock, senderPoints); },
+                    [&](coproto::Socket& sock) { return parallelRecvr.receive(sock, receiverPoints, intersec); }, intersec);
+
+                std::vector<point> expected_intersec;
+
+                expected_intersect<metric>(receiverPoints, senderPoints, d, delta, expected_intersec);
+
+                REQUIRE(is_intersec_correct(intersec, expected_intersec));
+
+                const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0;
+
+                SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+                print_perf(parties.perf, 2 * n);
+            };
+        }
+    }
+
+};
@@ -0,0 +1,262 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "cryptoTools/Common/block.h"
+#include "./support/Affinity.h"
+#include "../sparseComp/Common/Common.h"
+#include "../sparseComp/Common/HashUtils.h"
+#include "../sparseComp/Common/BlockUtils.h"
+#include "../sparseComp/SpBSOT/SpBSOT.h"
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Per item primitives whose cost scales with the number of points or cells, for d = 1..10 and 2^8 to 2^22 items,
+// on a single pinned core (see support/Affinity.h). Next to the Catch2 timings every benchmark prints its
+// throughput, in items and in bytes read and written per second. spatial_cell_hash is limited to 2^22 cells.
+
+using PRNG = osuCrypto::PRNG;
+using osuCrypto::block;
+using AES = osuCrypto::AES;
+using sparse_comp::point;
+
+namespace {
+
+    constexpr size_t MAX_CELLS = size_t(1) << 22;
+
+    template<size_t... Vs, typename F>
+    void for_each_value(F&& f) {
+        (f(std::integral_constant<size_t, Vs>{}), ...);
+    }
+
+    template<typename F>
+    void for_each_log_size(F&& f) {
+        for_each_value<8, 12, 16, 20, 22>(f);
+    }
+
+    template<typename F>
+    void for_each_dim(F&& f) {
+        for_each_value<1, 2, 3, 4, 5, 6, 7, 8, 9, 10>(f);
+    }
+
+    // Times fn inside the Catch2 measurement, then prints the throughput over all the calls Catch2 made.
+    template<typename Fn>
+    void measure_throughput(Catch::Benchmark::Chronometer& meter, const std::string& name, size_t items, size_t bytes, Fn fn) {
+        uint64_t elapsed_ns = 0;
+        uint64_t calls = 0;
+
+        meter.measure([&] {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            elapsed_ns += (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            calls++;
+        });
+
+        if (elapsed_ns == 0) return;
+
+        const double seconds = elapsed_ns / 1e9;
+        std::printf("Throughput %-40s items/s: %12.4e MBs/s: %10.1f\n", name.c_str(),
+                    (double) (items * calls) / seconds, (double) (bytes * calls) / 1024.0 / 1024.0 / seconds);
+    }
+
+    template<size_t t>
+    std::array<point, t>* gen_points(size_t d) {
+        PRNG prng = PRNG(block(9536629026107651350ULL, 2724119864341290560ULL));
+        std::array<point, t>* points = new std::array<point, t>();
+
+        for (size_t i = 0; i < t; i++) {
+            (*points)[i].coord_dim = (uint8_t) d;
+            for (size_t j = 0; j < d; j++) (*points)[i].coords[j] = prng.get<uint32_t>();
+        }
+
+        return points;
+    }
+
+    std::vector<block> gen_blocks(size_t n, block seed) {
+        PRNG prng = PRNG(seed);
+        std::vector<block> blocks(n);
+
+        for (size_t i = 0; i < n; i++) blocks[i] = prng.get<block>();
+
+        return blocks;
+    }
+
+    std::string params(size_t n, size_t d) {
+        return "n=" + std::to_string(n) + " d=" + std::to_string(d);
+    }
+
+    const AES hasher = AES(block(14034463513942181890ULL, 16276202269246990858ULL));
+
+};
+
+TEST_CASE("hash_points", "[primitives][hash_points]") {
+    sparse_comp::bench::pin_to_core();
+
+    for_each_log_size([](auto log_t) {
+        constexpr size_t t = size_t(1) << decltype(log_t)::value;
+        const std::string name = "hash_points n=" + std::to_string(t);
+
+        BENCHMARK_ADVANCED(name.c_str())(Catch::Benchmark::Chronometer meter) {
+            std::array<point, t>* points = gen_points<t>(point::MAX_DIM);
+            std::vector<point> point_vec(points->begin(), points->end());
+            std::vector<block> hashes;
+
+            measure_throughput(meter, name, t, t * (sizeof(uint32_t) * point::MAX_DIM + sizeof(block)), [&] {
+                sparse_comp::hash_points<t>(hasher, point_vec, hashes);
+            });
+
+            delete points;
+        };
+    });
+}
+
+TEST_CASE("spatial_hash", "[primitives][spatial_hash]") {
+    sparse_comp::bench::pin_to_core();
+
+    for_each_log_size([](auto log_t) {
+        constexpr size_t t = size_t(1) << decltype(log_t)::value;
+
+        for_each_dim([](auto dim) {
+            constexpr size_t d = decltype(dim)::value;
+            const std::string name = "spatial_hash " + params(t, d);
+
+            BENCHMARK_ADVANCED(name.c_str())(Catch::Benchmark::Chronometer meter) {
+                std::array<point, t>* points = gen_points<t>(d);
+                std::vector<block> hashes;
+
+                measure_throughput(meter, name, t, t * (sizeof(uint32_t) * d + sizeof(block)), [&] {
+                    sparse_comp::spatial_hash<t>(hasher, *points, hashes, d, 10);
+                });
+
+                delete points;
+            };
+        });
+    });
+}
+
+TEST_CASE("spatial_cell_hash", "[primitives][spatial_cell_hash]") {
+    sparse_comp::bench::pin_to_core();
+
+    for_each_log_size([](auto log_t) {
+        constexpr size_t t = size_t(1) << decltype(log_t)::value;
+
+        for_each_dim([](auto dim) {
+            constexpr size_t d = decltype(dim)::value;
+            constexpr size_t cells = (size_t(1) << d) * t;
+
+            if constexpr (cells <= MAX_CELLS) {
+                const std::string name = "spatial_cell_hash " + params(t, d);
+
+                BENCHMARK_ADVANCED(name.c_str())(Catch::Benchmark::Chronometer meter) {
+                    std::array<point, t>* points = gen_points<t>(d);
+                    std::vector<block> cell_hashes(cells);
+
+                    measure_throughput(meter, name, cells, t * sizeof(uint32_t) * d + cells * sizeof(block), [&] {
+                        sparse_comp::spatial_cell_hash<t, d, cells>(hasher, *points, cell_hashes, 10);
+                    });
+
+                    delete points;
+                };
+            }
+        });
+    });
+}
+
+TEST_CASE("points_to_blocks", "[primitives][points_to_blocks]") {
+    sparse_comp::bench::pin_to_core();
+
+    for_each_log_size([](auto log_t) {
+        constexpr size_t t = size_t(1) << decltype(log_t)::value;
+
+        for_each_dim([](auto dim) {
+            constexpr size_t d = decltype(dim)::value;
+            const size_t bytes = 2 * t * sparse_comp::point_encoding_block_count(d) * sizeof(block);
+            const std::string to_blocks = "points_to_blocks " + params(t, d);
+            const std::string to_points = "blocks_to_points " + params(t, d);
+
+            BENCHMARK_ADVANCED(to_blocks.c_str())(Catch::Benchmark::Chronometer meter) {
+                std::array<point, t>* points = gen_points<t>(d);
+                std::vector<block> blocks;
+
+                measure_throughput(meter, to_blocks, t, bytes, [&] {
+                    sparse_comp::points_to_blocks<t, d>(*points, blocks);
+                });
+
+                delete points;
+            };
+
+            BENCHMARK_ADVANCED(to_points.c_str())(Catch::Benchmark::Chronometer meter) {
+                std::array<point, t>* points = gen_points<t>(d);
+                std::vector<block> blocks;
+                sparse_comp::points_to_blocks<t, d>(*points, blocks);
+
+                measure_throughput(meter, to_points, t, bytes, [&] {
+                    sparse_comp::blocks_to_points<t, d>(blocks, *points);
+                });
+
+                delete points;
+            };
+        });
+    });
+}
+
+// The OKVS truncation of SpBSOT keeps ceil(log2(M)) bits per cell, with M = d*(delta+1)+1 as in SpL1 (delta=10).
+TEST_CASE("truncate_okvs", "[primitives][truncate_okvs]") {
+    sparse_comp::bench::pin_to_core();
+
+    for_each_log_size([](auto log_n) {
+        constexpr size_t n = size_t(1) << decltype(log_n)::value;
+
+        for_each_dim([](auto dim) {
+            constexpr size_t d = decltype(dim)::value;
+            const uint8_t nbits = (uint8_t) std::ceil(std::log2(d * (10 + 1) + 1));
+            const size_t packed_bytes = calc_compact_okvs_struct_size(n, nbits) * sizeof(uint64_t);
+            const std::string truncate = "truncate_okvs " + params(n, d);
+            const std::string reconstruct = "reconstruct_okvs " + params(n, d);
+
+            BENCHMARK_ADVANCED(truncate.c_str())(Catch::Benchmark::Chronometer meter) {
+                std::vector<block> okvs = gen_blocks(n, block(9537729726117351353ULL, 2724319864747298360ULL));
+
+                measure_throughput(meter, truncate, n, n * sizeof(block) + packed_bytes, [&] {
+                    delete truncate_okvs(okvs, nbits);
+                });
+            };
+
+            BENCHMARK_ADVANCED(reconstruct.c_str())(Catch::Benchmark::Chronometer meter) {
+                std::vector<block> okvs = gen_blocks(n, block(9537729726117351353ULL, 2724319864747298360ULL));
+                std::vector<uint64_t>* packed = truncate_okvs(okvs, nbits);
+
+                measure_throughput(meter, reconstruct, n, n * sizeof(block) + packed_bytes, [&] {
+                    reconstruct_okvs(*packed, nbits, okvs);
+                });
+
+                delete packed;
+            };
+        });
+    });
+}
+
+TEST_CASE("block_vec_xor", "[primitives][block_vec_xor]") {
+    sparse_comp::bench::pin_to_core();
+
+    for_each_log_size([](auto log_n) {
+        constexpr size_t n = size_t(1) << decltype(log_n)::value;
+        const std::string name = "block_vec_xor n=" + std::to_string(n);
+
+        BENCHMARK_ADVANCED(name.c_str())(Catch::Benchmark::Chronometer meter) {
+            std::vector<block> va = gen_blocks(n, block(9536629726117351353ULL, 2724349864741298565ULL));
+            std::vector<block> vb = gen_blocks(n, block(2724349864741298565ULL, 9536629726117351353ULL));
+            std::vector<block> vc(n);
+
+            measure_throughput(meter, name, n, 3 * n * sizeof(block), [&] {
+                sparse_comp::block_vec_xor(va, vb, vc);
+            });
+        };
+    });
+}
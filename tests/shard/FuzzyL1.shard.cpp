@@ -0,0 +1,26 @@
+#include "./Shard.h"
+#include "../../sparseComp/FuzzyL1/FuzzyL1.h"
+
+using osuCrypto::block;
+using sparse_comp::bench::Metric;
+using sparse_comp::bench::Workload;
+
+TEST_CASE("fuzzy_shard l1 uniform (n=m=2^18 d=2 delta=10 ssp=40)", "[fuzzy_shard][fuzzyl1][n=m=2^18]") {
+    sparse_comp::bench::bench_sharded<Metric::L1, sparse_comp::fuzzy_l1::Sender, sparse_comp::fuzzy_l1::Receiver, 2, 10, 40>(
+        Workload::Uniform, size_t(1) << 18, block(17586685423448ULL, 10379322751356ULL));
+}
+
+TEST_CASE("fuzzy_shard l1 uniform (n=m=2^20 d=2 delta=10 ssp=40)", "[fuzzy_shard][fuzzyl1][n=m=2^20]") {
+    sparse_comp::bench::bench_sharded<Metric::L1, sparse_comp::fuzzy_l1::Sender, sparse_comp::fuzzy_l1::Receiver, 2, 10, 40>(
+        Workload::Uniform, size_t(1) << 20, block(27143723132616ULL, 20076884131744ULL));
+}
+
+TEST_CASE("fuzzy_shard l1 clustered (n=m=2^18 d=2 delta=10 ssp=40)", "[fuzzy_shard][fuzzyl1][n=m=2^18]") {
+    sparse_comp::bench::bench_sharded<Metric::L1, sparse_comp::fuzzy_l1::Sender, sparse_comp::fuzzy_l1::Receiver, 2, 10, 40>(
+        Workload::Clustered, size_t(1) << 18, block(17630555042958ULL, 8987533338352ULL));
+}
+
+TEST_CASE("fuzzy_shard l1 clustered (n=m=2^20 d=2 delta=10 ssp=40)", "[fuzzy_shard][fuzzyl1][n=m=2^20]") {
+    sparse_comp::bench::bench_sharded<Metric::L1, sparse_comp::fuzzy_l1::Sender, sparse_comp::fuzzy_l1::Receiver, 2, 10, 40>(
+        Workload::Clustered, size_t(1) << 20, block(12583810817142ULL, 25030375173887ULL));
+}
@@ -0,0 +1,26 @@
+#include "./Shard.h"
+#include "../../sparseComp/FuzzyL2/FuzzyL2.h"
+
+using osuCrypto::block;
+using sparse_comp::bench::Metric;
+using sparse_comp::bench::Workload;
+
+TEST_CASE("fuzzy_shard l2 uniform (n=m=2^18 d=2 delta=10 ssp=40)", "[fuzzy_shard][fuzzyl2][n=m=2^18]") {
+    sparse_comp::bench::bench_sharded<Metric::L2, sparse_comp::fuzzy_l2::Sender, sparse_comp::fuzzy_l2::Receiver, 2, 10, 40>(
+        Workload::Uniform, size_t(1) << 18, block(17625434071784ULL, 27185926574916ULL));
+}
+
+TEST_CASE("fuzzy_shard l2 uniform (n=m=2^20 d=2 delta=10 ssp=40)", "[fuzzy_shard][fuzzyl2][n=m=2^20]") {
+    sparse_comp::bench::bench_sharded<Metric::L2, sparse_comp::fuzzy_l2::Sender, sparse_comp::fuzzy_l2::Receiver, 2, 10, 40>(
+        Workload::Uniform, size_t(1) << 20, block(14115442883358ULL, 22085830770840ULL));
+}
+
+TEST_CASE("fuzzy_shard l2 clustered (n=m=2^18 d=2 delta=10 ssp=40)", "[fuzzy_shard][fuzzyl2][n=m=2^18]") {
+    sparse_comp::bench::bench_sharded<Metric::L2, sparse_comp::fuzzy_l2::Sender, sparse_comp::fuzzy_l2::Receiver, 2, 10, 40>(
+        Workload::Clustered, size_t(1) << 18, block(24844090648950ULL, 31337298456413ULL));
+}
+
+TEST_CASE("fuzzy_shard l2 clustered (n=m=2^20 d=2 delta=10 ssp=40)", "[fuzzy_shard][fuzzyl2][n=m=2^20]") {
+    sparse_comp::bench::bench_sharded<Metric::L2, sparse_comp::fuzzy_l2::Sender, sparse_comp::fuzzy_l2::Receiver, 2, 10, 40>(
+        Workload::Clustered, size_t(1) << 20, block(4522382253946ULL, 23774071991151ULL));
+}
@@ -0,0 +1,26 @@
+#include "./Shard.h"
+#include "../../sparseComp/FuzzyLinf/FuzzyLinf.h"
+
+using osuCrypto::block;
+using sparse_comp::bench::Metric;
+using sparse_comp::bench::Workload;
+
+TEST_CASE("fuzzy_shard linf uniform (n=m=2^18 d=2 delta=10 ssp=40)", "[fuzzy_shard][fuzzylinf][n=m=2^18]") {
+    sparse_comp::bench::bench_sharded<Metric::Linf, sparse_comp::fuzzy_linf::Sender, sparse_comp::fuzzy_linf::Receiver, 2, 10, 40>(
+        Workload::Uniform, size_t(1) << 18, block(34344865381243ULL, 32298306901438ULL));
+}
+
+TEST_CASE("fuzzy_shard linf uniform (n=m=2^20 d=2 delta=10 ssp=40)", "[fuzzy_shard][fuzzylinf][n=m=2^20]") {
+    sparse_comp::bench::bench_sharded<Metric::Linf, sparse_comp::fuzzy_linf::Sender, sparse_comp::fuzzy_linf::Receiver, 2, 10, 40>(
+        Workload::Uniform, size_t(1) << 20, block(8583880663301ULL, 4447822352926ULL));
+}
+
+TEST_CASE("fuzzy_shard linf clustered (n=m=2^18 d=2 delta=10 ssp=40)", "[fuzzy_shard][fuzzylinf][n=m=2^18]") {
+    sparse_comp::bench::bench_sharded<Metric::Linf, sparse_comp::fuzzy_linf::Sender, sparse_comp::fuzzy_linf::Receiver, 2, 10, 40>(
+        Workload::Clustered, size_t(1) << 18, block(16130676652543ULL, 9825968281587ULL));
+}
+
+TEST_CASE("fuzzy_shard linf clustered (n=m=2^20 d=2 delta=10 ssp=40)", "[fuzzy_shard][fuzzylinf][n=m=2^20]") {
+    sparse_comp::bench::bench_sharded<Metric::Linf, sparse_comp::fuzzy_linf::Sender, sparse_comp::fuzzy_linf::Receiver, 2, 10, 40>(
+        Workload::Clustered, size_t(1) << 20, block(9476080681803ULL, 10045121808778ULL));
+}
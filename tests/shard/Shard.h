@@ -0,0 +1,247 @@
+#pragma once
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "cryptoTools/Common/block.h"
+#include "coproto/Socket/Socket.h"
+#include "coproto/Socket/AsioSocket.h"
+#include "coproto/Socket/LocalAsyncSock.h"
+#include "../support/GroundTruth.h"
+#include "../support/Workloads.h"
+#include "../../sparseComp/Common/Common.h"
+#include "../../sparseComp/FuzzyShard/FuzzyShard.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Scale out benchmark of the sharded mode (see FuzzyShard.h) on a single host. Every protocol has its own
+// translation unit, <Protocol>.shard.cpp, since the protocol implementations cannot share one.
+//
+// Each run forks one process per worker, 2 per shard, and keeps both coordinators in the benchmark process,
+// linked to each other by a local socket. Every worker connects to its coordinator, and to the other party's
+// worker of its shard, over local TCP from SPARSE_COMP_SHARD_PORT (31123 by default) upwards. After every
+// measurement, the benchmark prints the points, matches, run time and traffic of each shard, the balance of
+// the shards (largest over mean number of points), and the aggregate throughput over both sets. The output
+// is checked against GroundTruth.h.
+
+namespace sparse_comp::bench {
+
+    constexpr size_t SHARD_MEMORY_BUDGET = size_t(8) << 30;
+    constexpr size_t SHARD_BATCH = size_t(1) << 12;
+
+    struct ShardRun {
+        double wall_ms = 0;
+        std::vector<sparse_comp::fuzzy_shard::WorkerReport> receiver_reports;
+        std::vector<sparse_comp::fuzzy_shard::WorkerReport> sender_reports;
+    };
+
+    namespace detail {
+
+        inline std::string shard_address(size_t offset) {
+            const char* port = std::getenv("SPARSE_COMP_SHARD_PORT");
+
+            return "127.0.0.1:" + std::to_string((port == nullptr ? 31123 : std::atoi(port)) + offset);
+        }
+
+        // Body of a worker process: connects to its coordinator, as a client, and to the other party's worker
+        // of the shard, as the server on the receiver side, then runs the worker.
+        template<typename WorkerFn>
+        void run_worker(WorkerFn& worker, const std::string& coordinator_address, const std::string& peer_address, bool is_receiver) {
+#ifdef COPROTO_ENABLE_BOOST
+            boost::asio::io_context ioc;
+            auto work = boost::asio::make_work_guard(ioc);
+            std::thread io_thread([&ioc]() { ioc.run(); });
+
+            {
+                coproto::AsioSocket coordinator = coproto::asioConnect(coordinator_address, false, ioc);
+                coproto::AsioSocket peer = coproto::asioConnect(peer_address, is_receiver, ioc);
+
+                macoro::sync_wait(worker(coordinator, peer));
+                macoro::sync_wait(coordinator.flush());
+                macoro::sync_wait(peer.flush());
+
+                coordinator.close();
+                peer.close();
+            }
+
+            work.reset();
+            io_thread.join();
+#endif
+        }
+
+        inline double max_over_mean(const std::vector<sparse_comp::fuzzy_shard::WorkerReport>& reports) {
+            uint64_t total = 0;
+            uint64_t largest = 0;
+
+            for (const auto& report : reports) {
+                total += report.points;
+                largest = std::max(largest, report.points);
+            }
+
+            return total == 0 ? 1.0 : (double) largest * reports.size() / total;
+        }
+
+    }
+
+    // Runs the sharded mode on shards worker pairs and returns the wall time of the coordinators, from the
+    // connection of the workers to the merge of the intersections, and the worker reports.
+    template<template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+             template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+             size_t d, uint8_t delta, uint8_t ssp>
+    ShardRun run_sharded(std::span<const point> receiverPoints, std::span<const point> senderPoints, size_t shards, std::vector<point>& intersec) {
+#ifdef COPROTO_ENABLE_BOOST
+        const osuCrypto::block aesKey(14034463513942181890ULL, 16276202269246990858ULL);
+
+        // Coordinator links on [0, 2*shards), receiver workers first, and worker pairs on [2*shards, 3*shards)
+        std::vector<pid_t> pids;
+
+        std::cout.flush();
+
+        for (size_t k = 0; k < 2 * shards; k++) {
+            const bool is_receiver = k < shards;
+            const size_t shard = k % shards;
+
+            pid_t pid = ::fork();
+
+            if (pid < 0) throw std::runtime_error("could not fork a worker process");
+
+            if (pid == 0) { // Worker process, never returns to Catch
+                try {
+                    osuCrypto::PRNG prng(osuCrypto::block(is_receiver ? 6427781726132732903ULL : 15914074867899273501ULL, shard));
+                    osuCrypto::AES aes(aesKey);
+
+                    if (is_receiver) {
+                        auto worker = [&](coproto::Socket& coordinator, coproto::Socket& peer) {
+                            return sparse_comp::fuzzy_shard::receiver_worker<FuzzyReceiver, SHARD_BATCH, SHARD_BATCH, d, delta, ssp>(coordinator, peer, prng, aes, SHARD_MEMORY_BUDGET);
+                        };
+                        detail::run_worker(worker, detail::shard_address(k), detail::shard_address(2 * shards + shard), true);
+                    } else {
+                        auto worker = [&](coproto::Socket& coordinator, coproto::Socket& peer) {
+                            return sparse_comp::fuzzy_shard::sender_worker<FuzzySender, SHARD_BATCH, SHARD_BATCH, d, delta, ssp>(coordinator, peer, prng, aes, SHARD_MEMORY_BUDGET);
+                        };
+                        detail::run_worker(worker, detail::shard_address(k), detail::shard_address(2 * shards + shard), false);
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << "worker process failed: " << e.what() << std::endl;
+                    ::_exit(1);
+                }
+
+                ::_exit(0);
+            }
+
+            pids.push_back(pid);
+        }
+
+        ShardRun run;
+
+        {
+            boost::asio::io_context ioc;
+            auto work = boost::asio::make_work_guard(ioc);
+            std::thread io_thread([&ioc]() { ioc.run(); });
+
+            {
+                std::vector<coproto::Socket> receiverWorkers;
+                std::vector<coproto::Socket> senderWorkers;
+
+                for (size_t k = 0; k < shards; k++) receiverWorkers.push_back(coproto::asioConnect(detail::shard_address(k), true, ioc));
+                for (size_t k = 0; k < shards; k++) senderWorkers.push_back(coproto::asioConnect(detail::shard_address(shards + k), true, ioc));
+
+                auto peers = coproto::LocalAsyncSocket::makePair();
+
+                const auto start = std::chrono::steady_clock::now();
+
+                macoro::sync_wait(macoro::when_all_ready(
+                    sparse_comp::fuzzy_shard::sender_coordinator(peers[0], senderWorkers, senderPoints, run.sender_reports),
+                    sparse_comp::fuzzy_shard::receiver_coordinator(peers[1], receiverWorkers, receiverPoints, delta, intersec, run.receiver_reports)));
+
+                run.wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                for (auto& sock : receiverWorkers) sock.close();
+                for (auto& sock : senderWorkers) sock.close();
+            }
+
+            work.reset();
+            io_thread.join();
+        }
+
+        bool failed = false;
+
+        for (pid_t pid : pids) {
+            int status = 0;
+            ::waitpid(pid, &status, 0);
+            failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+        }
+
+        if (failed) throw std::runtime_error("a worker process failed");
+
+        return run;
+#else
+        throw std::runtime_error("the sharded benchmark requires coproto built with boost");
+#endif
+    }
+
+    template<Metric metric,
+             template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzySender,
+             template<size_t, size_t, size_t, uint8_t, uint8_t> class FuzzyReceiver,
+             size_t d, uint8_t delta, uint8_t ssp>
+    void bench_sharded(Workload workload, size_t n, osuCrypto::block seed) {
+        for (size_t shards : {2, 4}) {
+            const std::string name = std::string(workload_name(workload)) + " n=m=2^" + std::to_string(std::bit_width(n) - 1) +
+                                     " d=" + std::to_string(d) + " delta=" + std::to_string(delta) + " shards=" + std::to_string(shards);
+
+            BENCHMARK_ADVANCED(name.c_str())(Catch::Benchmark::Chronometer meter) {
+                std::vector<point> senderPoints(n);
+                std::vector<point> receiverPoints(n);
+                std::vector<point> intersec;
+
+                load_or_gen_workload(workload, seed, {d, delta, 29}, receiverPoints, senderPoints);
+
+                ShardRun run;
+
+                meter.measure([&] {
+                    intersec.clear();
+                    run = run_sharded<FuzzySender, FuzzyReceiver, d, delta, ssp>(receiverPoints, senderPoints, shards, intersec);
+                });
+
+                std::vector<point> expected_intersec;
+
+                expected_intersect<metric>(receiverPoints, senderPoints, d, delta, expected_intersec);
+
+                REQUIRE(is_intersec_correct(intersec, expected_intersec));
+
+                double nMBsExchanged = 0;
+
+                for (size_t k = 0; k < shards; k++) {
+                    const auto& rcvr = run.receiver_reports[k];
+                    const auto& sndr = run.sender_reports[k];
+
+                    nMBsExchanged += ((double) rcvr.bytes)/1024.0/1024.0;
+
+                    std::cout << "Shard " << k << " receiver points: " << rcvr.points << " sender points: " << sndr.points
+                              << " matches: " << rcvr.matches << " time ms: " << std::max(rcvr.wall_ms, sndr.wall_ms)
+                              << " MBs: " << ((double) rcvr.bytes)/1024.0/1024.0 << std::endl;
+                }
+
+                std::cout << "Shard balance (max/mean points) receiver: " << detail::max_over_mean(run.receiver_reports)
+                          << " sender: " << detail::max_over_mean(run.sender_reports) << std::endl;
+                std::cout << "Aggregate throughput points/s: " << (double) (receiverPoints.size() + senderPoints.size()) / (run.wall_ms / 1000.0) << std::endl;
+
+                SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+            };
+        }
+    }
+
+};
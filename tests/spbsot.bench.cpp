@@ -0,0 +1,259 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "coproto/Socket/LocalAsyncSock.h"
+#include "./support/TwoPartyBench.h"
+#include "../sparseComp/Common/Trace.h"
+#include "../sparseComp/Common/ZN.h"
+#include "../sparseComp/CustomOPRF/CustomizedOPRF.h"
+#include "../sparseComp/SpBSOT/SpBSOT.h"
+#include "../sparseComp/BlockSpBSOT/BlockSpBSOT.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// SpBSOT and BlockSpBSOT on their own, in the shapes the SpX protocols instantiate them with: SpBSOT with k=d
+// and n=2^8 over Z_M (M=d*(delta+1)+1 for SpL1, M=d+1 for SpLinf) and BlockSpBSOT with k=1 and n=M or n=d+1.
+// The OPRF sessions are set up before the measurement, as the SpX protocols do in their offline phase. Build
+// with -DSPARSE_COMP_TRACING=ON to get the time of every phase (oprf, mask, okvs_encode, truncate, okvs transfer,
+// reconstruct, okvs_decode and extract) next to their communication.
+
+using coproto::LocalAsyncSocket;
+
+using PRNG = osuCrypto::PRNG;
+using osuCrypto::block;
+
+using macoro::sync_wait;
+using macoro::when_all_ready;
+
+using OprfSender = sparse_comp::custom_oprf::Sender;
+using OprfReceiver = sparse_comp::custom_oprf::Receiver;
+
+namespace {
+
+    struct oprf_sessions {
+        vector<OprfSender*> sender_oprf_senders;
+        vector<OprfReceiver*> sender_oprf_receivers;
+        vector<OprfSender*> receiver_oprf_senders;
+        vector<OprfReceiver*> receiver_oprf_receivers;
+    };
+
+    // One OPRF instance per direction and party, handed over to (and freed by) the SpBSOT parties.
+    template<typename Socks>
+    void setup_oprf_sessions(Socks& socks, PRNG& senderPRNG, PRNG& receiverPRNG, oprf_sessions& sessions) {
+        Proto sender_setup = sparse_comp::custom_oprf::setup_session(socks[0], senderPRNG, true, 1, sessions.sender_oprf_senders, sessions.sender_oprf_receivers);
+        Proto receiver_setup = sparse_comp::custom_oprf::setup_session(socks[1], receiverPRNG, false, 1, sessions.receiver_oprf_senders, sessions.receiver_oprf_receivers);
+
+        sync_wait(when_all_ready(std::move(sender_setup), std::move(receiver_setup)));
+    }
+
+    void gen_index_sets(PRNG& prng, vector<block>& sender_set, vector<block>& receiver_set, size_t ts, size_t tr) {
+        sender_set.resize(ts);
+        receiver_set.resize(tr);
+
+        for (size_t i = 0; i < ts; i++) sender_set[i] = prng.get<block>();
+        for (size_t i = 0; i < tr; i++) receiver_set[i] = prng.get<block>();
+
+        // Half of the smaller set is shared, so that the receiver decodes both hits and misses
+        for (size_t i = 0; i < std::min(ts, tr) / 2; i++) receiver_set[i] = sender_set[i];
+    }
+
+    template<size_t t, size_t k, uint64_t N>
+    void gen_zn_matrix(PRNG& prng, array<array<ZN<N>,k>,t>& mtx) {
+        for (size_t i = 0; i < t; i++) {
+            for (size_t j = 0; j < k; j++) mtx[i][j] = ZN<N>::sample(prng);
+        }
+    }
+
+    void note_bsot_run(const sparse_comp::bench::TwoPartyStats& parties, size_t ts, size_t tr) {
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0;
+
+        if (!sparse_comp::trace::enabled()) WARN("Per phase times require the trace points, build with -DSPARSE_COMP_TRACING=ON");
+
+        SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+        sparse_comp::bench::print_perf(parties.perf, ts + tr);
+    }
+
+};
+
+template<size_t ts, size_t tr, size_t k, size_t n, uint64_t M>
+static void bench_spbsot(Catch::Benchmark::Chronometer& meter) {
+    auto socks = LocalAsyncSocket::makePair();
+    PRNG inputPRNG = PRNG(block(9536629026107651350ULL, 2724119864341290560ULL));
+    PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+    PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+
+    vector<block> senderSet, receiverSet;
+    gen_index_sets(inputPRNG, senderSet, receiverSet, ts, tr);
+
+    array<array<array<ZN<M>,n>,k>,ts>* msg_vecs = new array<array<array<ZN<M>,n>,k>,ts>();
+    array<array<ZN<n>,k>,ts>* sndr_choice_shares = new array<array<ZN<n>,k>,ts>();
+    array<array<ZN<n>,k>,tr>* rcvr_choice_shares = new array<array<ZN<n>,k>,tr>();
+    array<array<ZN<M>,k>,ts>* sndr_out_shares = new array<array<ZN<M>,k>,ts>();
+    array<array<ZN<M>,k>,tr>* rcvr_out_shares = new array<array<ZN<M>,k>,tr>();
+
+    for (size_t i = 0; i < ts; i++) {
+        for (size_t j = 0; j < k; j++) {
+            for (size_t h = 0; h < n; h++) (*msg_vecs)[i][j][h] = ZN<M>::sample(inputPRNG);
+        }
+    }
+    gen_zn_matrix<ts,k,n>(inputPRNG, *sndr_choice_shares);
+    gen_zn_matrix<tr,k,n>(inputPRNG, *rcvr_choice_shares);
+
+    oprf_sessions sessions;
+    setup_oprf_sessions(socks, senderPRNG, receiverPRNG, sessions);
+
+    sparse_comp::sp_bsot::Sender<tr,ts,k,n,M> sender(senderPRNG, sessions.sender_oprf_senders[0], sessions.sender_oprf_receivers[0]);
+    sparse_comp::sp_bsot::Receiver<ts,tr,k,n,M> receiver(receiverPRNG, sessions.receiver_oprf_receivers[0], sessions.receiver_oprf_senders[0]);
+
+    auto parties = sparse_comp::bench::measure_parties(meter, socks,
+        [&](coproto::Socket& sock) { return sender.send(sock, senderSet, *msg_vecs, *sndr_choice_shares, *sndr_out_shares); },
+        [&](coproto::Socket& sock) { return receiver.receive(sock, receiverSet, *rcvr_choice_shares, *rcvr_out_shares); }, *rcvr_out_shares);
+
+    delete msg_vecs;
+    delete sndr_choice_shares;
+    delete rcvr_choice_shares;
+    delete sndr_out_shares;
+    delete rcvr_out_shares;
+
+    note_bsot_run(parties, ts, tr);
+}
+
+template<size_t ts, size_t tr, size_t k, size_t n>
+static void bench_block_spbsot(Catch::Benchmark::Chronometer& meter) {
+    auto socks = LocalAsyncSocket::makePair();
+    PRNG inputPRNG = PRNG(block(9536629026107651350ULL, 2724119864341290560ULL));
+    PRNG senderPRNG = PRNG(block(15914074867899273501ULL, 6004108516319388444ULL));
+    PRNG receiverPRNG = PRNG(block(6427781726132732903ULL, 8471345356057289138ULL));
+
+    vector<block> senderSet, receiverSet;
+    gen_index_sets(inputPRNG, senderSet, receiverSet, ts, tr);
+
+    array<array<array<block,n>,k>,ts>* msg_vecs = new array<array<array<block,n>,k>,ts>();
+    array<array<ZN<n>,k>,ts>* sndr_choice_shares = new array<array<ZN<n>,k>,ts>();
+    array<array<ZN<n>,k>,tr>* rcvr_choice_shares = new array<array<ZN<n>,k>,tr>();
+    array<array<block,k>,ts>* sndr_out_shares = new array<array<block,k>,ts>();
+    array<array<block,k>,tr>* rcvr_out_shares = new array<array<block,k>,tr>();
+
+    for (size_t i = 0; i < ts; i++) {
+        for (size_t j = 0; j < k; j++) {
+            for (size_t h = 0; h < n; h++) (*msg_vecs)[i][j][h] = inputPRNG.get<block>();
+        }
+    }
+    gen_zn_matrix<ts,k,n>(inputPRNG, *sndr_choice_shares);
+    gen_zn_matrix<tr,k,n>(inputPRNG, *rcvr_choice_shares);
+
+    oprf_sessions sessions;
+    setup_oprf_sessions(socks, senderPRNG, receiverPRNG, sessions);
+
+    sparse_comp::block_sp_bsot::Sender<tr,ts,k,n> sender(senderPRNG, sessions.sender_oprf_senders[0], sessions.sender_oprf_receivers[0]);
+    sparse_comp::block_sp_bsot::Receiver<ts,tr,k,n> receiver(receiverPRNG, sessions.receiver_oprf_receivers[0], sessions.receiver_oprf_senders[0]);
+
+    auto parties = sparse_comp::bench::measure_parties(meter, socks,
+        [&](coproto::Socket& sock) { return sender.send(sock, senderSet, *msg_vecs, *sndr_choice_shares, *sndr_out_shares); },
+        [&](coproto::Socket& sock) { return receiver.receive(sock, receiverSet, *rcvr_choice_shares, *rcvr_out_shares); }, *rcvr_out_shares);
+
+    delete msg_vecs;
+    delete sndr_choice_shares;
+    delete rcvr_choice_shares;
+    delete sndr_out_shares;
+    delete rcvr_out_shares;
+
+    note_bsot_run(parties, ts, tr);
+}
+
+// SpBSOT with k=d, n=2^8: M=d*(delta+1)+1 as in SpL1, M=d+1 as in SpLinf
+
+TEST_CASE("spbsot (t_s=256 t_r=256 k=2 n=256 M=23)","[spbsot][t=2^8]") {
+    BENCHMARK_ADVANCED("t_s=256 t_r=256 k=2 n=256 M=23")(Catch::Benchmark::Chronometer meter) {
+        bench_spbsot<256,256,2,256,23>(meter);
+    };
+}
+
+TEST_CASE("spbsot (t_s=256 t_r=256 k=6 n=256 M=67)","[spbsot][t=2^8]") {
+    BENCHMARK_ADVANCED("t_s=256 t_r=256 k=6 n=256 M=67")(Catch::Benchmark::Chronometer meter) {
+        bench_spbsot<256,256,6,256,67>(meter);
+    };
+}
+
+TEST_CASE("spbsot (t_s=256 t_r=256 k=2 n=256 M=3)","[spbsot][t=2^8]") {
+    BENCHMARK_ADVANCED("t_s=256 t_r=256 k=2 n=256 M=3")(Catch::Benchmark::Chronometer meter) {
+        bench_spbsot<256,256,2,256,3>(meter);
+    };
+}
+
+TEST_CASE("spbsot (t_s=256 t_r=256 k=6 n=256 M=7)","[spbsot][t=2^8]") {
+    BENCHMARK_ADVANCED("t_s=256 t_r=256 k=6 n=256 M=7")(Catch::Benchmark::Chronometer meter) {
+        bench_spbsot<256,256,6,256,7>(meter);
+    };
+}
+
+TEST_CASE("spbsot (t_s=256 t_r=4096 k=2 n=256 M=23)","[spbsot][t=2^8]") {
+    BENCHMARK_ADVANCED("t_s=256 t_r=4096 k=2 n=256 M=23")(Catch::Benchmark::Chronometer meter) {
+        bench_spbsot<256,4096,2,256,23>(meter);
+    };
+}
+
+TEST_CASE("spbsot (t_s=4096 t_r=4096 k=2 n=256 M=23)","[spbsot][t=2^12]") {
+    BENCHMARK_ADVANCED("t_s=4096 t_r=4096 k=2 n=256 M=23")(Catch::Benchmark::Chronometer meter) {
+        bench_spbsot<4096,4096,2,256,23>(meter);
+    };
+}
+
+TEST_CASE("spbsot (t_s=4096 t_r=4096 k=6 n=256 M=67)","[spbsot][t=2^12]") {
+    BENCHMARK_ADVANCED("t_s=4096 t_r=4096 k=6 n=256 M=67")(Catch::Benchmark::Chronometer meter) {
+        bench_spbsot<4096,4096,6,256,67>(meter);
+    };
+}
+
+TEST_CASE("spbsot (t_s=4096 t_r=4096 k=2 n=256 M=3)","[spbsot][t=2^12]") {
+    BENCHMARK_ADVANCED("t_s=4096 t_r=4096 k=2 n=256 M=3")(Catch::Benchmark::Chronometer meter) {
+        bench_spbsot<4096,4096,2,256,3>(meter);
+    };
+}
+
+// BlockSpBSOT with k=1: n=M=d*(delta+1)+1 as in SpL1, n=d+1 as in SpLinf
+
+TEST_CASE("block_spbsot (t_s=256 t_r=256 k=1 n=23)","[block_spbsot][t=2^8]") {
+    BENCHMARK_ADVANCED("t_s=256 t_r=256 k=1 n=23")(Catch::Benchmark::Chronometer meter) {
+        bench_block_spbsot<256,256,1,23>(meter);
+    };
+}
+
+TEST_CASE("block_spbsot (t_s=256 t_r=256 k=1 n=67)","[block_spbsot][t=2^8]") {
+    BENCHMARK_ADVANCED("t_s=256 t_r=256 k=1 n=67")(Catch::Benchmark::Chronometer meter) {
+        bench_block_spbsot<256,256,1,67>(meter);
+    };
+}
+
+TEST_CASE("block_spbsot (t_s=256 t_r=256 k=1 n=3)","[block_spbsot][t=2^8]") {
+    BENCHMARK_ADVANCED("t_s=256 t_r=256 k=1 n=3")(Catch::Benchmark::Chronometer meter) {
+        bench_block_spbsot<256,256,1,3>(meter);
+    };
+}
+
+TEST_CASE("block_spbsot (t_s=256 t_r=4096 k=1 n=23)","[block_spbsot][t=2^8]") {
+    BENCHMARK_ADVANCED("t_s=256 t_r=4096 k=1 n=23")(Catch::Benchmark::Chronometer meter) {
+        bench_block_spbsot<256,4096,1,23>(meter);
+    };
+}
+
+TEST_CASE("block_spbsot (t_s=4096 t_r=4096 k=1 n=23)","[block_spbsot][t=2^12]") {
+    BENCHMARK_ADVANCED("t_s=4096 t_r=4096 k=1 n=23")(Catch::Benchmark::Chronometer meter) {
+        bench_block_spbsot<4096,4096,1,23>(meter);
+    };
+}
+
+TEST_CASE("block_spbsot (t_s=4096 t_r=4096 k=1 n=67)","[block_spbsot][t=2^12]") {
+    BENCHMARK_ADVANCED("t_s=4096 t_r=4096 k=1 n=67")(Catch::Benchmark::Chronometer meter) {
+        bench_block_spbsot<4096,4096,1,67>(meter);
+    };
+}
+
+TEST_CASE("block_spbsot (t_s=4096 t_r=4096 k=1 n=7)","[block_spbsot][t=2^12]") {
+    BENCHMARK_ADVANCED("t_s=4096 t_r=4096 k=1 n=7")(Catch::Benchmark::Chronometer meter) {
+        bench_block_spbsot<4096,4096,1,7>(meter);
+    };
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <sched.h>
+
+// Core pinning for the single threaded benchmarks, so that their timings are not spread over cores with
+// different caches and clocks. The core is SPARSE_COMP_BENCH_CPU if set, otherwise the one the process started on.
+
+namespace sparse_comp::bench {
+
+    // Pins the calling thread, on the first call, and returns its core; -1 if pinning failed (which is reported once).
+    inline int pin_to_core() {
+        static int pinned = [] {
+            const char* env = std::getenv("SPARSE_COMP_BENCH_CPU");
+            const int cpu = env != nullptr ? std::atoi(env) : sched_getcpu();
+
+            if (cpu < 0 || cpu >= CPU_SETSIZE) {
+                std::printf("Could not pin to cpu %d: no such cpu\n", cpu);
+                return -1;
+            }
+
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+
+            if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+                std::printf("Could not pin to cpu %d: %s\n", cpu, std::strerror(errno));
+                return -1;
+            }
+
+            std::printf("Pinned to cpu %d\n", cpu);
+            return cpu;
+        }();
+
+        return pinned;
+    }
+
+};
@@ -0,0 +1,71 @@
+#include "./MemoryProfile.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+
+// Replacement of the global allocation functions counting the bytes (as usable size) and the number of
+// allocations made through operator new by all the threads of the process, including the worker threads of
+// the protocols. Linked into the bench executables only.
+
+namespace {
+
+    // Relaxed: the counters are only read as totals, never to order other memory accesses
+    std::atomic<uint64_t> total_bytes = 0;
+    std::atomic<uint64_t> total_count = 0;
+
+    void* counted(void* ptr) {
+        total_bytes.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed);
+        total_count.fetch_add(1, std::memory_order_relaxed);
+
+        return ptr;
+    }
+
+    void* allocate(size_t size) {
+        void* ptr = std::malloc(size == 0 ? 1 : size);
+        if (ptr == nullptr) throw std::bad_alloc();
+
+        return counted(ptr);
+    }
+
+    void* allocate_aligned(size_t size, std::align_val_t align) {
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, std::max((size_t) align, sizeof(void*)), size == 0 ? 1 : size) != 0) throw std::bad_alloc();
+
+        return counted(ptr);
+    }
+
+    void* allocate_nothrow(size_t size) noexcept {
+        void* ptr = std::malloc(size == 0 ? 1 : size);
+
+        return ptr == nullptr ? nullptr : counted(ptr);
+    }
+
+};
+
+sparse_comp::bench::AllocTotals sparse_comp::bench::process_alloc_totals() {
+    AllocTotals totals;
+    totals.bytes = total_bytes.load(std::memory_order_relaxed);
+    totals.count = total_count.load(std::memory_order_relaxed);
+
+    return totals;
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void* operator new(size_t size, std::align_val_t align) { return allocate_aligned(size, align); }
+void* operator new[](size_t size, std::align_val_t align) { return allocate_aligned(size, align); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate_nothrow(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate_nothrow(size); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
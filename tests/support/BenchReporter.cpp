@@ -0,0 +1,199 @@
+#include "./BenchResults.h"
+#include "catch2/benchmark/detail/catch_benchmark_stats.hpp"
+#include "catch2/catch_test_case_info.hpp"
+#include "catch2/reporters/catch_reporter_registrars.hpp"
+#include "catch2/reporters/catch_reporter_streaming_base.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Machine readable benchmark results: one record per benchmark with its parameters, timing samples and the
+// run figures noted by measure_parties (see BenchResults.h). sparse-json writes a JSON document, sparse-csv a
+// CSV file with a header line; the samples column of the latter is a ';' separated list.
+
+namespace {
+
+    struct bench_record {
+        std::string test;
+        std::string benchmark;
+        std::string party_mode;
+        std::map<std::string, std::string> params;
+        std::vector<double> samples_ns;
+        double mean_ns = 0;
+        double stddev_ns = 0;
+        sparse_comp::bench::BenchRun run;
+    };
+
+    // Normalizes the parameter names of the different benchmarks: the SpX benchmarks call n t_s, the OKVS
+    // benchmarks nA.
+    std::string param(const bench_record& record, const std::string& name) {
+        const std::vector<std::string> aliases = name == "n" ? std::vector<std::string>{"n", "t_s", "nA"} : std::vector<std::string>{name};
+
+        for (auto& alias : aliases) {
+            auto it = record.params.find(alias);
+            if (it != record.params.end()) return it->second;
+        }
+
+        return std::string();
+    }
+
+    std::string json_string(const std::string& str) {
+        std::string out = "\"";
+
+        for (char c : str) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+
+        return out + "\"";
+    }
+
+    std::string csv_field(const std::string& str) {
+        std::string out = "\"";
+
+        for (char c : str) {
+            if (c == '"') out += '"';
+            out += c;
+        }
+
+        return out + "\"";
+    }
+
+    std::string number(double value) {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.3f", value);
+        return buf;
+    }
+
+    class ResultsReporterBase : public Catch::StreamingReporterBase {
+        protected:
+            std::vector<bench_record> records;
+            std::string current_test;
+
+        public:
+            ResultsReporterBase(Catch::ReporterConfig&& config) : StreamingReporterBase(std::move(config)) {
+                this->m_preferences.shouldReportAllAssertions = false;
+            }
+
+            void testCaseStarting(Catch::TestCaseInfo const& info) override {
+                StreamingReporterBase::testCaseStarting(info);
+                this->current_test = info.name;
+            }
+
+            void benchmarkStarting(Catch::BenchmarkInfo const& info) override {
+                StreamingReporterBase::benchmarkStarting(info);
+                sparse_comp::bench::current_run() = sparse_comp::bench::BenchRun();
+            }
+
+            void benchmarkEnded(Catch::BenchmarkStats<> const& stats) override {
+                StreamingReporterBase::benchmarkEnded(stats);
+
+                const char* mode = std::getenv("SPARSE_COMP_BENCH_PARTIES");
+
+                bench_record record;
+                record.test = this->current_test;
+                record.benchmark = stats.info.name;
+                record.party_mode = mode == nullptr ? "local" : mode;
+                record.params = sparse_comp::bench::parse_params(this->current_test);
+                for (auto& [name, value] : sparse_comp::bench::parse_params(stats.info.name)) record.params[name] = value;
+                for (auto& sample : stats.samples) record.samples_ns.push_back(sample.count());
+                record.mean_ns = stats.mean.point.count();
+                record.stddev_ns = stats.standardDeviation.point.count();
+                record.run = sparse_comp::bench::current_run();
+
+                this->records.push_back(record);
+            }
+    };
+
+    class JsonResultsReporter : public ResultsReporterBase {
+        public:
+            using ResultsReporterBase::ResultsReporterBase;
+
+            static std::string getDescription() {
+                return "Writes the benchmark results as JSON";
+            }
+
+            void testRunEnded(Catch::TestRunStats const& stats) override {
+                StreamingReporterBase::testRunEnded(stats);
+
+                this->m_stream << "{\"benchmarks\":[";
+
+                for (size_t i = 0; i < this->records.size(); i++) {
+                    const bench_record& record = this->records[i];
+
+                    this->m_stream << (i == 0 ? "\n" : ",\n")
+                                   << "{\"test\":" << json_string(record.test)
+                                   << ",\"benchmark\":" << json_string(record.benchmark)
+                                   << ",\"party_mode\":" << json_string(record.party_mode)
+                                   << ",\"params\":{";
+
+                    bool first = true;
+                    for (auto& [name, value] : record.params) {
+                        this->m_stream << (first ? "" : ",") << json_string(name) << ":" << json_string(value);
+                        first = false;
+                    }
+
+                    this->m_stream << "},\"n\":" << json_string(param(record, "n"))
+                                   << ",\"d\":" << json_string(param(record, "d"))
+                                   << ",\"delta\":" << json_string(param(record, "delta"))
+                                   << ",\"ssp\":" << json_string(param(record, "ssp"))
+                                   << ",\"threads\":" << record.run.threads
+                                   << ",\"mean_ns\":" << number(record.mean_ns)
+                                   << ",\"stddev_ns\":" << number(record.stddev_ns)
+                                   << ",\"samples_ns\":[";
+
+                    for (size_t j = 0; j < record.samples_ns.size(); j++) {
+                        this->m_stream << (j == 0 ? "" : ",") << number(record.samples_ns[j]);
+                    }
+
+                    this->m_stream << "],\"bytes\":" << record.run.bytes
+                                   << ",\"rounds\":" << record.run.rounds
+                                   << ",\"peak_rss_kb\":" << record.run.peak_rss_kb
+                                   << ",\"has_run_stats\":" << (record.run.noted ? "true" : "false") << "}";
+                }
+
+                this->m_stream << "\n]}\n";
+            }
+    };
+
+    class CsvResultsReporter : public ResultsReporterBase {
+        public:
+            using ResultsReporterBase::ResultsReporterBase;
+
+            static std::string getDescription() {
+                return "Writes the benchmark results as CSV";
+            }
+
+            void testRunEnded(Catch::TestRunStats const& stats) override {
+                StreamingReporterBase::testRunEnded(stats);
+
+                this->m_stream << "test,benchmark,party_mode,n,d,delta,ssp,threads,mean_ns,stddev_ns,samples_ns,bytes,rounds,peak_rss_kb\n";
+
+                for (const bench_record& record : this->records) {
+                    std::string samples;
+                    for (size_t j = 0; j < record.samples_ns.size(); j++) samples += (j == 0 ? "" : ";") + number(record.samples_ns[j]);
+
+                    this->m_stream << csv_field(record.test) << ","
+                                   << csv_field(record.benchmark) << ","
+                                   << record.party_mode << ","
+                                   << param(record, "n") << ","
+                                   << param(record, "d") << ","
+                                   << param(record, "delta") << ","
+                                   << param(record, "ssp") << ","
+                                   << record.run.threads << ","
+                                   << number(record.mean_ns) << ","
+                                   << number(record.stddev_ns) << ","
+                                   << samples << ","
+                                   << (record.run.noted ? std::to_string(record.run.bytes) : "") << ","
+                                   << (record.run.noted ? std::to_string(record.run.rounds) : "") << ","
+                                   << (record.run.noted ? std::to_string(record.run.peak_rss_kb) : "") << "\n";
+                }
+            }
+    };
+
+};
+
+CATCH_REGISTER_REPORTER("sparse-json", JsonResultsReporter)
+CATCH_REGISTER_REPORTER("sparse-csv", CsvResultsReporter)
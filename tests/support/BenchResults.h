@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cctype>
+#include <cstdint>
+#include <map>
+#include <string>
+
+// Side channel from the benchmark bodies to the result reporters of BenchReporter.cpp. The Catch2 benchmark
+// statistics only carry timings, so measure_parties notes the communication, rounds and memory of its run here
+// and the reporters attach them to the benchmark being reported.
+//
+//     spl1_bench --reporter console --reporter sparse-json::out=results.json
+//     spl1_bench --reporter console --reporter sparse-csv::out=results.csv
+
+namespace sparse_comp::bench {
+
+    struct BenchRun {
+        uint64_t bytes = 0; // Sent and received by the sender, per run
+        uint64_t rounds = 0; // Message flights seen by the sender, per run
+        uint64_t peak_rss_kb = 0; // Largest peak RSS over the parties
+        uint64_t threads = 1;
+        bool noted = false;
+    };
+
+    inline BenchRun& current_run() {
+        static BenchRun run;
+        return run;
+    }
+
+    inline void note_run(const BenchRun& run) {
+        current_run() = run;
+        current_run().noted = true;
+    }
+
+    // Parameters spelled in a test or benchmark name, e.g. "t_s=256, t_r=1024 d=2" or "n=m=256". Every name of a
+    // chained assignment gets its value.
+    inline std::map<std::string, std::string> parse_params(const std::string& name) {
+        std::map<std::string, std::string> params;
+
+        size_t pos = 0;
+        while (pos < name.size()) {
+            while (pos < name.size() && (std::isspace((unsigned char) name[pos]) || name[pos] == ',' || name[pos] == '(' || name[pos] == ')')) pos++;
+
+            size_t end = pos;
+            while (end < name.size() && !std::isspace((unsigned char) name[end]) && name[end] != ',' && name[end] != '(' && name[end] != ')') end++;
+
+            const std::string token = name.substr(pos, end - pos);
+            const size_t last_eq = token.rfind('=');
+
+            if (last_eq != std::string::npos && last_eq + 1 < token.size()) {
+                const std::string value = token.substr(last_eq + 1);
+
+                size_t key_start = 0;
+                while (key_start < last_eq) {
+                    size_t key_end = token.find('=', key_start);
+                    if (key_end > key_start) params[token.substr(key_start, key_end - key_start)] = value;
+                    key_start = key_end + 1;
+                }
+            }
+
+            pos = end;
+        }
+
+        return params;
+    }
+
+};
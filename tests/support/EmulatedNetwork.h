@@ -0,0 +1,359 @@
+#pragma once
+
+#include "coproto/Socket/Socket.h"
+#include "macoro/stop.h"
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// In-memory socket pair that emulates a network link: every send first waits for a token bucket
+// of the link bandwidth and then reaches the peer after the one way latency. A timer thread owned by
+// the EmulatedNetwork resumes the parties once their sends are serialized or their data arrived.
+// The network also counts flights, i.e. runs of messages sent in the same direction, which is the
+// number of rounds the latency is paid for, and can log every message it carries (see Transcript.h).
+// Closing the network, or stopping the token of a pending operation, fails that operation with
+// code::remoteClosed or code::operation_aborted instead of leaving its party suspended.
+
+namespace sparse_comp::bench {
+
+    struct NetworkProfile {
+        std::string name;
+        double bandwidth_bps;  // Link bandwidth in bits per second
+        double latency_ms;     // One way latency
+        size_t burst_bytes;    // Token bucket depth
+
+        static NetworkProfile lan() { return {"lan", 10e9, 0.1, 64 * 1024}; }
+        static NetworkProfile wan() { return {"wan", 100e6, 40, 64 * 1024}; }
+        static NetworkProfile loopback() { return {"loopback", 1e15, 0, 64 * 1024}; }
+    };
+
+    // A message carried by an EmulatedNetwork, from is the index of the sending socket in makePair()
+    struct LinkMessage {
+        uint8_t from;
+        std::vector<uint8_t> data;
+    };
+
+    class EmulatedNetwork {
+        public:
+            using clock = std::chrono::steady_clock;
+
+        private:
+            struct Chunk {
+                clock::time_point deliver_at;
+                std::vector<uint8_t> data;
+                size_t offset = 0;
+            };
+
+            struct RecvWaiter {
+                uint8_t* dest = nullptr;
+                size_t size = 0;
+                size_t filled = 0;
+                std::coroutine_handle<> handle;
+                coproto::error_code ec;
+            };
+
+            struct Direction {
+                std::deque<Chunk> chunks;
+                double tokens = 0;
+                clock::time_point refilled_at = clock::now();
+                RecvWaiter* waiter = nullptr;
+            };
+
+            // A timer either resumes a suspended sender or, with handle == nullptr, retries the pending receive of a direction
+            struct Timer {
+                std::coroutine_handle<> handle;
+                size_t dir = 0;
+            };
+
+            NetworkProfile profile;
+            std::mutex mtx;
+            std::condition_variable cv;
+            std::multimap<clock::time_point, Timer> timers;
+            std::array<Direction, 2> dirs;
+            std::thread timer_thread;
+            bool stopping = false;
+            bool closed = false;
+
+            int last_dir = -1;
+            size_t flights = 0;
+            std::vector<LinkMessage>* log = nullptr;
+
+            // Copies the delivered bytes into the waiter of dir. Must hold mtx.
+            bool fill(Direction& dir, RecvWaiter& waiter, clock::time_point now) {
+                while (waiter.filled < waiter.size && !dir.chunks.empty() && dir.chunks.front().deliver_at <= now) {
+                    Chunk& chunk = dir.chunks.front();
+                    size_t n = std::min(waiter.size - waiter.filled, chunk.data.size() - chunk.offset);
+
+                    std::memcpy(waiter.dest + waiter.filled, chunk.data.data() + chunk.offset, n);
+                    waiter.filled += n;
+                    chunk.offset += n;
+
+                    if (chunk.offset == chunk.data.size()) dir.chunks.pop_front();
+                }
+
+                return waiter.filled == waiter.size;
+            }
+
+            void schedule(clock::time_point at, Timer timer) {
+                timers.emplace(at, timer);
+                cv.notify_one();
+            }
+
+            // Takes the pending receive of dir off the direction and has the timer thread resume it with ec. Must hold mtx.
+            void fail_waiter(size_t dir, coproto::error_code ec) {
+                RecvWaiter* waiter = this->dirs[dir].waiter;
+                if (waiter == nullptr) return;
+
+                waiter->ec = ec;
+                this->dirs[dir].waiter = nullptr;
+                schedule(clock::now(), Timer{waiter->handle, dir});
+            }
+
+            // Moves the pending timer of the suspended sender h to now, so that it resumes early. Returns false if it
+            // already fired. Must hold mtx.
+            bool hurry_sender(std::coroutine_handle<> h, size_t dir) {
+                for (auto it = timers.begin(); it != timers.end(); ++it) {
+                    if (it->second.handle == h) {
+                        timers.erase(it);
+                        schedule(clock::now(), Timer{h, dir});
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            void run_timers() {
+                std::unique_lock<std::mutex> lock(mtx);
+
+                while (!stopping) {
+                    if (timers.empty()) {
+                        cv.wait(lock);
+                        continue;
+                    }
+
+                    auto next = timers.begin();
+                    if (next->first > clock::now()) {
+                        cv.wait_until(lock, next->first);
+                        continue;
+                    }
+
+                    Timer timer = next->second;
+                    timers.erase(next);
+
+                    std::coroutine_handle<> resume = timer.handle;
+
+                    if (!resume) {
+                        Direction& dir = this->dirs[timer.dir];
+
+                        if (dir.waiter != nullptr && fill(dir, *dir.waiter, clock::now())) {
+                            resume = dir.waiter->handle;
+                            dir.waiter = nullptr;
+                        }
+                    }
+
+                    if (resume) {
+                        lock.unlock();
+                        resume.resume();
+                        lock.lock();
+                    }
+                }
+            }
+
+        public:
+            struct SendAwaiter {
+                EmulatedNetwork* net;
+                size_t dir;
+                coproto::span<uint8_t> data;
+                macoro::stop_token token;
+                coproto::error_code ec;
+                bool stopped = false;
+                std::optional<macoro::stop_callback<std::function<void()>>> on_stop;
+
+                bool await_ready() { return false; }
+
+                bool await_suspend(std::coroutine_handle<> h) {
+                    // Registered before the send is queued, since the callback takes mtx and runs right away if the
+                    // stop was already requested
+                    if (token.stop_possible()) {
+                        on_stop.emplace(token, [this, h]() {
+                            std::lock_guard<std::mutex> lock(net->mtx);
+                            stopped = true;
+                            if (net->hurry_sender(h, dir)) ec = coproto::code::operation_aborted;
+                        });
+                    }
+
+                    std::lock_guard<std::mutex> lock(net->mtx);
+
+                    if (stopped) {
+                        ec = coproto::code::operation_aborted;
+                        return false;
+                    }
+
+                    if (net->closed) {
+                        ec = coproto::code::remoteClosed;
+                        return false;
+                    }
+
+                    const NetworkProfile& profile = net->profile;
+                    Direction& d = net->dirs[dir];
+                    clock::time_point now = clock::now();
+
+                    if (net->last_dir != (int) dir) {
+                        net->flights++;
+                        net->last_dir = (int) dir;
+                    }
+
+                    if (net->log != nullptr) net->log->push_back(LinkMessage{(uint8_t) dir, std::vector<uint8_t>(data.begin(), data.end())});
+
+                    // Token bucket refill, then wait for the tokens still missing
+                    const double rate = profile.bandwidth_bps / 8.0 / 1e9; // bytes per ns
+                    d.tokens = std::min<double>(profile.burst_bytes, d.tokens + rate * std::chrono::duration<double, std::nano>(now - d.refilled_at).count());
+                    d.refilled_at = now;
+                    d.tokens -= (double) data.size();
+
+                    clock::time_point sent_at = now;
+                    if (d.tokens < 0) sent_at += std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::nano>(-d.tokens / rate));
+
+                    const size_t peer = 1 - dir;
+                    clock::time_point deliver_at = sent_at + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::milli>(profile.latency_ms));
+
+                    net->dirs[peer].chunks.push_back(Chunk{deliver_at, std::vector<uint8_t>(data.begin(), data.end())});
+                    net->schedule(deliver_at, Timer{nullptr, peer});
+
+                    if (sent_at <= now) return false;
+
+                    net->schedule(sent_at, Timer{h, dir});
+                    return true;
+                }
+
+                std::pair<coproto::error_code, uint64_t> await_resume() {
+                    on_stop.reset();
+
+                    if (ec) return {ec, 0};
+                    return {coproto::error_code{}, data.size()};
+                }
+            };
+
+            struct RecvAwaiter {
+                EmulatedNetwork* net;
+                size_t dir;
+                coproto::span<uint8_t> data;
+                macoro::stop_token token;
+                RecvWaiter waiter;
+                bool stopped = false;
+                std::optional<macoro::stop_callback<std::function<void()>>> on_stop;
+
+                bool await_ready() { return false; }
+
+                bool await_suspend(std::coroutine_handle<> h) {
+                    waiter.dest = data.data();
+                    waiter.size = data.size();
+                    waiter.handle = h;
+
+                    // Registered before the waiter is published, since the callback takes mtx and runs right away
+                    // if the stop was already requested
+                    if (token.stop_possible()) {
+                        on_stop.emplace(token, [this]() {
+                            std::lock_guard<std::mutex> lock(net->mtx);
+                            stopped = true;
+                            if (net->dirs[dir].waiter == &waiter) net->fail_waiter(dir, coproto::code::operation_aborted);
+                        });
+                    }
+
+                    std::lock_guard<std::mutex> lock(net->mtx);
+
+                    if (stopped) {
+                        waiter.ec = coproto::code::operation_aborted;
+                        return false;
+                    }
+
+                    if (net->closed) {
+                        waiter.ec = coproto::code::remoteClosed;
+                        return false;
+                    }
+
+                    Direction& d = net->dirs[dir];
+                    if (net->fill(d, waiter, clock::now())) return false;
+
+                    d.waiter = &waiter;
+                    return true;
+                }
+
+                std::pair<coproto::error_code, uint64_t> await_resume() {
+                    on_stop.reset();
+
+                    return {waiter.ec, waiter.filled};
+                }
+            };
+
+            // Raw socket of one side, in the shape coproto expects from user defined sockets
+            struct Endpoint {
+                EmulatedNetwork* net;
+                size_t dir;
+
+                SendAwaiter send(coproto::span<uint8_t> data, macoro::stop_token token = {}) { return SendAwaiter{net, dir, data, token}; }
+                RecvAwaiter recv(coproto::span<uint8_t> data, macoro::stop_token token = {}) { return RecvAwaiter{net, dir, data, token}; }
+                void close() { net->close(); }
+            };
+
+            explicit EmulatedNetwork(NetworkProfile profile) : profile(profile) {
+                for (Direction& d : this->dirs) d.tokens = (double) profile.burst_bytes;
+
+                this->timer_thread = std::thread([this]() { this->run_timers(); });
+            }
+
+            ~EmulatedNetwork() {
+                {
+                    std::lock_guard<std::mutex> lock(this->mtx);
+                    this->stopping = true;
+                }
+
+                this->cv.notify_one();
+                this->timer_thread.join();
+            }
+
+            EmulatedNetwork(const EmulatedNetwork&) = delete;
+            EmulatedNetwork& operator=(const EmulatedNetwork&) = delete;
+
+            // The sockets must not outlive the network.
+            std::array<coproto::Socket, 2> makePair() {
+                return {coproto::makeSocket(Endpoint{this, 0}), coproto::makeSocket(Endpoint{this, 1})};
+            }
+
+            // Fails the pending and later operations of both sockets with code::remoteClosed.
+            void close() {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                this->closed = true;
+
+                for (size_t dir = 0; dir < this->dirs.size(); dir++) fail_waiter(dir, coproto::code::remoteClosed);
+            }
+
+            const NetworkProfile& networkProfile() const { return this->profile; }
+
+            // Appends every message sent from now on to log, which must outlive the network.
+            void record(std::vector<LinkMessage>* log) {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                this->log = log;
+            }
+
+            size_t rounds() {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                return this->flights;
+            }
+    };
+
+};
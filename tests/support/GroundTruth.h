@@ -0,0 +1,189 @@
+#pragma once
+
+#include "../../sparseComp/Common/Common.h"
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Ground truth for the fuzzy protocol tests and benchmarks: the sender points within distance delta of some
+// receiver point, in the order of the sender points.
+//
+// The receiver points are bucketed in a uniform grid over plain integer cell keys. The cell side is at least
+// 2*delta+1, so the L_inf ball of radius delta around a sender point (which contains its L_1 and L_2 balls)
+// overlaps at most 2 cells per dimension, and only the cells it overlaps are looked up. With a side of
+// (2*delta+1)*d a ball straddles a cell border in (1+1/d)^d < 3 cells on average, instead of the 2^d cells of
+// the protocols' own spatial hashing. The candidates in those cells are checked exactly, so the result does
+// not depend on the receiver points being sparse. Sender points are looked up on all cores.
+
+namespace sparse_comp::bench {
+
+    enum class Metric { L1, L2, Linf };
+
+    template<Metric metric>
+    inline bool is_close(const point& a, const point& b, size_t d, uint64_t delta) {
+        uint64_t acc = 0;
+
+        for (size_t i = 0; i < d; i++) {
+            const uint64_t dist = a[i] > b[i] ? (uint64_t) (a[i] - b[i]) : (uint64_t) (b[i] - a[i]);
+
+            if (dist > delta) return false;
+
+            if constexpr (metric == Metric::L1) acc += dist;
+            if constexpr (metric == Metric::L2) acc += dist*dist;
+        }
+
+        if constexpr (metric == Metric::L1) return acc <= delta;
+        if constexpr (metric == Metric::L2) return acc <= delta*delta;
+        return true;
+    }
+
+    inline uint64_t grid_mix(uint64_t key, uint64_t cell) {
+        key = (key ^ cell) * 0x9E3779B97F4A7C15ULL;
+        return key ^ (key >> 29);
+    }
+
+    // Key of the grid cell of the given side that holds p. Distinct cells may share a key.
+    inline uint64_t grid_cell_key(const point& p, size_t d, uint64_t side) {
+        uint64_t key = 0;
+        for (size_t i = 0; i < d; i++) key = grid_mix(key, p[i] / side);
+        return key;
+    }
+
+    // Calls fn(key) for the keys of the grid cells overlapped by the L_inf ball of the given radius around p, until
+    // it returns true; returns whether it did. The side must be at least 2*radius+1.
+    template<typename Fn>
+    inline bool any_ball_cell(const point& p, size_t d, uint64_t radius, uint64_t side, Fn fn) {
+        uint64_t lo[point::MAX_DIM];
+        size_t straddling[point::MAX_DIM];
+        size_t straddling_count = 0;
+
+        for (size_t i = 0; i < d; i++) {
+            const uint64_t c = p[i];
+            lo[i] = (c >= radius ? c - radius : 0) / side;
+            if ((c + radius) / side != lo[i]) straddling[straddling_count++] = i;
+        }
+
+        for (size_t mask = 0; mask < ((size_t) 1 << straddling_count); mask++) {
+            uint64_t key = 0;
+            size_t next = 0;
+
+            for (size_t i = 0; i < d; i++) {
+                uint64_t cell = lo[i];
+                if (next < straddling_count && straddling[next] == i) cell += (mask >> next++) & 1;
+                key = grid_mix(key, cell);
+            }
+
+            if (fn(key)) return true;
+        }
+
+        return false;
+    }
+
+    class GridIndex {
+        private:
+            std::span<const point> points;
+            size_t d;
+            uint64_t delta;
+            uint64_t side;
+            // (cell key, point index), sorted by key.
+            std::vector<std::pair<uint64_t, uint32_t>> cells;
+
+        public:
+            GridIndex(std::span<const point> points, size_t d, uint64_t delta)
+                : points(points), d(d), delta(delta), side((2*delta + 1) * std::max<size_t>(d, 1)) {
+                this->cells.resize(points.size());
+
+                for (size_t i = 0; i < points.size(); i++) {
+                    this->cells[i] = std::make_pair(grid_cell_key(points[i], d, this->side), (uint32_t) i);
+                }
+
+                std::sort(this->cells.begin(), this->cells.end());
+            }
+
+            // Whether some indexed point is within delta of p.
+            template<Metric metric>
+            bool any_close(const point& p) const {
+                return any_ball_cell(p, this->d, this->delta, this->side, [&](uint64_t key) {
+                    auto it = std::lower_bound(this->cells.begin(), this->cells.end(), std::make_pair(key, (uint32_t) 0));
+
+                    // Key collisions only add candidates, which are checked like the others.
+                    for (; it != this->cells.end() && it->first == key; it++) {
+                        if (is_close<metric>(this->points[it->second], p, this->d, this->delta)) return true;
+                    }
+
+                    return false;
+                });
+            }
+    };
+
+    // Runs fn(begin, end) over [0, count) split across the cores, or inline for small counts.
+    template<typename Fn>
+    inline void parallel_ranges(size_t count, Fn fn) {
+        constexpr size_t MIN_PER_THREAD = 1 << 12;
+
+        const size_t threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                                (count + MIN_PER_THREAD - 1) / MIN_PER_THREAD);
+
+        if (threads <= 1) {
+            fn((size_t) 0, count);
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        const size_t chunk = (count + threads - 1) / threads;
+
+        for (size_t begin = 0; begin < count; begin += chunk) {
+            workers.emplace_back(fn, begin, std::min(count, begin + chunk));
+        }
+
+        for (auto& worker : workers) worker.join();
+    }
+
+    // Appends to intersec the sender points within distance delta of some receiver point, in sender order.
+    template<Metric metric>
+    inline void expected_intersect(std::span<const point> rcvr_points,
+                                   std::span<const point> sndr_points,
+                                   size_t d,
+                                   uint64_t delta,
+                                   std::vector<point>& intersec) {
+        GridIndex index(rcvr_points, d, delta);
+        std::vector<uint8_t> close(sndr_points.size());
+
+        parallel_ranges(sndr_points.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) close[i] = index.any_close<metric>(sndr_points[i]);
+        });
+
+        for (size_t i = 0; i < sndr_points.size(); i++) {
+            if (close[i]) intersec.push_back(sndr_points[i]);
+        }
+    }
+
+    inline bool coords_less(const point& a, const point& b) {
+        return std::lexicographical_compare(a.coords, a.coords + point::MAX_DIM, b.coords, b.coords + point::MAX_DIM);
+    }
+
+    inline bool coords_equal(const point& a, const point& b) {
+        return std::equal(a.coords, a.coords + point::MAX_DIM, b.coords);
+    }
+
+    // Whether intersec has as many points as expected_intersec and contains all of them, compared by coordinates.
+    inline bool is_intersec_correct(const std::vector<point>& intersec, const std::vector<point>& expected_intersec) {
+        if (intersec.size() != expected_intersec.size()) {
+            return false;
+        }
+
+        std::vector<point> sorted(intersec);
+        std::sort(sorted.begin(), sorted.end(), coords_less);
+
+        for (const point& p : expected_intersec) {
+            auto it = std::lower_bound(sorted.begin(), sorted.end(), p, coords_less);
+            if (it == sorted.end() || !coords_equal(*it, p)) return false;
+        }
+
+        return true;
+    }
+
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "../../sparseComp/Common/Trace.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Memory accounting for the benchmarks. A phase is charged the bytes and number of allocations made through
+// operator new by the process between its start and its end, the change of the process RSS over it, and the
+// peak RSS of the process when it ends. Allocations are counted by the global operator new/delete replacement
+// of AllocHook.cpp, which every bench executable links. RSS figures come from /proc/self/status; the peak is
+// reset through /proc/self/clear_refs at the start of each measured run, where the kernel allows it, so that
+// it covers that run only.
+//
+// Bench level phases are opened with MemoryScope; protocol phases are picked up from the trace spans through
+// MemoryPhaseRecorder, so they require the trace points to be compiled in (cmake -DSPARSE_COMP_TRACING=ON).
+
+namespace sparse_comp::bench {
+
+    struct AllocTotals {
+        uint64_t bytes = 0;
+        uint64_t count = 0;
+    };
+
+    // Allocations made through operator new by all the threads of the process so far. Defined in AllocHook.cpp.
+    AllocTotals process_alloc_totals();
+
+    struct MemorySample {
+        uint64_t alloc_bytes = 0;
+        uint64_t alloc_count = 0;
+        int64_t rss_delta_kb = 0;
+        uint64_t peak_rss_kb = 0;
+        uint64_t runs = 0;
+
+        MemorySample& operator+=(const MemorySample& other) {
+            this->alloc_bytes += other.alloc_bytes;
+            this->alloc_count += other.alloc_count;
+            this->rss_delta_kb += other.rss_delta_kb;
+            this->peak_rss_kb = std::max(this->peak_rss_kb, other.peak_rss_kb);
+            this->runs += other.runs;
+
+            return *this;
+        }
+    };
+
+    // Memory use per phase over all runs, keyed by phase name
+    using MemoryReport = std::map<std::string, MemorySample>;
+
+    struct MemoryReading {
+        AllocTotals alloc;
+        uint64_t rss_kb = 0;
+        uint64_t peak_rss_kb = 0;
+    };
+
+    inline MemoryReading read_memory() {
+        MemoryReading reading;
+        reading.alloc = process_alloc_totals();
+
+        FILE* f = std::fopen("/proc/self/status", "r");
+        if (f == nullptr) return reading;
+
+        char line[256];
+        unsigned long long kb = 0;
+
+        while (std::fgets(line, sizeof(line), f) != nullptr) {
+            if (std::sscanf(line, "VmRSS: %llu kB", &kb) == 1) reading.rss_kb = kb;
+            else if (std::sscanf(line, "VmHWM: %llu kB", &kb) == 1) reading.peak_rss_kb = kb;
+        }
+
+        std::fclose(f);
+
+        return reading;
+    }
+
+    // Resets the peak RSS of the process to its current RSS. Returns false where the kernel does not allow it.
+    inline bool reset_peak_rss() {
+        FILE* f = std::fopen("/proc/self/clear_refs", "w");
+        if (f == nullptr) return false;
+
+        const bool written = std::fputs("5", f) >= 0;
+
+        return std::fclose(f) == 0 && written;
+    }
+
+    inline MemorySample memory_delta(const MemoryReading& from, const MemoryReading& to) {
+        MemorySample sample;
+        sample.alloc_bytes = to.alloc.bytes - from.alloc.bytes;
+        sample.alloc_count = to.alloc.count - from.alloc.count;
+        sample.rss_delta_kb = (int64_t) to.rss_kb - (int64_t) from.rss_kb;
+        sample.peak_rss_kb = to.peak_rss_kb;
+        sample.runs = 1;
+
+        return sample;
+    }
+
+    // Charges the allocations of the process during its lifetime to report[name].
+    class MemoryScope {
+        private:
+            MemoryReport& report;
+            std::string name;
+            MemoryReading start;
+
+        public:
+            MemoryScope(MemoryReport& report, const std::string& name) : report(report), name(name), start(read_memory()) {}
+
+            ~MemoryScope() {
+                this->report[this->name] += memory_delta(this->start, read_memory());
+            }
+
+            MemoryScope(const MemoryScope&) = delete;
+            MemoryScope& operator=(const MemoryScope&) = delete;
+    };
+
+    // Charges the trace spans of the registered tracks, run on the constructing thread, to report as
+    // "<role>/<span name>". Spans nest, and each one is charged its whole duration.
+    class MemoryPhaseRecorder : public sparse_comp::trace::SpanObserver {
+        private:
+            MemoryReport& report;
+            std::thread::id owner;
+            std::map<const void*, std::string> roles;
+            std::vector<std::pair<std::string, MemoryReading>> open_spans;
+
+        public:
+            explicit MemoryPhaseRecorder(MemoryReport& report) : report(report), owner(std::this_thread::get_id()) {
+                if (sparse_comp::trace::enabled()) sparse_comp::trace::add_span_observer(this);
+            }
+
+            ~MemoryPhaseRecorder() {
+                if (sparse_comp::trace::enabled()) sparse_comp::trace::remove_span_observer(this);
+            }
+
+            MemoryPhaseRecorder(const MemoryPhaseRecorder&) = delete;
+            MemoryPhaseRecorder& operator=(const MemoryPhaseRecorder&) = delete;
+
+            void add_track(const void* track, const std::string& role) {
+                this->roles[track] = role;
+            }
+
+            void span_begin(const void* track, const char* name) override {
+                if (std::this_thread::get_id() != this->owner) return;
+
+                auto it = this->roles.find(track);
+                if (it == this->roles.end()) return;
+
+                this->open_spans.emplace_back(it->second + "/" + name, read_memory());
+            }
+
+            void span_end(const void* track, const char*) override {
+                if (std::this_thread::get_id() != this->owner || this->roles.count(track) == 0 || this->open_spans.empty()) return;
+
+                this->report[this->open_spans.back().first] += memory_delta(this->open_spans.back().second, read_memory());
+                this->open_spans.pop_back();
+            }
+    };
+
+    // Prints one line per phase of report: allocations and RSS change averaged over its runs, and its peak RSS.
+    inline void print_memory(const MemoryReport& report) {
+        for (auto& [name, sample] : report) {
+            if (sample.runs == 0) continue;
+
+            const double runs = (double) sample.runs;
+
+            std::printf("Memory %-32s allocated: %10.3f MBs allocations: %10.0f rss delta: %10.3f MBs peak rss: %10.3f MBs runs: %lu\n",
+                        name.c_str(),
+                        ((double) sample.alloc_bytes)/runs/1024.0/1024.0,
+                        ((double) sample.alloc_count)/runs,
+                        ((double) sample.rss_delta_kb)/runs/1024.0,
+                        ((double) sample.peak_rss_kb)/1024.0,
+                        (unsigned long) sample.runs);
+        }
+    }
+
+};
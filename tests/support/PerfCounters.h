@@ -0,0 +1,294 @@
+#pragma once
+
+#include "../../sparseComp/Common/Trace.h"
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Hardware counters for the benchmarks, enabled with SPARSE_COMP_BENCH_PERF=1.
+//
+// Each measuring thread opens one perf_event group (cycles, instructions, last level cache misses, dTLB load
+// misses and branch misses) counting its own user space work. A phase is charged the counter deltas between its
+// start and its end, scaled for the time the group was multiplexed out. Bench level phases are opened with
+// PerfScope; protocol phases are picked up from the trace spans (SPARSE_COMP_TRACE_SCOPE and
+// SPARSE_COMP_TRACE_NESTED) through PerfPhaseRecorder, so they require the trace points to be compiled in
+// (cmake -DSPARSE_COMP_TRACING=ON). When the counters cannot be opened (no PMU in a VM, perf_event_paranoid,
+// seccomp) a single line says so and the benchmarks run as usual; counters that fail alone are reported as n/a.
+
+namespace sparse_comp::bench {
+
+    enum PerfCounter {
+        PERF_CYCLES,
+        PERF_INSTRUCTIONS,
+        PERF_LLC_MISSES,
+        PERF_DTLB_MISSES,
+        PERF_BRANCH_MISSES,
+        NUM_PERF_COUNTERS
+    };
+
+    struct PerfSample {
+        std::array<double, NUM_PERF_COUNTERS> values{};
+        std::array<bool, NUM_PERF_COUNTERS> valid{};
+        uint64_t runs = 0;
+
+        PerfSample& operator+=(const PerfSample& other) {
+            for (size_t i = 0; i < NUM_PERF_COUNTERS; i++) {
+                this->valid[i] = (this->runs == 0 || this->valid[i]) && other.valid[i];
+                this->values[i] += other.values[i];
+            }
+
+            this->runs += other.runs;
+
+            return *this;
+        }
+    };
+
+    // Counter totals per phase over all runs, keyed by phase name
+    using PerfReport = std::map<std::string, PerfSample>;
+
+    inline bool perf_requested() {
+        const char* perf = std::getenv("SPARSE_COMP_BENCH_PERF");
+
+        return perf != nullptr && std::string(perf) != "0";
+    }
+
+    struct PerfReading {
+        std::array<uint64_t, NUM_PERF_COUNTERS> raw{};
+        uint64_t time_enabled = 0;
+        uint64_t time_running = 0;
+    };
+
+    class PerfCounterGroup {
+        private:
+            std::array<int, NUM_PERF_COUNTERS> fds;
+            std::vector<PerfCounter> opened; // In the order the group reports them
+
+            static int open_counter(uint32_t type, uint64_t config, int group_fd) {
+                struct perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+
+                attr.size = sizeof(attr);
+                attr.type = type;
+                attr.config = config;
+                attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+
+                return (int) ::syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+            }
+
+        public:
+            PerfCounterGroup() {
+                this->fds.fill(-1);
+            }
+
+            ~PerfCounterGroup() {
+                for (int fd : this->fds) {
+                    if (fd >= 0) ::close(fd);
+                }
+            }
+
+            PerfCounterGroup(const PerfCounterGroup&) = delete;
+            PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+            // Opens the group on the calling thread. Returns false, with the reason in error, if not even the
+            // cycle counter is available.
+            bool open(std::string& error) {
+                const uint64_t dtlb_read_miss = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+                const std::array<std::pair<uint32_t, uint64_t>, NUM_PERF_COUNTERS> events = {{
+                    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+                    {PERF_TYPE_HW_CACHE, dtlb_read_miss},
+                    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+                }};
+
+                for (size_t i = 0; i < NUM_PERF_COUNTERS; i++) {
+                    this->fds[i] = open_counter(events[i].first, events[i].second, i == 0 ? -1 : this->fds[PERF_CYCLES]);
+
+                    if (this->fds[i] >= 0) {
+                        this->opened.push_back((PerfCounter) i);
+                    } else if (i == PERF_CYCLES) {
+                        error = std::strerror(errno);
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            PerfReading read() const {
+                std::array<uint64_t, 3 + NUM_PERF_COUNTERS> buf{};
+                PerfReading reading;
+
+                if (::read(this->fds[PERF_CYCLES], buf.data(), sizeof(buf)) <= 0) return reading;
+
+                reading.time_enabled = buf[1];
+                reading.time_running = buf[2];
+
+                for (size_t i = 0; i < this->opened.size() && i < buf[0]; i++) {
+                    reading.raw[this->opened[i]] = buf[3 + i];
+                }
+
+                return reading;
+            }
+
+            PerfSample delta(const PerfReading& from, const PerfReading& to) const {
+                PerfSample sample;
+                sample.runs = 1;
+
+                const uint64_t enabled = to.time_enabled - from.time_enabled;
+                const uint64_t running = to.time_running - from.time_running;
+
+                // A group that never got scheduled in (all PMU slots taken) has nothing to extrapolate from
+                if (running == 0) return sample;
+
+                for (PerfCounter counter : this->opened) {
+                    sample.values[counter] = (double) (to.raw[counter] - from.raw[counter]) * (double) enabled / (double) running;
+                    sample.valid[counter] = true;
+                }
+
+                return sample;
+            }
+    };
+
+    // The counter group of the calling thread, nullptr if counters are not requested or not available.
+    inline PerfCounterGroup* thread_perf_counters() {
+        thread_local std::unique_ptr<PerfCounterGroup> group;
+        thread_local bool tried = false;
+
+        if (!tried) {
+            tried = true;
+
+            if (perf_requested()) {
+                std::string error;
+                group = std::make_unique<PerfCounterGroup>();
+
+                if (!group->open(error)) {
+                    static bool reported = false;
+                    if (!reported) std::printf("Hardware counters unavailable: %s\n", error.c_str());
+                    reported = true;
+
+                    group.reset();
+                }
+            }
+        }
+
+        return group.get();
+    }
+
+    // Charges the work of the calling thread during its lifetime to report[name].
+    class PerfScope {
+        private:
+            PerfCounterGroup* group;
+            PerfReport& report;
+            std::string name;
+            PerfReading start;
+
+        public:
+            PerfScope(PerfReport& report, const std::string& name) : group(thread_perf_counters()), report(report), name(name) {
+                if (this->group != nullptr) this->start = this->group->read();
+            }
+
+            ~PerfScope() {
+                if (this->group != nullptr) this->report[this->name] += this->group->delta(this->start, this->group->read());
+            }
+
+            PerfScope(const PerfScope&) = delete;
+            PerfScope& operator=(const PerfScope&) = delete;
+    };
+
+    // Charges the trace spans of the registered tracks, run on the constructing thread, to report as
+    // "<role>/<span name>". Spans nest, and each one is charged its whole duration.
+    class PerfPhaseRecorder : public sparse_comp::trace::SpanObserver {
+        private:
+            PerfCounterGroup* group;
+            PerfReport& report;
+            std::thread::id owner;
+            std::map<const void*, std::string> roles;
+            std::vector<std::pair<std::string, PerfReading>> open_spans;
+
+        public:
+            explicit PerfPhaseRecorder(PerfReport& report) : group(thread_perf_counters()), report(report), owner(std::this_thread::get_id()) {
+                if (this->group != nullptr && sparse_comp::trace::enabled()) sparse_comp::trace::add_span_observer(this);
+            }
+
+            ~PerfPhaseRecorder() {
+                if (this->group != nullptr && sparse_comp::trace::enabled()) sparse_comp::trace::remove_span_observer(this);
+            }
+
+            PerfPhaseRecorder(const PerfPhaseRecorder&) = delete;
+            PerfPhaseRecorder& operator=(const PerfPhaseRecorder&) = delete;
+
+            void add_track(const void* track, const std::string& role) {
+                this->roles[track] = role;
+            }
+
+            void span_begin(const void* track, const char* name) override {
+                if (std::this_thread::get_id() != this->owner) return;
+
+                auto it = this->roles.find(track);
+                if (it == this->roles.end()) return;
+
+                this->open_spans.emplace_back(it->second + "/" + name, this->group->read());
+            }
+
+            void span_end(const void* track, const char*) override {
+                if (std::this_thread::get_id() != this->owner || this->roles.count(track) == 0 || this->open_spans.empty()) return;
+
+                const PerfReading end = this->group->read();
+
+                this->report[this->open_spans.back().first] += this->group->delta(this->open_spans.back().second, end);
+                this->open_spans.pop_back();
+            }
+    };
+
+    // Prints the IPC of the phase and its misses per item, averaged over its runs.
+    inline void print_perf_phase(const std::string& name, const PerfSample& sample, size_t items) {
+        if (sample.runs == 0) return;
+
+        auto per_run = [&sample](PerfCounter counter) { return sample.values[counter] / (double) sample.runs; };
+        auto per_item = [&sample, items, &per_run](PerfCounter counter) {
+            if (!sample.valid[counter]) return std::string("n/a");
+
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.3f", per_run(counter) / (double) (items == 0 ? 1 : items));
+            return std::string(buf);
+        };
+
+        std::string ipc = "n/a";
+        if (sample.valid[PERF_CYCLES] && sample.valid[PERF_INSTRUCTIONS] && sample.values[PERF_CYCLES] > 0) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.3f", sample.values[PERF_INSTRUCTIONS] / sample.values[PERF_CYCLES]);
+            ipc = buf;
+        }
+
+        std::printf("Perf %-32s IPC: %8s cycles/item: %12s LLC misses/item: %10s dTLB misses/item: %10s branch misses/item: %10s runs: %lu\n",
+                    name.c_str(), ipc.c_str(),
+                    per_item(PERF_CYCLES).c_str(),
+                    per_item(PERF_LLC_MISSES).c_str(),
+                    per_item(PERF_DTLB_MISSES).c_str(),
+                    per_item(PERF_BRANCH_MISSES).c_str(),
+                    (unsigned long) sample.runs);
+    }
+
+    // Prints every phase of report, with its misses divided by items.
+    inline void print_perf(const PerfReport& report, size_t items) {
+        for (auto& [name, sample] : report) print_perf_phase(name, sample, items);
+    }
+
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+
+// Unique path under the temporary directory for the files written by a test. The file and its companions (the
+// .tmp file of an atomic write and the .cursor file of an OT pool) are removed when the guard goes out of scope,
+// so a failing REQUIRE leaves nothing behind and concurrent test processes do not collide.
+
+namespace sparse_comp::bench {
+
+    class TempPath {
+        private:
+            std::string file_path;
+
+        public:
+            explicit TempPath(const std::string& name) {
+                static std::atomic<uint64_t> counter = 0;
+
+                const std::string unique = "sparse_comp_" + std::to_string(::getpid()) + "_" + std::to_string(counter++) + "_" + name;
+                this->file_path = (std::filesystem::temp_directory_path() / unique).string();
+            }
+
+            ~TempPath() {
+                std::error_code ec;
+
+                for (const char* suffix : {"", ".tmp", ".cursor", ".cursor.tmp"}) {
+                    std::filesystem::remove(this->file_path + suffix, ec);
+                }
+            }
+
+            TempPath(const TempPath&) = delete;
+            TempPath& operator=(const TempPath&) = delete;
+
+            const std::string& str() const { return this->file_path; }
+    };
+
+};
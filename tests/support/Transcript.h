@@ -0,0 +1,192 @@
+#pragma once
+
+#include "coproto/Socket/Socket.h"
+#include "./EmulatedNetwork.h"
+#include <algorithm>
+#include <coroutine>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// Transcripts of a two party run, for benchmarking and profiling one party without its peer.
+//
+// A recorded run logs every message of an EmulatedNetwork pair in the order it was sent (see
+// EmulatedNetwork::record). Replaying the transcript for one party hands it the bytes its peer sent, without
+// the peer running, and checks that what it sends matches what it sent during the recording. As the parties
+// draw all their randomness from the PRNGs they are constructed with, a party set up with the seeds of the
+// recorded run replays it exactly; a mismatch means the party changed its messages since the recording.
+//
+// The sends of a party are compared as a single stream, so the party must send its messages in the same order
+// on every run. Protocols whose subsockets are driven by a thread pool, like the partition parallel mode of
+// FuzzyParallel.h, interleave their messages differently from run to run and cannot be replayed.
+//
+// File layout: the magic "SPCTRNS1", then for every message the sending party (1 byte), the message size
+// (8 bytes, little endian) and the message bytes.
+
+namespace sparse_comp::bench {
+
+    class Transcript {
+        private:
+            static constexpr char MAGIC[8] = {'S', 'P', 'C', 'T', 'R', 'N', 'S', '1'};
+
+        public:
+            std::vector<LinkMessage> messages;
+
+            void save(const std::string& path) const {
+                std::ofstream out(path, std::ios::binary | std::ios::trunc);
+                if (!out) throw std::runtime_error("could not create the transcript " + path);
+
+                out.write(MAGIC, sizeof(MAGIC));
+
+                for (const LinkMessage& message : this->messages) {
+                    const uint64_t size = message.data.size();
+
+                    out.write((const char*) &message.from, 1);
+                    out.write((const char*) &size, sizeof(size));
+                    out.write((const char*) message.data.data(), (std::streamsize) size);
+                }
+
+                if (!out) throw std::runtime_error("could not write the transcript " + path);
+            }
+
+            static Transcript load(const std::string& path) {
+                std::ifstream in(path, std::ios::binary);
+                if (!in) throw std::runtime_error("could not open the transcript " + path + ", record it first with SPARSE_COMP_BENCH_PARTIES=record");
+
+                char magic[sizeof(MAGIC)];
+                in.read(magic, sizeof(magic));
+                if (!in || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) throw std::runtime_error(path + " is not a transcript");
+
+                Transcript transcript;
+                LinkMessage message;
+                uint64_t size = 0;
+
+                while (in.read((char*) &message.from, 1)) {
+                    in.read((char*) &size, sizeof(size));
+                    message.data.resize(size);
+                    in.read((char*) message.data.data(), (std::streamsize) size);
+
+                    if (!in || message.from > 1) throw std::runtime_error("the transcript " + path + " is truncated or corrupt");
+
+                    transcript.messages.push_back(message);
+                }
+
+                return transcript;
+            }
+    };
+
+    // One party's side of a transcript. socket() returns a socket on which the party receives the bytes sent by
+    // its peer and whose sends are checked against the recording; both complete immediately.
+    class ReplayStream {
+        private:
+            std::vector<uint8_t> incoming;
+            std::vector<uint8_t> outgoing;
+            size_t received = 0;
+            size_t sent = 0;
+            bool diverged = false;
+            size_t diverged_at = 0; // Offset in the party's sends of the first byte that differs from the recording
+
+        public:
+            struct SendAwaiter {
+                ReplayStream* stream;
+                coproto::span<uint8_t> data;
+
+                bool await_ready() { return true; }
+                bool await_suspend(std::coroutine_handle<>) { return false; }
+
+                std::pair<coproto::error_code, uint64_t> await_resume() {
+                    ReplayStream& s = *this->stream;
+
+                    if (s.diverged) return {std::make_error_code(std::errc::protocol_error), 0};
+
+                    const size_t recorded = std::min(data.size(), s.outgoing.size() - s.sent);
+                    const auto mismatch = std::mismatch(data.begin(), data.begin() + recorded, s.outgoing.begin() + s.sent);
+
+                    if (mismatch.first != data.begin() + recorded || recorded < data.size()) {
+                        s.diverged = true;
+                        s.diverged_at = s.sent + (size_t) (mismatch.first - data.begin());
+                        return {std::make_error_code(std::errc::protocol_error), 0};
+                    }
+
+                    s.sent += data.size();
+                    return {coproto::error_code{}, data.size()};
+                }
+            };
+
+            struct RecvAwaiter {
+                ReplayStream* stream;
+                coproto::span<uint8_t> data;
+
+                bool await_ready() { return true; }
+                bool await_suspend(std::coroutine_handle<>) { return false; }
+
+                std::pair<coproto::error_code, uint64_t> await_resume() {
+                    ReplayStream& s = *this->stream;
+                    const size_t n = std::min(data.size(), s.incoming.size() - s.received);
+
+                    std::memcpy(data.data(), s.incoming.data() + s.received, n);
+                    s.received += n;
+
+                    if (n < data.size()) return {std::make_error_code(std::errc::connection_aborted), n};
+                    return {coproto::error_code{}, n};
+                }
+            };
+
+            struct Endpoint {
+                ReplayStream* stream;
+
+                SendAwaiter send(coproto::span<uint8_t> data, macoro::stop_token token = {}) { return SendAwaiter{stream, data}; }
+                RecvAwaiter recv(coproto::span<uint8_t> data, macoro::stop_token token = {}) { return RecvAwaiter{stream, data}; }
+                void close() {}
+            };
+
+            ReplayStream(const Transcript& transcript, size_t party) {
+                for (const LinkMessage& message : transcript.messages) {
+                    std::vector<uint8_t>& bytes = message.from == party ? this->outgoing : this->incoming;
+                    bytes.insert(bytes.end(), message.data.begin(), message.data.end());
+                }
+            }
+
+            ReplayStream(const ReplayStream&) = delete;
+            ReplayStream& operator=(const ReplayStream&) = delete;
+
+            // The socket must not outlive the stream.
+            coproto::Socket socket() {
+                return coproto::makeSocket(Endpoint{this});
+            }
+
+            // Throws unless the party sent exactly its recorded messages and consumed all of its peer's.
+            void check(const std::string& role) const {
+                if (this->diverged) {
+                    throw std::runtime_error("the " + role + " diverged from the transcript at byte " + std::to_string(this->diverged_at) +
+                                             " of its sends, was it recorded with other inputs, seeds or code?");
+                }
+                if (this->sent != this->outgoing.size() || this->received != this->incoming.size()) {
+                    throw std::runtime_error("the " + role + " sent " + std::to_string(this->sent) + " of " + std::to_string(this->outgoing.size()) +
+                                             " and received " + std::to_string(this->received) + " of " + std::to_string(this->incoming.size()) +
+                                             " recorded bytes");
+                }
+            }
+
+            // Runs proto, the party's protocol on socket(), to completion, then checks it as check does. A
+            // protocol that fails on a divergence or on running out of recorded bytes only sees a socket error,
+            // so the failure is reported as check reports it instead.
+            template<typename Proto>
+            void replay(Proto proto, const std::string& role) {
+                try {
+                    macoro::sync_wait(std::move(proto));
+                } catch (...) {
+                    if (this->diverged || this->received == this->incoming.size()) this->check(role);
+                    throw;
+                }
+
+                this->check(role);
+            }
+    };
+
+};
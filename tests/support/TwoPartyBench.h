@@ -0,0 +1,538 @@
+#pragma once
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/interfaces/catch_interfaces_capture.hpp"
+#include "coproto/Socket/Socket.h"
+#include "coproto/Socket/AsioSocket.h"
+#include "../../sparseComp/Common/CommStats.h"
+#include "../../sparseComp/Common/Trace.h"
+#include "./BenchResults.h"
+#include "./EmulatedNetwork.h"
+#include "./MemoryProfile.h"
+#include "./PerfCounters.h"
+#include "./Transcript.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Party runner shared by the SpX and Fuzzy benchmarks.
+//
+// By default both parties run as coroutines of a single thread over a LocalAsyncSocket pair, so the measured
+// time is the sum of the work of both parties. With SPARSE_COMP_BENCH_PARTIES=processes every measured run forks
+// the receiver into its own process, connected to the sender over a local TCP socket (SPARSE_COMP_BENCH_PORT,
+// default 30123), and reports the wall clock latency, each party's CPU time and the time each party spent
+// waiting on its peer. The receiver outputs are shipped back to the parent so the benchmarks can keep checking
+// them. Inputs must be set up before measure_parties is called; run a single sample (--benchmark-samples 1),
+// as the protocols append to their outputs. In both modes the communication of every protocol phase, as seen
+// by the sender, is printed after the measurement. When the trace points are compiled in and SPARSE_COMP_TRACE_DIR
+// is set, each party's spans are written to <dir>/<test name>-<run>.<sender|receiver>.json. With
+// SPARSE_COMP_BENCH_PERF=1 the hardware counters of the run (and of each traced phase, see PerfCounters.h) are
+// collected in TwoPartyStats::perf; in process mode only the sender's are. The allocations and RSS of the run and
+// of each traced phase (see MemoryProfile.h) are printed after every measurement; in process mode they are
+// reported for each party. The whole run is accounted as the phase "run", and its bytes, flights and peak RSS
+// are handed to the result reporters (see BenchResults.h). With the trace points compiled in, the time spent in
+// each traced phase is printed per party as well.
+//
+// SPARSE_COMP_BENCH_PARTIES=record runs like local mode over an EmulatedNetwork loopback pair and saves the
+// messages of the run to <SPARSE_COMP_TRANSCRIPT_DIR, default .>/<test name>-<run>.transcript. A later run with
+// SPARSE_COMP_BENCH_PARTIES=replay-sender or replay-receiver measures that party alone against the transcript
+// (see Transcript.h), so profiles and counters cover only its work; the phases and memory are then the ones of
+// the replayed party. The other party is replayed afterwards, unmeasured, to produce its outputs for the checks.
+// A replayed party that departs from the transcript fails with the offset of the first byte it sent differently.
+// Recording and replaying need the parties to send their messages in the same order on every run, which the
+// partition parallel mode of FuzzyParallel.h does not (sweep_bench --threads above 1).
+
+namespace sparse_comp::bench {
+
+    enum class PartyMode {
+        Local,
+        Processes,
+        Record,
+        ReplaySender,
+        ReplayReceiver
+    };
+
+    struct PartyStats {
+        double wall_ms = 0;
+        double cpu_ms = 0;
+        double idle_ms = 0;
+    };
+
+    using PhaseTimes = std::map<std::string, sparse_comp::trace::SpanTotal>; // Keyed by role/phase
+
+    struct TwoPartyStats {
+        PartyStats sender;
+        PartyStats receiver;
+        double wall_ms = 0;
+        size_t bytes = 0; // Bytes sent and received by the sender over all runs
+        size_t runs = 0;
+        sparse_comp::comm::PhaseReport phases; // Per phase communication of the sender over all runs
+        PerfReport perf; // Hardware counters per phase over all runs, empty unless requested
+        MemoryReport memory; // Allocations and RSS per phase over all runs
+        PhaseTimes times; // Time per traced phase over all runs, empty unless the trace points are compiled in
+    };
+
+    inline PartyMode party_mode() {
+        const char* mode = std::getenv("SPARSE_COMP_BENCH_PARTIES");
+
+        if (mode == nullptr || std::string(mode) == "local") return PartyMode::Local;
+        if (std::string(mode) == "processes") return PartyMode::Processes;
+        if (std::string(mode) == "record") return PartyMode::Record;
+        if (std::string(mode) == "replay-sender") return PartyMode::ReplaySender;
+        if (std::string(mode) == "replay-receiver") return PartyMode::ReplayReceiver;
+
+        throw std::runtime_error("SPARSE_COMP_BENCH_PARTIES must be local, processes, record, replay-sender or replay-receiver");
+    }
+
+    namespace detail {
+
+        inline std::string current_test_file_name() {
+            std::string name = Catch::getResultCapture().getCurrentTestName();
+            for (char& c : name) {
+                if (!std::isalnum((unsigned char) c)) c = '_';
+            }
+
+            return name;
+        }
+
+        // Base path of the trace files of the next measured run, empty if no trace is requested.
+        inline std::string next_trace_path() {
+            static size_t trace_counter = 0;
+            const char* dir = std::getenv("SPARSE_COMP_TRACE_DIR");
+
+            if (!sparse_comp::trace::enabled() || dir == nullptr) return std::string();
+
+            return std::string(dir) + "/" + current_test_file_name() + "-" + std::to_string(trace_counter++);
+        }
+
+        // Path of the transcript of the next recorded or replayed run. Runs are numbered as for the traces, so
+        // a replay must select the same tests as the recording.
+        inline std::string next_transcript_path() {
+            static size_t transcript_counter = 0;
+            const char* dir = std::getenv("SPARSE_COMP_TRANSCRIPT_DIR");
+
+            return std::string(dir == nullptr ? "." : dir) + "/" + current_test_file_name() + "-" + std::to_string(transcript_counter++) + ".transcript";
+        }
+
+        // Adds the spans recorded on sock to times.
+        inline void collect_times(PhaseTimes& times, const coproto::Socket& sock, const std::string& role) {
+            if (!sparse_comp::trace::enabled()) return;
+
+            for (auto& [name, total] : sparse_comp::trace::totals(&sock)) times[role + "/" + name] += total;
+        }
+
+        // Drops spans left on the address of sock by an earlier socket.
+        inline void clear_spans(const coproto::Socket& sock) {
+            if (sparse_comp::trace::enabled()) sparse_comp::trace::clear(&sock);
+        }
+
+        inline void write_trace(const coproto::Socket& sock, const std::string& trace_path, const std::string& role) {
+            if (trace_path.empty()) return;
+
+            sparse_comp::trace::write_chrome_json(&sock, trace_path + "." + role + ".json", role);
+            sparse_comp::trace::clear(&sock);
+        }
+
+        inline double process_cpu_ms() {
+            struct rusage usage;
+            getrusage(RUSAGE_SELF, &usage);
+
+            return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+        }
+
+        inline void write_all(int fd, const void* data, size_t size) {
+            const uint8_t* ptr = (const uint8_t*) data;
+
+            while (size > 0) {
+                ssize_t written = ::write(fd, ptr, size);
+                if (written <= 0) throw std::runtime_error("could not write to the result pipe");
+
+                ptr += written;
+                size -= (size_t) written;
+            }
+        }
+
+        inline void read_all(int fd, void* data, size_t size) {
+            uint8_t* ptr = (uint8_t*) data;
+
+            while (size > 0) {
+                ssize_t got = ::read(fd, ptr, size);
+                if (got <= 0) throw std::runtime_error("the receiver process exited without reporting its results");
+
+                ptr += got;
+                size -= (size_t) got;
+            }
+        }
+
+        template<typename T>
+        void write_out(int fd, T& out) {
+            static_assert(std::is_trivially_copyable_v<T>, "receiver outputs must be trivially copyable or vectors of such");
+            write_all(fd, &out, sizeof(T));
+        }
+
+        template<typename T>
+        void write_out(int fd, std::vector<T>& out) {
+            static_assert(std::is_trivially_copyable_v<T>, "receiver outputs must be trivially copyable or vectors of such");
+            uint64_t size = out.size();
+            write_all(fd, &size, sizeof(size));
+            write_all(fd, out.data(), size * sizeof(T));
+        }
+
+        template<typename T>
+        void read_out(int fd, T& out) {
+            read_all(fd, &out, sizeof(T));
+        }
+
+        template<typename T>
+        void read_out(int fd, std::vector<T>& out) {
+            uint64_t size = 0;
+            read_all(fd, &size, sizeof(size));
+            out.resize(size);
+            read_all(fd, out.data(), size * sizeof(T));
+        }
+
+        template<typename T>
+        void write_out(int fd, std::map<std::string, T>& out) {
+            static_assert(std::is_trivially_copyable_v<T>, "report entries must be trivially copyable");
+            uint64_t size = out.size();
+            write_all(fd, &size, sizeof(size));
+
+            for (auto& [name, entry] : out) {
+                uint64_t name_size = name.size();
+                write_all(fd, &name_size, sizeof(name_size));
+                write_all(fd, name.data(), name_size);
+                write_all(fd, &entry, sizeof(T));
+            }
+        }
+
+        template<typename T>
+        void read_out(int fd, std::map<std::string, T>& out) {
+            uint64_t size = 0;
+            read_all(fd, &size, sizeof(size));
+
+            for (uint64_t i = 0; i < size; i++) {
+                uint64_t name_size = 0;
+                read_all(fd, &name_size, sizeof(name_size));
+
+                std::string name(name_size, '\0');
+                read_all(fd, name.data(), name_size);
+                read_all(fd, &out[name], sizeof(T));
+            }
+        }
+
+        // Connects to the peer, runs the party and returns its timings. The clocks start once the
+        // connection is up, so connection setup is not accounted.
+        template<typename PartyFn>
+        PartyStats run_party(PartyFn& party, const std::string& address, bool is_server, size_t& bytes, sparse_comp::comm::PhaseReport& phases, PerfReport& perf, MemoryReport& memory, PhaseTimes& times, const std::string& trace_path) {
+#ifdef COPROTO_ENABLE_BOOST
+            boost::asio::io_context ioc;
+            auto work = boost::asio::make_work_guard(ioc);
+            std::thread io_thread([&ioc]() { ioc.run(); });
+
+            PartyStats stats;
+
+            {
+                coproto::AsioSocket sock = coproto::asioConnect(address, is_server, ioc);
+                const std::string role = is_server ? "receiver" : "sender";
+
+                PerfPhaseRecorder recorder(perf);
+                recorder.add_track(&sock, role);
+                MemoryPhaseRecorder memory_recorder(memory);
+                memory_recorder.add_track(&sock, role);
+
+                clear_spans(sock);
+                reset_peak_rss();
+
+                const double cpu_start = process_cpu_ms();
+                const auto start = std::chrono::steady_clock::now();
+
+                {
+                    sparse_comp::comm::CommScope run_comm(sock, "run");
+                    MemoryScope run_memory(memory, role + "/run");
+                    PerfScope run(perf, role + "/run");
+                    macoro::sync_wait(party(sock));
+                    macoro::sync_wait(sock.flush());
+                }
+
+                stats.wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                stats.cpu_ms = process_cpu_ms() - cpu_start;
+                stats.idle_ms = stats.wall_ms > stats.cpu_ms ? stats.wall_ms - stats.cpu_ms : 0;
+
+                bytes = sock.bytesSent() + sock.bytesReceived();
+                phases = sparse_comp::comm::report(sock);
+                sparse_comp::comm::reset(sock);
+                collect_times(times, sock, role);
+                write_trace(sock, trace_path, role);
+                sock.close();
+            }
+
+            work.reset();
+            io_thread.join();
+
+            return stats;
+#else
+            throw std::runtime_error("SPARSE_COMP_BENCH_PARTIES=processes requires coproto built with boost");
+#endif
+        }
+
+        inline std::string next_address() {
+            static size_t run_counter = 0;
+            const char* port = std::getenv("SPARSE_COMP_BENCH_PORT");
+
+            return "127.0.0.1:" + std::to_string((port == nullptr ? 30123 : std::atoi(port)) + (run_counter++ % 64));
+        }
+
+        template<typename SenderFn, typename ReceiverFn, typename... Outs>
+        void run_forked(TwoPartyStats& stats, SenderFn& sender, ReceiverFn& receiver, Outs&... receiver_outs) {
+            const std::string address = next_address();
+            const std::string trace_path = next_trace_path();
+            int result_pipe[2];
+
+            if (::pipe(result_pipe) != 0) throw std::runtime_error("could not create the result pipe");
+
+            // Opened before forking so that an unavailability notice is printed once
+            thread_perf_counters();
+
+            std::cout.flush();
+            pid_t pid = ::fork();
+
+            if (pid < 0) throw std::runtime_error("could not fork the receiver process");
+
+            if (pid == 0) { // Receiver process, never returns to Catch
+                ::close(result_pipe[0]);
+
+                try {
+                    size_t bytes = 0;
+                    sparse_comp::comm::PhaseReport phases;
+                    PerfReport perf;
+                    MemoryReport memory;
+                    PhaseTimes times;
+                    PartyStats receiver_stats = run_party(receiver, address, true, bytes, phases, perf, memory, times, trace_path);
+
+                    write_all(result_pipe[1], &receiver_stats, sizeof(receiver_stats));
+                    write_out(result_pipe[1], memory);
+                    write_out(result_pipe[1], times);
+                    (write_out(result_pipe[1], receiver_outs), ...);
+                } catch (const std::exception& e) {
+                    std::cerr << "receiver process failed: " << e.what() << std::endl;
+                    ::_exit(1);
+                }
+
+                ::close(result_pipe[1]);
+                ::_exit(0);
+            }
+
+            ::close(result_pipe[1]);
+
+            size_t bytes = 0;
+            sparse_comp::comm::PhaseReport phases;
+            MemoryReport memory;
+            PhaseTimes times;
+            PartyStats sender_stats = run_party(sender, address, false, bytes, phases, stats.perf, memory, times, trace_path);
+            PartyStats receiver_stats;
+
+            read_all(result_pipe[0], &receiver_stats, sizeof(receiver_stats));
+            read_out(result_pipe[0], memory);
+            read_out(result_pipe[0], times);
+            (read_out(result_pipe[0], receiver_outs), ...);
+            ::close(result_pipe[0]);
+
+            int status = 0;
+            ::waitpid(pid, &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) throw std::runtime_error("the receiver process failed");
+
+            stats.sender.wall_ms += sender_stats.wall_ms;
+            stats.sender.cpu_ms += sender_stats.cpu_ms;
+            stats.sender.idle_ms += sender_stats.idle_ms;
+            stats.receiver.wall_ms += receiver_stats.wall_ms;
+            stats.receiver.cpu_ms += receiver_stats.cpu_ms;
+            stats.receiver.idle_ms += receiver_stats.idle_ms;
+            stats.wall_ms += std::max(sender_stats.wall_ms, receiver_stats.wall_ms);
+            stats.bytes += bytes;
+            stats.runs++;
+
+            for (auto& [name, phase] : phases) stats.phases[name] += phase;
+            for (auto& [name, sample] : memory) stats.memory[name] += sample;
+            for (auto& [name, total] : times) stats.times[name] += total;
+        }
+
+        // Runs both parties as coroutines of this thread over socks, see measure_parties.
+        template<typename Socks, typename SenderFn, typename ReceiverFn>
+        void run_local(Catch::Benchmark::Chronometer& meter, TwoPartyStats& stats, Socks& socks, SenderFn& sender, ReceiverFn& receiver) {
+            const size_t bytes_before = socks[0].bytesSent() + socks[0].bytesReceived();
+
+            sparse_comp::comm::reset(socks[0]);
+            sparse_comp::comm::reset(socks[1]);
+            clear_spans(socks[0]);
+            clear_spans(socks[1]);
+
+            PerfPhaseRecorder recorder(stats.perf);
+            recorder.add_track(&socks[0], "sender");
+            recorder.add_track(&socks[1], "receiver");
+            MemoryPhaseRecorder memory_recorder(stats.memory);
+            memory_recorder.add_track(&socks[0], "sender");
+            memory_recorder.add_track(&socks[1], "receiver");
+
+            auto sender_proto = sender(socks[0]);
+            auto receiver_proto = receiver(socks[1]);
+
+            reset_peak_rss();
+
+            meter.measure([&sender_proto,&receiver_proto,&stats,&socks]() {
+                sparse_comp::comm::CommScope run_comm(socks[0], "run");
+                MemoryScope run_memory(stats.memory, "run");
+                PerfScope run(stats.perf, "run");
+                macoro::sync_wait(macoro::when_all_ready(std::move(sender_proto), std::move(receiver_proto)));
+            });
+
+            stats.bytes = socks[0].bytesSent() + socks[0].bytesReceived() - bytes_before;
+            stats.runs = 1;
+            stats.phases = sparse_comp::comm::report(socks[0]);
+
+            const std::string trace_path = next_trace_path();
+            collect_times(stats.times, socks[0], "sender");
+            collect_times(stats.times, socks[1], "receiver");
+            write_trace(socks[0], trace_path, "sender");
+            write_trace(socks[1], trace_path, "receiver");
+        }
+
+        // Measures the party measured, with index party in the transcript of this run, against the transcript,
+        // then replays other to produce its outputs.
+        template<typename MeasuredFn, typename OtherFn>
+        void run_replayed(Catch::Benchmark::Chronometer& meter, TwoPartyStats& stats, MeasuredFn& measured, OtherFn& other, size_t party, const std::string& role) {
+            const std::string trace_path = next_trace_path();
+            const Transcript transcript = Transcript::load(next_transcript_path());
+
+            ReplayStream measured_stream(transcript, party);
+            ReplayStream other_stream(transcript, 1 - party);
+            coproto::Socket measured_sock = measured_stream.socket();
+            coproto::Socket other_sock = other_stream.socket();
+
+            PerfPhaseRecorder recorder(stats.perf);
+            recorder.add_track(&measured_sock, role);
+            MemoryPhaseRecorder memory_recorder(stats.memory);
+            memory_recorder.add_track(&measured_sock, role);
+
+            auto measured_proto = measured(measured_sock);
+
+            clear_spans(measured_sock);
+            reset_peak_rss();
+
+            // A divergence fails the protocol with a bare socket error; replay reports where it happened instead
+            meter.measure([&measured_proto,&measured_stream,&stats,&measured_sock,&role]() {
+                sparse_comp::comm::CommScope run_comm(measured_sock, "run");
+                MemoryScope run_memory(stats.memory, "run");
+                PerfScope run(stats.perf, "run");
+                measured_stream.replay(std::move(measured_proto), role);
+            });
+
+            stats.bytes = measured_sock.bytesSent() + measured_sock.bytesReceived();
+            stats.runs = 1;
+            stats.phases = sparse_comp::comm::report(measured_sock);
+            collect_times(stats.times, measured_sock, role);
+            write_trace(measured_sock, trace_path, role);
+
+            other_stream.replay(other(other_sock), role == "sender" ? "receiver" : "sender");
+        }
+    };
+
+    inline void print_stats(const TwoPartyStats& stats) {
+        if (stats.runs == 0) return;
+
+        const double runs = (double) stats.runs;
+
+        std::cout << "Wall clock latency (ms): " << stats.wall_ms / runs << std::endl;
+        std::cout << "Sender cpu / idle (ms): " << stats.sender.cpu_ms / runs << " / " << stats.sender.idle_ms / runs << std::endl;
+        std::cout << "Receiver cpu / idle (ms): " << stats.receiver.cpu_ms / runs << " / " << stats.receiver.idle_ms / runs << std::endl;
+    }
+
+    inline void print_phases(const TwoPartyStats& stats) {
+        sparse_comp::comm::print_report("Phase", stats.phases);
+    }
+
+    inline void print_memory(const TwoPartyStats& stats) {
+        print_memory(stats.memory);
+    }
+
+    inline void print_times(const TwoPartyStats& stats) {
+        if (stats.runs == 0) return;
+
+        for (auto& [name, total] : stats.times) {
+            std::printf("Time %-40s %12.3f ms spans: %lu\n", name.c_str(), total.ns / 1e6 / (double) stats.runs, (unsigned long) (total.count / stats.runs));
+        }
+    }
+
+    // Hands the figures of the run to the result reporters, see BenchResults.h.
+    inline void note_results(const TwoPartyStats& stats) {
+        if (stats.runs == 0) return;
+
+        BenchRun run;
+        run.bytes = stats.bytes / stats.runs;
+
+        auto phase = stats.phases.find("run");
+        if (phase != stats.phases.end()) run.rounds = phase->second.flights / stats.runs;
+
+        for (const char* name : {"run", "sender/run", "receiver/run"}) {
+            auto sample = stats.memory.find(name);
+            if (sample != stats.memory.end()) run.peak_rss_kb = std::max(run.peak_rss_kb, sample->second.peak_rss_kb);
+        }
+
+        note_run(run);
+    }
+
+    // Measures a sender/receiver run. sender and receiver map a socket to the party's protocol, e.g.
+    // [&](coproto::Socket& sock) { return spL1Sender.send(sock, ...); }. receiver_outs are the receiver
+    // outputs to bring back from the receiver process.
+    template<typename Socks, typename SenderFn, typename ReceiverFn, typename... Outs>
+    TwoPartyStats measure_parties(Catch::Benchmark::Chronometer& meter, Socks& socks, SenderFn sender, ReceiverFn receiver, Outs&... receiver_outs) {
+        TwoPartyStats stats;
+
+        const PartyMode mode = party_mode();
+
+        if (mode == PartyMode::Local) {
+            detail::run_local(meter, stats, socks, sender, receiver);
+        } else if (mode == PartyMode::Record) {
+            Transcript transcript;
+            EmulatedNetwork net(NetworkProfile::loopback());
+            net.record(&transcript.messages);
+
+            auto record_socks = net.makePair();
+            detail::run_local(meter, stats, record_socks, sender, receiver);
+
+            net.record(nullptr);
+            transcript.save(detail::next_transcript_path());
+        } else if (mode == PartyMode::ReplaySender) {
+            detail::run_replayed(meter, stats, sender, receiver, 0, "sender");
+        } else if (mode == PartyMode::ReplayReceiver) {
+            detail::run_replayed(meter, stats, receiver, sender, 1, "receiver");
+        } else {
+            meter.measure([&]() { detail::run_forked(stats, sender, receiver, receiver_outs...); });
+
+            print_stats(stats);
+        }
+
+        print_phases(stats);
+        print_times(stats);
+        print_memory(stats);
+        note_results(stats);
+
+        return stats;
+    }
+
+};
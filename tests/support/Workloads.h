@@ -0,0 +1,389 @@
+#pragma once
+
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Common/block.h"
+#include "../../sparseComp/Common/Common.h"
+#include "./GroundTruth.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numbers>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Seeded input sets for the fuzzy protocols, beyond the uniformly random points of their benchmarks:
+//
+//   uniform     uniformly random coordinates
+//   clustered   a mixture of Gaussian clusters, as for dense urban GPS cells or skewed feature vectors
+//   grid        coordinates on the multiples of 2*delta, i.e. on the cell edges of the spatial hashing
+//   boundary    coordinates within one of a cell edge, with the near matches straddling it
+//   high-match  uniformly random, with near matches for 90% of the smaller set
+//
+// In all of them the given number of sender points are planted within L_1 distance delta (hence also L_2 and
+// L_inf distance delta) of distinct receiver points; the other sender points follow the distribution of the
+// workload and may be close to receiver points too, so the expected output must come from GroundTruth.h. The
+// receiver points are at L_inf distance more than 4*delta of each other, which the protocols require: their
+// 2^d hashed cells must not overlap.
+//
+// Large sets can be generated once and streamed to a binary file (see load_or_gen_workload): the magic
+// "SPCWKLD1", the parameters, then the d coordinates (4 bytes each, little endian) of the receiver points
+// followed by those of the sender points.
+
+namespace sparse_comp::bench {
+
+    enum class Workload { Uniform, Clustered, Grid, Boundary, HighMatch };
+
+    inline const char* workload_name(Workload workload) {
+        switch (workload) {
+            case Workload::Uniform: return "uniform";
+            case Workload::Clustered: return "clustered";
+            case Workload::Grid: return "grid";
+            case Workload::Boundary: return "boundary";
+            case Workload::HighMatch: return "high-match";
+        }
+        return "unknown";
+    }
+
+    // Returns false for unknown names.
+    inline bool parse_workload(const std::string& name, Workload& workload) {
+        for (Workload w : {Workload::Uniform, Workload::Clustered, Workload::Grid, Workload::Boundary, Workload::HighMatch}) {
+            if (name == workload_name(w)) {
+                workload = w;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    struct WorkloadParams {
+        size_t d;
+        uint64_t delta;
+        // Planted near matches; high-match raises it to 90% of the smaller set.
+        size_t matches;
+        size_t clusters = 16;
+    };
+
+    namespace detail {
+
+        // Accepts points at L_inf distance more than min_dist of all the points accepted so far.
+        class SeparatedSet {
+            private:
+                size_t d;
+                uint64_t min_dist;
+                uint64_t side;
+                std::vector<point> points;
+                std::unordered_multimap<uint64_t, uint32_t> cells;
+
+            public:
+                SeparatedSet(size_t d, uint64_t min_dist, size_t capacity)
+                    : d(d), min_dist(min_dist), side((2*min_dist + 1) * std::max<size_t>(d, 1)) {
+                    this->points.reserve(capacity);
+                    this->cells.reserve(capacity);
+                }
+
+                bool try_add(const point& p) {
+                    const bool too_close = any_ball_cell(p, this->d, this->min_dist, this->side, [&](uint64_t key) {
+                        auto [it, end] = this->cells.equal_range(key);
+
+                        for (; it != end; it++) {
+                            if (is_close<Metric::Linf>(this->points[it->second], p, this->d, this->min_dist)) return true;
+                        }
+
+                        return false;
+                    });
+
+                    if (too_close) return false;
+
+                    this->cells.emplace(grid_cell_key(p, this->d, this->side), (uint32_t) this->points.size());
+                    this->points.push_back(p);
+                    return true;
+                }
+        };
+
+        inline uint32_t clamp_coord(double c, uint64_t margin) {
+            const double lo = (double) margin;
+            const double hi = (double) (std::numeric_limits<uint32_t>::max() - margin);
+            return (uint32_t) std::clamp(c, lo, hi);
+        }
+
+        inline uint32_t uniform_coord(osuCrypto::PRNG& prng, uint64_t margin) {
+            const uint64_t range = (uint64_t) std::numeric_limits<uint32_t>::max() - 2*margin + 1;
+            return (uint32_t) (margin + prng.get<uint64_t>() % range);
+        }
+
+        // Standard normal sample (Box-Muller), from the PRNG only so that the sets are the same on every platform.
+        inline double gaussian(osuCrypto::PRNG& prng) {
+            const double u1 = ((prng.get<uint64_t>() >> 11) + 1) * 0x1.0p-53;
+            const double u2 = (prng.get<uint64_t>() >> 11) * 0x1.0p-53;
+            return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * std::numbers::pi * u2);
+        }
+
+        class WorkloadSampler {
+            private:
+                Workload workload;
+                size_t d;
+                uint64_t delta;
+                uint64_t margin;
+                std::vector<point> centers;
+                double sigma = 0;
+                uint64_t cell = 0;
+
+            public:
+                WorkloadSampler(Workload workload, osuCrypto::PRNG& prng, const WorkloadParams& params, size_t tr)
+                    : workload(workload), d(params.d), delta(params.delta), margin(4*params.delta + 1) {
+                    this->cell = std::max<uint64_t>(2*params.delta, 1);
+
+                    if (workload == Workload::Clustered) {
+                        // Spread so that a cluster holds its share of the receiver points at twice their minimum spacing
+                        const double per_cluster = (double) std::max<size_t>(tr / std::max<size_t>(params.clusters, 1), 1);
+                        this->sigma = 2.0 * (4*params.delta + 1) * std::ceil(std::pow(per_cluster, 1.0 / (double) params.d));
+
+                        this->centers.resize(std::max<size_t>(params.clusters, 1));
+                        // Centers far enough from the bounds that few points are clamped onto them
+                        const uint64_t center_margin = std::min<uint64_t>(this->margin + (uint64_t) (4*this->sigma), (1ULL << 31) - 1);
+
+                        for (point& c : this->centers) {
+                            c.coord_dim = (uint8_t) params.d;
+                            for (size_t j = 0; j < params.d; j++) c[j] = uniform_coord(prng, center_margin);
+                        }
+                    }
+                }
+
+                point sample(osuCrypto::PRNG& prng) const {
+                    point p;
+                    p.coord_dim = (uint8_t) this->d;
+
+                    switch (this->workload) {
+                        case Workload::Clustered: {
+                            const point& c = this->centers[prng.get<uint64_t>() % this->centers.size()];
+                            for (size_t j = 0; j < this->d; j++) p[j] = clamp_coord(c[j] + this->sigma * gaussian(prng), this->margin);
+                            break;
+                        }
+                        case Workload::Grid:
+                            for (size_t j = 0; j < this->d; j++) p[j] = (uint32_t) (uniform_coord(prng, this->margin) / this->cell * this->cell);
+                            break;
+                        case Workload::Boundary:
+                            for (size_t j = 0; j < this->d; j++) {
+                                const uint64_t edge = uniform_coord(prng, this->margin) / this->cell * this->cell;
+                                p[j] = (uint32_t) (edge + (prng.get<uint8_t>() % 3) - 1);
+                            }
+                            break;
+                        default:
+                            for (size_t j = 0; j < this->d; j++) p[j] = uniform_coord(prng, this->margin);
+                            break;
+                    }
+
+                    return p;
+                }
+
+                // A point within L_1 distance delta of center.
+                point near(osuCrypto::PRNG& prng, const point& center) const {
+                    point p = center;
+
+                    if (this->workload == Workload::Boundary && this->delta > 0) {
+                        // All of the offset in one coordinate, across the nearest cell edge
+                        const size_t j = prng.get<uint64_t>() % this->d;
+                        const bool up = center[j] % this->cell >= this->cell / 2;
+                        p[j] = up ? center[j] + (uint32_t) this->delta : center[j] - (uint32_t) this->delta;
+                        return p;
+                    }
+
+                    // At most delta unit steps, so at most L_1 distance delta
+                    const uint64_t total = prng.get<uint64_t>() % (this->delta + 1);
+                    for (uint64_t i = 0; i < total; i++) {
+                        const size_t j = prng.get<uint64_t>() % this->d;
+                        p[j] = prng.get<bool>() ? p[j] + 1 : p[j] - 1;
+                    }
+
+                    return p;
+                }
+        };
+
+    };
+
+    inline size_t workload_matches(Workload workload, const WorkloadParams& params, size_t ts, size_t tr) {
+        const size_t bound = std::min(ts, tr);
+        if (workload == Workload::HighMatch) return std::min(std::max(params.matches, bound * 9 / 10), bound);
+        return std::min(params.matches, bound);
+    }
+
+    // Fills the receiver and sender points with the workload drawn from seed. Throws if the receiver points
+    // cannot be spaced out, which only happens when clusters are too small for the set.
+    inline void gen_workload(Workload workload,
+                             osuCrypto::block seed,
+                             const WorkloadParams& params,
+                             std::span<point> rcvr_points,
+                             std::span<point> sndr_points) {
+        osuCrypto::PRNG prng(seed);
+        detail::WorkloadSampler sampler(workload, prng, params, rcvr_points.size());
+        detail::SeparatedSet separated(params.d, 4*params.delta, rcvr_points.size());
+
+        const size_t max_attempts = 64 * rcvr_points.size() + 1024;
+        size_t attempts = 0;
+
+        for (size_t i = 0; i < rcvr_points.size(); i++) {
+            do {
+                if (attempts++ == max_attempts) {
+                    throw std::runtime_error(std::string("could not space out the receiver points of the ") + workload_name(workload) +
+                                             " workload, placed " + std::to_string(i) + " of " + std::to_string(rcvr_points.size()));
+                }
+                rcvr_points[i] = sampler.sample(prng);
+            } while (!separated.try_add(rcvr_points[i]));
+        }
+
+        // Planted matches near distinct receiver points, then fresh points, in random order
+        const size_t matches = workload_matches(workload, params, sndr_points.size(), rcvr_points.size());
+        std::vector<uint32_t> picks(rcvr_points.size());
+
+        for (size_t i = 0; i < picks.size(); i++) picks[i] = (uint32_t) i;
+        for (size_t i = 0; i < matches; i++) std::swap(picks[i], picks[i + prng.get<uint64_t>() % (picks.size() - i)]);
+
+        for (size_t i = 0; i < sndr_points.size(); i++) {
+            sndr_points[i] = i < matches ? sampler.near(prng, rcvr_points[picks[i]]) : sampler.sample(prng);
+        }
+
+        for (size_t i = sndr_points.size(); i > 1; i--) std::swap(sndr_points[i - 1], sndr_points[prng.get<uint64_t>() % i]);
+    }
+
+    namespace detail {
+
+        constexpr char WORKLOAD_MAGIC[8] = {'S', 'P', 'C', 'W', 'K', 'L', 'D', '1'};
+
+        struct WorkloadHeader {
+            uint8_t workload;
+            uint8_t d;
+            uint64_t delta;
+            uint64_t matches;
+            uint64_t clusters;
+            uint64_t seed[2];
+            uint64_t tr;
+            uint64_t ts;
+
+            bool operator==(const WorkloadHeader&) const = default;
+        };
+
+        inline WorkloadHeader workload_header(Workload workload, osuCrypto::block seed, const WorkloadParams& params, size_t tr, size_t ts) {
+            WorkloadHeader header{};
+            header.workload = (uint8_t) workload;
+            header.d = (uint8_t) params.d;
+            header.delta = params.delta;
+            header.matches = params.matches;
+            header.clusters = params.clusters;
+            std::memcpy(header.seed, seed.data(), sizeof(header.seed));
+            header.tr = tr;
+            header.ts = ts;
+            return header;
+        }
+
+        inline void write_workload_header(std::ostream& out, const WorkloadHeader& h) {
+            out.write(WORKLOAD_MAGIC, sizeof(WORKLOAD_MAGIC));
+            for (uint64_t v : {(uint64_t) h.workload, (uint64_t) h.d, h.delta, h.matches, h.clusters, h.seed[0], h.seed[1], h.tr, h.ts}) {
+                out.write((const char*) &v, sizeof(v));
+            }
+        }
+
+        inline bool read_workload_header(std::istream& in, WorkloadHeader& h) {
+            char magic[sizeof(WORKLOAD_MAGIC)];
+            uint64_t v[9];
+
+            in.read(magic, sizeof(magic));
+            in.read((char*) v, sizeof(v));
+            if (!in || std::memcmp(magic, WORKLOAD_MAGIC, sizeof(magic)) != 0) return false;
+
+            h = WorkloadHeader{(uint8_t) v[0], (uint8_t) v[1], v[2], v[3], v[4], {v[5], v[6]}, v[7], v[8]};
+            return true;
+        }
+
+        // Writes or reads the points through a fixed size buffer.
+        inline void write_points(std::ostream& out, std::span<const point> points, size_t d) {
+            std::vector<uint32_t> buffer;
+            buffer.reserve(4096 * d);
+
+            for (size_t i = 0; i < points.size(); i++) {
+                buffer.insert(buffer.end(), points[i].coords, points[i].coords + d);
+
+                if (buffer.size() == buffer.capacity() || i + 1 == points.size()) {
+                    out.write((const char*) buffer.data(), (std::streamsize) (buffer.size() * sizeof(uint32_t)));
+                    buffer.clear();
+                }
+            }
+        }
+
+        inline void read_points(std::istream& in, std::span<point> points, size_t d) {
+            std::vector<uint32_t> buffer(4096 * d);
+
+            for (size_t i = 0; i < points.size(); i += 4096) {
+                const size_t n = std::min<size_t>(4096, points.size() - i);
+                in.read((char*) buffer.data(), (std::streamsize) (n * d * sizeof(uint32_t)));
+
+                for (size_t k = 0; k < n; k++) {
+                    points[i + k] = point();
+                    points[i + k].coord_dim = (uint8_t) d;
+                    std::copy(buffer.begin() + k * d, buffer.begin() + (k + 1) * d, points[i + k].coords);
+                }
+            }
+        }
+
+    };
+
+    inline void save_workload(const std::string& path, Workload workload, osuCrypto::block seed, const WorkloadParams& params,
+                              std::span<const point> rcvr_points, std::span<const point> sndr_points) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("could not create the workload file " + path);
+
+        detail::write_workload_header(out, detail::workload_header(workload, seed, params, rcvr_points.size(), sndr_points.size()));
+        detail::write_points(out, rcvr_points, params.d);
+        detail::write_points(out, sndr_points, params.d);
+
+        if (!out) throw std::runtime_error("could not write the workload file " + path);
+    }
+
+    // Returns false if there is no such file; throws if it holds another workload or is truncated.
+    inline bool load_workload(const std::string& path, Workload workload, osuCrypto::block seed, const WorkloadParams& params,
+                              std::span<point> rcvr_points, std::span<point> sndr_points) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+
+        detail::WorkloadHeader header;
+        if (!detail::read_workload_header(in, header) ||
+            !(header == detail::workload_header(workload, seed, params, rcvr_points.size(), sndr_points.size()))) {
+            throw std::runtime_error(path + " does not hold the requested workload");
+        }
+
+        detail::read_points(in, rcvr_points, params.d);
+        detail::read_points(in, sndr_points, params.d);
+
+        if (!in) throw std::runtime_error("the workload file " + path + " is truncated");
+        return true;
+    }
+
+    // Generates the workload, or with SPARSE_COMP_WORKLOAD_DIR set loads it from that directory, where it is saved
+    // the first time it is generated.
+    inline void load_or_gen_workload(Workload workload, osuCrypto::block seed, const WorkloadParams& params,
+                                     std::span<point> rcvr_points, std::span<point> sndr_points) {
+        const char* dir = std::getenv("SPARSE_COMP_WORKLOAD_DIR");
+
+        if (dir == nullptr || *dir == '\0') {
+            gen_workload(workload, seed, params, rcvr_points, sndr_points);
+            return;
+        }
+
+        const std::string path = std::string(dir) + "/" + workload_name(workload) + "-tr" + std::to_string(rcvr_points.size()) +
+                                 "-ts" + std::to_string(sndr_points.size()) + "-d" + std::to_string(params.d) +
+                                 "-delta" + std::to_string(params.delta) + "-m" + std::to_string(params.matches) +
+                                 "-" + std::to_string(detail::workload_header(workload, seed, params, 0, 0).seed[0]) + ".spw";
+
+        if (load_workload(path, workload, seed, params, rcvr_points, sndr_points)) return;
+
+        gen_workload(workload, seed, params, rcvr_points, sndr_points);
+        save_workload(path, workload, seed, params, rcvr_points, sndr_points);
+    }
+
+};
@@ -0,0 +1,159 @@
+#include "catch2/catch_session.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/internal/catch_clara.hpp"
+#include "./sweep/Sweep.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Benchmark sweep over parameter grids given on the command line, e.g.
+//
+//     sweep_bench --protocols fuzzyl1,splinf --sizes 256,4096:256 --dims 2,6 --deltas 10,30 --networks local,wan
+//
+// The fuzzy protocols also sweep the input distributions of support/Workloads.h, e.g. --workloads uniform,clustered,
+// and the number of threads per party, e.g. --threads 1,4, which runs them in the partition parallel mode of
+// FuzzyParallel.h with one partition per thread.
+//
+// Sizes are t_s or t_s:t_r. A single size runs the fuzzy protocols with n=m and the SpX protocols with
+// t_r=t_s*2^d, as in their own benchmark executables. Every grid point runs the instantiation compiled for it
+// (see sweep/SweepGrid.h); points without one are reported and skipped. The Catch2 options (--benchmark-samples,
+// --reporter, ...) apply as usual, as do the SPARSE_COMP_BENCH_* variables of TwoPartyBench.h.
+
+using sparse_comp::bench::SweepContext;
+using sparse_comp::bench::SweepKey;
+using sparse_comp::bench::SweepRegistry;
+using sparse_comp::bench::Workload;
+
+namespace {
+
+    struct sweep_args {
+        std::string protocols = "fuzzyl1";
+        std::string sizes = "256";
+        std::string dims = "2";
+        std::string deltas = "10";
+        std::string ssps = "40";
+        std::string threads = "1";
+        std::string networks = "local";
+        std::string workloads = "uniform";
+    };
+
+    sweep_args args;
+
+    std::vector<std::string> split(const std::string& list) {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+
+        while (std::getline(stream, item, ',')) {
+            if (!item.empty()) items.push_back(item);
+        }
+
+        return items;
+    }
+
+    std::vector<size_t> split_numbers(const std::string& list) {
+        std::vector<size_t> numbers;
+
+        for (auto& item : split(list)) numbers.push_back(std::stoull(item));
+
+        return numbers;
+    }
+
+};
+
+TEST_CASE("sweep", "[sweep]") {
+    SweepRegistry registry;
+    sparse_comp::bench::register_fuzzyl1(registry);
+    sparse_comp::bench::register_fuzzyl2(registry);
+    sparse_comp::bench::register_fuzzylinf(registry);
+    sparse_comp::bench::register_spl1(registry);
+    sparse_comp::bench::register_spl2(registry);
+    sparse_comp::bench::register_splinf(registry);
+
+    for (auto& protocol : split(args.protocols)) {
+        const bool is_fuzzy = protocol.rfind("fuzzy", 0) == 0;
+
+        for (auto& size : split(args.sizes)) {
+            for (size_t d : split_numbers(args.dims)) {
+                const size_t colon = size.find(':');
+                const size_t ts = std::stoull(size.substr(0, colon));
+                const size_t tr = colon != std::string::npos ? std::stoull(size.substr(colon + 1)) : (is_fuzzy ? ts : ts << d);
+
+                for (size_t delta : split_numbers(args.deltas)) {
+                    for (size_t ssp : split_numbers(args.ssps)) {
+                        for (size_t threads : split_numbers(args.threads)) {
+                            for (auto& network : split(args.networks)) {
+                                for (auto& workload_name : split(args.workloads)) {
+                                    const std::string name = protocol + " t_s=" + std::to_string(ts) + " t_r=" + std::to_string(tr) +
+                                                             " d=" + std::to_string(d) + " delta=" + std::to_string(delta) +
+                                                             " ssp=" + std::to_string(ssp) + " threads=" + std::to_string(threads) +
+                                                             " net=" + network + " workload=" + workload_name;
+
+                                    auto it = registry.find(SweepKey{protocol, ts, tr, d, delta, ssp});
+
+                                    if (it == registry.end()) {
+                                        WARN(name << ": not compiled in, add it to tests/sweep/SweepGrid.h");
+                                        continue;
+                                    }
+                                    if (network != "local" && network != "lan" && network != "wan") {
+                                        WARN(name << ": unknown network, use local, lan or wan");
+                                        continue;
+                                    }
+                                    if (threads == 0 || (!is_fuzzy && threads != 1)) {
+                                        WARN(name << ": the SpX protocols run on a single thread per party, the fuzzy protocols on 1 or more");
+                                        continue;
+                                    }
+
+                                    Workload workload;
+                                    if (!sparse_comp::bench::parse_workload(workload_name, workload)) {
+                                        WARN(name << ": unknown workload, use uniform, clustered, grid, boundary or high-match");
+                                        continue;
+                                    }
+                                    if (!is_fuzzy && workload != Workload::Uniform) {
+                                        WARN(name << ": the SpX protocols only run on uniform inputs");
+                                        continue;
+                                    }
+
+                                    SweepContext ctx;
+                                    ctx.network = network;
+                                    ctx.threads = threads;
+                                    ctx.workload = workload;
+
+                                    sparse_comp::bench::SweepRunner runner = it->second;
+
+                                    BENCHMARK_ADVANCED(name)(Catch::Benchmark::Chronometer meter) {
+                                        runner(meter, ctx);
+                                    };
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Catch::Session session;
+
+    using Catch::Clara::Opt;
+
+    auto cli = session.cli()
+        | Opt(args.protocols, "list")["--protocols"]("protocols to run: fuzzyl1, fuzzyl2, fuzzylinf, spl1, spl2, splinf (default fuzzyl1)")
+        | Opt(args.sizes, "list")["--sizes"]("set sizes, t_s or t_s:t_r (default 256)")
+        | Opt(args.dims, "list")["--dims"]("dimensions d (default 2)")
+        | Opt(args.deltas, "list")["--deltas"]("distance thresholds delta (default 10)")
+        | Opt(args.ssps, "list")["--ssps"]("statistical security parameters (default 40)")
+        | Opt(args.threads, "list")["--threads"]("threads per party, i.e. partitions of the fuzzy protocols (default 1)")
+        | Opt(args.networks, "list")["--networks"]("networks: local, lan, wan (default local)")
+        | Opt(args.workloads, "list")["--workloads"]("fuzzy inputs: uniform, clustered, grid, boundary, high-match (default uniform)");
+
+    session.cli(cli);
+
+    const int rc = session.applyCommandLine(argc, argv);
+    if (rc != 0) return rc;
+
+    return session.run();
+}
@@ -0,0 +1,10 @@
+#include "./Sweep.h"
+#include "./SweepGrid.h"
+#include "../../sparseComp/FuzzyL1/FuzzyL1.h"
+
+#define SPARSE_COMP_SWEEP_ENTRY(ts, tr, d, delta, ssp) \
+    registry[{"fuzzyl1", ts, tr, d, delta, ssp}] = &sparse_comp::bench::run_sweep_fuzzy<sparse_comp::fuzzy_l1::Sender, sparse_comp::fuzzy_l1::Receiver, sparse_comp::bench::Metric::L1, ts, tr, d, delta, ssp>;
+
+void sparse_comp::bench::register_fuzzyl1(SweepRegistry& registry) {
+    SPARSE_COMP_SWEEP_FUZZY_GRID(SPARSE_COMP_SWEEP_ENTRY)
+}
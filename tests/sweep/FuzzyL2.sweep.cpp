@@ -0,0 +1,10 @@
+#include "./Sweep.h"
+#include "./SweepGrid.h"
+#include "../../sparseComp/FuzzyL2/FuzzyL2.h"
+
+#define SPARSE_COMP_SWEEP_ENTRY(ts, tr, d, delta, ssp) \
+    registry[{"fuzzyl2", ts, tr, d, delta, ssp}] = &sparse_comp::bench::run_sweep_fuzzy<sparse_comp::fuzzy_l2::Sender, sparse_comp::fuzzy_l2::Receiver, sparse_comp::bench::Metric::L2, ts, tr, d, delta, ssp>;
+
+void sparse_comp::bench::register_fuzzyl2(SweepRegistry& registry) {
+    SPARSE_COMP_SWEEP_FUZZY_L2_GRID(SPARSE_COMP_SWEEP_ENTRY)
+}
@@ -0,0 +1,10 @@
+#include "./Sweep.h"
+#include "./SweepGrid.h"
+#include "../../sparseComp/FuzzyLinf/FuzzyLinf.h"
+
+#define SPARSE_COMP_SWEEP_ENTRY(ts, tr, d, delta, ssp) \
+    registry[{"fuzzylinf", ts, tr, d, delta, ssp}] = &sparse_comp::bench::run_sweep_fuzzy<sparse_comp::fuzzy_linf::Sender, sparse_comp::fuzzy_linf::Receiver, sparse_comp::bench::Metric::Linf, ts, tr, d, delta, ssp>;
+
+void sparse_comp::bench::register_fuzzylinf(SweepRegistry& registry) {
+    SPARSE_COMP_SWEEP_FUZZY_GRID(SPARSE_COMP_SWEEP_ENTRY)
+}
@@ -0,0 +1,10 @@
+#include "./Sweep.h"
+#include "./SweepGrid.h"
+#include "../../sparseComp/SpL1/SpL1.h"
+
+#define SPARSE_COMP_SWEEP_ENTRY(ts, tr, d, delta, ssp) \
+    registry[{"spl1", ts, tr, d, delta, ssp}] = &sparse_comp::bench::run_sweep_sp<sparse_comp::sp_l1::Sender, sparse_comp::sp_l1::Receiver, ts, tr, d, delta, ssp>;
+
+void sparse_comp::bench::register_spl1(SweepRegistry& registry) {
+    SPARSE_COMP_SWEEP_SP_GRID(SPARSE_COMP_SWEEP_ENTRY)
+}
@@ -0,0 +1,18 @@
+#include "./Sweep.h"
+#include "./SweepGrid.h"
+#include "../../sparseComp/SpL2/SpL2.h"
+
+// SpL2 is fixed to d=2 and takes no dimension parameter
+template<size_t tr, size_t ts, size_t d, uint8_t delta, uint8_t ssp>
+using SweepSpL2Sender = sparse_comp::sp_l2::Sender<tr, ts, delta, ssp>;
+
+template<size_t ts, size_t tr, size_t d, uint8_t delta, uint8_t ssp>
+using SweepSpL2Receiver = sparse_comp::sp_l2::Receiver<ts, tr, delta, ssp>;
+
+#define SPARSE_COMP_SWEEP_ENTRY(ts, tr, d, delta, ssp) \
+    static_assert(d == 2, "spl2 only supports d=2"); \
+    registry[{"spl2", ts, tr, d, delta, ssp}] = &sparse_comp::bench::run_sweep_sp<SweepSpL2Sender, SweepSpL2Receiver, ts, tr, d, delta, ssp>;
+
+void sparse_comp::bench::register_spl2(SweepRegistry& registry) {
+    SPARSE_COMP_SWEEP_SP_L2_GRID(SPARSE_COMP_SWEEP_ENTRY)
+}
@@ -0,0 +1,10 @@
+#include "./Sweep.h"
+#include "./SweepGrid.h"
+#include "../../sparseComp/SpLInf/SpLInf.h"
+
+#define SPARSE_COMP_SWEEP_ENTRY(ts, tr, d, delta, ssp) \
+    registry[{"splinf", ts, tr, d, delta, ssp}] = &sparse_comp::bench::run_sweep_sp<sparse_comp::sp_linf::Sender, sparse_comp::sp_linf::Receiver, ts, tr, d, delta, ssp>;
+
+void sparse_comp::bench::register_splinf(SweepRegistry& registry) {
+    SPARSE_COMP_SWEEP_SP_GRID(SPARSE_COMP_SWEEP_ENTRY)
+}
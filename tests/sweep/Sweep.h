@@ -0,0 +1,257 @@
+#pragma once
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "cryptoTools/Crypto/PRNG.h"
+#include "cryptoTools/Crypto/AES.h"
+#include "cryptoTools/Common/block.h"
+#include "coproto/Socket/LocalAsyncSock.h"
+#include "../support/TwoPartyBench.h"
+#include "../support/EmulatedNetwork.h"
+#include "../support/GroundTruth.h"
+#include "../support/Workloads.h"
+#include "../../sparseComp/Common/Common.h"
+#include "../../sparseComp/FuzzyParallel/FuzzyParallel.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+// Runners of the sweep driver (sweep.bench.cpp). Every protocol has its own translation unit, <Protocol>.sweep.cpp,
+// which instantiates the runners for the grid points of SweepGrid.h and registers them by protocol name and
+// parameters. The inputs are random with a planted intersection, and each run checks the protocol output against it.
+// The fuzzy protocols can also run on the other input distributions of Workloads.h, and with more than one thread
+// per party they run in the partition parallel mode of FuzzyParallel.h, one partition per thread, with batches of
+// the grid point's set sizes.
+
+namespace sparse_comp::bench {
+
+    // Memory budget of the partition parallel runs, large enough for a single batch per partition at every grid point
+    constexpr size_t SWEEP_PARALLEL_MEMORY_BUDGET = size_t(16) << 30;
+
+    struct SweepContext {
+        std::string network = "local"; // local, lan or wan
+        size_t threads = 1; // partitions of the fuzzy protocols, 1 for the SpX protocols
+        Workload workload = Workload::Uniform; // fuzzy protocols only
+    };
+
+    struct SweepKey {
+        std::string protocol;
+        size_t ts;
+        size_t tr;
+        size_t d;
+        size_t delta;
+        size_t ssp;
+
+        bool operator<(const SweepKey& other) const {
+            return std::tie(this->protocol, this->ts, this->tr, this->d, this->delta, this->ssp) <
+                   std::tie(other.protocol, other.ts, other.tr, other.d, other.delta, other.ssp);
+        }
+    };
+
+    using SweepRunner = void (*)(Catch::Benchmark::Chronometer&, const SweepContext&);
+    using SweepRegistry = std::map<SweepKey, SweepRunner>;
+
+    void register_fuzzyl1(SweepRegistry& registry);
+    void register_fuzzyl2(SweepRegistry& registry);
+    void register_fuzzylinf(SweepRegistry& registry);
+    void register_spl1(SweepRegistry& registry);
+    void register_spl2(SweepRegistry& registry);
+    void register_splinf(SweepRegistry& registry);
+
+    // Runs fn on a socket pair of the network of ctx.
+    template<typename Fn>
+    void with_sweep_socks(const SweepContext& ctx, Fn fn) {
+        if (ctx.network == "local") {
+            auto socks = coproto::LocalAsyncSocket::makePair();
+            fn(socks);
+        } else {
+            EmulatedNetwork net(ctx.network == "lan" ? NetworkProfile::lan() : NetworkProfile::wan());
+            auto socks = net.makePair();
+            fn(socks);
+        }
+    }
+
+    inline size_t sweep_matches(size_t ts, size_t tr) {
+        return std::max<size_t>(1, std::min(ts, tr) / 16);
+    }
+
+    // Random fuzzy inputs. The first matches sender points lie within delta of distinct receiver points, the other
+    // ones are uniformly random and thus far from every receiver point. Returns matches.
+    template<size_t ts, size_t tr, size_t d, uint8_t delta>
+    size_t gen_sweep_fuzzy_inputs(osuCrypto::PRNG& prng, std::array<point, ts>& sender_points, std::array<point, tr>& receiver_points) {
+        const uint32_t lb = 2 * delta;
+        const uint32_t ub = std::numeric_limits<uint32_t>::max() - 2 * delta;
+        const size_t matches = sweep_matches(ts, tr);
+        uint32_t c[point::MAX_DIM] = {};
+
+        for (size_t i = 0; i < tr; i++) {
+            for (size_t j = 0; j < d; j++) c[j] = (prng.get<uint32_t>() % (ub - lb + 1)) + lb;
+            receiver_points[i] = point(d, c);
+        }
+
+        for (size_t i = 0; i < matches; i++) {
+            sender_points[i] = receiver_points[i * (tr / matches)];
+            sender_points[i][0] += delta / 2;
+        }
+
+        for (size_t i = matches; i < ts; i++) {
+            for (size_t j = 0; j < d; j++) c[j] = prng.get<uint32_t>();
+            sender_points[i] = point(d, c);
+        }
+
+        return matches;
+    }
+
+    // Random SpX inputs. The first matches sender points are distinct receiver points with the same values, the
+    // other ones are fresh. Returns the receiver indices of the intersection.
+    template<size_t ts, size_t tr, size_t d>
+    std::set<size_t> gen_sweep_sp_inputs(osuCrypto::PRNG& prng,
+                                         std::vector<osuCrypto::block>& sender_points, std::array<std::array<uint32_t, d>, ts>& sender_values,
+                                         std::vector<osuCrypto::block>& receiver_points, std::array<std::array<uint32_t, d>, tr>& receiver_values) {
+        const size_t matches = sweep_matches(ts, tr);
+        std::set<size_t> expected;
+
+        sender_points.resize(ts);
+        receiver_points.resize(tr);
+
+        for (size_t i = 0; i < tr; i++) {
+            receiver_points[i] = prng.get<osuCrypto::block>();
+            for (size_t j = 0; j < d; j++) receiver_values[i][j] = prng.get<uint8_t>();
+        }
+
+        for (size_t i = 0; i < matches; i++) {
+            const size_t r_idx = i * (tr / matches);
+
+            sender_points[i] = receiver_points[r_idx];
+            sender_values[i] = receiver_values[r_idx];
+            expected.insert(r_idx);
+        }
+
+        for (size_t i = matches; i < ts; i++) {
+            sender_points[i] = prng.get<osuCrypto::block>();
+            for (size_t j = 0; j < d; j++) sender_values[i][j] = prng.get<uint8_t>();
+        }
+
+        return expected;
+    }
+
+    inline void note_sweep_run(const TwoPartyStats& parties, const SweepContext& ctx) {
+        current_run().threads = ctx.threads;
+
+        const double nMBsExchanged = ((double) parties.bytes)/1024.0/1024.0;
+
+        SUCCEED("Number of MBs exchanged: " << nMBsExchanged);
+    }
+
+    template<template<size_t, size_t, size_t, uint8_t, uint8_t> class Sender,
+             template<size_t, size_t, size_t, uint8_t, uint8_t> class Receiver,
+             Metric metric, size_t ts, size_t tr, size_t d, uint8_t delta, uint8_t ssp>
+    void run_sweep_fuzzy(Catch::Benchmark::Chronometer& meter, const SweepContext& ctx) {
+        // The partitions send on a thread pool, in another order on every run, so no transcript would replay
+        if (ctx.threads > 1 && party_mode() != PartyMode::Local && party_mode() != PartyMode::Processes) {
+            throw std::runtime_error("SPARSE_COMP_BENCH_PARTIES=record and replay need --threads 1, the partitions of the "
+                                     "parallel mode do not send their messages in a fixed order");
+        }
+
+        with_sweep_socks(ctx, [&](auto& socks) {
+            osuCrypto::PRNG inputPRNG = osuCrypto::PRNG(osuCrypto::block(9536629026107651350ULL, 2724119864341290560ULL));
+            osuCrypto::PRNG senderPRNG = osuCrypto::PRNG(osuCrypto::block(15914074867899273501ULL, 6004108516319388444ULL));
+            osuCrypto::PRNG receiverPRNG = osuCrypto::PRNG(osuCrypto::block(6427781726132732903ULL, 8471345356057289138ULL));
+            osuCrypto::AES aes = osuCrypto::AES(osuCrypto::block(14034463513942181890ULL, 16276202269246990858ULL));
+
+            std::array<point, ts>* senderPoints = new std::array<point, ts>();
+            std::array<point, tr>* receiverPoints = new std::array<point, tr>();
+            std::vector<point> intersec;
+
+            if (ctx.workload == Workload::Uniform) {
+                gen_sweep_fuzzy_inputs<ts, tr, d, delta>(inputPRNG, *senderPoints, *receiverPoints);
+            } else {
+                load_or_gen_workload(ctx.workload, inputPRNG.get<osuCrypto::block>(), WorkloadParams{d, delta, sweep_matches(ts, tr)},
+                                     *receiverPoints, *senderPoints);
+            }
+
+            std::vector<point> expected;
+            expected_intersect<metric>(*receiverPoints, *senderPoints, d, delta, expected);
+
+            TwoPartyStats parties;
+
+            if (ctx.threads > 1) {
+                sparse_comp::fuzzy_parallel::Sender<Sender, tr, ts, d, delta, ssp> sender(senderPRNG, aes, ctx.threads, SWEEP_PARALLEL_MEMORY_BUDGET);
+                sparse_comp::fuzzy_parallel::Receiver<Receiver, ts, tr, d, delta, ssp> receiver(receiverPRNG, aes, ctx.threads, SWEEP_PARALLEL_MEMORY_BUDGET);
+
+                parties = measure_parties(meter, socks,
+                    [&](coproto::Socket& sock) { return sender.send(sock, *senderPoints); },
+                    [&](coproto::Socket& sock) { return receiver.receive(sock, *receiverPoints, intersec); }, intersec);
+            } else {
+                Sender<tr, ts, d, delta, ssp> sender(senderPRNG, aes);
+                Receiver<ts, tr, d, delta, ssp> receiver(receiverPRNG, aes);
+
+                parties = measure_parties(meter, socks,
+                    [&](coproto::Socket& sock) { return sender.send(sock, *senderPoints); },
+                    [&](coproto::Socket& sock) { return receiver.receive(sock, *receiverPoints, intersec); }, intersec);
+            }
+
+            delete senderPoints;
+            delete receiverPoints;
+
+            REQUIRE(is_intersec_correct(intersec, expected));
+
+            note_sweep_run(parties, ctx);
+        });
+    }
+
+    template<template<size_t, size_t, size_t, uint8_t, uint8_t> class Sender,
+             template<size_t, size_t, size_t, uint8_t, uint8_t> class Receiver,
+             size_t ts, size_t tr, size_t d, uint8_t delta, uint8_t ssp>
+    void run_sweep_sp(Catch::Benchmark::Chronometer& meter, const SweepContext& ctx) {
+        with_sweep_socks(ctx, [&](auto& socks) {
+            osuCrypto::PRNG inputPRNG = osuCrypto::PRNG(osuCrypto::block(9536629026107651350ULL, 2724119864341290560ULL));
+            osuCrypto::PRNG senderPRNG = osuCrypto::PRNG(osuCrypto::block(15914074867899273501ULL, 6004108516319388444ULL));
+            osuCrypto::PRNG receiverPRNG = osuCrypto::PRNG(osuCrypto::block(6427781726132732903ULL, 8471345356057289138ULL));
+            osuCrypto::AES aes = osuCrypto::AES(osuCrypto::block(14034463513942181890ULL, 16276202269246990858ULL));
+
+            std::array<std::array<uint32_t, d>, ts>* senderValues = new std::array<std::array<uint32_t, d>, ts>();
+            std::array<std::array<uint32_t, d>, tr>* receiverValues = new std::array<std::array<uint32_t, d>, tr>();
+            std::array<std::array<osuCrypto::block, 1>, ts>* senderShares = new std::array<std::array<osuCrypto::block, 1>, ts>();
+            std::array<std::array<osuCrypto::block, 1>, tr>* receiverShares = new std::array<std::array<osuCrypto::block, 1>, tr>();
+            std::vector<osuCrypto::block> senderPoints;
+            std::vector<osuCrypto::block> receiverPoints;
+
+            std::set<size_t> expected = gen_sweep_sp_inputs<ts, tr, d>(inputPRNG, senderPoints, *senderValues, receiverPoints, *receiverValues);
+
+            Sender<tr, ts, d, delta, ssp> sender(senderPRNG, aes);
+            Receiver<ts, tr, d, delta, ssp> receiver(receiverPRNG, aes);
+
+            auto parties = measure_parties(meter, socks,
+                [&](coproto::Socket& sock) { return sender.send(sock, senderPoints, *senderValues, *senderShares); },
+                [&](coproto::Socket& sock) { return receiver.receive(sock, receiverPoints, *receiverValues, *receiverShares); }, *receiverShares);
+
+            // The parties hold equal shares exactly for the points of the intersection
+            std::unordered_set<osuCrypto::block> sender_shares;
+            for (size_t i = 0; i < ts; i++) sender_shares.insert((*senderShares)[i][0]);
+
+            std::set<size_t> intersec;
+            for (size_t i = 0; i < tr; i++) {
+                if (sender_shares.contains((*receiverShares)[i][0])) intersec.insert(i);
+            }
+
+            delete senderValues;
+            delete receiverValues;
+            delete senderShares;
+            delete receiverShares;
+
+            REQUIRE(intersec == expected);
+
+            note_sweep_run(parties, ctx);
+        });
+    }
+
+};
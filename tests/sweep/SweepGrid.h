@@ -0,0 +1,83 @@
+#pragma once
+
+// Grid points compiled into sweep_bench, one X(t_s, t_r, d, delta, ssp) per instantiation. The protocols are
+// sized at compile time, so a point must be listed here before sweep_bench can run it; every instantiation
+// adds to the build time of its protocol's translation unit.
+
+// fuzzyl1 and fuzzylinf: n=m as in their benchmarks, plus unbalanced sizes
+#define SPARSE_COMP_SWEEP_FUZZY_GRID(X) \
+    X(256, 256, 2, 10, 40) \
+    X(256, 256, 2, 30, 40) \
+    X(256, 256, 6, 10, 40) \
+    X(256, 256, 6, 30, 40) \
+    X(256, 256, 10, 10, 40) \
+    X(256, 256, 10, 30, 40) \
+    X(4096, 4096, 2, 10, 40) \
+    X(4096, 4096, 2, 30, 40) \
+    X(4096, 4096, 6, 10, 40) \
+    X(4096, 4096, 6, 30, 40) \
+    X(4096, 4096, 10, 10, 40) \
+    X(4096, 4096, 10, 30, 40) \
+    X(65536, 65536, 2, 10, 40) \
+    X(65536, 65536, 2, 30, 40) \
+    X(65536, 65536, 6, 10, 40) \
+    X(65536, 65536, 6, 30, 40) \
+    X(65536, 65536, 10, 10, 40) \
+    X(65536, 65536, 10, 30, 40) \
+    X(256, 4096, 2, 10, 40) \
+    X(256, 4096, 6, 10, 40) \
+    X(4096, 256, 2, 10, 40) \
+    X(4096, 256, 6, 10, 40) \
+    X(4096, 65536, 2, 10, 40) \
+    X(4096, 65536, 6, 10, 40) \
+    X(65536, 4096, 2, 10, 40) \
+    X(65536, 4096, 6, 10, 40)
+
+// fuzzyl2 only supports d=2
+#define SPARSE_COMP_SWEEP_FUZZY_L2_GRID(X) \
+    X(256, 256, 2, 10, 40) \
+    X(256, 256, 2, 30, 40) \
+    X(4096, 4096, 2, 10, 40) \
+    X(4096, 4096, 2, 30, 40) \
+    X(65536, 65536, 2, 10, 40) \
+    X(65536, 65536, 2, 30, 40) \
+    X(256, 4096, 2, 10, 40) \
+    X(4096, 256, 2, 10, 40) \
+    X(4096, 65536, 2, 10, 40) \
+    X(65536, 4096, 2, 10, 40)
+
+// spl1 and splinf: t_r=t_s*2^d as in their benchmarks, plus t_r=t_s
+#define SPARSE_COMP_SWEEP_SP_GRID(X) \
+    X(256, 1024, 2, 10, 40) \
+    X(256, 1024, 2, 30, 40) \
+    X(256, 16384, 6, 10, 40) \
+    X(256, 16384, 6, 30, 40) \
+    X(256, 262144, 10, 10, 40) \
+    X(256, 262144, 10, 30, 40) \
+    X(4096, 16384, 2, 10, 40) \
+    X(4096, 16384, 2, 30, 40) \
+    X(4096, 262144, 6, 10, 40) \
+    X(4096, 262144, 6, 30, 40) \
+    X(4096, 4194304, 10, 10, 40) \
+    X(4096, 4194304, 10, 30, 40) \
+    X(65536, 262144, 2, 10, 40) \
+    X(65536, 262144, 2, 30, 40) \
+    X(65536, 4194304, 6, 10, 40) \
+    X(65536, 4194304, 6, 30, 40) \
+    X(65536, 67108864, 10, 10, 40) \
+    X(65536, 67108864, 10, 30, 40) \
+    X(1024, 1024, 2, 10, 40) \
+    X(1024, 1024, 6, 10, 40) \
+    X(16384, 16384, 2, 10, 40) \
+    X(16384, 16384, 6, 10, 40)
+
+// spl2 only supports d=2
+#define SPARSE_COMP_SWEEP_SP_L2_GRID(X) \
+    X(256, 1024, 2, 10, 40) \
+    X(256, 1024, 2, 30, 40) \
+    X(4096, 16384, 2, 10, 40) \
+    X(4096, 16384, 2, 30, 40) \
+    X(65536, 262144, 2, 10, 40) \
+    X(65536, 262144, 2, 30, 40) \
+    X(1024, 1024, 2, 10, 40) \
+    X(16384, 16384, 2, 10, 40)